@@ -0,0 +1,368 @@
+/* lzmadec - public domain single buffer LZMA decoder
+   See "unlicense" statement in LICENSE, and lzmadec.h for the API.
+*/
+#include "lzmadec.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LZMADEC_NUM_BIT_MODEL_TOTAL_BITS 11
+#define LZMADEC_BIT_MODEL_TOTAL (1 << LZMADEC_NUM_BIT_MODEL_TOTAL_BITS)
+#define LZMADEC_NUM_MOVE_BITS 5
+#define LZMADEC_TOP_VALUE (1u << 24)
+
+#define LZMADEC_NUM_STATES 12
+#define LZMADEC_NUM_POS_BITS_MAX 4
+#define LZMADEC_NUM_LEN_TO_POS_STATES 4
+#define LZMADEC_NUM_ALIGN_BITS 4
+#define LZMADEC_START_POS_MODEL_INDEX 4
+#define LZMADEC_END_POS_MODEL_INDEX 14
+#define LZMADEC_NUM_FULL_DISTANCES (1 << (LZMADEC_END_POS_MODEL_INDEX >> 1))
+#define LZMADEC_MATCH_MIN_LEN 2
+
+typedef uint16_t lzmadec_prob;
+
+typedef struct {
+    const unsigned char *in;
+    const unsigned char *in_end;
+    uint32_t range;
+    uint32_t code;
+    int corrupted;
+} lzmadec_range_decoder;
+
+typedef struct {
+    lzmadec_prob choice;
+    lzmadec_prob choice2;
+    lzmadec_prob low[1 << LZMADEC_NUM_POS_BITS_MAX][1 << 3];
+    lzmadec_prob mid[1 << LZMADEC_NUM_POS_BITS_MAX][1 << 3];
+    lzmadec_prob high[1 << 8];
+} lzmadec_len_decoder;
+
+typedef struct {
+    lzmadec_prob is_match[LZMADEC_NUM_STATES << LZMADEC_NUM_POS_BITS_MAX];
+    lzmadec_prob is_rep[LZMADEC_NUM_STATES];
+    lzmadec_prob is_rep_g0[LZMADEC_NUM_STATES];
+    lzmadec_prob is_rep_g1[LZMADEC_NUM_STATES];
+    lzmadec_prob is_rep_g2[LZMADEC_NUM_STATES];
+    lzmadec_prob is_rep0_long[LZMADEC_NUM_STATES << LZMADEC_NUM_POS_BITS_MAX];
+    lzmadec_prob pos_slot[LZMADEC_NUM_LEN_TO_POS_STATES][1 << 6];
+    lzmadec_prob pos_special[1 + LZMADEC_NUM_FULL_DISTANCES - LZMADEC_END_POS_MODEL_INDEX];
+    lzmadec_prob align[1 << LZMADEC_NUM_ALIGN_BITS];
+    lzmadec_len_decoder len;
+    lzmadec_len_decoder rep_len;
+} lzmadec_probs;
+
+static void lzmadec_init_probs(lzmadec_prob *probs, size_t count) {
+    size_t i;
+    for (i = 0; i < count; i++)
+        probs[i] = LZMADEC_BIT_MODEL_TOTAL >> 1;
+}
+
+static unsigned char lzmadec_next_byte(lzmadec_range_decoder *rc) {
+    if (rc->in == rc->in_end) {
+        rc->corrupted = 1;
+        return 0;
+    }
+
+    return *rc->in++;
+}
+
+static int lzmadec_rc_init(lzmadec_range_decoder *rc) {
+    int i;
+    rc->range = 0xFFFFFFFF;
+    rc->code = 0;
+    rc->corrupted = 0;
+
+    if (lzmadec_next_byte(rc) != 0)
+        return 0;
+
+    for (i = 0; i < 4; i++)
+        rc->code = (rc->code << 8) | lzmadec_next_byte(rc);
+
+    return !rc->corrupted && (rc->code != rc->range);
+}
+
+static void lzmadec_normalize(lzmadec_range_decoder *rc) {
+    if (rc->range < LZMADEC_TOP_VALUE) {
+        rc->range <<= 8;
+        rc->code = (rc->code << 8) | lzmadec_next_byte(rc);
+    }
+}
+
+static unsigned lzmadec_decode_bit(lzmadec_range_decoder *rc, lzmadec_prob *prob) {
+    unsigned symbol;
+    const uint32_t bound = (rc->range >> LZMADEC_NUM_BIT_MODEL_TOTAL_BITS) * *prob;
+
+    if (rc->code < bound) {
+        *prob += (LZMADEC_BIT_MODEL_TOTAL - *prob) >> LZMADEC_NUM_MOVE_BITS;
+        rc->range = bound;
+        symbol = 0;
+    } else {
+        *prob -= *prob >> LZMADEC_NUM_MOVE_BITS;
+        rc->code -= bound;
+        rc->range -= bound;
+        symbol = 1;
+    }
+
+    lzmadec_normalize(rc);
+    return symbol;
+}
+
+static uint32_t lzmadec_decode_direct_bits(lzmadec_range_decoder *rc, unsigned num_bits) {
+    uint32_t result = 0;
+
+    do {
+        uint32_t t;
+        rc->range >>= 1;
+        rc->code -= rc->range;
+        t = 0 - (rc->code >> 31);
+        rc->code += rc->range & t;
+
+        if (rc->code == rc->range)
+            rc->corrupted = 1;
+
+        lzmadec_normalize(rc);
+        result = (result << 1) + (t + 1);
+    } while (--num_bits);
+
+    return result;
+}
+
+static unsigned lzmadec_bit_tree_decode(lzmadec_range_decoder *rc, lzmadec_prob *probs, unsigned num_bits) {
+    unsigned m = 1;
+    unsigned i;
+
+    for (i = 0; i < num_bits; i++)
+        m = (m << 1) + lzmadec_decode_bit(rc, &probs[m]);
+
+    return m - (1u << num_bits);
+}
+
+static unsigned lzmadec_bit_tree_reverse_decode(lzmadec_range_decoder *rc, lzmadec_prob *probs, unsigned num_bits) {
+    unsigned m = 1;
+    unsigned symbol = 0;
+    unsigned i;
+
+    for (i = 0; i < num_bits; i++) {
+        const unsigned bit = lzmadec_decode_bit(rc, &probs[m]);
+        m = (m << 1) + bit;
+        symbol |= bit << i;
+    }
+
+    return symbol;
+}
+
+static unsigned lzmadec_decode_len(lzmadec_range_decoder *rc, lzmadec_len_decoder *len, unsigned pos_state) {
+    if (!lzmadec_decode_bit(rc, &len->choice))
+        return lzmadec_bit_tree_decode(rc, len->low[pos_state], 3);
+
+    if (!lzmadec_decode_bit(rc, &len->choice2))
+        return 8 + lzmadec_bit_tree_decode(rc, len->mid[pos_state], 3);
+
+    return 16 + lzmadec_bit_tree_decode(rc, len->high, 8);
+}
+
+static uint32_t lzmadec_decode_distance(lzmadec_range_decoder *rc, lzmadec_probs *probs, unsigned len) {
+    unsigned len_state = len;
+    unsigned pos_slot;
+    unsigned num_direct_bits;
+    uint32_t dist;
+
+    if (len_state > LZMADEC_NUM_LEN_TO_POS_STATES - 1)
+        len_state = LZMADEC_NUM_LEN_TO_POS_STATES - 1;
+
+    pos_slot = lzmadec_bit_tree_decode(rc, probs->pos_slot[len_state], 6);
+    if (pos_slot < 4)
+        return pos_slot;
+
+    num_direct_bits = (pos_slot >> 1) - 1;
+    dist = (2 | (pos_slot & 1)) << num_direct_bits;
+
+    if (pos_slot < LZMADEC_END_POS_MODEL_INDEX)
+        return dist + lzmadec_bit_tree_reverse_decode(rc, probs->pos_special + dist - pos_slot, num_direct_bits);
+
+    dist += lzmadec_decode_direct_bits(rc, num_direct_bits - LZMADEC_NUM_ALIGN_BITS) << LZMADEC_NUM_ALIGN_BITS;
+    return dist + lzmadec_bit_tree_reverse_decode(rc, probs->align, LZMADEC_NUM_ALIGN_BITS);
+}
+
+lzmadec_status lzmadec_decode_alone(unsigned char *dest, size_t *dest_len, const unsigned char *src, size_t src_len) {
+    lzmadec_range_decoder rc;
+    lzmadec_probs probs;
+    lzmadec_prob *literal_probs;
+    lzmadec_status status = LZMADEC_OK;
+    unsigned lc, lp, pb;
+    unsigned state = 0;
+    uint32_t rep0 = 0, rep1 = 0, rep2 = 0, rep3 = 0;
+    uint64_t unpack_size = 0;
+    int size_defined = 0;
+    size_t capacity = *dest_len;
+    size_t pos = 0;
+    unsigned d;
+    int i;
+
+    *dest_len = 0;
+
+    if (src_len < LZMADEC_HEADER_SIZE || src[0] >= 9 * 5 * 5)
+        return LZMADEC_BAD_HEADER;
+
+    d = src[0];
+    lc = d % 9;
+    d /= 9;
+    lp = d % 5;
+    pb = d / 5;
+
+    for (i = 0; i < 8; i++) {
+        if (src[5 + i] != 0xFF)
+            size_defined = 1;
+        unpack_size |= (uint64_t)src[5 + i] << (8 * i);
+    }
+
+    if (size_defined && unpack_size > capacity)
+        return LZMADEC_OUTPUT_FULL;
+
+    literal_probs = (lzmadec_prob *)malloc(sizeof(lzmadec_prob) * ((size_t)0x300 << (lc + lp)));
+    if (!literal_probs)
+        return LZMADEC_NO_MEMORY;
+
+    lzmadec_init_probs(literal_probs, (size_t)0x300 << (lc + lp));
+    lzmadec_init_probs((lzmadec_prob *)&probs, sizeof(probs) / sizeof(lzmadec_prob));
+
+    rc.in = src + LZMADEC_HEADER_SIZE;
+    rc.in_end = src + src_len;
+    if (!lzmadec_rc_init(&rc)) {
+        free(literal_probs);
+        return LZMADEC_BAD_DATA;
+    }
+
+    for (;;) {
+        const unsigned pos_state = (unsigned)(pos & ((1u << pb) - 1));
+        unsigned len;
+
+        if (rc.corrupted) {
+            status = LZMADEC_BAD_DATA;
+            break;
+        }
+
+        /* A known size may still be followed by an end marker */
+        if (size_defined && pos == unpack_size && rc.code == 0)
+            break;
+
+        if (!lzmadec_decode_bit(&rc, &probs.is_match[(state << LZMADEC_NUM_POS_BITS_MAX) + pos_state])) {
+            const unsigned prev_byte = pos ? dest[pos - 1] : 0;
+            const unsigned lit_state = (unsigned)(((pos & ((1u << lp) - 1)) << lc) + (prev_byte >> (8 - lc)));
+            lzmadec_prob *lit = literal_probs + 0x300 * (size_t)lit_state;
+            unsigned symbol = 1;
+
+            if ((size_defined && pos == unpack_size) || pos == capacity) {
+                status = (pos == capacity) ? LZMADEC_OUTPUT_FULL : LZMADEC_BAD_DATA;
+                break;
+            }
+
+            if (state >= 7) {
+                unsigned match_byte = dest[pos - rep0 - 1];
+                do {
+                    const unsigned match_bit = (match_byte >> 7) & 1;
+                    unsigned bit;
+                    match_byte <<= 1;
+                    bit = lzmadec_decode_bit(&rc, &lit[((1 + match_bit) << 8) + symbol]);
+                    symbol = (symbol << 1) | bit;
+                    if (match_bit != bit)
+                        break;
+                } while (symbol < 0x100);
+            }
+
+            while (symbol < 0x100)
+                symbol = (symbol << 1) | lzmadec_decode_bit(&rc, &lit[symbol]);
+
+            dest[pos++] = (unsigned char)(symbol - 0x100);
+            state = (state < 4) ? 0 : ((state < 10) ? state - 3 : state - 6);
+            continue;
+        }
+
+        if (lzmadec_decode_bit(&rc, &probs.is_rep[state])) {
+            if ((size_defined && pos == unpack_size) || pos == 0) {
+                status = LZMADEC_BAD_DATA;
+                break;
+            }
+
+            if (!lzmadec_decode_bit(&rc, &probs.is_rep_g0[state])) {
+                if (!lzmadec_decode_bit(&rc, &probs.is_rep0_long[(state << LZMADEC_NUM_POS_BITS_MAX) + pos_state])) {
+                    if (pos == capacity) {
+                        status = LZMADEC_OUTPUT_FULL;
+                        break;
+                    }
+
+                    state = (state < 7) ? 9 : 11;
+                    dest[pos] = dest[pos - rep0 - 1];
+                    pos++;
+                    continue;
+                }
+            } else {
+                uint32_t dist;
+                if (!lzmadec_decode_bit(&rc, &probs.is_rep_g1[state])) {
+                    dist = rep1;
+                } else {
+                    if (!lzmadec_decode_bit(&rc, &probs.is_rep_g2[state])) {
+                        dist = rep2;
+                    } else {
+                        dist = rep3;
+                        rep3 = rep2;
+                    }
+                    rep2 = rep1;
+                }
+                rep1 = rep0;
+                rep0 = dist;
+            }
+
+            len = lzmadec_decode_len(&rc, &probs.rep_len, pos_state);
+            state = (state < 7) ? 8 : 11;
+        } else {
+            rep3 = rep2;
+            rep2 = rep1;
+            rep1 = rep0;
+            len = lzmadec_decode_len(&rc, &probs.len, pos_state);
+            state = (state < 7) ? 7 : 10;
+
+            rep0 = lzmadec_decode_distance(&rc, &probs, len);
+            if (rep0 == 0xFFFFFFFF) {
+                /* End marker */
+                if (rc.corrupted || rc.code != 0 || (size_defined && pos != unpack_size))
+                    status = LZMADEC_BAD_DATA;
+                break;
+            }
+
+            if ((size_defined && pos == unpack_size) || rep0 >= pos) {
+                status = LZMADEC_BAD_DATA;
+                break;
+            }
+        }
+
+        len += LZMADEC_MATCH_MIN_LEN;
+
+        {
+            size_t limit = capacity;
+            size_t end;
+
+            if (size_defined && unpack_size < limit)
+                limit = (size_t)unpack_size;
+
+            if (len > limit - pos) {
+                status = (limit == capacity) ? LZMADEC_OUTPUT_FULL : LZMADEC_BAD_DATA;
+                break;
+            }
+
+            for (end = pos + len; pos < end; pos++)
+                dest[pos] = dest[pos - rep0 - 1];
+        }
+    }
+
+    free(literal_probs);
+
+    if (status == LZMADEC_OK && rc.corrupted)
+        status = LZMADEC_BAD_DATA;
+
+    if (status == LZMADEC_OK)
+        *dest_len = pos;
+
+    return status;
+}
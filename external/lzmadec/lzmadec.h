@@ -0,0 +1,42 @@
+/* lzmadec - public domain single buffer LZMA decoder
+   See "unlicense" statement in LICENSE.
+
+   Decodes LZMA streams in the .lzma ("LZMA alone") container: one properties byte, the dictionary
+   size in 4 little endian bytes, the unpacked size in 8 little endian bytes (all ones when unknown,
+   the stream then ends with a marker) and the compressed data.
+
+   The decoder follows the reference decoder of the LZMA specification by Igor Pavlov (LzmaSpec.cpp,
+   placed in the public domain). It only decodes whole buffers: the output buffer is used as the
+   dictionary, so nothing is allocated besides the probability tables.
+*/
+#ifndef LZMADEC_H
+#define LZMADEC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LZMADEC_HEADER_SIZE 13
+
+typedef enum {
+    LZMADEC_OK = 0,
+    /* The header is truncated or has invalid properties */
+    LZMADEC_BAD_HEADER = -1,
+    /* The stream is corrupted or ends early */
+    LZMADEC_BAD_DATA = -2,
+    /* The unpacked data doesn't fit in the output buffer */
+    LZMADEC_OUTPUT_FULL = -3,
+    LZMADEC_NO_MEMORY = -4
+} lzmadec_status;
+
+/* Decodes the .lzma stream in src into dest.
+   On input, *dest_len is the capacity of dest. On success it is set to the number of bytes written. */
+lzmadec_status lzmadec_decode_alone(unsigned char *dest, size_t *dest_len, const unsigned char *src, size_t src_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LZMADEC_H */
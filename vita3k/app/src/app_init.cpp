@@ -160,7 +160,7 @@ bool init(HostState &state, Config &cfg, const Root &root_paths) {
         return false;
     }
 
-    if (!init(state.audio, resume_thread)) {
+    if (!init(state.audio, resume_thread, state.cfg.audio_backend)) {
         LOG_WARN("Failed to init audio! Audio will not work.");
     }
 
@@ -169,6 +169,10 @@ bool init(HostState &state, Config &cfg, const Root &root_paths) {
         return false;
     }
 
+    // In MiB, reading ahead stays off at zero
+    if (cfg.read_ahead_budget > 0)
+        state.io.read_ahead.set_budget(static_cast<std::size_t>(cfg.read_ahead_budget) * 1024 * 1024);
+
     if (!ngs::init(state.ngs, state.mem)) {
         LOG_ERROR("Failed to initialize ngs.");
         return false;
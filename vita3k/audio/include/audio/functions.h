@@ -20,9 +20,32 @@
 #include <util/types.h>
 
 #include <functional>
+#include <memory>
+#include <string>
 
 struct AudioState;
+struct AudioOutPort;
 
 typedef std::function<void(SceUID)> ResumeAudioThread;
+typedef std::shared_ptr<AudioOutPort> AudioOutPortPtr;
 
-bool init(AudioState &state, ResumeAudioThread resume_thread);
+// Backend is either SDL or Null. The null device consumes audio at the same pace as a real one,
+// without any output, which keeps guests running at the right speed on headless hosts.
+bool init(AudioState &state, ResumeAudioThread resume_thread, const std::string &backend);
+
+// Returns nullptr if the guest format can't be converted to the device one
+AudioOutPortPtr create_out_port(const AudioState &state, int len, int freq, int channels);
+// Returns the new port id, or 0 if the mixer can't take more ports
+int add_out_port(AudioState &state, const AudioOutPortPtr &port);
+// Once this returns, the mixer no longer uses the port
+bool remove_out_port(AudioState &state, int port_id);
+
+// Queue one buffer of the port length. Only returns false if the mixer is too far behind to take it all.
+bool queue_out_port(AudioOutPort &port, const void *buf);
+// Whether the guest feeding the port should wait for the mixer to catch up
+bool is_out_port_full(const AudioState &state, const AudioOutPort &port);
+// Frames still waiting to be played, in the device format
+int get_out_port_rest(const AudioState &state, const AudioOutPort &port);
+
+// Fill one device buffer from every open port
+void mix_out_ports(AudioState &state, uint8_t *stream, int len);
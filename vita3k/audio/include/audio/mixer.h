@@ -0,0 +1,35 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels producing the device buffer. The mix is accumulated as float in 16-bit sample units, so
+// clipping only happens once at the end instead of after every port.
+namespace audio {
+// dest[i] += src[i] * gain of its channel, over interleaved stereo frames
+void mix_s16_stereo(float *dest, const std::int16_t *src, std::size_t frames, float left_gain, float right_gain);
+
+// Truncates and saturates
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count);
+
+// Portable versions the SIMD ones have to match bit for bit
+void mix_s16_stereo_scalar(float *dest, const std::int16_t *src, std::size_t frames, float left_gain, float right_gain);
+void float_to_s16_scalar(const float *src, std::int16_t *dest, std::size_t count);
+} // namespace audio
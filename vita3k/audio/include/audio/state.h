@@ -17,10 +17,13 @@
 
 #pragma once
 
+#include <util/spsc_ring_buffer.h>
 #include <util/types.h>
 
 #include <SDL_audio.h>
 
+#include <array>
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -33,24 +36,30 @@
 typedef std::shared_ptr<SDL_AudioStream> AudioStreamPtr;
 typedef std::function<void(SceUID)> ResumeAudioThread;
 
+#define AUDIO_MAX_OUT_PORTS 16 //!< Ports the mixer can play at once
+
 struct ReadOnlyAudioOutPortState {
     int len_bytes = 0;
 };
 
-struct SharedAudioOutPortState {
+// Only used by the guest threads feeding the port, never by the mixer
+struct ProducerAudioOutPortState {
     std::mutex mutex;
+    // Converts the guest samples to the device format
     AudioStreamPtr stream;
-    SceUID thread = -1;
+    std::vector<int16_t> converted;
 };
 
 struct AudioOutPort {
     ReadOnlyAudioOutPortState ro;
-    SharedAudioOutPortState shared;
+    ProducerAudioOutPortState producer;
+    // Samples in the device format, written by the guest and read by the mixer
+    std::unique_ptr<SPSCRingBuffer<int16_t>> queue;
+    // Guest thread waiting for the mixer to catch up
+    std::atomic<SceUID> thread = -1;
     // Channel range from 0 - 32768
-    int left_channel_volume = SCE_AUDIO_VOLUME_0DB;
-    int right_channel_volume = SCE_AUDIO_VOLUME_0DB;
-    // Volume range from 1 - 128
-    float volume = SDL_MIX_MAXVOLUME;
+    std::atomic<int> left_channel_volume = SCE_AUDIO_VOLUME_0DB;
+    std::atomic<int> right_channel_volume = SCE_AUDIO_VOLUME_0DB;
 };
 
 struct AudioInPort {
@@ -69,13 +78,17 @@ struct ReadOnlyAudioState {
 };
 
 struct AudioCallbackState {
-    std::vector<uint8_t> temp_buffer;
+    std::vector<float> mix_buffer;
+    // Odd while the mixer runs, so that a released port can be kept alive until the mixer let go of it
+    std::atomic<uint64_t> generation = 0;
 };
 
 struct SharedAudioState {
     std::mutex mutex;
     int next_port_id = 1;
     AudioOutPortPtrs out_ports;
+    // Read by the mixer without taking the mutex, only written with it held
+    std::array<std::atomic<AudioOutPort *>, AUDIO_MAX_OUT_PORTS> mixed_ports = {};
     AudioInPort in_port;
 };
 
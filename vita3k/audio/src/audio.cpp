@@ -15,43 +15,178 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+
 #include "Tracy.hpp"
 
 #include <audio/functions.h>
+#include <audio/mixer.h>
 #include <audio/state.h>
 
 #include <util/log.h>
+#include <util/string_utils.h>
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
+#include <thread>
 
-static void mix_out_port(uint8_t *stream, uint8_t *temp_buffer, int len, AudioOutPort &port, const ResumeAudioThread &resume_thread) {
-    ZoneScopedC(0xF6C2FF); // Tracy - Track function scope with color thistle
+// Frames a port may hold before the guest feeding it is told to wait, two device buffers keep the
+// mixer fed while the guest thread wakes up
+static int get_out_port_threshold(const AudioState &state) {
+    return state.ro.spec.samples * 2;
+}
+
+AudioOutPortPtr create_out_port(const AudioState &state, int len, int freq, int channels) {
+    const SDL_AudioSpec &spec = state.ro.spec;
+    if (spec.freq == 0) {
+        return nullptr;
+    }
+
+    const AudioStreamPtr stream(SDL_NewAudioStream(AUDIO_S16LSB, channels, freq, spec.format, spec.channels, spec.freq), SDL_FreeAudioStream);
+    if (!stream) {
+        return nullptr;
+    }
+
+    // A bit more than one guest buffer once resampled, the resampler may hold some frames back and
+    // release them with the next buffer
+    const int converted_frames = static_cast<int>((static_cast<int64_t>(len) * spec.freq + freq - 1) / freq) + 64;
+
+    const AudioOutPortPtr port = std::make_shared<AudioOutPort>();
+    port->ro.len_bytes = len * channels * sizeof(int16_t);
+    port->producer.stream = stream;
+    port->producer.converted.resize(converted_frames * spec.channels);
+
+    // The guest only stops queuing once over the threshold, so there must be room for a buffer past it
+    port->queue = std::make_unique<SPSCRingBuffer<int16_t>>((get_out_port_threshold(state) + converted_frames * 2) * spec.channels);
+
+    return port;
+}
+
+int add_out_port(AudioState &state, const AudioOutPortPtr &port) {
+    const std::lock_guard<std::mutex> lock(state.shared.mutex);
+
+    const auto slot = std::find_if(state.shared.mixed_ports.begin(), state.shared.mixed_ports.end(), [](const std::atomic<AudioOutPort *> &mixed) {
+        return mixed.load() == nullptr;
+    });
+
+    if (slot == state.shared.mixed_ports.end()) {
+        return 0;
+    }
+
+    const int port_id = state.shared.next_port_id++;
+    state.shared.out_ports.emplace(port_id, port);
+    slot->store(port.get());
+
+    return port_id;
+}
+
+bool remove_out_port(AudioState &state, int port_id) {
+    AudioOutPortPtr port;
 
-    // How much data is available?
-    std::unique_lock<std::mutex> lock(port.shared.mutex);
-    const int bytes_available = SDL_AudioStreamAvailable(port.shared.stream.get());
-    assert(bytes_available >= 0);
-
-    // Running out of data?
-    // The (len * 2) is just a guess that seems to work.
-    if (bytes_available < (len * 2)) {
-        // Is there a thread waiting for playback to finish?
-        if (port.shared.thread >= 0) {
-            // Wake the thread up.
-            resume_thread(port.shared.thread);
-            port.shared.thread = -1;
+    {
+        const std::lock_guard<std::mutex> lock(state.shared.mutex);
+        const auto found = state.shared.out_ports.find(port_id);
+        if (found == state.shared.out_ports.end()) {
+            return false;
+        }
+
+        port = std::move(found->second);
+        state.shared.out_ports.erase(found);
+
+        for (std::atomic<AudioOutPort *> &mixed : state.shared.mixed_ports) {
+            if (mixed.load() == port.get()) {
+                mixed.store(nullptr);
+            }
         }
     }
 
-    // Mix as much as we need.
-    const int bytes_to_get = std::min(len, bytes_available);
-    const int bytes_got = SDL_AudioStreamGet(port.shared.stream.get(), temp_buffer, bytes_to_get);
-    lock.unlock();
-    if (bytes_got > 0) {
-        SDL_MixAudio(stream, temp_buffer, bytes_got, port.volume);
+    // A mix that started before the port was taken out of the list may still be reading it
+    const uint64_t generation = state.callback.generation.load();
+    if (generation & 1) {
+        while (state.callback.generation.load() == generation) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Nobody would wake up a thread still waiting on the port
+    const SceUID thread = port->thread.exchange(-1);
+    if (thread >= 0) {
+        state.ro.resume_thread(thread);
     }
+
+    return true;
+}
+
+bool queue_out_port(AudioOutPort &port, const void *buf) {
+    const std::lock_guard<std::mutex> lock(port.producer.mutex);
+
+    if (SDL_AudioStreamPut(port.producer.stream.get(), buf, port.ro.len_bytes) != 0) {
+        LOG_ERROR("SDL audio error: {}", SDL_GetError());
+        return false;
+    }
+
+    std::vector<int16_t> &converted = port.producer.converted;
+    const int converted_bytes = static_cast<int>(converted.size() * sizeof(int16_t));
+
+    bool complete = true;
+    int bytes_got = 0;
+    while ((bytes_got = SDL_AudioStreamGet(port.producer.stream.get(), converted.data(), converted_bytes)) > 0) {
+        const std::size_t samples = bytes_got / sizeof(int16_t);
+        if (port.queue->write(converted.data(), samples) != samples) {
+            complete = false;
+        }
+    }
+
+    return complete;
+}
+
+bool is_out_port_full(const AudioState &state, const AudioOutPort &port) {
+    return get_out_port_rest(state, port) > get_out_port_threshold(state);
+}
+
+int get_out_port_rest(const AudioState &state, const AudioOutPort &port) {
+    return static_cast<int>(port.queue->size() / state.ro.spec.channels);
+}
+
+void mix_out_ports(AudioState &state, uint8_t *stream, int len) {
+    ZoneScopedC(0xF6C2FF); // Tracy - Track function scope with color thistle
+
+    std::vector<float> &mix_buffer = state.callback.mix_buffer;
+    const std::size_t samples = std::min(len / sizeof(int16_t), mix_buffer.size());
+    std::fill_n(mix_buffer.begin(), samples, 0.0f);
+
+    state.callback.generation.fetch_add(1);
+
+    for (std::atomic<AudioOutPort *> &mixed : state.shared.mixed_ports) {
+        AudioOutPort *port = mixed.load();
+        if (!port) {
+            continue;
+        }
+
+        const float left_gain = static_cast<float>(port->left_channel_volume.load(std::memory_order_relaxed)) / SCE_AUDIO_VOLUME_0DB;
+        const float right_gain = static_cast<float>(port->right_channel_volume.load(std::memory_order_relaxed)) / SCE_AUDIO_VOLUME_0DB;
+
+        // Mixed straight out of the queue, missing frames are left silent
+        float *dest = mix_buffer.data();
+        port->queue->consume(samples, [&](const int16_t *data, std::size_t count) {
+            audio::mix_s16_stereo(dest, data, count / 2, left_gain, right_gain);
+            dest += count;
+        });
+
+        // Running out of data? Wake up the thread waiting for playback to finish.
+        if (!is_out_port_full(state, *port)) {
+            const SceUID thread = port->thread.exchange(-1);
+            if (thread >= 0) {
+                state.ro.resume_thread(thread);
+            }
+        }
+    }
+
+    state.callback.generation.fetch_add(1);
+
+    audio::float_to_s16(mix_buffer.data(), reinterpret_cast<int16_t *>(stream), samples);
+    std::memset(stream + samples * sizeof(int16_t), 0, len - samples * sizeof(int16_t));
 }
 
 static void SDLCALL audio_callback(void *userdata, Uint8 *stream, int len) {
@@ -62,32 +197,45 @@ static void SDLCALL audio_callback(void *userdata, Uint8 *stream, int len) {
     assert(stream != nullptr);
     AudioState &state = *static_cast<AudioState *>(userdata);
     assert(len == state.ro.spec.size);
-    assert(len == state.callback.temp_buffer.size());
 
-    std::vector<AudioOutPortPtr> ports;
-    {
-        // Read from shared state.
-        const std::lock_guard<std::mutex> lock(state.shared.mutex);
-        ports.reserve(state.shared.out_ports.size());
-        for (const AudioOutPortPtrs::value_type &port : state.shared.out_ports) {
-            ports.push_back(port.second);
-        }
-    }
+    mix_out_ports(state, stream, len);
 
-    std::memset(stream, state.ro.spec.silence, len);
+    FrameMarkNamed("Audio"); // Tracy - End discontinuous frame for audio rendering
+}
 
-    for (const AudioOutPortPtr &port : ports) {
-        mix_out_port(stream, state.callback.temp_buffer.data(), len, *port, state.ro.resume_thread);
-    }
+struct NullAudioDevice {
+    std::thread thread;
+    std::atomic<bool> running = true;
+};
 
-    FrameMarkNamed("Audio"); // Tracy - End discontinuous frame for audio rendering
+// Pull one device buffer per period, exactly like the SDL callback would
+static void run_null_device(AudioState &state, NullAudioDevice &device) {
+    const SDL_AudioSpec &spec = state.ro.spec;
+    const auto period = std::chrono::nanoseconds(INT64_C(1000000000) * spec.samples / spec.freq);
+    std::vector<uint8_t> stream(spec.size);
+
+    auto next = std::chrono::steady_clock::now();
+    while (device.running) {
+        mix_out_ports(state, stream.data(), spec.size);
+
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
 }
 
-static void close_audio(void *) {
-    SDL_CloseAudio();
+static AudioDevicePtr start_null_device(AudioState &state) {
+    NullAudioDevice *device = new NullAudioDevice;
+    device->thread = std::thread(run_null_device, std::ref(state), std::ref(*device));
+
+    return AudioDevicePtr(device, [](void *data) {
+        NullAudioDevice *device = static_cast<NullAudioDevice *>(data);
+        device->running = false;
+        device->thread.join();
+        delete device;
+    });
 }
 
-bool init(AudioState &state, ResumeAudioThread resume_thread) {
+bool init(AudioState &state, ResumeAudioThread resume_thread, const std::string &backend) {
     state.ro.resume_thread = resume_thread;
 
     SDL_AudioSpec desired = {};
@@ -98,15 +246,36 @@ bool init(AudioState &state, ResumeAudioThread resume_thread) {
     desired.callback = &audio_callback;
     desired.userdata = &state;
 
-    if (SDL_OpenAudio(&desired, &state.ro.spec) != 0) {
+    const std::string backend_name = string_utils::toupper(backend);
+
+    if (backend_name == "NULL") {
+        desired.callback = nullptr;
+        desired.size = desired.samples * desired.channels * sizeof(int16_t);
+        state.ro.spec = desired;
+        state.callback.mix_buffer.resize(desired.samples * desired.channels);
+        state.device = start_null_device(state);
+
+        LOG_INFO("Using the null audio device, audio will not be heard.");
+        return true;
+    }
+
+    if (backend_name != "SDL") {
+        LOG_WARN("Unknown audio backend {}, using SDL.", backend);
+    }
+
+    // The mixer only produces signed 16-bit stereo, let SDL convert it if the device wants something else
+    const SDL_AudioDeviceID device = SDL_OpenAudioDevice(nullptr, 0, &desired, &state.ro.spec, 0);
+    if (device == 0) {
         LOG_ERROR("SDL audio error: {}", SDL_GetError());
         return false;
     }
 
-    state.device = AudioDevicePtr(nullptr, close_audio);
-    state.callback.temp_buffer.resize(state.ro.spec.size);
+    state.device = AudioDevicePtr(nullptr, [device](void *) {
+        SDL_CloseAudioDevice(device);
+    });
+    state.callback.mix_buffer.resize(state.ro.spec.samples * state.ro.spec.channels);
 
-    SDL_PauseAudio(0);
+    SDL_PauseAudioDevice(device, 0);
 
     return true;
 }
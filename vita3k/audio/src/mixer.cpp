@@ -0,0 +1,121 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <audio/mixer.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIXER_USE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIXER_USE_NEON
+#endif
+
+namespace audio {
+void mix_s16_stereo_scalar(float *dest, const std::int16_t *src, std::size_t frames, float left_gain, float right_gain) {
+    for (std::size_t k = 0; k < frames; k++) {
+        dest[k * 2] += static_cast<float>(src[k * 2]) * left_gain;
+        dest[k * 2 + 1] += static_cast<float>(src[k * 2 + 1]) * right_gain;
+    }
+}
+
+void float_to_s16_scalar(const float *src, std::int16_t *dest, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        dest[i] = static_cast<std::int16_t>(std::clamp(src[i], -32768.0f, 32767.0f));
+    }
+}
+
+#ifdef MIXER_USE_SSE2
+void mix_s16_stereo(float *dest, const std::int16_t *src, std::size_t frames, float left_gain, float right_gain) {
+    const __m128 gains = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k * 2));
+
+        // Put each value in the upper half of a 32-bit lane, then shift it down keeping the sign
+        const __m128 first = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(input, input), 16));
+        const __m128 second = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(input, input), 16));
+
+        _mm_storeu_ps(dest + k * 2, _mm_add_ps(_mm_loadu_ps(dest + k * 2), _mm_mul_ps(first, gains)));
+        _mm_storeu_ps(dest + k * 2 + 4, _mm_add_ps(_mm_loadu_ps(dest + k * 2 + 4), _mm_mul_ps(second, gains)));
+    }
+
+    mix_s16_stereo_scalar(dest + k * 2, src + k * 2, frames - k, left_gain, right_gain);
+}
+
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count) {
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 first = _mm_min_ps(high, _mm_max_ps(low, _mm_loadu_ps(src + i)));
+        const __m128 second = _mm_min_ps(high, _mm_max_ps(low, _mm_loadu_ps(src + i + 4)));
+
+        // Already in range, the saturation of the pack never kicks in
+        const __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(first), _mm_cvttps_epi32(second));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), packed);
+    }
+
+    float_to_s16_scalar(src + i, dest + i, count - i);
+}
+#elif defined(MIXER_USE_NEON)
+void mix_s16_stereo(float *dest, const std::int16_t *src, std::size_t frames, float left_gain, float right_gain) {
+    const float gain_values[4] = { left_gain, right_gain, left_gain, right_gain };
+    const float32x4_t gains = vld1q_f32(gain_values);
+
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const int16x8_t input = vld1q_s16(src + k * 2);
+        const float32x4_t first = vcvtq_f32_s32(vmovl_s16(vget_low_s16(input)));
+        const float32x4_t second = vcvtq_f32_s32(vmovl_s16(vget_high_s16(input)));
+
+        // Separate multiply and add, a fused one would not round like the scalar version
+        vst1q_f32(dest + k * 2, vaddq_f32(vld1q_f32(dest + k * 2), vmulq_f32(first, gains)));
+        vst1q_f32(dest + k * 2 + 4, vaddq_f32(vld1q_f32(dest + k * 2 + 4), vmulq_f32(second, gains)));
+    }
+
+    mix_s16_stereo_scalar(dest + k * 2, src + k * 2, frames - k, left_gain, right_gain);
+}
+
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count) {
+    const float32x4_t low = vdupq_n_f32(-32768.0f);
+    const float32x4_t high = vdupq_n_f32(32767.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t first = vminq_f32(high, vmaxq_f32(low, vld1q_f32(src + i)));
+        const float32x4_t second = vminq_f32(high, vmaxq_f32(low, vld1q_f32(src + i + 4)));
+
+        vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(first)), vqmovn_s32(vcvtq_s32_f32(second))));
+    }
+
+    float_to_s16_scalar(src + i, dest + i, count - i);
+}
+#else
+void mix_s16_stereo(float *dest, const std::int16_t *src, std::size_t frames, float left_gain, float right_gain) {
+    mix_s16_stereo_scalar(dest, src, frames, left_gain, right_gain);
+}
+
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count) {
+    float_to_s16_scalar(src, dest, count);
+}
+#endif
+} // namespace audio
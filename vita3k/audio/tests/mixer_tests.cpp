@@ -0,0 +1,107 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <audio/mixer.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+// Lengths hitting every vector width and leftover case
+constexpr std::size_t LENGTHS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 255, 256, 1024 };
+
+std::vector<std::int16_t> random_s16(const std::size_t count, const unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(-32768, 32767);
+
+    std::vector<std::int16_t> result(count);
+    for (std::int16_t &sample : result) {
+        sample = static_cast<std::int16_t>(distribution(generator));
+    }
+
+    return result;
+}
+
+std::vector<float> random_float(const std::size_t count, const float range, const unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-range, range);
+
+    std::vector<float> result(count);
+    for (float &sample : result) {
+        sample = distribution(generator);
+    }
+
+    return result;
+}
+} // namespace
+
+TEST(audio_mixer, mix_s16_stereo_matches_scalar) {
+    const float gains[][2] = { { 1.0f, 1.0f }, { 0.25f, 0.8f }, { 0.0f, 1.0f } };
+
+    for (const std::size_t frames : LENGTHS) {
+        for (const auto &gain : gains) {
+            const std::vector<std::int16_t> src = random_s16(frames * 2, static_cast<unsigned>(frames));
+            std::vector<float> expected = random_float(frames * 2, 40000.0f, static_cast<unsigned>(frames + 1));
+            std::vector<float> result = expected;
+
+            audio::mix_s16_stereo_scalar(expected.data(), src.data(), frames, gain[0], gain[1]);
+            audio::mix_s16_stereo(result.data(), src.data(), frames, gain[0], gain[1]);
+
+            ASSERT_EQ(std::memcmp(expected.data(), result.data(), expected.size() * sizeof(float)), 0) << frames;
+        }
+    }
+}
+
+TEST(audio_mixer, mix_s16_stereo_applies_channel_gains) {
+    const std::int16_t src[] = { 1000, -1000, 32767, -32768 };
+    float dest[] = { 1.0f, 1.0f, 0.0f, 0.0f };
+
+    audio::mix_s16_stereo(dest, src, 2, 0.5f, 0.25f);
+
+    EXPECT_EQ(dest[0], 501.0f);
+    EXPECT_EQ(dest[1], -249.0f);
+    EXPECT_EQ(dest[2], 16383.5f);
+    EXPECT_EQ(dest[3], -8192.0f);
+}
+
+TEST(audio_mixer, float_to_s16_matches_scalar) {
+    for (const std::size_t count : LENGTHS) {
+        const std::vector<float> src = random_float(count, 70000.0f, static_cast<unsigned>(count));
+        std::vector<std::int16_t> expected(count);
+        std::vector<std::int16_t> result(count);
+
+        audio::float_to_s16_scalar(src.data(), expected.data(), count);
+        audio::float_to_s16(src.data(), result.data(), count);
+
+        ASSERT_EQ(expected, result) << count;
+    }
+}
+
+TEST(audio_mixer, float_to_s16_saturates) {
+    const float src[] = { 0.0f, 1.9f, -1.9f, 32767.0f, 40000.0f, -32768.0f, -1e9f, 1e9f };
+    std::int16_t dest[8];
+
+    audio::float_to_s16(src, dest, 8);
+
+    const std::int16_t expected[] = { 0, 1, -1, 32767, 32767, -32768, -32768, 32767 };
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(dest[i], expected[i]) << i;
+    }
+}
@@ -0,0 +1,231 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <audio/functions.h>
+#include <audio/state.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace {
+// Same format the SDL backend asks for, without opening any device
+void setup_spec(AudioState &state) {
+    state.ro.spec.freq = 48000;
+    state.ro.spec.format = AUDIO_S16LSB;
+    state.ro.spec.channels = 2;
+    state.ro.spec.samples = 1024;
+    state.ro.spec.size = 1024 * 2 * sizeof(int16_t);
+    state.callback.mix_buffer.resize(1024 * 2);
+}
+
+std::vector<int16_t> mix(AudioState &state) {
+    std::vector<int16_t> result(state.ro.spec.samples * state.ro.spec.channels);
+    mix_out_ports(state, reinterpret_cast<uint8_t *>(result.data()), state.ro.spec.size);
+    return result;
+}
+} // namespace
+
+TEST(audio_ring_buffer, wraps_around) {
+    SPSCRingBuffer<int> ring(5);
+    ASSERT_EQ(ring.capacity(), 8);
+
+    const int first[] = { 1, 2, 3, 4, 5, 6 };
+    ASSERT_EQ(ring.write(first, 6), 6);
+
+    int out[8] = {};
+    ASSERT_EQ(ring.read(out, 4), 4);
+    ASSERT_EQ(out[3], 4);
+
+    // Only 6 fit, the last ones land at the start of the storage
+    const int second[] = { 7, 8, 9, 10, 11, 12, 13 };
+    ASSERT_EQ(ring.write(second, 7), 6);
+    ASSERT_EQ(ring.size(), 8);
+
+    int runs = 0;
+    std::vector<int> consumed;
+    ASSERT_EQ(ring.consume(100, [&](const int *data, std::size_t count) {
+        runs++;
+        consumed.insert(consumed.end(), data, data + count);
+    }),
+        8);
+
+    ASSERT_EQ(runs, 2);
+    ASSERT_EQ(consumed, (std::vector<int>{ 5, 6, 7, 8, 9, 10, 11, 12 }));
+    ASSERT_EQ(ring.size(), 0);
+}
+
+TEST(audio_ring_buffer, one_producer_one_consumer) {
+    SPSCRingBuffer<uint32_t> ring(64);
+    constexpr uint32_t COUNT = 50000;
+
+    std::thread producer([&]() {
+        uint32_t next = 0;
+        while (next < COUNT) {
+            const uint32_t values[7] = { next, next + 1, next + 2, next + 3, next + 4, next + 5, next + 6 };
+            const std::size_t written = ring.write(values, std::min<uint32_t>(7, COUNT - next));
+            if (written == 0) {
+                std::this_thread::yield();
+            }
+
+            next += static_cast<uint32_t>(written);
+        }
+    });
+
+    uint32_t expected = 0;
+    bool in_order = true;
+    while (expected < COUNT) {
+        const std::size_t consumed = ring.consume(13, [&](const uint32_t *data, std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+                in_order &= (data[i] == expected++);
+            }
+        });
+
+        if (consumed == 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    ASSERT_TRUE(in_order);
+}
+
+TEST(audio_out_port, mixes_ports_with_their_volumes) {
+    AudioState state;
+    setup_spec(state);
+
+    const AudioOutPortPtr first = create_out_port(state, 256, 48000, 2);
+    const AudioOutPortPtr second = create_out_port(state, 256, 48000, 1);
+    ASSERT_TRUE(first && second);
+
+    const int first_id = add_out_port(state, first);
+    const int second_id = add_out_port(state, second);
+    ASSERT_NE(first_id, 0);
+    ASSERT_NE(second_id, 0);
+    ASSERT_NE(first_id, second_id);
+
+    second->left_channel_volume = SCE_AUDIO_VOLUME_0DB / 2;
+    second->right_channel_volume = 0;
+
+    const std::vector<int16_t> stereo(256 * 2, 1000);
+    const std::vector<int16_t> mono(256, 30000);
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue_out_port(*first, stereo.data()));
+        ASSERT_TRUE(queue_out_port(*second, mono.data()));
+    }
+
+    ASSERT_EQ(get_out_port_rest(state, *first), 1024);
+    ASSERT_EQ(get_out_port_rest(state, *second), 1024);
+
+    const std::vector<int16_t> result = mix(state);
+    EXPECT_EQ(result[0], 16000);
+    EXPECT_EQ(result[1], 1000);
+    EXPECT_EQ(result[2046], 16000);
+    EXPECT_EQ(result[2047], 1000);
+    EXPECT_EQ(get_out_port_rest(state, *first), 0);
+
+    // Missing data is silence, not a repeat of the last buffer
+    EXPECT_EQ(mix(state), std::vector<int16_t>(2048, 0));
+
+    ASSERT_TRUE(remove_out_port(state, first_id));
+    ASSERT_FALSE(remove_out_port(state, first_id));
+    ASSERT_TRUE(remove_out_port(state, second_id));
+}
+
+TEST(audio_out_port, mix_saturates) {
+    AudioState state;
+    setup_spec(state);
+
+    const std::vector<int16_t> loud(1024 * 2, 20000);
+
+    for (int i = 0; i < 2; i++) {
+        const AudioOutPortPtr port = create_out_port(state, 1024, 48000, 2);
+        ASSERT_NE(add_out_port(state, port), 0);
+        ASSERT_TRUE(queue_out_port(*port, loud.data()));
+    }
+
+    EXPECT_EQ(mix(state), std::vector<int16_t>(2048, 32767));
+}
+
+TEST(audio_out_port, port_limit) {
+    AudioState state;
+    setup_spec(state);
+
+    std::vector<int> ids;
+    for (int i = 0; i < AUDIO_MAX_OUT_PORTS; i++) {
+        ids.push_back(add_out_port(state, create_out_port(state, 256, 48000, 2)));
+        ASSERT_NE(ids.back(), 0);
+    }
+
+    ASSERT_EQ(add_out_port(state, create_out_port(state, 256, 48000, 2)), 0);
+
+    // Releasing one frees its slot for the next port
+    ASSERT_TRUE(remove_out_port(state, ids[3]));
+    ASSERT_NE(add_out_port(state, create_out_port(state, 256, 48000, 2)), 0);
+}
+
+TEST(audio_out_port, null_device_paces_the_guest) {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool resumed = false;
+
+    AudioState state;
+    ASSERT_TRUE(init(state, [&](SceUID) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        resumed = true;
+        condition.notify_all();
+    },
+        "Null"));
+
+    const AudioOutPortPtr port = create_out_port(state, 480, 48000, 2);
+    const int port_id = add_out_port(state, port);
+    ASSERT_NE(port_id, 0);
+
+    const std::vector<int16_t> buffer(480 * 2, 100);
+    constexpr int BUFFERS = 50; // Half a second
+
+    // Waits the same way sceAudioOutOutput does
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BUFFERS; i++) {
+        ASSERT_TRUE(queue_out_port(*port, buffer.data()));
+        ASSERT_LE(get_out_port_rest(state, *port), 2048 + 480);
+
+        if (is_out_port_full(state, *port)) {
+            port->thread = 1;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!is_out_port_full(state, *port)) {
+                SceUID waiting = 1;
+                port->thread.compare_exchange_strong(waiting, -1);
+                continue;
+            }
+
+            condition.wait(lock, [&]() { return resumed; });
+            resumed = false;
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Everything past what the port holds has to be played before the guest can queue it
+    EXPECT_GE(elapsed, std::chrono::milliseconds(400));
+
+    ASSERT_TRUE(remove_out_port(state, port_id));
+}
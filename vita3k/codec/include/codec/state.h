@@ -18,10 +18,16 @@
 #pragma once
 
 #include <array>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <string>
+#include <thread>
+#include <vector>
 
 struct AVFrame;
 struct AVPacket;
@@ -31,6 +37,7 @@ struct AVFormatContext;
 struct AVCodecParserContext;
 struct AVCodec;
 struct SwrContext;
+struct SwsContext;
 
 union DecoderSize {
     struct {
@@ -59,6 +66,13 @@ enum class DecoderQuery {
     AT9_SUPERFRAME_SIZE,
 };
 
+// What a decode_frames call went through, counted over every frame
+struct DecoderBatch {
+    uint32_t frames = 0;
+    uint32_t samples = 0;
+    uint32_t es_size = 0;
+};
+
 struct DecoderState {
     AVCodecContext *context{};
 
@@ -71,6 +85,10 @@ struct DecoderState {
     virtual uint32_t get_es_size();
     virtual void clear_context();
 
+    // Decode up to frame_count audio frames laid one after the other, each at most max_es_size bytes long,
+    // as interleaved 16-bit PCM. Stops at the first frame which fails, in which case false is returned.
+    virtual bool decode_frames(const uint8_t *data, uint32_t max_es_size, uint8_t *pcm, uint32_t frame_count, DecoderBatch &batch);
+
     virtual ~DecoderState();
 };
 
@@ -93,6 +111,16 @@ struct H264DecoderState : public DecoderState {
 
     bool is_stopped = true;
 
+    // Guest memory given to the decoder for its pictures. If the stream allows it, pictures are decoded
+    // straight into it, with the same layout as the output.
+    uint8_t *frame_memory = nullptr;
+    uint32_t frame_memory_size = 0;
+    uint32_t frame_slot_size = 0;
+    std::vector<bool> frame_slots_used;
+
+    static int get_frame_buffer(AVCodecContext *context, AVFrame *frame, int flags);
+    static void release_frame_buffer(void *opaque, uint8_t *data);
+
     static uint32_t buffer_size(DecoderSize size);
 
     uint32_t get(DecoderQuery query) override;
@@ -103,15 +131,33 @@ struct H264DecoderState : public DecoderState {
     void get_res(uint32_t &width, uint32_t &height);
     void get_pts(uint32_t &upper, uint32_t &lower);
 
-    H264DecoderState(uint32_t width, uint32_t height);
+    H264DecoderState(uint32_t width, uint32_t height, uint8_t *frame_memory = nullptr, uint32_t frame_memory_size = 0);
     ~H264DecoderState() override;
 };
 
+// Chroma subsampling of planar YCbCr pictures, as the log2 of the factor in each direction
+struct YCbCrSampling {
+    uint32_t h_shift = 0;
+    uint32_t v_shift = 0;
+};
+
 struct MjpegDecoderState : public DecoderState {
+    // Pictures in a layout the guest can't take are converted to 4:4:4. The context is kept as long
+    // as the size and format of the pictures don't change.
+    SwsContext *sws_context{};
+
+    // Sampling of the last picture received
+    YCbCrSampling sampling;
+
+    // Picture received without a buffer to write it to, so only its size was asked for. The next receive
+    // gives it out instead of decoding again, the next send drops it.
+    AVFrame *held_frame{};
+
     bool send(const uint8_t *data, uint32_t size) override;
     bool receive(uint8_t *data, DecoderSize *size) override;
 
     MjpegDecoderState();
+    ~MjpegDecoderState() override;
 };
 
 struct Atrac9DecoderState : public DecoderState {
@@ -123,6 +169,8 @@ struct Atrac9DecoderState : public DecoderState {
     int superframe_frame_idx;
     int superframe_data_left;
 
+    bool decode(const uint8_t *data, int16_t *pcm);
+
     uint32_t get(DecoderQuery query) override;
     uint32_t get_es_size() override;
 
@@ -130,6 +178,7 @@ struct Atrac9DecoderState : public DecoderState {
 
     bool send(const uint8_t *data, uint32_t size) override;
     bool receive(uint8_t *data, DecoderSize *size) override;
+    bool decode_frames(const uint8_t *data, uint32_t max_es_size, uint8_t *pcm, uint32_t frame_count, DecoderBatch &batch) override;
 
     explicit Atrac9DecoderState(uint32_t config_data);
     ~Atrac9DecoderState() override;
@@ -183,6 +232,7 @@ public:
 struct AacDecoderState : public DecoderState {
     AVCodec *codec;
     AVFrame *frame;
+    AVPacket *packet;
     uint32_t es_size_used;
     uint32_t get(DecoderQuery query) override;
 
@@ -196,44 +246,118 @@ struct AacDecoderState : public DecoderState {
     ~AacDecoderState();
 };
 
-struct PlayerState {
-    std::string video_playing;
-    std::queue<std::string> videos_queue;
-
-    AVFormatContext *format{};
-    AVCodecContext *video_context{};
-    AVCodecContext *audio_context{};
-    int32_t video_stream_id = -1;
-    int32_t audio_stream_id = -1;
+struct PlayerVideoFrame {
+    // YUV420P, the way the guest gets it
+    std::vector<uint8_t> data;
+    // In milliseconds
+    uint64_t timestamp = 0;
+};
 
-    std::queue<AVPacket *> audio_packets;
-    std::queue<AVPacket *> video_packets;
+struct PlayerAudioFrame {
+    // Interleaved S16, the way the guest gets it
+    std::vector<int16_t> data;
+    // In milliseconds
+    uint64_t timestamp = 0;
+    uint32_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint32_t sample_count = 0;
+};
 
-    uint64_t time_of_last_frame = 0;
-    uint64_t framerate_microseconds = 0;
+// Plays a queue of videos. A thread decodes ahead of the guest and converts the frames, so getting
+// a frame only takes it from a queue.
+struct PlayerState {
+    // How far ahead of the guest the decoding thread goes
+    static constexpr std::size_t MAX_QUEUED_VIDEO_FRAMES = 4;
+    static constexpr std::size_t MAX_QUEUED_AUDIO_FRAMES = 16;
 
+    // Info about the last frames given to the guest
     uint64_t last_timestamp = 0;
     uint32_t last_channels = 0;
     uint32_t last_sample_rate = 0;
     uint32_t last_sample_count = 0;
 
+    // These wait for the video being opened, if there is one
     DecoderSize get_size();
     uint64_t get_framerate_microseconds();
+    bool is_active();
 
+    void queue(const std::string &path);
+    // Skip to the next queued video, if there is any
     void pop_video();
+    // Stop decoding and close the current video, the ones queued after it are kept
     void free_video();
-    void switch_video(const std::string &path);
+    // Jump to the given time in milliseconds, throwing away all the frames decoded ahead
+    void seek(uint64_t timestamp);
+
+    // Take the next decoded frame, return false if it is not decoded yet
+    bool receive_video(PlayerVideoFrame &frame);
+    bool receive_audio(PlayerAudioFrame &frame);
+    // Get the format of the next audio frame without taking it, waits for it to be decoded
+    bool peek_audio(PlayerAudioFrame &info);
+
+    std::size_t queued_video_frames();
+    std::size_t queued_audio_frames();
+
+    ~PlayerState();
+
+private:
+    // Only used by the decoding thread while it runs
+    AVFormatContext *format{};
+    AVCodecContext *video_context{};
+    AVCodecContext *audio_context{};
+    int32_t video_stream_id = -1;
+    int32_t audio_stream_id = -1;
 
+    std::queue<AVPacket *> audio_packets;
+    std::queue<AVPacket *> video_packets;
+    bool video_drained = false;
+    bool audio_drained = false;
+
+    // Frames before this position (after a seek) are not given to the guest
+    uint64_t skip_until = 0;
+
+    bool open_video(const std::string &path);
+    void close_video();
+    void seek_video(uint64_t timestamp);
     bool next_packet(int32_t stream_id);
+    bool decode_video(PlayerVideoFrame &frame);
+    bool decode_audio(PlayerAudioFrame &frame);
+    void decode_loop();
 
-    std::vector<int16_t> receive_audio();
-    std::vector<uint8_t> receive_video();
+    // Everything below is guarded by the mutex
+    std::mutex mutex;
+    std::condition_variable condvar;
 
-    void queue(const std::string &path);
+    std::string video_playing;
+    std::queue<std::string> videos_queue;
+    DecoderSize video_size{};
+    uint64_t framerate_microseconds = 0;
 
-    ~PlayerState();
+    std::deque<PlayerVideoFrame> video_frames;
+    std::deque<PlayerAudioFrame> audio_frames;
+    // No more frames will come from the current video
+    bool video_ended = true;
+    bool audio_ended = true;
+
+    bool skip_requested = false;
+    std::optional<uint64_t> seek_target;
+    bool stop_requested = false;
+    // Bumped whenever the queued frames are thrown away, frames decoded before that are dropped
+    uint32_t generation = 0;
+
+    std::thread decode_thread;
+
+    bool is_opening() const;
+    void start_decoding();
+    void wait_for_open(std::unique_lock<std::mutex> &lock);
 };
 
-void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint32_t height);
+uint32_t ycbcr_buffer_size(uint32_t width, uint32_t height, YCbCrSampling sampling);
+// Convert full range BT.601 YCbCr, with the Y, Cb and Cr planes packed one after the other, to RGBA or BGRA
+void convert_ycbcr_to_rgba(const uint8_t *ycbcr, uint8_t *rgba, uint32_t width, uint32_t height, uint32_t rgba_pitch, YCbCrSampling sampling, bool bgra);
+void convert_ycbcr_to_rgba_scalar(const uint8_t *ycbcr, uint8_t *rgba, uint32_t width, uint32_t height, uint32_t rgba_pitch, YCbCrSampling sampling, bool bgra);
+// Convert planar float samples to interleaved signed 16-bit ones, rounded and clipped the way swresample does
+void convert_f32_planar_to_s16(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t samples);
+void convert_f32_planar_to_s16_scalar(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t samples);
 void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest);
 std::string codec_error_name(int error);
@@ -29,6 +29,7 @@ extern "C" {
 
 #include <util/log.h>
 
+#include <algorithm>
 #include <cassert>
 
 struct FFMPEGAtrac9Info {
@@ -65,12 +66,12 @@ void Atrac9DecoderState::clear_context() {
     reinterpret_cast<Atrac9Handle *>(decoder_handle)->Frame.IndexInSuperframe = 0;
 }
 
-bool Atrac9DecoderState::send(const uint8_t *data, uint32_t size) {
+bool Atrac9DecoderState::decode(const uint8_t *data, int16_t *pcm) {
     Atrac9CodecInfo *info = reinterpret_cast<Atrac9CodecInfo *>(atrac9_info);
 
     int decode_used = 0;
 
-    const int res = Atrac9Decode(decoder_handle, data, reinterpret_cast<short *>(result.data()), &decode_used);
+    const int res = Atrac9Decode(decoder_handle, data, pcm, &decode_used);
     if (res != At9Status::ERR_SUCCESS) {
         LOG_ERROR("Decode failure with code {}!", res);
         return false;
@@ -89,6 +90,10 @@ bool Atrac9DecoderState::send(const uint8_t *data, uint32_t size) {
     return true;
 }
 
+bool Atrac9DecoderState::send(const uint8_t *data, uint32_t size) {
+    return decode(data, reinterpret_cast<int16_t *>(result.data()));
+}
+
 bool Atrac9DecoderState::receive(uint8_t *data, DecoderSize *size) {
     Atrac9CodecInfo *info = reinterpret_cast<Atrac9CodecInfo *>(atrac9_info);
 
@@ -103,6 +108,24 @@ bool Atrac9DecoderState::receive(uint8_t *data, DecoderSize *size) {
     return true;
 }
 
+bool Atrac9DecoderState::decode_frames(const uint8_t *data, uint32_t max_es_size, uint8_t *pcm, uint32_t frame_count, DecoderBatch &batch) {
+    Atrac9CodecInfo *info = reinterpret_cast<Atrac9CodecInfo *>(atrac9_info);
+    batch = {};
+
+    // Frames are decoded straight into the output, without going through the result buffer
+    for (; batch.frames < frame_count; batch.frames++) {
+        int16_t *frame_pcm = pcm ? reinterpret_cast<int16_t *>(pcm) + batch.samples * info->channels : reinterpret_cast<int16_t *>(result.data());
+        if (!decode(data + batch.es_size, frame_pcm)) {
+            return false;
+        }
+
+        batch.es_size += std::min(es_size_used, max_es_size);
+        batch.samples += info->frameSamples;
+    }
+
+    return true;
+}
+
 Atrac9DecoderState::Atrac9DecoderState(uint32_t config_data)
     : config_data(config_data) {
     decoder_handle = Atrac9GetHandle();
@@ -23,6 +23,7 @@ extern "C" {
 
 #include <util/log.h>
 
+#include <algorithm>
 #include <cassert>
 
 uint32_t DecoderState::get(DecoderQuery query) {
@@ -35,6 +36,24 @@ uint32_t DecoderState::get_es_size() {
 
 void DecoderState::clear_context() {}
 
+bool DecoderState::decode_frames(const uint8_t *data, uint32_t max_es_size, uint8_t *pcm, uint32_t frame_count, DecoderBatch &batch) {
+    const uint32_t bytes_per_sample = get(DecoderQuery::CHANNELS) * sizeof(int16_t);
+    batch = {};
+
+    for (; batch.frames < frame_count; batch.frames++) {
+        DecoderSize size;
+        if (!send(data + batch.es_size, max_es_size)
+            || !receive(pcm ? pcm + batch.samples * bytes_per_sample : nullptr, &size)) {
+            return false;
+        }
+
+        batch.es_size += std::min(get_es_size(), max_es_size);
+        batch.samples += size.samples;
+    }
+
+    return true;
+}
+
 void DecoderState::flush() {
     avcodec_flush_buffers(context);
 }
@@ -17,27 +17,47 @@
 
 #include <codec/state.h>
 
+#include <util/align.h>
 #include <util/log.h>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 }
 
+#include <algorithm>
 #include <cassert>
 
-void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest) {
-    for (int32_t a = 0; a < frame->height; a++) {
-        memcpy(dest, &frame->data[0][frame->linesize[0] * a], frame->width);
-        dest += frame->width;
+// At least the STRIDE_ALIGN FFmpeg is built with, 64 covers its AVX-512 code
+constexpr static uint32_t FRAME_PLANE_ALIGNMENT = 64;
+
+static void copy_plane(uint8_t *dest, const uint8_t *src, int32_t src_pitch, int32_t width, int32_t height) {
+    if (src_pitch == width) {
+        memcpy(dest, src, width * height);
+        return;
     }
-    for (int32_t a = 0; a < frame->height / 2; a++) {
-        memcpy(dest, &frame->data[1][frame->linesize[1] * a], frame->width / 2);
-        dest += frame->width / 2;
+
+    for (int32_t a = 0; a < height; a++) {
+        memcpy(dest, &src[src_pitch * a], width);
+        dest += width;
     }
-    for (int32_t a = 0; a < frame->height / 2; a++) {
-        memcpy(dest, &frame->data[2][frame->linesize[2] * a], frame->width / 2);
-        dest += frame->width / 2;
+}
+
+void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest) {
+    const int32_t luma_size = frame->width * frame->height;
+    const int32_t chroma_size = (frame->width / 2) * (frame->height / 2);
+
+    // Pictures decoded into guest frame memory can already have the exact output layout
+    if (frame->linesize[0] == frame->width && frame->linesize[1] == frame->width / 2 && frame->linesize[2] == frame->width / 2
+        && frame->data[1] == frame->data[0] + luma_size && frame->data[2] == frame->data[1] + chroma_size) {
+        memcpy(dest, frame->data[0], luma_size + chroma_size * 2);
+        return;
     }
+
+    copy_plane(dest, frame->data[0], frame->linesize[0], frame->width, frame->height);
+    dest += luma_size;
+    copy_plane(dest, frame->data[1], frame->linesize[1], frame->width / 2, frame->height / 2);
+    dest += chroma_size;
+    copy_plane(dest, frame->data[2], frame->linesize[2], frame->width / 2, frame->height / 2);
 }
 
 uint32_t H264DecoderState::buffer_size(DecoderSize size) {
@@ -133,7 +153,74 @@ void H264DecoderState::get_pts(uint32_t &upper, uint32_t &lower) {
     lower = pts_out & 0xFFFFFFFF;
 }
 
-H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
+void H264DecoderState::release_frame_buffer(void *opaque, uint8_t *data) {
+    auto *state = static_cast<H264DecoderState *>(opaque);
+    state->frame_slots_used[(data - state->frame_memory) / state->frame_slot_size] = false;
+}
+
+int H264DecoderState::get_frame_buffer(AVCodecContext *context, AVFrame *frame, int flags) {
+    auto *state = static_cast<H264DecoderState *>(context->opaque);
+
+    if (state->frame_memory && (frame->format == AV_PIX_FMT_YUV420P || frame->format == AV_PIX_FMT_YUVJ420P)) {
+        int width = frame->width;
+        int height = frame->height;
+        int linesize_align[AV_NUM_DATA_POINTERS];
+        avcodec_align_dimensions2(context, &width, &height, linesize_align);
+
+        const uint32_t luma_size = width * height;
+        const uint32_t chroma_size = (width / 2) * (height / 2);
+
+        // The planes must keep rows as wide as the picture, so that they can be given to the guest in one copy.
+        // The SIMD code of FFmpeg also needs every plane to start on an aligned address, which the guest
+        // buffer does not promise.
+        const bool fits = (width == frame->width) && (width % linesize_align[0] == 0)
+            && ((width / 2) % linesize_align[1] == 0) && ((width / 2) % linesize_align[2] == 0)
+            && (reinterpret_cast<uintptr_t>(state->frame_memory) % FRAME_PLANE_ALIGNMENT == 0)
+            && (luma_size % FRAME_PLANE_ALIGNMENT == 0) && (chroma_size % FRAME_PLANE_ALIGNMENT == 0);
+
+        if (fits) {
+            // Rounded up so that every slot starts aligned as well
+            const uint32_t slot_size = align(luma_size + chroma_size * 2 + AV_INPUT_BUFFER_PADDING_SIZE, FRAME_PLANE_ALIGNMENT);
+
+            if (slot_size != state->frame_slot_size) {
+                // Pictures of the old size may still be referenced, wait for them to be released
+                const bool in_use = std::find(state->frame_slots_used.begin(), state->frame_slots_used.end(), true) != state->frame_slots_used.end();
+                if (!in_use) {
+                    state->frame_slot_size = slot_size;
+                    state->frame_slots_used.assign(state->frame_memory_size / slot_size, false);
+                }
+            }
+
+            const auto slot = std::find(state->frame_slots_used.begin(), state->frame_slots_used.end(), false);
+            if ((slot_size == state->frame_slot_size) && (slot != state->frame_slots_used.end())) {
+                *slot = true;
+
+                uint8_t *memory = state->frame_memory + (slot - state->frame_slots_used.begin()) * slot_size;
+                frame->buf[0] = av_buffer_create(memory, slot_size, release_frame_buffer, state, 0);
+                if (!frame->buf[0]) {
+                    *slot = false;
+                    return AVERROR(ENOMEM);
+                }
+
+                frame->data[0] = memory;
+                frame->data[1] = memory + luma_size;
+                frame->data[2] = memory + luma_size + chroma_size;
+                frame->linesize[0] = width;
+                frame->linesize[1] = width / 2;
+                frame->linesize[2] = width / 2;
+                frame->extended_data = frame->data;
+
+                return 0;
+            }
+        }
+    }
+
+    return avcodec_default_get_buffer2(context, frame, flags);
+}
+
+H264DecoderState::H264DecoderState(uint32_t width, uint32_t height, uint8_t *frame_memory, uint32_t frame_memory_size)
+    : frame_memory(frame_memory)
+    , frame_memory_size(frame_memory_size) {
     AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
     assert(codec);
 
@@ -146,10 +233,24 @@ H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
     context->width = width;
     context->height = height;
 
+    // The guest expects a picture back for every access unit, so frame threading and the delay
+    // it adds are out. Slices can still be decoded in parallel.
+    context->thread_type = FF_THREAD_SLICE;
+    context->thread_count = 0;
+
+    if (frame_memory && frame_memory_size) {
+        context->opaque = this;
+        context->get_buffer2 = get_frame_buffer;
+    }
+
     int result = avcodec_open2(context, codec, nullptr);
     assert(result == 0);
 }
 
 H264DecoderState::~H264DecoderState() {
     av_parser_close(parser);
+
+    // Release the pictures in frame memory while the slots are still there
+    avcodec_close(context);
+    avcodec_free_context(&context);
 }
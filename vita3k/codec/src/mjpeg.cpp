@@ -26,37 +26,44 @@ extern "C" {
 
 #include <cassert>
 
-void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint32_t height) {
-    SwsContext *context = sws_getContext(width, height, AV_PIX_FMT_YUV444P, width, height, AV_PIX_FMT_RGBA,
-        0, nullptr, nullptr, nullptr);
-    assert(context);
+// Layouts the guest can take as they are
+static bool get_native_sampling(int format, YCbCrSampling &sampling) {
+    switch (format) {
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_YUV444P:
+        sampling = { 0, 0 };
+        return true;
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV422P:
+        sampling = { 1, 0 };
+        return true;
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV420P:
+        sampling = { 1, 1 };
+        return true;
+    case AV_PIX_FMT_YUVJ411P:
+    case AV_PIX_FMT_YUV411P:
+        sampling = { 2, 0 };
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void copy_plane(uint8_t *dest, const uint8_t *src, int linesize, uint32_t width, uint32_t height) {
+    if (static_cast<uint32_t>(linesize) == width) {
+        std::memcpy(dest, src, width * height);
+        return;
+    }
 
-    const uint8_t *slices[] = {
-        &yuv[0], // Y Slice
-        &yuv[width * height], // U Slice
-        &yuv[width * height * 2], // V Slice
-    };
-
-    int strides[] = {
-        static_cast<int>(width),
-        static_cast<int>(width),
-        static_cast<int>(width),
-    };
-
-    uint8_t *dst_slices[] = {
-        rgba,
-    };
-
-    const int dst_strides[] = {
-        static_cast<int>(width * 4),
-    };
-
-    int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
-    assert(error == height);
-    sws_freeContext(context);
+    for (uint32_t row = 0; row < height; row++) {
+        std::memcpy(&dest[row * width], &src[row * linesize], width);
+    }
 }
 
 bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
+    av_frame_free(&held_frame);
+
     std::vector<uint8_t> jpeg_buffer(size + AV_INPUT_BUFFER_PADDING_SIZE);
     std::memcpy(jpeg_buffer.data(), data, size);
 
@@ -74,37 +81,70 @@ bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool MjpegDecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
-    int error = avcodec_receive_frame(context, frame);
-    if (error < 0) {
-        LOG_WARN("Error receiving Mjpeg frame: {}.", codec_error_name(error));
-        av_frame_free(&frame);
-        return false;
+    AVFrame *frame = held_frame;
+    held_frame = nullptr;
+
+    if (!frame) {
+        frame = av_frame_alloc();
+        int error = avcodec_receive_frame(context, frame);
+        if (error < 0) {
+            LOG_WARN("Error receiving Mjpeg frame: {}.", codec_error_name(error));
+            av_frame_free(&frame);
+            return false;
+        }
     }
 
+    const uint32_t width = frame->width;
+    const uint32_t height = frame->height;
+
+    // Anything else is converted to 4:4:4
+    YCbCrSampling frame_sampling;
+    const bool is_native = get_native_sampling(frame->format, frame_sampling);
+
     if (data) {
-        uint8_t *channels[] = {
+        const uint32_t chroma_width = (width + (1 << frame_sampling.h_shift) - 1) >> frame_sampling.h_shift;
+        const uint32_t chroma_height = (height + (1 << frame_sampling.v_shift) - 1) >> frame_sampling.v_shift;
+
+        uint8_t *planes[] = {
             &data[0], // y
-            &data[frame->width * frame->height], // u
-            &data[frame->width * frame->height * 2], // v
+            &data[width * height], // cb
+            &data[width * height + chroma_width * chroma_height], // cr
         };
 
-        assert(frame->format == AV_PIX_FMT_YUVJ444P);
-
-        // Copy YUV444 data.
-        for (uint32_t a = 0; a < 3; a++) {
-            for (int b = 0; b < frame->height; b++) {
-                std::memcpy(&channels[a][b * frame->width], &frame->data[a][b * frame->linesize[a]], frame->width);
+        if (is_native) {
+            copy_plane(planes[0], frame->data[0], frame->linesize[0], width, height);
+            copy_plane(planes[1], frame->data[1], frame->linesize[1], chroma_width, chroma_height);
+            copy_plane(planes[2], frame->data[2], frame->linesize[2], chroma_width, chroma_height);
+        } else {
+            sws_context = sws_getCachedContext(sws_context, width, height, static_cast<AVPixelFormat>(frame->format),
+                width, height, AV_PIX_FMT_YUVJ444P, SWS_POINT, nullptr, nullptr, nullptr);
+            if (!sws_context) {
+                LOG_ERROR("Unable to convert Mjpeg frame with pixel format {}.", frame->format);
+                av_frame_free(&frame);
+                return false;
             }
+
+            const int strides[] = {
+                static_cast<int>(width),
+                static_cast<int>(width),
+                static_cast<int>(width),
+            };
+
+            sws_scale(sws_context, frame->data, frame->linesize, 0, height, planes, strides);
         }
     }
 
+    sampling = frame_sampling;
+
     if (size) {
         size->width = frame->width;
         size->height = frame->height;
     }
 
-    av_frame_free(&frame);
+    if (data)
+        av_frame_free(&frame);
+    else
+        held_frame = frame;
 
     return true;
 }
@@ -118,3 +158,8 @@ MjpegDecoderState::MjpegDecoderState() {
     int error = avcodec_open2(context, codec, nullptr);
     assert(error == 0);
 }
+
+MjpegDecoderState::~MjpegDecoderState() {
+    av_frame_free(&held_frame);
+    sws_freeContext(sws_context);
+}
@@ -0,0 +1,112 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/state.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PCM_USE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PCM_USE_NEON
+#endif
+
+// Same rounding and clipping as swresample, so output doesn't change with the path taken
+static int16_t to_s16(float sample) {
+    return static_cast<int16_t>(std::lrintf(std::min(std::max(sample * 32768.0f, -32768.0f), 32767.0f)));
+}
+
+static void convert_scalar(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t start, uint32_t samples) {
+    for (uint32_t i = start; i < samples; i++) {
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            dest[i * channels + ch] = to_s16(planes[ch][i]);
+        }
+    }
+}
+
+#ifdef PCM_USE_SSE2
+static __m128i to_s16x8(const float *samples) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+
+    const __m128 first = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(samples), scale), low), high);
+    const __m128 second = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(samples + 4), scale), low), high);
+
+    return _mm_packs_epi32(_mm_cvtps_epi32(first), _mm_cvtps_epi32(second));
+}
+
+void convert_f32_planar_to_s16(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t samples) {
+    uint32_t i = 0;
+
+    if (channels == 1) {
+        for (; i + 8 <= samples; i += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), to_s16x8(planes[0] + i));
+        }
+    } else if (channels == 2) {
+        for (; i + 8 <= samples; i += 8) {
+            const __m128i left = to_s16x8(planes[0] + i);
+            const __m128i right = to_s16x8(planes[1] + i);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 2), _mm_unpacklo_epi16(left, right));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 2 + 8), _mm_unpackhi_epi16(left, right));
+        }
+    }
+
+    convert_scalar(planes, dest, channels, i, samples);
+}
+#elif defined(PCM_USE_NEON)
+static int16x8_t to_s16x8(const float *samples) {
+    const float32x4_t low = vdupq_n_f32(-32768.0f);
+    const float32x4_t high = vdupq_n_f32(32767.0f);
+
+    const float32x4_t first = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(samples), 32768.0f), low), high);
+    const float32x4_t second = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(samples + 4), 32768.0f), low), high);
+
+    return vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(first)), vqmovn_s32(vcvtnq_s32_f32(second)));
+}
+
+void convert_f32_planar_to_s16(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t samples) {
+    uint32_t i = 0;
+
+    if (channels == 1) {
+        for (; i + 8 <= samples; i += 8) {
+            vst1q_s16(dest + i, to_s16x8(planes[0] + i));
+        }
+    } else if (channels == 2) {
+        for (; i + 8 <= samples; i += 8) {
+            int16x8x2_t stereo;
+            stereo.val[0] = to_s16x8(planes[0] + i);
+            stereo.val[1] = to_s16x8(planes[1] + i);
+            vst2q_s16(dest + i * 2, stereo);
+        }
+    }
+
+    convert_scalar(planes, dest, channels, i, samples);
+}
+#else
+void convert_f32_planar_to_s16(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t samples) {
+    convert_scalar(planes, dest, channels, 0, samples);
+}
+#endif
+
+void convert_f32_planar_to_s16_scalar(const float *const *planes, int16_t *dest, uint32_t channels, uint32_t samples) {
+    convert_scalar(planes, dest, channels, 0, samples);
+}
@@ -25,27 +25,79 @@ extern "C" {
 #include <libavformat/avformat.h>
 }
 
-#include <cassert>
-#include <chrono>
+#include <algorithm>
 
-uint64_t PlayerState::get_framerate_microseconds() {
-    AVRational rational = format->streams[video_stream_id]->avg_frame_rate;
-    return static_cast<float>(rational.den) / static_cast<float>(rational.num) * 1000000;
+static uint64_t to_milliseconds(const AVStream *stream, int64_t timestamp) {
+    if (timestamp == AV_NOPTS_VALUE || timestamp < 0)
+        return 0;
+
+    return av_rescale_q(timestamp, stream->time_base, AVRational{ 1, 1000 });
 }
 
-DecoderSize PlayerState::get_size() {
-    if (video_context)
-        return { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) };
+static AVCodecContext *open_stream_decoder(AVStream *stream) {
+    AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        LOG_ERROR("No decoder for codec {}.", avcodec_get_name(stream->codecpar->codec_id));
+        return nullptr;
+    }
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(context, stream->codecpar);
+
+    // The frames are only needed some time later, so the delay of frame threading does not matter here
+    if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+        context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        context->thread_count = 0;
+    }
+
+    const int error = avcodec_open2(context, codec, nullptr);
+    if (error < 0) {
+        LOG_ERROR("Failed to open decoder for codec {}: {}.", avcodec_get_name(stream->codecpar->codec_id), codec_error_name(error));
+        avcodec_free_context(&context);
+        return nullptr;
+    }
 
-    return {};
+    return context;
 }
 
-void PlayerState::pop_video() {
-    switch_video(videos_queue.front());
-    videos_queue.pop();
+bool PlayerState::open_video(const std::string &path) {
+    int error = avformat_open_input(&format, path.c_str(), nullptr, nullptr);
+    if (error < 0) {
+        LOG_ERROR("Failed to open video {}: {}.", path, codec_error_name(error));
+        return false;
+    }
+
+    // Load stream info.
+    error = avformat_find_stream_info(format, nullptr);
+    if (error < 0) {
+        LOG_ERROR("Failed to find the streams of video {}: {}.", path, codec_error_name(error));
+        close_video();
+        return false;
+    }
+
+    video_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    audio_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+
+    if (video_stream_id >= 0) {
+        video_context = open_stream_decoder(format->streams[video_stream_id]);
+        if (!video_context)
+            video_stream_id = -1;
+    }
+
+    if (audio_stream_id >= 0) {
+        audio_context = open_stream_decoder(format->streams[audio_stream_id]);
+        if (!audio_context)
+            audio_stream_id = -1;
+    }
+
+    video_drained = false;
+    audio_drained = false;
+    skip_until = 0;
+
+    return true;
 }
 
-void PlayerState::free_video() {
+void PlayerState::close_video() {
     if (video_context) {
         avcodec_close(video_context);
         avcodec_free_context(&video_context);
@@ -72,188 +124,432 @@ void PlayerState::free_video() {
         audio_packets.pop();
     }
 
-    video_playing = "";
+    video_stream_id = -1;
+    audio_stream_id = -1;
 }
 
-void PlayerState::switch_video(const std::string &path) {
-    free_video();
-    video_playing = path;
-
-    int error;
+void PlayerState::seek_video(uint64_t timestamp) {
+    if (!format)
+        return;
 
-    error = avformat_open_input(&format, path.c_str(), nullptr, nullptr);
-    assert(error == 0);
-
-    // Load stream info.
-    error = avformat_find_stream_info(format, nullptr);
-    assert(error >= 0);
+    // Land on the keyframe before the position and decode from there, the frames in between are dropped
+    const int error = av_seek_frame(format, -1, static_cast<int64_t>(timestamp) * (AV_TIME_BASE / 1000), AVSEEK_FLAG_BACKWARD);
+    if (error < 0) {
+        LOG_ERROR("Failed to seek to {}ms: {}.", timestamp, codec_error_name(error));
+        return;
+    }
 
-    video_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
-    audio_stream_id = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (video_context)
+        avcodec_flush_buffers(video_context);
+    if (audio_context)
+        avcodec_flush_buffers(audio_context);
 
-    if (video_stream_id >= 0) {
-        AVStream *video_stream = format->streams[video_stream_id];
-        AVCodec *video_codec = avcodec_find_decoder(video_stream->codecpar->codec_id);
-        video_context = avcodec_alloc_context3(video_codec);
-        avcodec_parameters_to_context(video_context, video_stream->codecpar);
-        avcodec_open2(video_context, video_codec, nullptr);
+    while (!video_packets.empty()) {
+        AVPacket *packet = video_packets.front();
+        av_packet_free(&packet);
+        video_packets.pop();
     }
 
-    if (audio_stream_id >= 0) {
-        AVStream *audio_stream = format->streams[audio_stream_id];
-        AVCodec *audio_codec = avcodec_find_decoder(audio_stream->codecpar->codec_id);
-        audio_context = avcodec_alloc_context3(audio_codec);
-        avcodec_parameters_to_context(audio_context, audio_stream->codecpar);
-        avcodec_open2(audio_context, audio_codec, nullptr);
+    while (!audio_packets.empty()) {
+        AVPacket *packet = audio_packets.front();
+        av_packet_free(&packet);
+        audio_packets.pop();
     }
+
+    video_drained = false;
+    audio_drained = false;
+    skip_until = timestamp;
 }
 
 bool PlayerState::next_packet(int32_t stream_id) {
     std::queue<AVPacket *> &this_queue = stream_id == video_stream_id ? video_packets : audio_packets;
     std::queue<AVPacket *> &other_queue = stream_id != video_stream_id ? video_packets : audio_packets;
+    AVCodecContext *context = stream_id == video_stream_id ? video_context : audio_context;
 
     while (true) {
         if (!this_queue.empty()) {
             AVPacket *this_packet = this_queue.front();
             this_queue.pop();
 
-            if (stream_id == video_stream_id) {
-                int err = avcodec_send_packet(video_context, this_packet);
-                assert(err == 0);
-            }
-
-            if (stream_id == audio_stream_id) {
-                int err = avcodec_send_packet(audio_context, this_packet);
-                assert(err == 0);
-            }
+            const int err = avcodec_send_packet(context, this_packet);
+            LOG_WARN_IF(err < 0, "Failed to send packet to the decoder: {}.", codec_error_name(err));
 
             av_packet_free(&this_packet);
             return true;
         }
 
         AVPacket *packet = av_packet_alloc();
-        if (av_read_frame(format, packet) != 0)
-            return false;
+        if (av_read_frame(format, packet) != 0) {
+            av_packet_free(&packet);
+
+            // Get the frames the decoder still holds out of it
+            bool &drained = stream_id == video_stream_id ? video_drained : audio_drained;
+            if (drained)
+                return false;
+
+            drained = true;
+            avcodec_send_packet(context, nullptr);
+            return true;
+        }
 
         if (packet->stream_index == stream_id) {
             this_queue.push(packet);
-        } else {
+        } else if (packet->stream_index == video_stream_id || packet->stream_index == audio_stream_id) {
             other_queue.push(packet);
+        } else {
+            av_packet_free(&packet);
         }
     }
 }
 
-std::vector<int16_t> PlayerState::receive_audio() {
-    if (audio_stream_id < 0)
-        return {};
+bool PlayerState::decode_audio(PlayerAudioFrame &frame) {
+    AVFrame *av_frame = av_frame_alloc();
+    bool got_frame = false;
 
-    if (video_playing.empty())
-        return {};
-
-    int error;
-    AVFrame *frame = av_frame_alloc();
-    std::vector<int16_t> data;
     while (true) {
-        error = avcodec_receive_frame(audio_context, frame);
+        const int error = avcodec_receive_frame(audio_context, av_frame);
 
         if (error == AVERROR(EAGAIN) && next_packet(audio_stream_id))
             continue;
 
-        if (error != 0) {
-            if (videos_queue.empty()) {
-                // Stop playing videos or
-                video_playing = "";
-                break;
-            } else {
-                // Play the next video (if there is any).
-                switch_video(videos_queue.front());
-                videos_queue.pop();
-                continue;
-            }
-        }
+        if (error != 0)
+            break;
+
+        frame.timestamp = to_milliseconds(format->streams[audio_stream_id], av_frame->best_effort_timestamp);
+        if (frame.timestamp < skip_until)
+            continue;
 
-        LOG_WARN_IF(frame->format != AV_SAMPLE_FMT_FLTP, "Unknown audio format {}.", frame->format);
+        LOG_WARN_IF(av_frame->format != AV_SAMPLE_FMT_FLTP, "Unknown audio format {}.", av_frame->format);
 
-        last_channels = frame->channels;
-        last_sample_count = frame->nb_samples;
-        last_sample_rate = frame->sample_rate;
+        frame.channels = av_frame->channels;
+        frame.sample_count = av_frame->nb_samples;
+        frame.sample_rate = av_frame->sample_rate;
 
-        data.resize(frame->nb_samples * frame->channels);
+        frame.data.resize(av_frame->nb_samples * av_frame->channels);
 
-        for (int a = 0; a < frame->nb_samples; a++) {
-            for (int b = 0; b < frame->channels; b++) {
-                auto *frame_data = reinterpret_cast<float *>(frame->data[b]);
+        for (int a = 0; a < av_frame->nb_samples; a++) {
+            for (int b = 0; b < av_frame->channels; b++) {
+                auto *frame_data = reinterpret_cast<float *>(av_frame->data[b]);
                 float current_sample = frame_data[a];
                 int16_t pcm_sample = current_sample * INT16_MAX;
 
-                data[a * frame->channels + b] = pcm_sample;
+                frame.data[a * av_frame->channels + b] = pcm_sample;
             }
         }
 
+        got_frame = true;
         break;
     }
 
-    av_frame_free(&frame);
-    return data;
+    av_frame_free(&av_frame);
+    return got_frame;
 }
 
-std::vector<uint8_t> PlayerState::receive_video() {
-    if (video_stream_id < 0)
-        return {};
+bool PlayerState::decode_video(PlayerVideoFrame &frame) {
+    AVFrame *av_frame = av_frame_alloc();
+    bool got_frame = false;
 
-    if (video_playing.empty())
-        return {};
-
-    int error;
-    AVFrame *frame = av_frame_alloc();
-    std::vector<uint8_t> data;
     while (true) {
-        error = avcodec_receive_frame(video_context, frame);
+        const int error = avcodec_receive_frame(video_context, av_frame);
 
         if (error == AVERROR(EAGAIN) && next_packet(video_stream_id))
             continue;
 
-        if (error != 0) {
+        if (error != 0)
+            break;
+
+        frame.timestamp = to_milliseconds(format->streams[video_stream_id], av_frame->best_effort_timestamp);
+        if (frame.timestamp < skip_until)
+            continue;
+
+        frame.data.resize(H264DecoderState::buffer_size(
+            { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) }));
+        copy_yuv_data_from_frame(av_frame, frame.data.data());
+
+        got_frame = true;
+        break;
+    }
+
+    av_frame_free(&av_frame);
+    return got_frame;
+}
+
+void PlayerState::decode_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    const auto wants_video = [&] {
+        return !video_ended && (video_frames.size() < MAX_QUEUED_VIDEO_FRAMES);
+    };
+    const auto wants_audio = [&] {
+        return !audio_ended && (audio_frames.size() < MAX_QUEUED_AUDIO_FRAMES);
+    };
+    const auto is_finished = [&] {
+        return !video_playing.empty() && video_ended && audio_ended;
+    };
+
+    while (true) {
+        condvar.wait(lock, [&] {
+            return stop_requested || seek_target || skip_requested || is_opening() || is_finished() || wants_video() || wants_audio();
+        });
+
+        if (stop_requested)
+            break;
+
+        if (seek_target) {
+            const uint64_t target = *seek_target;
+            seek_target.reset();
+
+            lock.unlock();
+            seek_video(target);
+            lock.lock();
+
+            video_ended = video_stream_id < 0;
+            audio_ended = audio_stream_id < 0;
+            continue;
+        }
+
+        if (skip_requested || is_opening() || is_finished()) {
+            skip_requested = false;
+
+            const bool was_playing = !video_playing.empty();
+            video_playing.clear();
+            video_ended = true;
+            audio_ended = true;
+
             if (videos_queue.empty()) {
-                // Stop playing videos or
-                video_playing = "";
-                break;
-            } else {
-                // Play the next video (if there is any).
-                switch_video(videos_queue.front());
-                videos_queue.pop();
+                lock.unlock();
+                close_video();
+                lock.lock();
+
+                condvar.notify_all();
                 continue;
             }
+
+            const std::string path = videos_queue.front();
+            videos_queue.pop();
+            video_playing = path;
+
+            lock.unlock();
+            if (was_playing)
+                close_video();
+            const bool opened = open_video(path);
+            lock.lock();
+
+            if (opened) {
+                video_size = {};
+                framerate_microseconds = 0;
+
+                if (video_stream_id >= 0) {
+                    video_size = { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) };
+
+                    const AVRational rational = format->streams[video_stream_id]->avg_frame_rate;
+                    if (rational.num != 0)
+                        framerate_microseconds = static_cast<uint64_t>(rational.den) * 1000000 / rational.num;
+                }
+
+                video_ended = video_stream_id < 0;
+                audio_ended = audio_stream_id < 0;
+            }
+
+            condvar.notify_all();
+            continue;
         }
 
-        last_timestamp = frame->best_effort_timestamp;
+        // Keep both queues about as full as each other
+        const bool decode_video_frame = wants_video() && (!wants_audio() || video_frames.size() * MAX_QUEUED_AUDIO_FRAMES <= audio_frames.size() * MAX_QUEUED_VIDEO_FRAMES);
+        const uint32_t current_generation = generation;
 
-        data.resize(H264DecoderState::buffer_size(
-            { static_cast<uint32_t>(video_context->width), static_cast<uint32_t>(video_context->height) }));
-        copy_yuv_data_from_frame(frame, data.data());
+        lock.unlock();
 
-        break;
+        PlayerVideoFrame video_frame;
+        PlayerAudioFrame audio_frame;
+        const bool got_frame = decode_video_frame ? decode_video(video_frame) : decode_audio(audio_frame);
+
+        lock.lock();
+
+        // Seeked or skipped while it was decoding
+        if (generation != current_generation)
+            continue;
+
+        if (decode_video_frame) {
+            if (got_frame)
+                video_frames.push_back(std::move(video_frame));
+            else
+                video_ended = true;
+        } else {
+            if (got_frame)
+                audio_frames.push_back(std::move(audio_frame));
+            else
+                audio_ended = true;
+        }
+
+        condvar.notify_all();
+    }
+}
+
+bool PlayerState::is_opening() const {
+    return video_playing.empty() && !videos_queue.empty();
+}
+
+void PlayerState::start_decoding() {
+    if (!decode_thread.joinable()) {
+        stop_requested = false;
+        decode_thread = std::thread(&PlayerState::decode_loop, this);
     }
+}
 
-    av_frame_free(&frame);
-    return data;
+void PlayerState::wait_for_open(std::unique_lock<std::mutex> &lock) {
+    condvar.wait(lock, [&] {
+        return stop_requested || !decode_thread.joinable() || (!is_opening() && !skip_requested);
+    });
+}
+
+DecoderSize PlayerState::get_size() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wait_for_open(lock);
+
+    return video_size;
+}
+
+uint64_t PlayerState::get_framerate_microseconds() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wait_for_open(lock);
+
+    return framerate_microseconds;
+}
+
+bool PlayerState::is_active() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wait_for_open(lock);
+
+    return !video_playing.empty() || !video_frames.empty() || !audio_frames.empty();
 }
 
 void PlayerState::queue(const std::string &path) {
     if (fs::exists(path)) {
         LOG_INFO("Queued video: '{}'.", path);
-        if (video_playing.empty())
-            switch_video(path);
-        else
-            videos_queue.push(path);
+
+        const std::lock_guard<std::mutex> guard(mutex);
+        videos_queue.push(path);
+        start_decoding();
+        condvar.notify_all();
     } else {
         LOG_INFO("Cannot find video: {}", path);
     }
 }
 
+void PlayerState::pop_video() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (videos_queue.empty())
+        return;
+
+    skip_requested = true;
+    video_frames.clear();
+    audio_frames.clear();
+    generation++;
+
+    start_decoding();
+    condvar.notify_all();
+}
+
+void PlayerState::free_video() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stop_requested = true;
+    condvar.notify_all();
+    lock.unlock();
+
+    if (decode_thread.joinable())
+        decode_thread.join();
+
+    // The thread is gone, the decoding state is ours now
+    close_video();
+
+    lock.lock();
+    video_playing.clear();
+    video_size = {};
+    framerate_microseconds = 0;
+    video_frames.clear();
+    audio_frames.clear();
+    video_ended = true;
+    audio_ended = true;
+    skip_requested = false;
+    seek_target.reset();
+    generation++;
+    stop_requested = false;
+}
+
+void PlayerState::seek(uint64_t timestamp) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (video_playing.empty())
+        return;
+
+    seek_target = timestamp;
+    video_frames.clear();
+    audio_frames.clear();
+    generation++;
+
+    last_timestamp = timestamp;
+    condvar.notify_all();
+}
+
+bool PlayerState::receive_video(PlayerVideoFrame &frame) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (video_frames.empty())
+        return false;
+
+    frame = std::move(video_frames.front());
+    video_frames.pop_front();
+    last_timestamp = frame.timestamp;
+
+    condvar.notify_all();
+    return true;
+}
+
+bool PlayerState::receive_audio(PlayerAudioFrame &frame) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    if (audio_frames.empty())
+        return false;
+
+    frame = std::move(audio_frames.front());
+    audio_frames.pop_front();
+    last_channels = frame.channels;
+    last_sample_rate = frame.sample_rate;
+    last_sample_count = frame.sample_count;
+
+    condvar.notify_all();
+    return true;
+}
+
+bool PlayerState::peek_audio(PlayerAudioFrame &info) {
+    std::unique_lock<std::mutex> lock(mutex);
+    wait_for_open(lock);
+
+    condvar.wait(lock, [&] {
+        return stop_requested || !decode_thread.joinable() || !audio_frames.empty() || audio_ended;
+    });
+
+    if (audio_frames.empty())
+        return false;
+
+    const PlayerAudioFrame &next = audio_frames.front();
+    info.timestamp = next.timestamp;
+    info.channels = next.channels;
+    info.sample_rate = next.sample_rate;
+    info.sample_count = next.sample_count;
+
+    return true;
+}
+
+std::size_t PlayerState::queued_video_frames() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return video_frames.size();
+}
+
+std::size_t PlayerState::queued_audio_frames() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return audio_frames.size();
+}
+
 PlayerState::~PlayerState() {
     free_video();
-
-    video_playing = "";
-    videos_queue = {};
 }
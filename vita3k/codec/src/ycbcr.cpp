@@ -0,0 +1,203 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/state.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define YCBCR_USE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define YCBCR_USE_NEON
+#endif
+
+// JFIF coefficients in Q10. They are all even so that NEON can use a doubling multiply.
+static constexpr int16_t CR_TO_R = 1436; // 1.402
+static constexpr int16_t CB_TO_G = 352; // 0.344136
+static constexpr int16_t CR_TO_G = 732; // 0.714136
+static constexpr int16_t CB_TO_B = 1814; // 1.772
+
+// Everything is computed at four times the scale and rounded at the end, like the vector code does with 16-bit lanes
+static int32_t mulhi(int32_t a, int32_t b) {
+    return (a * b) >> 16;
+}
+
+static uint8_t round_channel(int32_t scaled) {
+    return static_cast<uint8_t>(std::clamp((scaled + 2) >> 2, 0, 255));
+}
+
+static void convert_row_scalar(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgba, uint32_t start, uint32_t width, uint32_t h_shift, bool bgra) {
+    for (uint32_t x = start; x < width; x++) {
+        const int32_t luma = y[x] << 2;
+        const int32_t blue_diff = (cb[x >> h_shift] - 128) << 8;
+        const int32_t red_diff = (cr[x >> h_shift] - 128) << 8;
+
+        const uint8_t r = round_channel(luma + mulhi(red_diff, CR_TO_R));
+        const uint8_t g = round_channel(luma - mulhi(blue_diff, CB_TO_G) - mulhi(red_diff, CR_TO_G));
+        const uint8_t b = round_channel(luma + mulhi(blue_diff, CB_TO_B));
+
+        uint8_t *pixel = rgba + x * 4;
+        pixel[0] = bgra ? b : r;
+        pixel[1] = g;
+        pixel[2] = bgra ? r : b;
+        pixel[3] = 0xFF;
+    }
+}
+
+#ifdef YCBCR_USE_SSE2
+// Spread the chroma samples of 8 pixels over 8 bytes
+static __m128i load_chroma(const uint8_t *chroma, uint32_t h_shift) {
+    switch (h_shift) {
+    case 0:
+        return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(chroma));
+    case 1: {
+        int32_t samples;
+        std::memcpy(&samples, chroma, sizeof(samples));
+        const __m128i packed = _mm_cvtsi32_si128(samples);
+        return _mm_unpacklo_epi8(packed, packed);
+    }
+    default: {
+        uint16_t samples;
+        std::memcpy(&samples, chroma, sizeof(samples));
+        __m128i packed = _mm_cvtsi32_si128(samples);
+        packed = _mm_unpacklo_epi8(packed, packed);
+        return _mm_unpacklo_epi8(packed, packed);
+    }
+    }
+}
+
+static void convert_row(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgba, uint32_t width, uint32_t h_shift, bool bgra) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i half = _mm_set1_epi16(2);
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i luma = _mm_slli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + x)), zero), 2);
+        const __m128i blue_diff = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(load_chroma(cb + (x >> h_shift), h_shift), zero), bias), 8);
+        const __m128i red_diff = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(load_chroma(cr + (x >> h_shift), h_shift), zero), bias), 8);
+
+        __m128i r = _mm_add_epi16(luma, _mm_mulhi_epi16(red_diff, _mm_set1_epi16(CR_TO_R)));
+        __m128i g = _mm_sub_epi16(_mm_sub_epi16(luma, _mm_mulhi_epi16(blue_diff, _mm_set1_epi16(CB_TO_G))), _mm_mulhi_epi16(red_diff, _mm_set1_epi16(CR_TO_G)));
+        __m128i b = _mm_add_epi16(luma, _mm_mulhi_epi16(blue_diff, _mm_set1_epi16(CB_TO_B)));
+
+        r = _mm_srai_epi16(_mm_add_epi16(r, half), 2);
+        g = _mm_srai_epi16(_mm_add_epi16(g, half), 2);
+        b = _mm_srai_epi16(_mm_add_epi16(b, half), 2);
+
+        const __m128i first = bgra ? _mm_packus_epi16(b, b) : _mm_packus_epi16(r, r);
+        const __m128i third = bgra ? _mm_packus_epi16(r, r) : _mm_packus_epi16(b, b);
+        const __m128i first_second = _mm_unpacklo_epi8(first, _mm_packus_epi16(g, g));
+        const __m128i third_alpha = _mm_unpacklo_epi8(third, alpha);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + x * 4), _mm_unpacklo_epi16(first_second, third_alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + x * 4 + 16), _mm_unpackhi_epi16(first_second, third_alpha));
+    }
+
+    convert_row_scalar(y, cb, cr, rgba, x, width, h_shift, bgra);
+}
+#elif defined(YCBCR_USE_NEON)
+static uint8x8_t load_chroma(const uint8_t *chroma, uint32_t h_shift) {
+    switch (h_shift) {
+    case 0:
+        return vld1_u8(chroma);
+    case 1: {
+        uint32_t samples;
+        std::memcpy(&samples, chroma, sizeof(samples));
+        const uint8x8_t packed = vreinterpret_u8_u32(vdup_n_u32(samples));
+        return vzip1_u8(packed, packed);
+    }
+    default: {
+        uint16_t samples;
+        std::memcpy(&samples, chroma, sizeof(samples));
+        uint8x8_t packed = vreinterpret_u8_u16(vdup_n_u16(samples));
+        packed = vzip1_u8(packed, packed);
+        return vzip1_u8(packed, packed);
+    }
+    }
+}
+
+static void convert_row(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgba, uint32_t width, uint32_t h_shift, bool bgra) {
+    const int16x8_t bias = vdupq_n_s16(128);
+    const int16x8_t half = vdupq_n_s16(2);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const int16x8_t luma = vshlq_n_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + x))), 2);
+        const int16x8_t blue_diff = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(load_chroma(cb + (x >> h_shift), h_shift))), bias), 8);
+        const int16x8_t red_diff = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(load_chroma(cr + (x >> h_shift), h_shift))), bias), 8);
+
+        // vqdmulh doubles the product, so half the coefficients give the same result as the SSE2 mulhi
+        int16x8_t r = vaddq_s16(luma, vqdmulhq_n_s16(red_diff, CR_TO_R / 2));
+        int16x8_t g = vsubq_s16(vsubq_s16(luma, vqdmulhq_n_s16(blue_diff, CB_TO_G / 2)), vqdmulhq_n_s16(red_diff, CR_TO_G / 2));
+        int16x8_t b = vaddq_s16(luma, vqdmulhq_n_s16(blue_diff, CB_TO_B / 2));
+
+        r = vshrq_n_s16(vaddq_s16(r, half), 2);
+        g = vshrq_n_s16(vaddq_s16(g, half), 2);
+        b = vshrq_n_s16(vaddq_s16(b, half), 2);
+
+        uint8x8x4_t pixels;
+        pixels.val[0] = bgra ? vqmovun_s16(b) : vqmovun_s16(r);
+        pixels.val[1] = vqmovun_s16(g);
+        pixels.val[2] = bgra ? vqmovun_s16(r) : vqmovun_s16(b);
+        pixels.val[3] = vdup_n_u8(0xFF);
+        vst4_u8(rgba + x * 4, pixels);
+    }
+
+    convert_row_scalar(y, cb, cr, rgba, x, width, h_shift, bgra);
+}
+#else
+static void convert_row(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *rgba, uint32_t width, uint32_t h_shift, bool bgra) {
+    convert_row_scalar(y, cb, cr, rgba, 0, width, h_shift, bgra);
+}
+#endif
+
+uint32_t ycbcr_buffer_size(uint32_t width, uint32_t height, YCbCrSampling sampling) {
+    const uint32_t chroma_width = (width + (1 << sampling.h_shift) - 1) >> sampling.h_shift;
+    const uint32_t chroma_height = (height + (1 << sampling.v_shift) - 1) >> sampling.v_shift;
+    return width * height + chroma_width * chroma_height * 2;
+}
+
+template <typename ConvertRow>
+static void convert_planes(const uint8_t *ycbcr, uint8_t *rgba, uint32_t width, uint32_t height, uint32_t rgba_pitch, YCbCrSampling sampling, ConvertRow convert) {
+    const uint32_t chroma_width = (width + (1 << sampling.h_shift) - 1) >> sampling.h_shift;
+    const uint32_t chroma_height = (height + (1 << sampling.v_shift) - 1) >> sampling.v_shift;
+
+    const uint8_t *cb = ycbcr + width * height;
+    const uint8_t *cr = cb + chroma_width * chroma_height;
+
+    for (uint32_t row = 0; row < height; row++) {
+        const uint32_t chroma_row = row >> sampling.v_shift;
+        convert(ycbcr + row * width, cb + chroma_row * chroma_width, cr + chroma_row * chroma_width, rgba + row * rgba_pitch * 4);
+    }
+}
+
+void convert_ycbcr_to_rgba(const uint8_t *ycbcr, uint8_t *rgba, uint32_t width, uint32_t height, uint32_t rgba_pitch, YCbCrSampling sampling, bool bgra) {
+    convert_planes(ycbcr, rgba, width, height, rgba_pitch, sampling, [&](const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *out) {
+        convert_row(y, cb, cr, out, width, sampling.h_shift, bgra);
+    });
+}
+
+void convert_ycbcr_to_rgba_scalar(const uint8_t *ycbcr, uint8_t *rgba, uint32_t width, uint32_t height, uint32_t rgba_pitch, YCbCrSampling sampling, bool bgra) {
+    convert_planes(ycbcr, rgba, width, height, rgba_pitch, sampling, [&](const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *out) {
+        convert_row_scalar(y, cb, cr, out, 0, width, sampling.h_shift, bgra);
+    });
+}
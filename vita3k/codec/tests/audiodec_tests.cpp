@@ -0,0 +1,254 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/state.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr int SAMPLE_RATE = 48000;
+constexpr int CHANNELS = 2;
+constexpr int AAC_FRAME_COUNT = 40;
+constexpr uint32_t AAC_MAX_ES_SIZE = 1536 + 0x100;
+
+// Wrap a raw AAC LC frame in an ADTS header, the way games hand them to the decoder
+void append_adts_frame(std::vector<uint8_t> &stream, const uint8_t *data, int size) {
+    const int length = size + 7;
+    constexpr int sample_rate_index = 3; // 48000
+
+    const uint8_t header[] = {
+        0xFF,
+        0xF1,
+        static_cast<uint8_t>((1 << 6) | (sample_rate_index << 2) | (CHANNELS >> 2)),
+        static_cast<uint8_t>(((CHANNELS & 3) << 6) | (length >> 11)),
+        static_cast<uint8_t>((length >> 3) & 0xFF),
+        static_cast<uint8_t>(((length & 7) << 5) | 0x1F),
+        0xFC,
+    };
+
+    stream.insert(stream.end(), std::begin(header), std::end(header));
+    stream.insert(stream.end(), data, data + size);
+}
+
+// Encode a stereo sine as ADTS. Returns nothing if the FFmpeg build has no AAC encoder.
+std::vector<uint8_t> generate_aac_stream() {
+    std::vector<uint8_t> stream;
+
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!codec)
+        return stream;
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    context->sample_rate = SAMPLE_RATE;
+    context->channels = CHANNELS;
+    context->channel_layout = AV_CH_LAYOUT_STEREO;
+    context->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    context->bit_rate = 128000;
+
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return stream;
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_SAMPLE_FMT_FLTP;
+    frame->channel_layout = AV_CH_LAYOUT_STEREO;
+    frame->channels = CHANNELS;
+    frame->sample_rate = SAMPLE_RATE;
+    frame->nb_samples = context->frame_size;
+    av_frame_get_buffer(frame, 0);
+
+    AVPacket *packet = av_packet_alloc();
+    const auto receive_packets = [&] {
+        while (avcodec_receive_packet(context, packet) == 0) {
+            append_adts_frame(stream, packet->data, packet->size);
+            av_packet_unref(packet);
+        }
+    };
+
+    int position = 0;
+    for (int i = 0; i < AAC_FRAME_COUNT; i++) {
+        av_frame_make_writable(frame);
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            float *samples = reinterpret_cast<float *>(frame->data[ch]);
+            for (int s = 0; s < frame->nb_samples; s++)
+                samples[s] = 0.5f * std::sin((position + s) * (ch + 1) * 0.02f);
+        }
+
+        frame->pts = position;
+        position += frame->nb_samples;
+        avcodec_send_frame(context, frame);
+        receive_packets();
+    }
+
+    avcodec_send_frame(context, nullptr);
+    receive_packets();
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+
+    return stream;
+}
+
+// 48 kHz mono with 256-byte frames and one frame per superframe, as LibAtrac9 reads it
+constexpr uint32_t AT9_CONFIG_DATA = 0xE01F70FE;
+constexpr uint32_t AT9_FRAME_SIZE = 256;
+
+// LibAtrac9 can only decode, so the stream is made of frames where every field takes its first value
+std::vector<uint8_t> generate_atrac9_stream(uint32_t frame_count) {
+    return std::vector<uint8_t>(frame_count * AT9_FRAME_SIZE, 0);
+}
+
+std::vector<float> random_samples(uint32_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> sample(-1.5f, 1.5f);
+
+    std::vector<float> samples(count);
+    for (float &value : samples)
+        value = sample(rng);
+
+    return samples;
+}
+} // namespace
+
+TEST(audiodec, convert_matches_scalar) {
+    for (uint32_t channels = 1; channels <= 3; channels++) {
+        for (const uint32_t samples : { 1u, 7u, 8u, 9u, 1023u, 1024u }) {
+            std::vector<std::vector<float>> planes;
+            std::vector<const float *> plane_pointers;
+            for (uint32_t ch = 0; ch < channels; ch++) {
+                planes.push_back(random_samples(samples, channels * 100 + ch + samples));
+                plane_pointers.push_back(planes.back().data());
+            }
+
+            std::vector<int16_t> expected(samples * channels);
+            std::vector<int16_t> result(samples * channels);
+            convert_f32_planar_to_s16_scalar(plane_pointers.data(), expected.data(), channels, samples);
+            convert_f32_planar_to_s16(plane_pointers.data(), result.data(), channels, samples);
+
+            ASSERT_EQ(result, expected) << channels << " channels, " << samples << " samples";
+        }
+    }
+}
+
+TEST(audiodec, convert_rounds_and_clips) {
+    const std::vector<float> left = { 0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.5f / 32768.0f, 1.5f / 32768.0f, -0.25f, 0.999f };
+    const std::vector<float> right = { 0.5f, -0.5f, 1.0f / 32768.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    const float *planes[] = { left.data(), right.data() };
+
+    std::vector<int16_t> result(left.size() * 2);
+    convert_f32_planar_to_s16(planes, result.data(), 2, static_cast<uint32_t>(left.size()));
+
+    const std::vector<int16_t> expected = {
+        0, 16384,
+        32767, -16384,
+        -32768, 1,
+        32767, 0,
+        -32768, 0,
+        0, 0, // ties go to even, like lrintf
+        2, 0,
+        -8192, 0,
+        32735, 0
+    };
+    ASSERT_EQ(result, expected);
+}
+
+TEST(audiodec, aac_batch_matches_single_frames) {
+    const std::vector<uint8_t> stream = generate_aac_stream();
+    if (stream.empty())
+        GTEST_SKIP() << "This FFmpeg build can't encode AAC";
+
+    // Enough room for the last frame to be read with the maximum size
+    std::vector<uint8_t> padded(stream);
+    padded.resize(stream.size() + AAC_MAX_ES_SIZE + AV_INPUT_BUFFER_PADDING_SIZE);
+
+    AacDecoderState single(SAMPLE_RATE, CHANNELS);
+    std::vector<uint8_t> expected;
+    uint32_t offset = 0;
+    uint32_t frames = 0;
+    while (offset < stream.size()) {
+        DecoderSize size;
+        ASSERT_TRUE(single.send(padded.data() + offset, AAC_MAX_ES_SIZE));
+        ASSERT_TRUE(single.receive(nullptr, &size));
+
+        const std::size_t old_size = expected.size();
+        expected.resize(old_size + size.samples * CHANNELS * sizeof(int16_t));
+        single.receive(expected.data() + old_size, &size);
+
+        offset += std::min(single.get_es_size(), AAC_MAX_ES_SIZE);
+        frames++;
+    }
+
+    AacDecoderState batched(SAMPLE_RATE, CHANNELS);
+    std::vector<uint8_t> result(expected.size());
+    DecoderBatch batch;
+    ASSERT_TRUE(batched.decode_frames(padded.data(), AAC_MAX_ES_SIZE, result.data(), frames, batch));
+
+    ASSERT_EQ(batch.frames, frames);
+    ASSERT_EQ(batch.es_size, offset);
+    ASSERT_EQ(batch.samples * CHANNELS * sizeof(int16_t), expected.size());
+    ASSERT_EQ(result, expected);
+}
+
+TEST(audiodec, atrac9_benchmark) {
+    constexpr uint32_t frame_count = 2000;
+    constexpr uint32_t frames_per_call = 8;
+    const std::vector<uint8_t> stream = generate_atrac9_stream(frame_count);
+
+    Atrac9DecoderState single(AT9_CONFIG_DATA);
+    if ((single.get(DecoderQuery::AT9_SUPERFRAME_SIZE) != AT9_FRAME_SIZE) || !single.send(stream.data(), AT9_FRAME_SIZE))
+        GTEST_SKIP() << "LibAtrac9 doesn't take the synthetic stream";
+    single.clear_context();
+
+    const uint32_t frame_bytes = single.get(DecoderQuery::AT9_SAMPLE_PER_FRAME) * single.get(DecoderQuery::CHANNELS) * sizeof(int16_t);
+    std::vector<uint8_t> expected(frame_count * frame_bytes);
+    std::vector<uint8_t> result(frame_count * frame_bytes);
+
+    using clock = std::chrono::steady_clock;
+
+    const auto single_start = clock::now();
+    for (uint32_t i = 0; i < frame_count; i++) {
+        ASSERT_TRUE(single.send(stream.data() + i * AT9_FRAME_SIZE, AT9_FRAME_SIZE));
+        ASSERT_TRUE(single.receive(expected.data() + i * frame_bytes, nullptr));
+    }
+    const auto single_time = std::chrono::duration<double>(clock::now() - single_start).count();
+
+    Atrac9DecoderState batched(AT9_CONFIG_DATA);
+    const auto batch_start = clock::now();
+    for (uint32_t i = 0; i < frame_count; i += frames_per_call) {
+        DecoderBatch batch;
+        ASSERT_TRUE(batched.decode_frames(stream.data() + i * AT9_FRAME_SIZE, AT9_FRAME_SIZE, result.data() + i * frame_bytes, frames_per_call, batch));
+        ASSERT_EQ(batch.es_size, frames_per_call * AT9_FRAME_SIZE);
+    }
+    const auto batch_time = std::chrono::duration<double>(clock::now() - batch_start).count();
+
+    ASSERT_EQ(result, expected);
+
+    std::printf("atrac9 x%u: %.0f frames/s one by one, %.0f frames/s by %u\n", frame_count,
+        frame_count / single_time, frame_count / batch_time, frames_per_call);
+}
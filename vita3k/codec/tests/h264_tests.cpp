@@ -0,0 +1,242 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/state.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr int WIDTH = 960;
+constexpr int HEIGHT = 544;
+constexpr int FRAME_COUNT = 60;
+
+// Encode a moving gradient as an Annex B stream, one packet per access unit.
+// Returns nothing if the FFmpeg build has no H264 encoder.
+std::vector<std::vector<uint8_t>> generate_stream() {
+    std::vector<std::vector<uint8_t>> access_units;
+
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec)
+        return access_units;
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    context->width = WIDTH;
+    context->height = HEIGHT;
+    context->time_base = { 1, 30 };
+    context->framerate = { 30, 1 };
+    context->pix_fmt = AV_PIX_FMT_YUV420P;
+    context->gop_size = 30;
+    context->max_b_frames = 0;
+
+    AVDictionary *options = nullptr;
+    av_dict_set(&options, "preset", "ultrafast", 0);
+    // Several slices per picture, so slice threading has something to work with
+    av_dict_set(&options, "slices", "4", 0);
+
+    const int error = avcodec_open2(context, codec, &options);
+    av_dict_free(&options);
+    if (error < 0) {
+        avcodec_free_context(&context);
+        return access_units;
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = WIDTH;
+    frame->height = HEIGHT;
+    av_frame_get_buffer(frame, 0);
+
+    AVPacket *packet = av_packet_alloc();
+    const auto receive_packets = [&] {
+        while (avcodec_receive_packet(context, packet) == 0) {
+            access_units.emplace_back(packet->data, packet->data + packet->size);
+            av_packet_unref(packet);
+        }
+    };
+
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        av_frame_make_writable(frame);
+        for (int y = 0; y < HEIGHT; y++)
+            for (int x = 0; x < WIDTH; x++)
+                frame->data[0][y * frame->linesize[0] + x] = static_cast<uint8_t>(x + y + i * 4);
+        for (int plane = 1; plane < 3; plane++)
+            for (int y = 0; y < HEIGHT / 2; y++)
+                std::memset(frame->data[plane] + y * frame->linesize[plane], 128 + plane * 16 - i, WIDTH / 2);
+
+        frame->pts = i;
+        avcodec_send_frame(context, frame);
+        receive_packets();
+    }
+
+    avcodec_send_frame(context, nullptr);
+    receive_packets();
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+
+    return access_units;
+}
+
+// Decode every access unit and return all the pictures back to back
+std::vector<uint8_t> decode_stream(H264DecoderState &decoder, const std::vector<std::vector<uint8_t>> &access_units) {
+    const uint32_t picture_size = H264DecoderState::buffer_size({ WIDTH, HEIGHT });
+    std::vector<uint8_t> result;
+    std::vector<uint8_t> picture(picture_size);
+
+    for (const auto &access_unit : access_units) {
+        if (decoder.send(access_unit.data(), static_cast<uint32_t>(access_unit.size())) && decoder.receive(picture.data()))
+            result.insert(result.end(), picture.begin(), picture.end());
+    }
+
+    return result;
+}
+
+struct FrameMemory {
+    std::vector<uint8_t> storage;
+    uint8_t *data;
+    uint32_t size;
+};
+
+// Frame memory starting offset bytes past a 64 bytes boundary
+FrameMemory make_frame_memory(const std::size_t offset = 0) {
+    FrameMemory memory;
+    // Room for the decoder's references and some alignment padding
+    memory.size = (H264DecoderState::buffer_size({ WIDTH, HEIGHT }) + 0x10000) * 16;
+    memory.storage.resize(memory.size + 64 + offset);
+
+    const uintptr_t start = reinterpret_cast<uintptr_t>(memory.storage.data());
+    memory.data = memory.storage.data() + ((64 - start % 64) % 64) + offset;
+    return memory;
+}
+} // namespace
+
+TEST(h264, copy_padded_planes) {
+    AVFrame *frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = 50;
+    frame->height = 20;
+    ASSERT_EQ(av_frame_get_buffer(frame, 64), 0);
+    ASSERT_GT(frame->linesize[0], frame->width);
+
+    for (int plane = 0; plane < 3; plane++) {
+        const int height = (plane == 0) ? frame->height : frame->height / 2;
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < frame->linesize[plane]; x++)
+                frame->data[plane][y * frame->linesize[plane] + x] = static_cast<uint8_t>(plane * 64 + y + x);
+    }
+
+    std::vector<uint8_t> output(H264DecoderState::buffer_size({ 50, 20 }));
+    copy_yuv_data_from_frame(frame, output.data());
+
+    const uint8_t *dest = output.data();
+    for (int plane = 0; plane < 3; plane++) {
+        const int width = (plane == 0) ? frame->width : frame->width / 2;
+        const int height = (plane == 0) ? frame->height : frame->height / 2;
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                ASSERT_EQ(*(dest++), static_cast<uint8_t>(plane * 64 + y + x));
+    }
+
+    av_frame_free(&frame);
+}
+
+TEST(h264, copy_packed_planes) {
+    constexpr int width = 64;
+    constexpr int height = 16;
+
+    // Planes laid out exactly like the output, as when decoding into frame memory
+    std::vector<uint8_t> memory(H264DecoderState::buffer_size({ width, height }));
+    for (std::size_t i = 0; i < memory.size(); i++)
+        memory[i] = static_cast<uint8_t>(i * 7);
+
+    AVFrame *frame = av_frame_alloc();
+    frame->width = width;
+    frame->height = height;
+    frame->data[0] = memory.data();
+    frame->data[1] = memory.data() + width * height;
+    frame->data[2] = memory.data() + width * height * 5 / 4;
+    frame->linesize[0] = width;
+    frame->linesize[1] = width / 2;
+    frame->linesize[2] = width / 2;
+
+    std::vector<uint8_t> output(memory.size());
+    copy_yuv_data_from_frame(frame, output.data());
+    ASSERT_EQ(output, memory);
+
+    av_frame_free(&frame);
+}
+
+TEST(h264, frame_memory_gives_same_pictures) {
+    const auto access_units = generate_stream();
+    if (access_units.empty())
+        GTEST_SKIP() << "This FFmpeg build can't encode H264";
+
+    H264DecoderState reference(WIDTH, HEIGHT);
+    const std::vector<uint8_t> expected = decode_stream(reference, access_units);
+    ASSERT_EQ(expected.size(), H264DecoderState::buffer_size({ WIDTH, HEIGHT }) * FRAME_COUNT);
+
+    FrameMemory frame_memory = make_frame_memory();
+    H264DecoderState decoder(WIDTH, HEIGHT, frame_memory.data, frame_memory.size);
+    ASSERT_EQ(decode_stream(decoder, access_units), expected);
+    ASSERT_NE(decoder.frame_slot_size, 0u);
+}
+
+TEST(h264, unaligned_frame_memory_is_not_used) {
+    const auto access_units = generate_stream();
+    if (access_units.empty())
+        GTEST_SKIP() << "This FFmpeg build can't encode H264";
+
+    H264DecoderState reference(WIDTH, HEIGHT);
+    const std::vector<uint8_t> expected = decode_stream(reference, access_units);
+
+    FrameMemory frame_memory = make_frame_memory(16);
+    H264DecoderState decoder(WIDTH, HEIGHT, frame_memory.data, frame_memory.size);
+    ASSERT_EQ(decode_stream(decoder, access_units), expected);
+    ASSERT_EQ(decoder.frame_slot_size, 0u);
+}
+
+TEST(h264, benchmark) {
+    const auto access_units = generate_stream();
+    if (access_units.empty())
+        GTEST_SKIP() << "This FFmpeg build can't encode H264";
+
+    using clock = std::chrono::steady_clock;
+
+    const auto host_start = clock::now();
+    H264DecoderState host_decoder(WIDTH, HEIGHT);
+    decode_stream(host_decoder, access_units);
+    const auto host_time = std::chrono::duration<double>(clock::now() - host_start).count();
+
+    FrameMemory frame_memory = make_frame_memory();
+    const auto guest_start = clock::now();
+    H264DecoderState guest_decoder(WIDTH, HEIGHT, frame_memory.data, frame_memory.size);
+    decode_stream(guest_decoder, access_units);
+    const auto guest_time = std::chrono::duration<double>(clock::now() - guest_start).count();
+
+    std::printf("h264 %dx%d x%d: %.0f fps in host buffers, %.0f fps in frame memory (%s)\n", WIDTH, HEIGHT, FRAME_COUNT,
+        FRAME_COUNT / host_time, FRAME_COUNT / guest_time, guest_decoder.frame_slot_size ? "used" : "not used, unaligned");
+}
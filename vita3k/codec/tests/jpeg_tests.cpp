@@ -0,0 +1,300 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/state.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr YCbCrSampling SAMPLINGS[] = {
+    { 0, 0 }, // 4:4:4
+    { 1, 0 }, // 4:2:2
+    { 1, 1 }, // 4:2:0
+    { 2, 0 }, // 4:1:1
+};
+
+std::vector<uint8_t> random_planes(uint32_t width, uint32_t height, YCbCrSampling sampling) {
+    std::mt19937 rng(width * 31 + height);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    std::vector<uint8_t> planes(ycbcr_buffer_size(width, height, sampling));
+    for (uint8_t &value : planes)
+        value = static_cast<uint8_t>(byte(rng));
+
+    return planes;
+}
+
+// Encode a single gradient picture with the given chroma layout.
+// Returns nothing if the FFmpeg build has no MJPEG encoder.
+std::vector<uint8_t> generate_jpeg(AVPixelFormat format, int width, int height) {
+    std::vector<uint8_t> jpeg;
+
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    if (!codec)
+        return jpeg;
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    context->width = width;
+    context->height = height;
+    context->time_base = { 1, 30 };
+    context->pix_fmt = format;
+
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return jpeg;
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    av_frame_get_buffer(frame, 0);
+
+    int chroma_h_shift = 0;
+    int chroma_v_shift = 0;
+    av_pix_fmt_get_chroma_sub_sample(format, &chroma_h_shift, &chroma_v_shift);
+
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            frame->data[0][y * frame->linesize[0] + x] = static_cast<uint8_t>(x * 2 + y);
+    for (int plane = 1; plane < 3; plane++)
+        for (int y = 0; y < AV_CEIL_RSHIFT(height, chroma_v_shift); y++)
+            for (int x = 0; x < AV_CEIL_RSHIFT(width, chroma_h_shift); x++)
+                frame->data[plane][y * frame->linesize[plane] + x] = static_cast<uint8_t>(plane * 80 + x - y);
+
+    AVPacket *packet = av_packet_alloc();
+    if ((avcodec_send_frame(context, frame) == 0) && (avcodec_receive_packet(context, packet) == 0))
+        jpeg.assign(packet->data, packet->data + packet->size);
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+
+    return jpeg;
+}
+
+// Decode with FFmpeg directly, packing the planes the way the decoder state does
+std::vector<uint8_t> reference_decode(const std::vector<uint8_t> &jpeg, YCbCrSampling sampling) {
+    AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    avcodec_open2(context, codec, nullptr);
+
+    std::vector<uint8_t> padded(jpeg.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+    std::memcpy(padded.data(), jpeg.data(), jpeg.size());
+
+    AVPacket *packet = av_packet_alloc();
+    packet->data = padded.data();
+    packet->size = static_cast<int>(jpeg.size());
+
+    AVFrame *frame = av_frame_alloc();
+    std::vector<uint8_t> planes;
+    if ((avcodec_send_packet(context, packet) == 0) && (avcodec_receive_frame(context, frame) == 0)) {
+        const int widths[] = { frame->width, AV_CEIL_RSHIFT(frame->width, static_cast<int>(sampling.h_shift)) };
+        const int heights[] = { frame->height, AV_CEIL_RSHIFT(frame->height, static_cast<int>(sampling.v_shift)) };
+
+        for (int plane = 0; plane < 3; plane++) {
+            const int index = (plane == 0) ? 0 : 1;
+            for (int y = 0; y < heights[index]; y++) {
+                const uint8_t *row = frame->data[plane] + y * frame->linesize[plane];
+                planes.insert(planes.end(), row, row + widths[index]);
+            }
+        }
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&context);
+
+    return planes;
+}
+} // namespace
+
+TEST(jpeg, csc_matches_scalar) {
+    for (const YCbCrSampling sampling : SAMPLINGS) {
+        for (uint32_t width = 1; width <= 40; width += 3) {
+            constexpr uint32_t height = 5;
+            const uint32_t pitch = width + 3;
+            const std::vector<uint8_t> planes = random_planes(width, height, sampling);
+
+            for (const bool bgra : { false, true }) {
+                std::vector<uint8_t> expected(pitch * height * 4, 0xCD);
+                std::vector<uint8_t> result(pitch * height * 4, 0xCD);
+
+                convert_ycbcr_to_rgba_scalar(planes.data(), expected.data(), width, height, pitch, sampling, bgra);
+                convert_ycbcr_to_rgba(planes.data(), result.data(), width, height, pitch, sampling, bgra);
+
+                ASSERT_EQ(result, expected) << "width " << width << ", shifts " << sampling.h_shift << "/" << sampling.v_shift << ", bgra " << bgra;
+            }
+        }
+    }
+}
+
+TEST(jpeg, csc_close_to_swscale) {
+    constexpr int width = 64;
+    constexpr int height = 32;
+    const std::vector<uint8_t> planes = random_planes(width, height, {});
+
+    std::vector<uint8_t> result(width * height * 4);
+    convert_ycbcr_to_rgba(planes.data(), result.data(), width, height, width, {}, false);
+
+    SwsContext *context = sws_getContext(width, height, AV_PIX_FMT_YUVJ444P, width, height, AV_PIX_FMT_RGBA,
+        SWS_POINT | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT, nullptr, nullptr, nullptr);
+    ASSERT_NE(context, nullptr);
+
+    const uint8_t *slices[] = { &planes[0], &planes[width * height], &planes[width * height * 2] };
+    const int strides[] = { width, width, width };
+    std::vector<uint8_t> expected(width * height * 4);
+    uint8_t *dst_slices[] = { expected.data() };
+    const int dst_strides[] = { width * 4 };
+
+    ASSERT_EQ(sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides), height);
+    sws_freeContext(context);
+
+    for (std::size_t i = 0; i < result.size(); i++)
+        ASSERT_LE(std::abs(result[i] - expected[i]), 2) << "at byte " << i;
+}
+
+TEST(jpeg, csc_chroma_layout) {
+    // Each Y sample must use the chroma sample covering it
+    constexpr uint32_t width = 12;
+    constexpr uint32_t height = 4;
+    const YCbCrSampling sampling = { 2, 1 };
+
+    std::vector<uint8_t> planes(ycbcr_buffer_size(width, height, sampling), 128);
+    uint8_t *cr = planes.data() + width * height + 3 * 2;
+    cr[1] = 200;
+
+    std::vector<uint8_t> result(width * height * 4);
+    convert_ycbcr_to_rgba(planes.data(), result.data(), width, height, width, sampling, false);
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            const uint8_t expected = ((y < 2) && (x >= 4) && (x < 8)) ? 229 : 128;
+            ASSERT_EQ(result[(y * width + x) * 4], expected) << x << ", " << y;
+            ASSERT_EQ(result[(y * width + x) * 4 + 3], 0xFF);
+        }
+    }
+}
+
+TEST(jpeg, decode_native_sampling) {
+    const struct {
+        AVPixelFormat format;
+        YCbCrSampling sampling;
+    } cases[] = {
+        { AV_PIX_FMT_YUVJ444P, { 0, 0 } },
+        { AV_PIX_FMT_YUVJ422P, { 1, 0 } },
+        { AV_PIX_FMT_YUVJ420P, { 1, 1 } },
+    };
+
+    // Odd sizes, so the chroma planes are rounded up
+    constexpr int width = 67;
+    constexpr int height = 35;
+
+    MjpegDecoderState decoder;
+    for (const auto &test : cases) {
+        const std::vector<uint8_t> jpeg = generate_jpeg(test.format, width, height);
+        if (jpeg.empty())
+            GTEST_SKIP() << "This FFmpeg build can't encode MJPEG";
+
+        const std::vector<uint8_t> expected = reference_decode(jpeg, test.sampling);
+        ASSERT_EQ(expected.size(), ycbcr_buffer_size(width, height, test.sampling));
+
+        std::vector<uint8_t> planes(width * height * 3);
+        DecoderSize size = {};
+        ASSERT_TRUE(decoder.send(jpeg.data(), static_cast<uint32_t>(jpeg.size())));
+        ASSERT_TRUE(decoder.receive(planes.data(), &size));
+
+        ASSERT_EQ(size.width, width);
+        ASSERT_EQ(size.height, height);
+        ASSERT_EQ(decoder.sampling.h_shift, test.sampling.h_shift);
+        ASSERT_EQ(decoder.sampling.v_shift, test.sampling.v_shift);
+
+        planes.resize(expected.size());
+        ASSERT_EQ(planes, expected);
+    }
+}
+
+TEST(jpeg, size_first_then_picture) {
+    constexpr int width = 67;
+    constexpr int height = 35;
+
+    const std::vector<uint8_t> jpeg = generate_jpeg(AV_PIX_FMT_YUVJ420P, width, height);
+    if (jpeg.empty())
+        GTEST_SKIP() << "This FFmpeg build can't encode MJPEG";
+
+    const std::vector<uint8_t> expected = reference_decode(jpeg, { 1, 1 });
+
+    // The picture asked for without a buffer is the one given out next, without sending it again
+    MjpegDecoderState decoder;
+    DecoderSize size = {};
+    ASSERT_TRUE(decoder.send(jpeg.data(), static_cast<uint32_t>(jpeg.size())));
+    ASSERT_TRUE(decoder.receive(nullptr, &size));
+    ASSERT_EQ(size.width, width);
+    ASSERT_EQ(size.height, height);
+
+    std::vector<uint8_t> planes(ycbcr_buffer_size(size.width, size.height, decoder.sampling));
+    ASSERT_TRUE(decoder.receive(planes.data(), &size));
+    ASSERT_EQ(planes, expected);
+
+    // A picture only sized is dropped by the next send
+    ASSERT_TRUE(decoder.send(jpeg.data(), static_cast<uint32_t>(jpeg.size())));
+    ASSERT_TRUE(decoder.receive(nullptr, &size));
+    ASSERT_TRUE(decoder.send(jpeg.data(), static_cast<uint32_t>(jpeg.size())));
+    ASSERT_TRUE(decoder.receive(planes.data(), &size));
+    ASSERT_EQ(planes, expected);
+    ASSERT_FALSE(decoder.receive(planes.data(), &size));
+}
+
+TEST(jpeg, benchmark) {
+    constexpr uint32_t width = 960;
+    constexpr uint32_t height = 544;
+    constexpr int iterations = 100;
+    const YCbCrSampling sampling = { 1, 1 };
+
+    const std::vector<uint8_t> planes = random_planes(width, height, sampling);
+    std::vector<uint8_t> rgba(width * height * 4);
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    for (int i = 0; i < iterations; i++)
+        convert_ycbcr_to_rgba_scalar(planes.data(), rgba.data(), width, height, width, sampling, false);
+    const auto scalar_time = clock::now() - start;
+
+    start = clock::now();
+    for (int i = 0; i < iterations; i++)
+        convert_ycbcr_to_rgba(planes.data(), rgba.data(), width, height, width, sampling, false);
+    const auto vector_time = clock::now() - start;
+
+    const auto to_us = [](auto duration) {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    };
+
+    std::printf("%d csc of %ux%u 4:2:0: scalar %lld us, vector %lld us\n", iterations, width, height, to_us(scalar_time), to_us(vector_time));
+}
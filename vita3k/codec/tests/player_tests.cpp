@@ -0,0 +1,297 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/state.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+namespace {
+constexpr int WIDTH = 64;
+constexpr int HEIGHT = 48;
+constexpr int FRAME_RATE = 10;
+constexpr int FRAME_COUNT = 20;
+constexpr int SAMPLE_RATE = 48000;
+
+bool write_packets(AVFormatContext *format, AVCodecContext *context, AVStream *stream, const AVFrame *frame) {
+    if (avcodec_send_frame(context, frame) < 0)
+        return false;
+
+    AVPacket *packet = av_packet_alloc();
+    while (avcodec_receive_packet(context, packet) == 0) {
+        av_packet_rescale_ts(packet, context->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+        av_interleaved_write_frame(format, packet);
+    }
+    av_packet_free(&packet);
+
+    return true;
+}
+
+AVCodecContext *open_encoder(AVFormatContext *format, AVCodec *codec, AVStream *&stream, const std::function<void(AVCodecContext *)> &configure) {
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    configure(context);
+
+    if (format->oformat->flags & AVFMT_GLOBALHEADER)
+        context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+
+    stream = avformat_new_stream(format, nullptr);
+    avcodec_parameters_from_context(stream->codecpar, context);
+    stream->time_base = context->time_base;
+
+    return context;
+}
+
+// Write a short MP4 with an MPEG-4 video track and an AAC audio track. Frame i has a flat luma of i * 10.
+// Returns false if the FFmpeg build has no encoder or muxer for it.
+bool generate_video(const std::string &path) {
+    AVCodec *video_codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    AVCodec *audio_codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    AVFormatContext *format = nullptr;
+    if (!video_codec || !audio_codec || avformat_alloc_output_context2(&format, nullptr, "mp4", path.c_str()) < 0)
+        return false;
+
+    AVStream *video_stream = nullptr;
+    AVCodecContext *video_context = open_encoder(format, video_codec, video_stream, [](AVCodecContext *context) {
+        context->width = WIDTH;
+        context->height = HEIGHT;
+        context->time_base = { 1, FRAME_RATE };
+        context->framerate = { FRAME_RATE, 1 };
+        context->pix_fmt = AV_PIX_FMT_YUV420P;
+        // Only keyframes, so seeking lands exactly where asked
+        context->gop_size = 1;
+        context->max_b_frames = 0;
+    });
+
+    AVStream *audio_stream = nullptr;
+    AVCodecContext *audio_context = open_encoder(format, audio_codec, audio_stream, [](AVCodecContext *context) {
+        context->sample_fmt = AV_SAMPLE_FMT_FLTP;
+        context->sample_rate = SAMPLE_RATE;
+        context->channel_layout = AV_CH_LAYOUT_STEREO;
+        context->channels = 2;
+        context->bit_rate = 64000;
+        context->time_base = { 1, SAMPLE_RATE };
+    });
+
+    bool result = video_context && audio_context && (avio_open(&format->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0);
+    result = result && (avformat_write_header(format, nullptr) >= 0);
+
+    if (result) {
+        AVFrame *frame = av_frame_alloc();
+        frame->format = AV_PIX_FMT_YUV420P;
+        frame->width = WIDTH;
+        frame->height = HEIGHT;
+        av_frame_get_buffer(frame, 0);
+
+        for (int i = 0; i < FRAME_COUNT; i++) {
+            av_frame_make_writable(frame);
+            for (int plane = 0; plane < 3; plane++) {
+                const int plane_height = (plane == 0) ? HEIGHT : HEIGHT / 2;
+                for (int y = 0; y < plane_height; y++)
+                    std::fill_n(frame->data[plane] + y * frame->linesize[plane], (plane == 0) ? WIDTH : WIDTH / 2, (plane == 0) ? i * 10 : 128);
+            }
+
+            frame->pts = i;
+            write_packets(format, video_context, video_stream, frame);
+        }
+        av_frame_free(&frame);
+        write_packets(format, video_context, video_stream, nullptr);
+
+        frame = av_frame_alloc();
+        frame->format = AV_SAMPLE_FMT_FLTP;
+        frame->nb_samples = audio_context->frame_size;
+        frame->channel_layout = AV_CH_LAYOUT_STEREO;
+        frame->channels = 2;
+        frame->sample_rate = SAMPLE_RATE;
+        av_frame_get_buffer(frame, 0);
+
+        const int total_samples = SAMPLE_RATE * FRAME_COUNT / FRAME_RATE;
+        for (int position = 0; position < total_samples; position += frame->nb_samples) {
+            av_frame_make_writable(frame);
+            for (int channel = 0; channel < 2; channel++) {
+                float *samples = reinterpret_cast<float *>(frame->data[channel]);
+                for (int i = 0; i < frame->nb_samples; i++)
+                    samples[i] = 0.25f * std::sin(2.0f * 3.14159265f * 440.0f * (position + i) / SAMPLE_RATE);
+            }
+
+            frame->pts = position;
+            write_packets(format, audio_context, audio_stream, frame);
+        }
+        av_frame_free(&frame);
+        write_packets(format, audio_context, audio_stream, nullptr);
+
+        result = av_write_trailer(format) >= 0;
+    }
+
+    if (format->pb)
+        avio_closep(&format->pb);
+    avcodec_free_context(&video_context);
+    avcodec_free_context(&audio_context);
+    avformat_free_context(format);
+
+    return result;
+}
+
+bool wait_for(const std::function<bool()> &condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+class player : public testing::Test {
+protected:
+    static std::string video_path;
+    static bool video_generated;
+
+    static void SetUpTestSuite() {
+        video_path = (std::filesystem::temp_directory_path() / "vita3k_player_test.mp4").string();
+        video_generated = generate_video(video_path);
+    }
+
+    static void TearDownTestSuite() {
+        std::error_code error;
+        std::filesystem::remove(video_path, error);
+    }
+
+    void SetUp() override {
+        if (!video_generated)
+            GTEST_SKIP() << "This FFmpeg build can't write MP4 files";
+    }
+};
+
+std::string player::video_path;
+bool player::video_generated = false;
+} // namespace
+
+TEST_F(player, decodes_ahead_in_order) {
+    PlayerState state;
+    state.queue(video_path);
+
+    const DecoderSize size = state.get_size();
+    ASSERT_EQ(size.width, WIDTH);
+    ASSERT_EQ(size.height, HEIGHT);
+    ASSERT_EQ(state.get_framerate_microseconds(), 1000000 / FRAME_RATE);
+
+    // The thread fills the queue by itself, then waits for room
+    ASSERT_TRUE(wait_for([&] { return state.queued_video_frames() == PlayerState::MAX_QUEUED_VIDEO_FRAMES; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_EQ(state.queued_video_frames(), PlayerState::MAX_QUEUED_VIDEO_FRAMES);
+
+    PlayerVideoFrame frame;
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        ASSERT_TRUE(wait_for([&] { return state.receive_video(frame); }));
+        ASSERT_EQ(frame.timestamp, i * 1000 / FRAME_RATE);
+        ASSERT_EQ(frame.data.size(), H264DecoderState::buffer_size(size));
+        ASSERT_NEAR(frame.data[WIDTH * HEIGHT / 2 + WIDTH / 2], i * 10, 8);
+    }
+
+    ASSERT_FALSE(state.receive_video(frame));
+}
+
+TEST_F(player, audio_info_without_taking_frames) {
+    PlayerState state;
+    state.queue(video_path);
+
+    PlayerAudioFrame info;
+    ASSERT_TRUE(state.peek_audio(info));
+    ASSERT_EQ(info.channels, 2);
+    ASSERT_EQ(info.sample_rate, SAMPLE_RATE);
+
+    PlayerAudioFrame frame;
+    ASSERT_TRUE(state.receive_audio(frame));
+    ASSERT_EQ(frame.timestamp, info.timestamp);
+    ASSERT_EQ(frame.sample_count, info.sample_count);
+    ASSERT_EQ(frame.data.size(), frame.sample_count * frame.channels);
+    ASSERT_EQ(state.last_sample_rate, SAMPLE_RATE);
+}
+
+TEST_F(player, seek_flushes_queues) {
+    PlayerState state;
+    state.queue(video_path);
+    ASSERT_TRUE(wait_for([&] { return state.queued_video_frames() == PlayerState::MAX_QUEUED_VIDEO_FRAMES; }));
+
+    state.seek(1000);
+    ASSERT_EQ(state.last_timestamp, 1000);
+
+    PlayerVideoFrame frame;
+    ASSERT_TRUE(wait_for([&] { return state.receive_video(frame); }));
+    ASSERT_EQ(frame.timestamp, 1000);
+    ASSERT_NEAR(frame.data[0], (1000 * FRAME_RATE / 1000) * 10, 8);
+
+    PlayerAudioFrame audio;
+    ASSERT_TRUE(wait_for([&] { return state.receive_audio(audio); }));
+    ASSERT_GE(audio.timestamp, 1000);
+}
+
+TEST_F(player, plays_queued_videos_back_to_back) {
+    PlayerState state;
+    state.queue(video_path);
+    state.queue(video_path);
+
+    PlayerVideoFrame frame;
+    PlayerAudioFrame audio;
+    for (int i = 0; i < FRAME_COUNT * 2; i++) {
+        // The next video only starts once both streams of the current one are done, so take audio too
+        ASSERT_TRUE(wait_for([&] {
+            while (state.receive_audio(audio)) {
+            }
+            return state.receive_video(frame);
+        }));
+        ASSERT_EQ(frame.timestamp, (i % FRAME_COUNT) * 1000 / FRAME_RATE);
+    }
+
+    while (wait_for([&] { return state.receive_audio(audio) || !state.is_active(); }) && state.is_active()) {
+    }
+    ASSERT_FALSE(state.is_active());
+}
+
+TEST_F(player, free_video_stops_decoding) {
+    PlayerState state;
+    state.queue(video_path);
+    ASSERT_TRUE(state.is_active());
+
+    state.free_video();
+    ASSERT_FALSE(state.is_active());
+    ASSERT_EQ(state.queued_video_frames(), 0);
+    ASSERT_EQ(state.queued_audio_frames(), 0);
+
+    // Can be used again afterwards
+    state.queue(video_path);
+    PlayerVideoFrame frame;
+    ASSERT_TRUE(wait_for([&] { return state.receive_video(frame); }));
+    ASSERT_EQ(frame.timestamp, 0);
+}
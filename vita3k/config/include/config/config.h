@@ -64,8 +64,12 @@ enum PerfomanceOverleyPosition {
     code(int, "anisotropic-filtering", 1, anisotropic_filtering)                                        \
     code(bool, "texture-cache", true, texture_cache)                                                    \
     code(bool, "hashless-texture-cache", false, hashless_texture_cache)                                 \
+    code(int, "surface-cache-capacity", 20, surface_cache_capacity)                                     \
+    code(int, "surface-cache-vram-budget", 1024, surface_cache_vram_budget)                             \
     code(bool, "boot-apps-full-screen", false, boot_apps_full_screen)                                   \
     code(bool, "disable-ngs", false, disable_ngs)                                                       \
+    code(int, "ngs-thread-count", 0, ngs_thread_count)                                                  \
+    code(int, "read-ahead-budget", 0, read_ahead_budget)                                                \
     code(int, "sys-button", static_cast<int>(SCE_SYSTEM_PARAM_ENTER_BUTTON_CROSS), sys_button)          \
     code(int, "sys-lang", static_cast<int>(SCE_SYSTEM_PARAM_LANG_ENGLISH_US), sys_lang)                 \
     code(int, "sys-date-format", (int)SCE_SYSTEM_PARAM_DATE_FORMAT_MMDDYYYY, sys_date_format)           \
@@ -86,6 +90,7 @@ enum PerfomanceOverleyPosition {
     code(int, "perfomance-overlay-detail", static_cast<int>(MINIMUM), performance_overlay_detail)       \
     code(int, "perfomance-overlay-position", static_cast<int>(TOP_LEFT), performance_overlay_position)  \
     code(std::string, "backend-renderer", "OpenGL", backend_renderer)                                   \
+    code(std::string, "audio-backend", "SDL", audio_backend)                                            \
     code(int, "keyboard-button-select", 229, keyboard_button_select)                                    \
     code(int, "keyboard-button-start", 40, keyboard_button_start)                                       \
     code(int, "keyboard-button-up", 82, keyboard_button_up)                                             \
@@ -173,6 +173,21 @@ int aes_crypt_ctr(aes_context *ctx,
 
 void aes_cmac(aes_context *ctx, int length, unsigned char *input, unsigned char *output);
 
+/**
+ * \brief          Whether the AES instructions of the host CPU are used
+ *
+ * \return         1 with AES-NI or the ARMv8 crypto extension, 0 with the table implementation
+ */
+int aes_hw_enabled(void);
+
+/**
+ * \brief          Use the AES instructions of the host CPU when it has them,
+ *                 which is the default, or force the table implementation
+ *
+ * \param enabled  0 to use the tables
+ */
+void aes_set_hw_enabled(int enabled);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,9 +29,13 @@
  *  http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf
  */
 
+#include "aes_hw.h"
+
 #include <aes.h>
 #include <crypto/aes.h>
 
+#include <atomic>
+
 /*
  * 32-bit integer manipulation macros (little endian)
  */
@@ -422,6 +426,22 @@ static void aes_gen_tables(void) {
 
 #endif
 
+/*
+ * Hardware acceleration, used as soon as the CPU has it
+ */
+static std::atomic<bool> &aes_hw_flag() {
+    static std::atomic<bool> flag(crypto::aes_hw_supported());
+    return flag;
+}
+
+int aes_hw_enabled(void) {
+    return aes_hw_flag().load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+void aes_set_hw_enabled(int enabled) {
+    aes_hw_flag().store((enabled != 0) && crypto::aes_hw_supported(), std::memory_order_relaxed);
+}
+
 /*
  * AES key schedule (encryption)
  */
@@ -577,6 +597,11 @@ int aes_crypt_ecb(aes_context *ctx,
     int i;
     uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+    if (aes_hw_enabled()) {
+        crypto::aes_hw_crypt_ecb(ctx, mode, input, output);
+        return (0);
+    }
+
     RK = ctx->rk;
 
     GET_UINT32_LE(X0, input, 0);
@@ -645,6 +670,19 @@ int aes_crypt_cbc(aes_context *ctx,
     if (length % 16)
         return (POLARSSL_ERR_AES_INVALID_INPUT_LENGTH);
 
+    if (aes_hw_enabled()) {
+        // The IV is given back untouched when decrypting, same as below
+        if (mode == AES_DECRYPT)
+            memcpy(orig_iv, iv, 16);
+
+        crypto::aes_hw_crypt_cbc(ctx, mode, length, iv, input, output);
+
+        if (mode == AES_DECRYPT)
+            memcpy(iv, orig_iv, 16);
+
+        return (0);
+    }
+
     if (mode == AES_DECRYPT) {
         memcpy(orig_iv, iv, 16);
         while (length > 0) {
@@ -731,6 +769,39 @@ int aes_crypt_ctr(aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+    /* Use up what is left of the stream block of the previous call */
+    while ((n != 0) && (length != 0)) {
+        *output++ = (unsigned char)(*input++ ^ stream_block[n]);
+
+        n = (n + 1) & 0x0F;
+        length--;
+    }
+
+    /* Whole blocks, n is 0 from here on */
+    if (length >= 16) {
+        size_t blocks = length / 16;
+
+        if (aes_hw_enabled()) {
+            crypto::aes_hw_crypt_ctr(ctx, blocks, nonce_counter, input, output);
+
+            input += blocks * 16;
+            output += blocks * 16;
+        } else {
+            while (blocks--) {
+                aes_crypt_ecb(ctx, AES_ENCRYPT, nonce_counter, stream_block);
+
+                for (i = 16; i > 0; i--)
+                    if (++nonce_counter[i - 1] != 0)
+                        break;
+
+                for (i = 0; i < 16; i++)
+                    *output++ = (unsigned char)(*input++ ^ stream_block[i]);
+            }
+        }
+
+        length %= 16;
+    }
+
     while (length--) {
         if (n == 0) {
             aes_crypt_ecb(ctx, AES_ENCRYPT, nonce_counter, stream_block);
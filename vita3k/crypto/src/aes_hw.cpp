@@ -0,0 +1,330 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "aes_hw.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AES_HW_X86
+#include <util/instrset_detect.h>
+#include <wmmintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AES_HW_TARGET __attribute__((target("aes,sse2")))
+#else
+#define AES_HW_TARGET
+#endif
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define AES_HW_ARM
+#include <arm_neon.h>
+
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__clang__)
+#define AES_HW_TARGET __attribute__((target("aes")))
+#elif defined(__GNUC__)
+#define AES_HW_TARGET __attribute__((target("+crypto")))
+#else
+#define AES_HW_TARGET
+#endif
+#endif
+
+namespace crypto {
+
+#if defined(AES_HW_X86) || defined(AES_HW_ARM)
+
+// Enough blocks in flight to hide the latency of the AES instructions, they are pipelined on every recent CPU
+static constexpr size_t PARALLEL_BLOCKS = 8;
+
+// AES-256 has the most rounds
+static constexpr int MAX_ROUND_KEYS = 15;
+
+static inline uint64_t swap_bytes(const uint64_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+#ifdef AES_HW_X86
+typedef __m128i Block;
+
+AES_HW_TARGET static inline Block load_block(const unsigned char *data) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+}
+
+AES_HW_TARGET static inline void store_block(unsigned char *data, const Block block) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data), block);
+}
+
+AES_HW_TARGET static inline Block xor_blocks(const Block a, const Block b) {
+    return _mm_xor_si128(a, b);
+}
+
+// Bytes 0-7 hold the high half of the counter, both halves are big endian
+AES_HW_TARGET static inline Block make_counter(const uint64_t high, const uint64_t low) {
+    return _mm_set_epi64x(static_cast<long long>(swap_bytes(low)), static_cast<long long>(swap_bytes(high)));
+}
+
+// The blocks are expanded with a fold rather than a loop, so they stay in registers whatever the optimization level
+template <size_t... J>
+AES_HW_TARGET static inline void encrypt_blocks(Block *blocks, const Block *keys, const int nr, std::index_sequence<J...>) {
+    ((blocks[J] = _mm_xor_si128(blocks[J], keys[0])), ...);
+
+    for (int i = 1; i < nr; i++)
+        ((blocks[J] = _mm_aesenc_si128(blocks[J], keys[i])), ...);
+
+    ((blocks[J] = _mm_aesenclast_si128(blocks[J], keys[nr])), ...);
+}
+
+template <size_t... J>
+AES_HW_TARGET static inline void decrypt_blocks(Block *blocks, const Block *keys, const int nr, std::index_sequence<J...>) {
+    ((blocks[J] = _mm_xor_si128(blocks[J], keys[0])), ...);
+
+    for (int i = 1; i < nr; i++)
+        ((blocks[J] = _mm_aesdec_si128(blocks[J], keys[i])), ...);
+
+    ((blocks[J] = _mm_aesdeclast_si128(blocks[J], keys[nr])), ...);
+}
+#else
+typedef uint8x16_t Block;
+
+AES_HW_TARGET static inline Block load_block(const unsigned char *data) {
+    return vld1q_u8(data);
+}
+
+AES_HW_TARGET static inline void store_block(unsigned char *data, const Block block) {
+    vst1q_u8(data, block);
+}
+
+AES_HW_TARGET static inline Block xor_blocks(const Block a, const Block b) {
+    return veorq_u8(a, b);
+}
+
+// Bytes 0-7 hold the high half of the counter, both halves are big endian
+AES_HW_TARGET static inline Block make_counter(const uint64_t high, const uint64_t low) {
+    return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(swap_bytes(high)), vcreate_u64(swap_bytes(low))));
+}
+
+// The blocks are expanded with a fold rather than a loop, so they stay in registers whatever the optimization level.
+// AESE adds the round key before substituting, unlike AESENC, so the last key is added on its own.
+template <size_t... J>
+AES_HW_TARGET static inline void encrypt_blocks(Block *blocks, const Block *keys, const int nr, std::index_sequence<J...>) {
+    for (int i = 0; i < nr - 1; i++)
+        ((blocks[J] = vaesmcq_u8(vaeseq_u8(blocks[J], keys[i]))), ...);
+
+    ((blocks[J] = veorq_u8(vaeseq_u8(blocks[J], keys[nr - 1]), keys[nr])), ...);
+}
+
+template <size_t... J>
+AES_HW_TARGET static inline void decrypt_blocks(Block *blocks, const Block *keys, const int nr, std::index_sequence<J...>) {
+    for (int i = 0; i < nr - 1; i++)
+        ((blocks[J] = vaesimcq_u8(vaesdq_u8(blocks[J], keys[i]))), ...);
+
+    ((blocks[J] = veorq_u8(vaesdq_u8(blocks[J], keys[nr - 1]), keys[nr])), ...);
+}
+#endif
+
+template <size_t COUNT>
+AES_HW_TARGET static inline void encrypt_blocks(Block *blocks, const Block *keys, const int nr) {
+    encrypt_blocks(blocks, keys, nr, std::make_index_sequence<COUNT>());
+}
+
+template <size_t COUNT>
+AES_HW_TARGET static inline void decrypt_blocks(Block *blocks, const Block *keys, const int nr) {
+    decrypt_blocks(blocks, keys, nr, std::make_index_sequence<COUNT>());
+}
+
+AES_HW_TARGET static inline void load_keys(const aes_context *ctx, Block *keys) {
+    const unsigned char *round_keys = reinterpret_cast<const unsigned char *>(ctx->rk);
+
+    for (int i = 0; i <= ctx->nr; i++)
+        keys[i] = load_block(round_keys + i * 16);
+}
+
+static inline void increment_counter(uint64_t &high, uint64_t &low) {
+    if (++low == 0)
+        high++;
+}
+
+bool aes_hw_supported() {
+#if defined(AES_HW_X86)
+    return util::instrset::hasAES();
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(__APPLE__)
+    // Every 64-bit Apple CPU has them
+    return true;
+#elif defined(_WIN32)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE);
+#else
+    return false;
+#endif
+}
+
+AES_HW_TARGET void aes_hw_crypt_ecb(const aes_context *ctx, const int mode, const unsigned char input[16], unsigned char output[16]) {
+    Block keys[MAX_ROUND_KEYS];
+    load_keys(ctx, keys);
+
+    Block block = load_block(input);
+
+    if (mode == AES_DECRYPT)
+        decrypt_blocks<1>(&block, keys, ctx->nr);
+    else
+        encrypt_blocks<1>(&block, keys, ctx->nr);
+
+    store_block(output, block);
+}
+
+AES_HW_TARGET void aes_hw_crypt_cbc(const aes_context *ctx, const int mode, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output) {
+    Block keys[MAX_ROUND_KEYS];
+    load_keys(ctx, keys);
+
+    Block chain = load_block(iv);
+
+    if (mode == AES_DECRYPT) {
+        // Decrypting a block only needs the ciphertext, so several of them go through at once.
+        // Everything is loaded before being stored, input and output may be the same buffer.
+        while (length >= PARALLEL_BLOCKS * 16) {
+            Block ciphertext[PARALLEL_BLOCKS];
+            Block blocks[PARALLEL_BLOCKS];
+
+            for (size_t i = 0; i < PARALLEL_BLOCKS; i++) {
+                ciphertext[i] = load_block(input + i * 16);
+                blocks[i] = ciphertext[i];
+            }
+
+            decrypt_blocks<PARALLEL_BLOCKS>(blocks, keys, ctx->nr);
+
+            for (size_t i = 0; i < PARALLEL_BLOCKS; i++) {
+                store_block(output + i * 16, xor_blocks(blocks[i], chain));
+                chain = ciphertext[i];
+            }
+
+            input += PARALLEL_BLOCKS * 16;
+            output += PARALLEL_BLOCKS * 16;
+            length -= PARALLEL_BLOCKS * 16;
+        }
+
+        while (length >= 16) {
+            const Block ciphertext = load_block(input);
+
+            Block block = ciphertext;
+            decrypt_blocks<1>(&block, keys, ctx->nr);
+            store_block(output, xor_blocks(block, chain));
+            chain = ciphertext;
+
+            input += 16;
+            output += 16;
+            length -= 16;
+        }
+    } else {
+        // Every block needs the previous ciphertext, there is nothing to do in parallel
+        while (length >= 16) {
+            Block block = xor_blocks(load_block(input), chain);
+            encrypt_blocks<1>(&block, keys, ctx->nr);
+            store_block(output, block);
+            chain = block;
+
+            input += 16;
+            output += 16;
+            length -= 16;
+        }
+    }
+
+    store_block(iv, chain);
+}
+
+AES_HW_TARGET void aes_hw_crypt_ctr(const aes_context *ctx, size_t blocks, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output) {
+    Block keys[MAX_ROUND_KEYS];
+    load_keys(ctx, keys);
+
+    // Both x86 and AArch64 are little endian
+    uint64_t high;
+    uint64_t low;
+    std::memcpy(&high, nonce_counter, 8);
+    std::memcpy(&low, nonce_counter + 8, 8);
+    high = swap_bytes(high);
+    low = swap_bytes(low);
+
+    while (blocks >= PARALLEL_BLOCKS) {
+        Block stream[PARALLEL_BLOCKS];
+
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++) {
+            stream[i] = make_counter(high, low);
+            increment_counter(high, low);
+        }
+
+        encrypt_blocks<PARALLEL_BLOCKS>(stream, keys, ctx->nr);
+
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            store_block(output + i * 16, xor_blocks(load_block(input + i * 16), stream[i]));
+
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+        blocks -= PARALLEL_BLOCKS;
+    }
+
+    while (blocks > 0) {
+        Block stream = make_counter(high, low);
+        increment_counter(high, low);
+
+        encrypt_blocks<1>(&stream, keys, ctx->nr);
+        store_block(output, xor_blocks(load_block(input), stream));
+
+        input += 16;
+        output += 16;
+        blocks--;
+    }
+
+    high = swap_bytes(high);
+    low = swap_bytes(low);
+    std::memcpy(nonce_counter, &high, 8);
+    std::memcpy(nonce_counter + 8, &low, 8);
+}
+
+#else
+
+// No AES instructions known on this architecture, the rest is never called
+
+bool aes_hw_supported() {
+    return false;
+}
+
+void aes_hw_crypt_ecb(const aes_context *ctx, const int mode, const unsigned char input[16], unsigned char output[16]) {
+}
+
+void aes_hw_crypt_cbc(const aes_context *ctx, const int mode, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output) {
+}
+
+void aes_hw_crypt_ctr(const aes_context *ctx, size_t blocks, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output) {
+}
+
+#endif
+
+} // namespace crypto
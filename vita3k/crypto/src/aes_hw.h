@@ -0,0 +1,40 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <crypto/aes.h>
+
+#include <cstddef>
+
+// AES using the instructions of the host CPU (AES-NI on x86, the crypto extension on ARMv8).
+// The round keys are the ones made by aes_setkey_enc and aes_setkey_dec: both instruction sets
+// expect the same layout for encryption, and the decryption keys already are the equivalent
+// inverse cipher ones. Only call these when aes_hw_supported returns true.
+namespace crypto {
+
+bool aes_hw_supported();
+
+void aes_hw_crypt_ecb(const aes_context *ctx, int mode, const unsigned char input[16], unsigned char output[16]);
+
+// Length must be a multiple of 16, the IV is replaced with the last ciphertext block
+void aes_hw_crypt_cbc(const aes_context *ctx, int mode, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output);
+
+// Counter is a 128-bit big endian number, incremented once per block
+void aes_hw_crypt_ctr(const aes_context *ctx, size_t blocks, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output);
+
+} // namespace crypto
@@ -0,0 +1,244 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <crypto/aes.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<unsigned char> from_hex(const std::string &hex) {
+    std::vector<unsigned char> result;
+    for (size_t i = 0; i < hex.size(); i += 2)
+        result.push_back(static_cast<unsigned char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+
+    return result;
+}
+
+// Every implementation this CPU can run, the tables always being one of them
+static std::vector<int> implementations() {
+    std::vector<int> result = { 0 };
+
+    aes_set_hw_enabled(1);
+    if (aes_hw_enabled())
+        result.push_back(1);
+
+    return result;
+}
+
+class AesTest : public testing::Test {
+protected:
+    void TearDown() override {
+        aes_set_hw_enabled(1);
+    }
+};
+
+// FIPS-197 appendix C
+TEST_F(AesTest, ecb_fips197) {
+    const auto plaintext = from_hex("00112233445566778899aabbccddeeff");
+
+    const struct {
+        unsigned int keysize;
+        const char *key;
+        const char *ciphertext;
+    } vectors[] = {
+        { 128, "000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a" },
+        { 192, "000102030405060708090a0b0c0d0e0f1011121314151617", "dda97ca4864cdfe06eaf70a0ec0d7191" },
+        { 256, "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "8ea2b7ca516745bfeafc49904b496089" },
+    };
+
+    for (const int hw : implementations()) {
+        aes_set_hw_enabled(hw);
+
+        for (const auto &vector : vectors) {
+            const auto key = from_hex(vector.key);
+            const auto expected = from_hex(vector.ciphertext);
+            std::vector<unsigned char> output(16);
+
+            aes_context ctx;
+            ASSERT_EQ(aes_setkey_enc(&ctx, key.data(), vector.keysize), 0);
+            aes_crypt_ecb(&ctx, AES_ENCRYPT, plaintext.data(), output.data());
+            ASSERT_EQ(output, expected) << "hw " << hw << " key size " << vector.keysize;
+
+            ASSERT_EQ(aes_setkey_dec(&ctx, key.data(), vector.keysize), 0);
+            aes_crypt_ecb(&ctx, AES_DECRYPT, expected.data(), output.data());
+            ASSERT_EQ(output, plaintext) << "hw " << hw << " key size " << vector.keysize;
+        }
+    }
+}
+
+static const char SP800_38A_KEY[] = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char SP800_38A_PLAINTEXT[] = "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                                          "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+// SP 800-38A F.2.1 and F.2.2
+TEST_F(AesTest, cbc_sp800_38a) {
+    const auto key = from_hex(SP800_38A_KEY);
+    const auto plaintext = from_hex(SP800_38A_PLAINTEXT);
+    const auto iv = from_hex("000102030405060708090a0b0c0d0e0f");
+    const auto ciphertext = from_hex("7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+                                     "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+
+    for (const int hw : implementations()) {
+        aes_set_hw_enabled(hw);
+
+        aes_context ctx;
+        std::vector<unsigned char> output(plaintext.size());
+        std::vector<unsigned char> iv_copy = iv;
+
+        aes_setkey_enc(&ctx, key.data(), 128);
+        ASSERT_EQ(aes_crypt_cbc(&ctx, AES_ENCRYPT, plaintext.size(), iv_copy.data(), plaintext.data(), output.data()), 0);
+        ASSERT_EQ(output, ciphertext) << "hw " << hw;
+
+        // Encrypting leaves the last block as IV to chain the next call
+        ASSERT_EQ(iv_copy, std::vector<unsigned char>(ciphertext.end() - 16, ciphertext.end()));
+
+        // Decrypting in place, and the IV is given back as it was
+        iv_copy = iv;
+        output = ciphertext;
+        aes_setkey_dec(&ctx, key.data(), 128);
+        ASSERT_EQ(aes_crypt_cbc(&ctx, AES_DECRYPT, output.size(), iv_copy.data(), output.data(), output.data()), 0);
+        ASSERT_EQ(output, plaintext) << "hw " << hw;
+        ASSERT_EQ(iv_copy, iv);
+
+        ASSERT_EQ(aes_crypt_cbc(&ctx, AES_DECRYPT, 15, iv_copy.data(), output.data(), output.data()), POLARSSL_ERR_AES_INVALID_INPUT_LENGTH);
+    }
+}
+
+// SP 800-38A F.5.1, also cut in uneven pieces which resume from the saved stream block
+TEST_F(AesTest, ctr_sp800_38a) {
+    const auto key = from_hex(SP800_38A_KEY);
+    const auto plaintext = from_hex(SP800_38A_PLAINTEXT);
+    const auto counter = from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    const auto ciphertext = from_hex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+                                     "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+
+    for (const int hw : implementations()) {
+        aes_set_hw_enabled(hw);
+
+        aes_context ctx;
+        aes_setkey_enc(&ctx, key.data(), 128);
+
+        for (const size_t piece : { 64, 1, 5, 16, 17, 33 }) {
+            std::vector<unsigned char> output(plaintext.size());
+            std::vector<unsigned char> nonce_counter = counter;
+            unsigned char stream_block[16];
+            size_t nc_off = 0;
+
+            for (size_t done = 0; done < plaintext.size(); done += piece) {
+                const size_t size = std::min(piece, plaintext.size() - done);
+                aes_crypt_ctr(&ctx, size, &nc_off, nonce_counter.data(), stream_block, plaintext.data() + done, output.data() + done);
+            }
+
+            ASSERT_EQ(output, ciphertext) << "hw " << hw << " piece " << piece;
+            ASSERT_EQ(nonce_counter, from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdff03")) << "hw " << hw << " piece " << piece;
+        }
+    }
+}
+
+// Lengths around the blocks done in parallel, and a counter carrying into its high half
+TEST_F(AesTest, implementations_agree) {
+    aes_set_hw_enabled(1);
+    if (!aes_hw_enabled())
+        GTEST_SKIP() << "No AES instructions on this CPU";
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    const auto random_bytes = [&](size_t size) {
+        std::vector<unsigned char> result(size);
+        for (auto &value : result)
+            value = static_cast<unsigned char>(byte(rng));
+        return result;
+    };
+
+    for (const unsigned int keysize : { 128, 192, 256 }) {
+        const auto key = random_bytes(keysize / 8);
+        aes_context enc;
+        aes_context dec;
+        aes_setkey_enc(&enc, key.data(), keysize);
+        aes_setkey_dec(&dec, key.data(), keysize);
+
+        for (const size_t size : { 16, 112, 128, 144, 1000, 4096 + 48 }) {
+            const auto input = random_bytes(size);
+            const auto iv = random_bytes(16);
+
+            std::vector<unsigned char> counter = iv;
+            std::fill(counter.begin() + 8, counter.end(), 0xFF);
+            counter[15] = 0xFA;
+
+            std::vector<unsigned char> results[2][3];
+
+            for (const int hw : { 0, 1 }) {
+                aes_set_hw_enabled(hw);
+
+                std::vector<unsigned char> iv_copy = iv;
+                std::vector<unsigned char> &ctr = results[hw][0];
+                std::vector<unsigned char> &cbc_enc = results[hw][1];
+                std::vector<unsigned char> &cbc_dec = results[hw][2];
+                ctr.resize(size);
+                cbc_enc.resize(size & ~15);
+                cbc_dec.resize(size & ~15);
+
+                std::vector<unsigned char> nonce_counter = counter;
+                unsigned char stream_block[16];
+                size_t nc_off = 0;
+                aes_crypt_ctr(&enc, size, &nc_off, nonce_counter.data(), stream_block, input.data(), ctr.data());
+                ctr.insert(ctr.end(), nonce_counter.begin(), nonce_counter.end());
+
+                aes_crypt_cbc(&enc, AES_ENCRYPT, cbc_enc.size(), iv_copy.data(), input.data(), cbc_enc.data());
+                iv_copy = iv;
+                aes_crypt_cbc(&dec, AES_DECRYPT, cbc_dec.size(), iv_copy.data(), cbc_enc.data(), cbc_dec.data());
+                ASSERT_TRUE(std::equal(cbc_dec.begin(), cbc_dec.end(), input.begin()));
+            }
+
+            for (int mode = 0; mode < 3; mode++)
+                ASSERT_EQ(results[0][mode], results[1][mode]) << "key size " << keysize << " size " << size << " mode " << mode;
+        }
+    }
+}
+
+// Not a pass/fail check, reports the CTR throughput of the tables against the AES instructions
+TEST_F(AesTest, benchmark) {
+    constexpr size_t SIZE = 32 * 1024 * 1024;
+
+    std::vector<unsigned char> data(SIZE, 0x5A);
+    const auto key = from_hex(SP800_38A_KEY);
+
+    aes_context ctx;
+    aes_setkey_enc(&ctx, key.data(), 128);
+
+    using clock = std::chrono::steady_clock;
+
+    for (const int hw : implementations()) {
+        aes_set_hw_enabled(hw);
+
+        unsigned char nonce_counter[16] = {};
+        unsigned char stream_block[16];
+        size_t nc_off = 0;
+
+        const auto start = clock::now();
+        aes_crypt_ctr(&ctx, data.size(), &nc_off, nonce_counter, stream_block, data.data(), data.data());
+        const auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        std::printf("aes-128-ctr %s: %.0f MiB/s\n", hw ? "hardware" : "tables", SIZE / (1024.0 * 1024.0) / seconds);
+    }
+}
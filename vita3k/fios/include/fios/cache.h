@@ -0,0 +1,89 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fios {
+
+// Decompressed archive block, shared between the cache and the readers still copying from it
+typedef std::shared_ptr<const std::vector<std::uint8_t>> Block;
+
+struct CacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+};
+
+// Decompressed blocks of every mounted archive, evicted least recently used first once over the budget.
+// Safe to use from several threads at once.
+class BlockCache {
+    typedef std::uint64_t Key;
+    typedef std::list<Key> LRUList;
+
+    struct Entry {
+        Block block;
+        LRUList::iterator lru_position;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Entry> entries;
+
+    // Front is the least recently used block
+    LRUList lru;
+
+    std::size_t budget;
+    std::size_t used = 0;
+    CacheStats statistics;
+
+    static Key make_key(std::uint32_t archive, std::uint32_t block) {
+        return (static_cast<Key>(archive) << 32) | block;
+    }
+
+    void remove(std::unordered_map<Key, Entry>::iterator entry);
+    void enforce_budget();
+
+public:
+    static constexpr std::size_t DEFAULT_BUDGET = 32 * 1024 * 1024;
+
+    explicit BlockCache(std::size_t budget = DEFAULT_BUDGET)
+        : budget(budget) {
+    }
+
+    Block find(std::uint32_t archive, std::uint32_t block);
+    bool contains(std::uint32_t archive, std::uint32_t block) const;
+    void insert(std::uint32_t archive, std::uint32_t block, Block data);
+
+    // Forget every block, or the blocks of one archive
+    void flush();
+    void flush(std::uint32_t archive);
+
+    void set_budget(std::size_t new_budget);
+
+    std::size_t used_bytes() const;
+    CacheStats stats() const;
+    void reset_stats();
+};
+
+} // namespace fios
@@ -0,0 +1,78 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fios {
+
+enum class OverlayType : std::uint8_t {
+    // Everything below dst is taken from src
+    OPAQUE = 0,
+    // Files found in src hide the ones of dst, the others are still taken from dst
+    TRANSLUCENT = 1,
+    // The most recently modified of the two files is used
+    NEWER = 2,
+    // Like translucent, but files are always written to src
+    WRITABLE = 3,
+};
+
+struct Overlay {
+    std::int32_t id = 0;
+    OverlayType type = OverlayType::OPAQUE;
+
+    // Overlays with a higher order are looked at first
+    std::uint8_t order = 0;
+
+    std::string dst;
+    std::string src;
+};
+
+// Modification time of the path, if it exists
+typedef std::function<std::optional<std::uint64_t>(const std::string &)> StatFunc;
+
+// Redirections of guest paths, looked at from the highest order down. Safe to use from several threads at once.
+class OverlayTable {
+    mutable std::mutex mutex;
+
+    // Sorted by descending order, the first overlay added comes first for equal orders
+    std::vector<Overlay> overlays;
+    std::int32_t next_id = 1;
+
+    void sort();
+
+public:
+    // Returns the id of the new overlay
+    std::int32_t add(const Overlay &overlay);
+    bool modify(std::int32_t id, const Overlay &overlay);
+    bool remove(std::int32_t id);
+    void clear();
+
+    std::optional<Overlay> get(std::int32_t id) const;
+    std::vector<std::int32_t> list() const;
+
+    // Get the path a file is really accessed at. Writes only go through opaque and writable overlays.
+    std::string resolve(const std::string &path, bool for_write, const StatFunc &stat) const;
+};
+
+} // namespace fios
@@ -0,0 +1,111 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <fios/cache.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+class ThreadPool;
+}
+
+// PlayStation archives, made of a table of contents followed by the files cut into blocks compressed
+// one by one. The table is parsed once on mount, blocks are decompressed on demand through a BlockCache.
+namespace fios {
+
+// Read at the given offset of the archive, returning the number of bytes read or a negative value on error
+typedef std::function<std::int64_t(void *data, std::uint64_t size, std::uint64_t offset)> ReadFunc;
+
+enum class Compression {
+    ZLIB,
+    LZMA,
+};
+
+struct PsarcEntry {
+    // As written in the manifest
+    std::string path;
+    std::uint64_t size = 0;
+
+    // Of the first block of the file, in the archive
+    std::uint64_t offset = 0;
+    std::uint32_t first_block = 0;
+};
+
+class Psarc {
+    ReadFunc read_archive;
+
+    // Unique among the archives opened, it identifies the blocks of this one in the cache
+    std::uint32_t archive_id = 0;
+
+    Compression compression = Compression::ZLIB;
+    std::uint32_t archive_block_size = 0;
+    std::uint32_t toc_length = 0;
+    bool ignore_case = false;
+
+    // Entry 0 is the manifest listing the paths of the others
+    std::vector<PsarcEntry> file_entries;
+    std::unordered_map<std::string, std::size_t> index;
+
+    // Where each block starts in the archive and how many bytes are stored, 0 meaning a whole block
+    std::vector<std::uint64_t> block_offsets;
+    std::vector<std::uint32_t> block_lengths;
+
+    std::string make_key(const std::string &path) const;
+    bool load_block(std::uint32_t block, std::uint32_t size, std::vector<std::uint8_t> &data) const;
+
+    // Get the blocks of the range into the cache, optionally keeping them in order in the given vector
+    bool fetch(const PsarcEntry &entry, std::uint64_t first, std::uint64_t last, BlockCache &cache, util::ThreadPool *workers, std::vector<Block> *blocks) const;
+
+public:
+    // Parse the header, the table of contents and the manifest. Returns false if the archive is invalid.
+    bool open(ReadFunc read);
+
+    std::uint32_t id() const {
+        return archive_id;
+    }
+
+    std::uint32_t block_size() const {
+        return archive_block_size;
+    }
+
+    // Size of the table of contents and manifest, which the guest gives a buffer for when mounting
+    std::uint64_t index_size() const;
+
+    // Every file, the manifest excluded
+    std::vector<const PsarcEntry *> entries() const;
+
+    // Case insensitive if the archive says so, with or without a leading slash
+    const PsarcEntry *find(const std::string &path) const;
+
+    // Read part of a file, the missing blocks being decompressed on the workers if given.
+    // Returns the number of bytes read, or -1 if a block could not be read.
+    std::int64_t read(const PsarcEntry &entry, void *data, std::uint64_t size, std::uint64_t offset, BlockCache &cache, util::ThreadPool *workers) const;
+
+    // Same as read, but only brings the blocks into the cache
+    bool prefetch(const PsarcEntry &entry, std::uint64_t size, std::uint64_t offset, BlockCache &cache, util::ThreadPool *workers) const;
+
+    // Whether every block of the range is in the cache
+    bool is_cached(const PsarcEntry &entry, std::uint64_t size, std::uint64_t offset, const BlockCache &cache) const;
+};
+
+} // namespace fios
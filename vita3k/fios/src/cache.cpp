@@ -0,0 +1,116 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <fios/cache.h>
+
+namespace fios {
+
+void BlockCache::remove(std::unordered_map<Key, Entry>::iterator entry) {
+    used -= entry->second.block->size();
+    lru.erase(entry->second.lru_position);
+    entries.erase(entry);
+}
+
+void BlockCache::enforce_budget() {
+    // The block just inserted is at the back, it is kept even if it is larger than the whole budget
+    while ((used > budget) && (lru.size() > 1)) {
+        remove(entries.find(lru.front()));
+        statistics.evictions++;
+    }
+}
+
+Block BlockCache::find(const std::uint32_t archive, const std::uint32_t block) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    const auto entry = entries.find(make_key(archive, block));
+    if (entry == entries.end()) {
+        statistics.misses++;
+        return {};
+    }
+
+    statistics.hits++;
+    lru.splice(lru.end(), lru, entry->second.lru_position);
+    return entry->second.block;
+}
+
+bool BlockCache::contains(const std::uint32_t archive, const std::uint32_t block) const {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return entries.contains(make_key(archive, block));
+}
+
+void BlockCache::insert(const std::uint32_t archive, const std::uint32_t block, Block data) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    const Key key = make_key(archive, block);
+
+    // Two readers may have decompressed the same block at once
+    const auto existing = entries.find(key);
+    if (existing != entries.end()) {
+        remove(existing);
+    }
+
+    used += data->size();
+    entries.emplace(key, Entry{ std::move(data), lru.insert(lru.end(), key) });
+
+    enforce_budget();
+}
+
+void BlockCache::flush() {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    entries.clear();
+    lru.clear();
+    used = 0;
+}
+
+void BlockCache::flush(const std::uint32_t archive) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        if ((entry->first >> 32) == archive) {
+            used -= entry->second.block->size();
+            lru.erase(entry->second.lru_position);
+            entry = entries.erase(entry);
+        } else {
+            entry++;
+        }
+    }
+}
+
+void BlockCache::set_budget(const std::size_t new_budget) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    budget = new_budget;
+    enforce_budget();
+}
+
+std::size_t BlockCache::used_bytes() const {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return used;
+}
+
+CacheStats BlockCache::stats() const {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return statistics;
+}
+
+void BlockCache::reset_stats() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    statistics = CacheStats{};
+}
+
+} // namespace fios
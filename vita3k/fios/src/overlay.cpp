@@ -0,0 +1,158 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <fios/overlay.h>
+
+#include <algorithm>
+
+namespace fios {
+
+// Without the trailing slashes, so "app0:/data/" and "app0:/data" are the same directory
+static std::string trim_directory(std::string path) {
+    while ((path.size() > 1) && (path.back() == '/'))
+        path.pop_back();
+
+    return path;
+}
+
+// If the path is dst or below it, get the matching path below src
+static std::optional<std::string> redirect(const Overlay &overlay, const std::string &path) {
+    if (path.compare(0, overlay.dst.size(), overlay.dst) != 0)
+        return std::nullopt;
+
+    if ((path.size() > overlay.dst.size()) && (path[overlay.dst.size()] != '/') && (overlay.dst.back() != '/'))
+        return std::nullopt;
+
+    return overlay.src + path.substr(overlay.dst.size());
+}
+
+void OverlayTable::sort() {
+    std::stable_sort(overlays.begin(), overlays.end(), [](const Overlay &lhs, const Overlay &rhs) {
+        return lhs.order > rhs.order;
+    });
+}
+
+std::int32_t OverlayTable::add(const Overlay &overlay) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    Overlay &added = overlays.emplace_back(overlay);
+    added.id = next_id++;
+    added.dst = trim_directory(added.dst);
+    added.src = trim_directory(added.src);
+
+    const std::int32_t id = added.id;
+    sort();
+
+    return id;
+}
+
+bool OverlayTable::modify(const std::int32_t id, const Overlay &overlay) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    const auto existing = std::find_if(overlays.begin(), overlays.end(), [id](const Overlay &overlay) {
+        return overlay.id == id;
+    });
+
+    if (existing == overlays.end())
+        return false;
+
+    *existing = overlay;
+    existing->id = id;
+    existing->dst = trim_directory(existing->dst);
+    existing->src = trim_directory(existing->src);
+
+    sort();
+    return true;
+}
+
+bool OverlayTable::remove(const std::int32_t id) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    return std::erase_if(overlays, [id](const Overlay &overlay) {
+        return overlay.id == id;
+    }) != 0;
+}
+
+void OverlayTable::clear() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    overlays.clear();
+}
+
+std::optional<Overlay> OverlayTable::get(const std::int32_t id) const {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    for (const Overlay &overlay : overlays) {
+        if (overlay.id == id)
+            return overlay;
+    }
+
+    return std::nullopt;
+}
+
+std::vector<std::int32_t> OverlayTable::list() const {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    std::vector<std::int32_t> ids;
+    for (const Overlay &overlay : overlays) {
+        ids.push_back(overlay.id);
+    }
+
+    return ids;
+}
+
+std::string OverlayTable::resolve(const std::string &path, const bool for_write, const StatFunc &stat) const {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    for (const Overlay &overlay : overlays) {
+        const auto redirected = redirect(overlay, path);
+        if (!redirected)
+            continue;
+
+        switch (overlay.type) {
+        case OverlayType::OPAQUE:
+            return *redirected;
+
+        case OverlayType::WRITABLE:
+            if (for_write || stat(*redirected))
+                return *redirected;
+            break;
+
+        case OverlayType::TRANSLUCENT:
+            if (!for_write && stat(*redirected))
+                return *redirected;
+            break;
+
+        case OverlayType::NEWER: {
+            if (for_write)
+                break;
+
+            const auto redirected_time = stat(*redirected);
+            if (!redirected_time)
+                break;
+
+            const auto original_time = stat(path);
+            if (!original_time || (*redirected_time >= *original_time))
+                return *redirected;
+            break;
+        }
+        }
+    }
+
+    return path;
+}
+
+} // namespace fios
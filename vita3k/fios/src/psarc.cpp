@@ -0,0 +1,307 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <fios/psarc.h>
+
+#include <util/thread_pool.h>
+
+#include <lzmadec.h>
+#include <miniz.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+
+namespace fios {
+
+static constexpr std::uint32_t HEADER_SIZE = 0x20;
+static constexpr std::uint32_t ENTRY_SIZE = 30;
+
+enum ArchiveFlags : std::uint32_t {
+    ARCHIVE_FLAGS_IGNORE_CASE = 1,
+    ARCHIVE_FLAGS_ABSOLUTE_PATHS = 2,
+};
+
+// Everything in the archive is big endian, some of it in 40 bits
+static std::uint64_t read_be(const std::uint8_t *data, const std::size_t size) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        value = (value << 8) | data[i];
+    }
+
+    return value;
+}
+
+static std::atomic<std::uint32_t> next_archive_id = 1;
+
+std::string Psarc::make_key(const std::string &path) const {
+    std::string key = path;
+
+    // Paths are relative or absolute depending on the archive, find both the same way
+    while (!key.empty() && (key.front() == '/'))
+        key.erase(0, 1);
+
+    if (ignore_case) {
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::tolower(c); });
+    }
+
+    return key;
+}
+
+bool Psarc::open(ReadFunc reader) {
+    read_archive = std::move(reader);
+
+    std::uint8_t header[HEADER_SIZE];
+    if (read_archive(header, sizeof(header), 0) != sizeof(header))
+        return false;
+
+    if (std::memcmp(header, "PSAR", 4) != 0)
+        return false;
+
+    if (std::memcmp(header + 8, "zlib", 4) == 0)
+        compression = Compression::ZLIB;
+    else if (std::memcmp(header + 8, "lzma", 4) == 0)
+        compression = Compression::LZMA;
+    else
+        return false;
+
+    toc_length = static_cast<std::uint32_t>(read_be(header + 0xC, 4));
+    const std::uint32_t entry_size = static_cast<std::uint32_t>(read_be(header + 0x10, 4));
+    const std::uint32_t entry_count = static_cast<std::uint32_t>(read_be(header + 0x14, 4));
+    archive_block_size = static_cast<std::uint32_t>(read_be(header + 0x18, 4));
+    const std::uint32_t flags = static_cast<std::uint32_t>(read_be(header + 0x1C, 4));
+
+    ignore_case = flags & ARCHIVE_FLAGS_IGNORE_CASE;
+
+    if ((entry_size < ENTRY_SIZE) || (entry_count == 0) || (archive_block_size == 0) || (toc_length < HEADER_SIZE + entry_size * entry_count))
+        return false;
+
+    std::vector<std::uint8_t> toc(toc_length - HEADER_SIZE);
+    if (read_archive(toc.data(), toc.size(), HEADER_SIZE) != static_cast<std::int64_t>(toc.size()))
+        return false;
+
+    file_entries.resize(entry_count);
+    for (std::uint32_t i = 0; i < entry_count; i++) {
+        // Starts with the MD5 of the path, which we have no use for
+        const std::uint8_t *raw = toc.data() + i * entry_size;
+        file_entries[i].first_block = static_cast<std::uint32_t>(read_be(raw + 16, 4));
+        file_entries[i].size = read_be(raw + 20, 5);
+        file_entries[i].offset = read_be(raw + 25, 5);
+    }
+
+    // The lengths of the blocks take as few bytes as the block size allows
+    const std::size_t length_size = (archive_block_size <= 0x10000) ? 2 : ((archive_block_size <= 0x1000000) ? 3 : 4);
+    const std::size_t table_start = static_cast<std::size_t>(entry_count) * entry_size;
+    const std::size_t block_count = (toc.size() - table_start) / length_size;
+
+    block_lengths.resize(block_count);
+    for (std::size_t i = 0; i < block_count; i++) {
+        block_lengths[i] = static_cast<std::uint32_t>(read_be(toc.data() + table_start + i * length_size, length_size));
+    }
+
+    // The blocks of a file follow each other
+    block_offsets.assign(block_count, 0);
+    for (const PsarcEntry &entry : file_entries) {
+        const std::uint64_t blocks = (entry.size + archive_block_size - 1) / archive_block_size;
+        if (entry.first_block + blocks > block_count)
+            return false;
+
+        std::uint64_t offset = entry.offset;
+        for (std::uint64_t i = 0; i < blocks; i++) {
+            const std::uint32_t block = entry.first_block + static_cast<std::uint32_t>(i);
+            block_offsets[block] = offset;
+            offset += (block_lengths[block] == 0) ? archive_block_size : block_lengths[block];
+        }
+    }
+
+    archive_id = next_archive_id++;
+
+    // The manifest is read like any file, though it is never cached
+    std::string manifest(file_entries[0].size, '\0');
+    BlockCache manifest_cache(0);
+    if (read(file_entries[0], manifest.data(), manifest.size(), 0, manifest_cache, nullptr) != static_cast<std::int64_t>(manifest.size()))
+        return false;
+
+    std::size_t start = 0;
+    for (std::uint32_t i = 1; i < entry_count; i++) {
+        std::size_t end = manifest.find('\n', start);
+        if (end == std::string::npos)
+            end = manifest.size();
+
+        std::string path = manifest.substr(start, end - start);
+        if (!path.empty() && (path.back() == '\0' || path.back() == '\r'))
+            path.pop_back();
+
+        file_entries[i].path = path;
+        index.emplace(make_key(path), i);
+
+        start = std::min(end + 1, manifest.size());
+    }
+
+    return true;
+}
+
+std::uint64_t Psarc::index_size() const {
+    return toc_length + (file_entries.empty() ? 0 : file_entries[0].size);
+}
+
+std::vector<const PsarcEntry *> Psarc::entries() const {
+    std::vector<const PsarcEntry *> result;
+    for (std::size_t i = 1; i < file_entries.size(); i++) {
+        result.push_back(&file_entries[i]);
+    }
+
+    return result;
+}
+
+const PsarcEntry *Psarc::find(const std::string &path) const {
+    const auto entry = index.find(make_key(path));
+    if (entry == index.end())
+        return nullptr;
+
+    return &file_entries[entry->second];
+}
+
+bool Psarc::load_block(const std::uint32_t block, const std::uint32_t size, std::vector<std::uint8_t> &data) const {
+    const std::uint32_t stored = (block_lengths[block] == 0) ? archive_block_size : block_lengths[block];
+
+    std::vector<std::uint8_t> raw(stored);
+    if (read_archive(raw.data(), raw.size(), block_offsets[block]) != static_cast<std::int64_t>(raw.size()))
+        return false;
+
+    data.resize(size);
+
+    // Blocks which would not get smaller are stored as they are, and so is anything without the zlib header
+    const bool is_compressed = (stored < size) && ((compression != Compression::ZLIB) || ((raw.size() >= 2) && (raw[0] == 0x78)));
+    if (!is_compressed) {
+        if (stored < size)
+            return false;
+
+        std::memcpy(data.data(), raw.data(), size);
+        return true;
+    }
+
+    if (compression == Compression::LZMA) {
+        // Each block is a whole .lzma stream, header included
+        std::size_t decompressed = size;
+        if (lzmadec_decode_alone(data.data(), &decompressed, raw.data(), raw.size()) != LZMADEC_OK)
+            return false;
+
+        return decompressed == size;
+    }
+
+    mz_ulong decompressed = size;
+    if (mz_uncompress(data.data(), &decompressed, raw.data(), static_cast<mz_ulong>(raw.size())) != MZ_OK)
+        return false;
+
+    return decompressed == size;
+}
+
+bool Psarc::fetch(const PsarcEntry &entry, const std::uint64_t first, const std::uint64_t last, BlockCache &cache, util::ThreadPool *workers, std::vector<Block> *blocks) const {
+    std::vector<std::uint64_t> missing;
+
+    if (blocks)
+        blocks->resize(last - first + 1);
+
+    for (std::uint64_t i = first; i <= last; i++) {
+        Block block = cache.find(archive_id, entry.first_block + static_cast<std::uint32_t>(i));
+        if (!block) {
+            missing.push_back(i);
+        } else if (blocks) {
+            (*blocks)[i - first] = std::move(block);
+        }
+    }
+
+    std::atomic<bool> failed = false;
+
+    const auto decompress = [&](std::size_t n) {
+        const std::uint64_t i = missing[n];
+        const std::uint32_t size = static_cast<std::uint32_t>(std::min<std::uint64_t>(archive_block_size, entry.size - i * archive_block_size));
+
+        auto data = std::make_shared<std::vector<std::uint8_t>>();
+        if (!load_block(entry.first_block + static_cast<std::uint32_t>(i), size, *data)) {
+            failed = true;
+            return;
+        }
+
+        cache.insert(archive_id, entry.first_block + static_cast<std::uint32_t>(i), data);
+        if (blocks)
+            (*blocks)[i - first] = std::move(data);
+    };
+
+    // A single block is not worth handing over to another thread
+    if (workers && (missing.size() > 1)) {
+        workers->parallel_for(missing.size(), decompress);
+    } else {
+        for (std::size_t n = 0; n < missing.size(); n++) {
+            decompress(n);
+        }
+    }
+
+    return !failed;
+}
+
+std::int64_t Psarc::read(const PsarcEntry &entry, void *data, const std::uint64_t size, const std::uint64_t offset, BlockCache &cache, util::ThreadPool *workers) const {
+    if ((offset >= entry.size) || (size == 0))
+        return 0;
+
+    const std::uint64_t count = std::min(size, entry.size - offset);
+    const std::uint64_t first = offset / archive_block_size;
+    const std::uint64_t last = (offset + count - 1) / archive_block_size;
+
+    std::vector<Block> blocks;
+    if (!fetch(entry, first, last, cache, workers, &blocks))
+        return -1;
+
+    std::uint8_t *output = static_cast<std::uint8_t *>(data);
+    std::uint64_t position = offset;
+    while (position < offset + count) {
+        const Block &block = blocks[position / archive_block_size - first];
+        const std::uint64_t in_block = position % archive_block_size;
+        const std::uint64_t copied = std::min<std::uint64_t>(block->size() - in_block, offset + count - position);
+
+        std::memcpy(output, block->data() + in_block, copied);
+        output += copied;
+        position += copied;
+    }
+
+    return static_cast<std::int64_t>(count);
+}
+
+bool Psarc::prefetch(const PsarcEntry &entry, const std::uint64_t size, const std::uint64_t offset, BlockCache &cache, util::ThreadPool *workers) const {
+    if ((offset >= entry.size) || (size == 0))
+        return true;
+
+    const std::uint64_t count = std::min(size, entry.size - offset);
+    return fetch(entry, offset / archive_block_size, (offset + count - 1) / archive_block_size, cache, workers, nullptr);
+}
+
+bool Psarc::is_cached(const PsarcEntry &entry, const std::uint64_t size, const std::uint64_t offset, const BlockCache &cache) const {
+    if ((offset >= entry.size) || (size == 0))
+        return true;
+
+    const std::uint64_t count = std::min(size, entry.size - offset);
+    for (std::uint64_t i = offset / archive_block_size; i <= (offset + count - 1) / archive_block_size; i++) {
+        if (!cache.contains(archive_id, entry.first_block + static_cast<std::uint32_t>(i)))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace fios
@@ -0,0 +1,126 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <fios/overlay.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+using namespace fios;
+
+namespace {
+class OverlayTest : public testing::Test {
+protected:
+    OverlayTable table;
+
+    // Paths which exist, with their modification time
+    std::map<std::string, std::uint64_t> files;
+
+    StatFunc stat = [this](const std::string &path) -> std::optional<std::uint64_t> {
+        const auto file = files.find(path);
+        if (file == files.end())
+            return std::nullopt;
+
+        return file->second;
+    };
+
+    std::int32_t add(const OverlayType type, const std::uint8_t order, const std::string &dst, const std::string &src) {
+        Overlay overlay;
+        overlay.type = type;
+        overlay.order = order;
+        overlay.dst = dst;
+        overlay.src = src;
+
+        return table.add(overlay);
+    }
+};
+} // namespace
+
+TEST_F(OverlayTest, opaque_redirects_everything) {
+    add(OverlayType::OPAQUE, 0, "/data", "/patch");
+
+    ASSERT_EQ(table.resolve("/data/file.bin", false, stat), "/patch/file.bin");
+    ASSERT_EQ(table.resolve("/data", false, stat), "/patch");
+    ASSERT_EQ(table.resolve("/data/file.bin", true, stat), "/patch/file.bin");
+
+    // Only whole directory names match
+    ASSERT_EQ(table.resolve("/database/file.bin", false, stat), "/database/file.bin");
+}
+
+TEST_F(OverlayTest, translucent_falls_through) {
+    add(OverlayType::TRANSLUCENT, 0, "/data/", "/patch/");
+    files["/patch/new.bin"] = 0;
+
+    ASSERT_EQ(table.resolve("/data/new.bin", false, stat), "/patch/new.bin");
+    ASSERT_EQ(table.resolve("/data/old.bin", false, stat), "/data/old.bin");
+
+    // Never written to
+    ASSERT_EQ(table.resolve("/data/new.bin", true, stat), "/data/new.bin");
+}
+
+TEST_F(OverlayTest, writable_takes_writes) {
+    add(OverlayType::WRITABLE, 0, "/data", "/save");
+    files["/save/present.bin"] = 0;
+
+    ASSERT_EQ(table.resolve("/data/present.bin", false, stat), "/save/present.bin");
+    ASSERT_EQ(table.resolve("/data/absent.bin", false, stat), "/data/absent.bin");
+    ASSERT_EQ(table.resolve("/data/absent.bin", true, stat), "/save/absent.bin");
+}
+
+TEST_F(OverlayTest, newer_compares_times) {
+    add(OverlayType::NEWER, 0, "/data", "/patch");
+    files["/data/a.bin"] = 10;
+    files["/patch/a.bin"] = 20;
+    files["/data/b.bin"] = 30;
+    files["/patch/b.bin"] = 20;
+    files["/patch/c.bin"] = 5;
+
+    ASSERT_EQ(table.resolve("/data/a.bin", false, stat), "/patch/a.bin");
+    ASSERT_EQ(table.resolve("/data/b.bin", false, stat), "/data/b.bin");
+    ASSERT_EQ(table.resolve("/data/c.bin", false, stat), "/patch/c.bin");
+    ASSERT_EQ(table.resolve("/data/d.bin", false, stat), "/data/d.bin");
+}
+
+TEST_F(OverlayTest, highest_order_wins) {
+    add(OverlayType::OPAQUE, 1, "/data", "/low");
+    add(OverlayType::OPAQUE, 5, "/data", "/high");
+    add(OverlayType::OPAQUE, 5, "/data", "/later");
+
+    ASSERT_EQ(table.resolve("/data/file.bin", false, stat), "/high/file.bin");
+}
+
+TEST_F(OverlayTest, modify_and_remove) {
+    const std::int32_t first = add(OverlayType::OPAQUE, 1, "/data", "/first");
+    const std::int32_t second = add(OverlayType::OPAQUE, 2, "/data", "/second");
+    ASSERT_NE(first, second);
+    ASSERT_EQ(table.list(), (std::vector<std::int32_t>{ second, first }));
+
+    Overlay changed = *table.get(first);
+    changed.order = 3;
+    ASSERT_TRUE(table.modify(first, changed));
+    ASSERT_EQ(table.get(first)->id, first);
+    ASSERT_EQ(table.resolve("/data/file.bin", false, stat), "/first/file.bin");
+
+    ASSERT_TRUE(table.remove(first));
+    ASSERT_FALSE(table.remove(first));
+    ASSERT_FALSE(table.get(first));
+    ASSERT_EQ(table.resolve("/data/file.bin", false, stat), "/second/file.bin");
+
+    table.clear();
+    ASSERT_EQ(table.resolve("/data/file.bin", false, stat), "/data/file.bin");
+}
@@ -0,0 +1,433 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <fios/psarc.h>
+
+#include <util/thread_pool.h>
+
+#include <gtest/gtest.h>
+#include <miniz.h>
+
+#include <cstring>
+#include <atomic>
+#include <functional>
+
+using namespace fios;
+
+namespace {
+struct TestFile {
+    std::string path;
+    std::vector<std::uint8_t> data;
+};
+
+// Returns the packed block, or nothing to store it raw
+typedef std::function<std::vector<std::uint8_t>(const std::uint8_t *data, std::size_t size)> Packer;
+
+std::vector<std::uint8_t> pack_zlib(const std::uint8_t *data, const std::size_t size) {
+    std::vector<std::uint8_t> packed(mz_compressBound(static_cast<mz_ulong>(size)));
+    mz_ulong packed_size = static_cast<mz_ulong>(packed.size());
+    if (mz_compress(packed.data(), &packed_size, data, static_cast<mz_ulong>(size)) != MZ_OK)
+        return {};
+
+    packed.resize(packed_size);
+    return packed;
+}
+
+// Build an archive the same way the official packer does, blocks which don't shrink being stored raw
+std::vector<std::uint8_t> make_psarc(const std::vector<TestFile> &files, const std::uint32_t block_size, const bool ignore_case, const char *compression = "zlib", const Packer &pack = pack_zlib) {
+    std::vector<TestFile> all_files;
+
+    std::string manifest;
+    for (const TestFile &file : files) {
+        manifest += (manifest.empty() ? "" : "\n") + file.path;
+    }
+    all_files.push_back({ "", std::vector<std::uint8_t>(manifest.begin(), manifest.end()) });
+    all_files.insert(all_files.end(), files.begin(), files.end());
+
+    std::vector<std::uint32_t> lengths;
+    std::vector<std::uint8_t> blocks;
+    std::vector<std::uint32_t> first_blocks;
+    std::vector<std::uint64_t> offsets;
+
+    for (const TestFile &file : all_files) {
+        first_blocks.push_back(static_cast<std::uint32_t>(lengths.size()));
+        offsets.push_back(blocks.size());
+
+        for (std::size_t start = 0; start < file.data.size(); start += block_size) {
+            const std::size_t size = std::min<std::size_t>(block_size, file.data.size() - start);
+
+            const std::vector<std::uint8_t> packed = pack(file.data.data() + start, size);
+
+            if (!packed.empty() && (packed.size() < size)) {
+                blocks.insert(blocks.end(), packed.begin(), packed.end());
+                lengths.push_back(static_cast<std::uint32_t>(packed.size()));
+            } else {
+                blocks.insert(blocks.end(), file.data.begin() + start, file.data.begin() + start + size);
+                lengths.push_back((size == block_size) ? 0 : static_cast<std::uint32_t>(size));
+            }
+        }
+    }
+
+    const std::size_t length_size = (block_size <= 0x10000) ? 2 : 3;
+    const std::uint32_t toc_length = static_cast<std::uint32_t>(0x20 + all_files.size() * 30 + lengths.size() * length_size);
+
+    std::vector<std::uint8_t> archive;
+    const auto write_be = [&](std::uint64_t value, std::size_t size) {
+        for (std::size_t i = 0; i < size; i++) {
+            archive.push_back(static_cast<std::uint8_t>(value >> ((size - i - 1) * 8)));
+        }
+    };
+
+    archive.insert(archive.end(), { 'P', 'S', 'A', 'R' });
+    write_be(1, 2);
+    write_be(4, 2);
+    archive.insert(archive.end(), compression, compression + 4);
+    write_be(toc_length, 4);
+    write_be(30, 4);
+    write_be(all_files.size(), 4);
+    write_be(block_size, 4);
+    write_be(ignore_case ? 1 : 0, 4);
+
+    for (std::size_t i = 0; i < all_files.size(); i++) {
+        archive.insert(archive.end(), 16, 0);
+        write_be(first_blocks[i], 4);
+        write_be(all_files[i].data.size(), 5);
+        write_be(toc_length + offsets[i], 5);
+    }
+
+    for (const std::uint32_t length : lengths) {
+        write_be(length, length_size);
+    }
+
+    archive.insert(archive.end(), blocks.begin(), blocks.end());
+    return archive;
+}
+
+std::vector<std::uint8_t> make_data(const std::size_t size, const std::uint32_t seed) {
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; i++) {
+        // Compressible, but different from one block to the next
+        data[i] = static_cast<std::uint8_t>((i / 7) * seed + (i >> 12));
+    }
+
+    return data;
+}
+
+std::vector<std::uint8_t> make_noise(const std::size_t size) {
+    std::vector<std::uint8_t> data(size);
+    std::uint32_t state = 0x12345678;
+    for (std::size_t i = 0; i < size; i++) {
+        state = state * 1664525 + 1013904223;
+        data[i] = static_cast<std::uint8_t>(state >> 24);
+    }
+
+    return data;
+}
+
+class PsarcTest : public testing::Test {
+protected:
+    static constexpr std::uint32_t BLOCK_SIZE = 0x10000;
+
+    std::vector<TestFile> files;
+    std::vector<std::uint8_t> archive;
+    std::atomic<std::uint64_t> archive_reads = 0;
+
+    Psarc psarc;
+    BlockCache cache;
+
+    bool open(const bool ignore_case = false, const std::uint32_t block_size = BLOCK_SIZE) {
+        archive = make_psarc(files, block_size, ignore_case);
+
+        return psarc.open([this](void *data, std::uint64_t size, std::uint64_t offset) -> std::int64_t {
+            archive_reads++;
+            if (offset >= archive.size())
+                return 0;
+
+            const std::uint64_t count = std::min<std::uint64_t>(size, archive.size() - offset);
+            std::memcpy(data, archive.data() + offset, count);
+            return static_cast<std::int64_t>(count);
+        });
+    }
+
+    void SetUp() override {
+        files.push_back({ "/data/big.bin", make_data(BLOCK_SIZE * 5 + 1234, 3) });
+        files.push_back({ "/data/small.txt", make_data(100, 5) });
+        files.push_back({ "/Sound/Noise.at9", make_noise(BLOCK_SIZE * 2 + 10) });
+        files.push_back({ "/empty", {} });
+    }
+};
+} // namespace
+
+TEST_F(PsarcTest, reads_whole_files) {
+    ASSERT_TRUE(open());
+    ASSERT_EQ(psarc.entries().size(), files.size());
+
+    for (const TestFile &file : files) {
+        const PsarcEntry *entry = psarc.find(file.path);
+        ASSERT_NE(entry, nullptr) << file.path;
+        ASSERT_EQ(entry->size, file.data.size());
+
+        std::vector<std::uint8_t> data(file.data.size() + 16);
+        ASSERT_EQ(psarc.read(*entry, data.data(), data.size(), 0, cache, nullptr), static_cast<std::int64_t>(file.data.size()));
+        data.resize(file.data.size());
+        ASSERT_EQ(data, file.data) << file.path;
+    }
+}
+
+TEST_F(PsarcTest, reads_at_odd_offsets) {
+    ASSERT_TRUE(open());
+
+    const TestFile &file = files[0];
+    const PsarcEntry *entry = psarc.find(file.path);
+    ASSERT_NE(entry, nullptr);
+
+    // Inside one block, across two blocks, across several blocks and past the end
+    const std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges = {
+        { 17, 100 },
+        { BLOCK_SIZE - 3, 7 },
+        { BLOCK_SIZE / 2, BLOCK_SIZE * 3 },
+        { file.data.size() - 10, 100 },
+    };
+
+    for (const auto &[offset, size] : ranges) {
+        const std::uint64_t expected = std::min<std::uint64_t>(size, file.data.size() - offset);
+
+        std::vector<std::uint8_t> data(size);
+        ASSERT_EQ(psarc.read(*entry, data.data(), size, offset, cache, nullptr), static_cast<std::int64_t>(expected));
+        ASSERT_EQ(std::memcmp(data.data(), file.data.data() + offset, expected), 0) << offset;
+    }
+
+    std::uint8_t byte;
+    ASSERT_EQ(psarc.read(*entry, &byte, 1, file.data.size(), cache, nullptr), 0);
+}
+
+TEST_F(PsarcTest, decompresses_on_workers) {
+    files.push_back({ "/data/huge.bin", make_data(BLOCK_SIZE * 64, 11) });
+    ASSERT_TRUE(open());
+
+    util::ThreadPool workers(4);
+
+    const TestFile &file = files.back();
+    const PsarcEntry *entry = psarc.find(file.path);
+    ASSERT_NE(entry, nullptr);
+
+    std::vector<std::uint8_t> data(file.data.size());
+    ASSERT_EQ(psarc.read(*entry, data.data(), data.size(), 0, cache, &workers), static_cast<std::int64_t>(data.size()));
+    ASSERT_EQ(data, file.data);
+}
+
+TEST_F(PsarcTest, cached_blocks_are_not_read_again) {
+    ASSERT_TRUE(open());
+
+    const PsarcEntry *entry = psarc.find("/data/big.bin");
+    ASSERT_NE(entry, nullptr);
+
+    std::vector<std::uint8_t> data(entry->size);
+    ASSERT_EQ(psarc.read(*entry, data.data(), data.size(), 0, cache, nullptr), static_cast<std::int64_t>(data.size()));
+
+    const std::uint64_t reads = archive_reads;
+    cache.reset_stats();
+
+    ASSERT_EQ(psarc.read(*entry, data.data(), 10, BLOCK_SIZE * 2 + 5, cache, nullptr), 10);
+    ASSERT_EQ(archive_reads, reads);
+    ASSERT_EQ(cache.stats().hits, 1);
+    ASSERT_EQ(cache.stats().misses, 0);
+
+    cache.flush(psarc.id());
+    ASSERT_EQ(cache.used_bytes(), 0);
+    ASSERT_EQ(psarc.read(*entry, data.data(), 10, BLOCK_SIZE * 2 + 5, cache, nullptr), 10);
+    ASSERT_EQ(archive_reads, reads + 1);
+}
+
+TEST_F(PsarcTest, prefetch_fills_the_cache) {
+    ASSERT_TRUE(open());
+
+    const PsarcEntry *entry = psarc.find("/data/big.bin");
+    ASSERT_NE(entry, nullptr);
+
+    ASSERT_FALSE(psarc.is_cached(*entry, BLOCK_SIZE, BLOCK_SIZE, cache));
+    ASSERT_TRUE(psarc.prefetch(*entry, BLOCK_SIZE + 1, BLOCK_SIZE, cache, nullptr));
+    ASSERT_TRUE(psarc.is_cached(*entry, BLOCK_SIZE, BLOCK_SIZE, cache));
+    ASSERT_TRUE(psarc.is_cached(*entry, BLOCK_SIZE + 1, BLOCK_SIZE, cache));
+    ASSERT_FALSE(psarc.is_cached(*entry, BLOCK_SIZE + 1, BLOCK_SIZE * 2, cache));
+    ASSERT_FALSE(psarc.is_cached(*entry, entry->size, 0, cache));
+
+    // Empty ranges are always there
+    ASSERT_TRUE(psarc.is_cached(*entry, 0, 0, cache));
+}
+
+TEST_F(PsarcTest, stores_incompressible_blocks_raw) {
+    ASSERT_TRUE(open());
+
+    const TestFile &file = files[2];
+    const PsarcEntry *entry = psarc.find(file.path);
+    ASSERT_NE(entry, nullptr);
+
+    std::vector<std::uint8_t> data(file.data.size());
+    ASSERT_EQ(psarc.read(*entry, data.data(), data.size(), 0, cache, nullptr), static_cast<std::int64_t>(data.size()));
+    ASSERT_EQ(data, file.data);
+}
+
+TEST_F(PsarcTest, larger_blocks_use_wider_lengths) {
+    files.push_back({ "/data/wide.bin", make_data(0x30000, 7) });
+    ASSERT_TRUE(open(false, 0x20000));
+
+    const TestFile &file = files.back();
+    const PsarcEntry *entry = psarc.find(file.path);
+    ASSERT_NE(entry, nullptr);
+
+    std::vector<std::uint8_t> data(file.data.size());
+    ASSERT_EQ(psarc.read(*entry, data.data(), data.size(), 0, cache, nullptr), static_cast<std::int64_t>(data.size()));
+    ASSERT_EQ(data, file.data);
+}
+
+TEST_F(PsarcTest, finds_paths) {
+    ASSERT_TRUE(open());
+
+    ASSERT_NE(psarc.find("data/small.txt"), nullptr);
+    ASSERT_NE(psarc.find("/data/small.txt"), nullptr);
+    ASSERT_EQ(psarc.find("/DATA/small.txt"), nullptr);
+    ASSERT_EQ(psarc.find("/data"), nullptr);
+}
+
+TEST_F(PsarcTest, finds_paths_ignoring_case) {
+    ASSERT_TRUE(open(true));
+
+    const PsarcEntry *entry = psarc.find("/sound/noise.AT9");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->path, "/Sound/Noise.at9");
+    ASSERT_NE(psarc.find("DATA/SMALL.TXT"), nullptr);
+}
+
+TEST_F(PsarcTest, rejects_invalid_archives) {
+    archive = make_psarc(files, BLOCK_SIZE, false);
+    archive[0] = 'X';
+
+    const auto read = [this](void *data, std::uint64_t size, std::uint64_t offset) -> std::int64_t {
+        if (offset >= archive.size())
+            return 0;
+
+        const std::uint64_t count = std::min<std::uint64_t>(size, archive.size() - offset);
+        std::memcpy(data, archive.data() + offset, count);
+        return static_cast<std::int64_t>(count);
+    };
+
+    ASSERT_FALSE(psarc.open(read));
+
+    // Cut in the middle of the table of contents
+    archive = make_psarc(files, BLOCK_SIZE, false);
+    archive.resize(0x30);
+    ASSERT_FALSE(psarc.open(read));
+}
+
+TEST_F(PsarcTest, archives_do_not_share_blocks) {
+    ASSERT_TRUE(open());
+
+    Psarc other;
+    const std::vector<std::uint8_t> other_archive = make_psarc({ { "/data/big.bin", make_data(BLOCK_SIZE, 9) } }, BLOCK_SIZE, false);
+    ASSERT_TRUE(other.open([&](void *data, std::uint64_t size, std::uint64_t offset) -> std::int64_t {
+        const std::uint64_t count = std::min<std::uint64_t>(size, other_archive.size() - offset);
+        std::memcpy(data, other_archive.data() + offset, count);
+        return static_cast<std::int64_t>(count);
+    }));
+    ASSERT_NE(psarc.id(), other.id());
+
+    std::uint8_t first[16];
+    std::uint8_t second[16];
+    ASSERT_EQ(psarc.read(*psarc.find("/data/big.bin"), first, sizeof(first), 100, cache, nullptr), 16);
+    ASSERT_EQ(other.read(*other.find("/data/big.bin"), second, sizeof(second), 100, cache, nullptr), 16);
+    ASSERT_NE(std::memcmp(first, second, sizeof(first)), 0);
+}
+
+TEST_F(PsarcTest, reads_lzma_archives) {
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text += "Hello from an LZMA archive\n";
+    }
+
+    // Made by the lzma module of Python, with the unpacked size written in the header like the official packer does
+    static const std::vector<std::uint8_t> packed_text = {
+        0x5d, 0x00, 0x00, 0x01, 0x00, 0x18, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x19,
+        0x49, 0x98, 0x6f, 0x10, 0x15, 0x88, 0x4c, 0x89, 0xfc, 0x9a, 0x26, 0x08, 0x03, 0x2b, 0xfc, 0x2b,
+        0x7a, 0x87, 0x7f, 0x0f, 0x2f, 0x9f, 0x35, 0x29, 0x4f, 0x18, 0xe1, 0x44, 0xc0, 0x1c, 0xe7, 0x60,
+        0x15, 0xce, 0xd5, 0x90, 0x11, 0x82, 0xe7, 0xcc, 0xf8, 0x45, 0xa9, 0xec, 0xf2, 0xbe, 0x90, 0xd2,
+        0x8b, 0x39, 0xa2, 0xae, 0xbd, 0x67, 0xee, 0x70, 0xa7, 0xff, 0xff, 0xc1, 0x8c, 0x80, 0x00
+    };
+
+    // There is no encoder at hand, anything but the text is stored raw
+    const std::vector<std::uint8_t> data(text.begin(), text.end());
+    const Packer pack = [&](const std::uint8_t *block, std::size_t size) -> std::vector<std::uint8_t> {
+        if ((size == data.size()) && (std::memcmp(block, data.data(), size) == 0))
+            return packed_text;
+
+        return {};
+    };
+
+    files = { { "/text/hello.txt", data }, { "/data/raw.bin", make_noise(BLOCK_SIZE + 10) } };
+    archive = make_psarc(files, BLOCK_SIZE, false, "lzma", pack);
+    ASSERT_TRUE(psarc.open([this](void *out, std::uint64_t size, std::uint64_t offset) -> std::int64_t {
+        if (offset >= archive.size())
+            return 0;
+
+        const std::uint64_t count = std::min<std::uint64_t>(size, archive.size() - offset);
+        std::memcpy(out, archive.data() + offset, count);
+        return static_cast<std::int64_t>(count);
+    }));
+
+    for (const TestFile &file : files) {
+        const PsarcEntry *entry = psarc.find(file.path);
+        ASSERT_NE(entry, nullptr) << file.path;
+
+        std::vector<std::uint8_t> read(file.data.size());
+        ASSERT_EQ(psarc.read(*entry, read.data(), read.size(), 0, cache, nullptr), static_cast<std::int64_t>(file.data.size()));
+        ASSERT_EQ(read, file.data) << file.path;
+    }
+
+    // A damaged block is an error, not garbage
+    archive[archive.size() - BLOCK_SIZE - 10 - 20] ^= 0x55;
+    std::vector<std::uint8_t> read(data.size());
+    BlockCache fresh_cache;
+    ASSERT_LT(psarc.read(*psarc.find("/text/hello.txt"), read.data(), read.size(), 0, fresh_cache, nullptr), 0);
+}
+
+TEST(BlockCacheTest, evicts_least_recently_used) {
+    BlockCache cache(300);
+
+    const auto make_block = [](std::size_t size) {
+        return std::make_shared<const std::vector<std::uint8_t>>(size);
+    };
+
+    cache.insert(1, 0, make_block(100));
+    cache.insert(1, 1, make_block(100));
+    cache.insert(1, 2, make_block(100));
+    ASSERT_TRUE(cache.find(1, 0));
+
+    cache.insert(2, 0, make_block(100));
+    ASSERT_EQ(cache.used_bytes(), 300);
+    ASSERT_FALSE(cache.contains(1, 1));
+    ASSERT_TRUE(cache.contains(1, 0));
+    ASSERT_EQ(cache.stats().evictions, 1);
+
+    // A block larger than the budget still stays until the next one comes
+    cache.insert(3, 0, make_block(1000));
+    ASSERT_TRUE(cache.contains(3, 0));
+    ASSERT_EQ(cache.used_bytes(), 1000);
+
+    cache.flush();
+    ASSERT_EQ(cache.used_bytes(), 0);
+    ASSERT_FALSE(cache.contains(3, 0));
+}
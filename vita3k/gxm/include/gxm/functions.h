@@ -41,7 +41,25 @@ size_t index_element_size(SceGxmIndexFormat format);
 bool is_stream_instancing(SceGxmIndexSource source);
 bool convert_color_format_to_texture_format(SceGxmColorFormat format, SceGxmTextureFormat &dest_format);
 // Transfer
+struct TransferImage {
+    uint8_t *address;
+    SceGxmTransferFormat format;
+    SceGxmTransferType type;
+    uint32_t x;
+    uint32_t y;
+    int32_t stride;
+};
 uint32_t get_bits_per_pixel(SceGxmTransferFormat Format);
+void transfer_copy(const TransferImage &src, const TransferImage &dest, uint32_t width, uint32_t height,
+    SceGxmTransferColorKeyMode color_key_mode, uint32_t color_key_value, uint32_t color_key_mask);
+void transfer_downscale(const TransferImage &src, const TransferImage &dest, uint32_t src_width, uint32_t src_height);
+void transfer_fill(const TransferImage &dest, uint32_t width, uint32_t height, uint32_t fill_color);
+// Indices.
+struct IndexRange {
+    uint32_t min = 0;
+    uint32_t max = 0;
+};
+IndexRange get_index_range(const void *indices, SceGxmIndexFormat format, size_t count);
 } // namespace gxm
 
 namespace gxp {
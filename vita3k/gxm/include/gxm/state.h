@@ -17,12 +17,18 @@
 
 #pragma once
 
+#include <gxm/functions.h>
 #include <gxm/types.h>
 #include <mem/ptr.h>
 #include <threads/queue.h>
+#include <util/thread_pool.h>
 
+#include <atomic>
+#include <future>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <tuple>
 
 typedef void SceGxmDisplayQueueCallback(Ptr<const void> callbackData);
 static constexpr std::uint64_t SCENE_TIME_UNDEF = 0xFFFFFFFFFFFFFFFF;
@@ -71,6 +77,22 @@ struct SurfaceSyncingInfo {
     }
 };
 
+struct IndexRangeCacheKey {
+    Address address;
+    std::uint32_t count;
+    SceGxmIndexFormat format;
+
+    bool operator<(const IndexRangeCacheKey &rhs) const {
+        return std::tie(address, count, format) < std::tie(rhs.address, rhs.count, rhs.format);
+    }
+};
+
+struct IndexRangeCacheInfo {
+    gxm::IndexRange range;
+    // Set by the write protection callback once the guest touches the index buffer
+    std::atomic<bool> dirty = true;
+};
+
 struct GxmState {
     SceGxmInitializeParams params;
     Queue<DisplayCallback> display_queue;
@@ -79,4 +101,10 @@ struct GxmState {
     std::map<Address, MemoryMapInfo> memory_mapped_regions;
     std::array<SurfaceSyncingInfo, 40> surface_syncing_infoes;
     std::mutex callback_lock;
+    std::map<IndexRangeCacheKey, std::shared_ptr<IndexRangeCacheInfo>> index_range_cache;
+    std::mutex index_range_cache_lock;
+    // Transfers run in submission order on a single worker
+    std::unique_ptr<util::ThreadPool> transfer_worker;
+    std::shared_future<void> last_transfer;
+    std::mutex transfer_lock;
 };
@@ -0,0 +1,160 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <gxm/functions.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define INDICES_USE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define INDICES_USE_NEON
+#endif
+
+namespace gxm {
+
+template <typename T>
+static void scan_scalar(const T *indices, size_t count, uint32_t &min, uint32_t &max) {
+    for (size_t i = 0; i < count; i++) {
+        min = std::min<uint32_t>(min, indices[i]);
+        max = std::max<uint32_t>(max, indices[i]);
+    }
+}
+
+#ifdef INDICES_USE_SSE2
+// SSE2 only has signed comparisons, flipping the sign bit maps unsigned order onto signed order
+static inline __m128i min_epu32(__m128i a, __m128i b, __m128i sign) {
+    const __m128i a_greater = _mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+    return _mm_or_si128(_mm_and_si128(a_greater, b), _mm_andnot_si128(a_greater, a));
+}
+
+static inline __m128i max_epu32(__m128i a, __m128i b, __m128i sign) {
+    const __m128i a_greater = _mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+    return _mm_or_si128(_mm_and_si128(a_greater, a), _mm_andnot_si128(a_greater, b));
+}
+
+static IndexRange scan_u16(const uint16_t *indices, size_t count) {
+    const __m128i sign = _mm_set1_epi16(static_cast<short>(0x8000));
+    __m128i min_lanes = _mm_set1_epi16(0x7FFF);
+    __m128i max_lanes = _mm_set1_epi16(static_cast<short>(0x8000));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i values = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)), sign);
+        min_lanes = _mm_min_epi16(min_lanes, values);
+        max_lanes = _mm_max_epi16(max_lanes, values);
+    }
+
+    alignas(16) uint16_t min_values[8];
+    alignas(16) uint16_t max_values[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(min_values), _mm_xor_si128(min_lanes, sign));
+    _mm_store_si128(reinterpret_cast<__m128i *>(max_values), _mm_xor_si128(max_lanes, sign));
+
+    IndexRange range{ *std::min_element(min_values, min_values + 8), *std::max_element(max_values, max_values + 8) };
+    scan_scalar(indices + i, count - i, range.min, range.max);
+
+    return range;
+}
+
+static IndexRange scan_u32(const uint32_t *indices, size_t count) {
+    const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000));
+    __m128i min_lanes = _mm_set1_epi32(-1);
+    __m128i max_lanes = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i));
+        min_lanes = min_epu32(min_lanes, values, sign);
+        max_lanes = max_epu32(max_lanes, values, sign);
+    }
+
+    alignas(16) uint32_t min_values[4];
+    alignas(16) uint32_t max_values[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(min_values), min_lanes);
+    _mm_store_si128(reinterpret_cast<__m128i *>(max_values), max_lanes);
+
+    IndexRange range{ *std::min_element(min_values, min_values + 4), *std::max_element(max_values, max_values + 4) };
+    scan_scalar(indices + i, count - i, range.min, range.max);
+
+    return range;
+}
+#elif defined(INDICES_USE_NEON)
+static IndexRange scan_u16(const uint16_t *indices, size_t count) {
+    uint16x8_t min_lanes = vdupq_n_u16(0xFFFF);
+    uint16x8_t max_lanes = vdupq_n_u16(0);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t values = vld1q_u16(indices + i);
+        min_lanes = vminq_u16(min_lanes, values);
+        max_lanes = vmaxq_u16(max_lanes, values);
+    }
+
+    IndexRange range{ vminvq_u16(min_lanes), vmaxvq_u16(max_lanes) };
+    scan_scalar(indices + i, count - i, range.min, range.max);
+
+    return range;
+}
+
+static IndexRange scan_u32(const uint32_t *indices, size_t count) {
+    uint32x4_t min_lanes = vdupq_n_u32(0xFFFFFFFF);
+    uint32x4_t max_lanes = vdupq_n_u32(0);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t values = vld1q_u32(indices + i);
+        min_lanes = vminq_u32(min_lanes, values);
+        max_lanes = vmaxq_u32(max_lanes, values);
+    }
+
+    IndexRange range{ vminvq_u32(min_lanes), vmaxvq_u32(max_lanes) };
+    scan_scalar(indices + i, count - i, range.min, range.max);
+
+    return range;
+}
+#else
+template <typename T>
+static IndexRange scan_generic(const T *indices, size_t count) {
+    IndexRange range{ 0xFFFFFFFF, 0 };
+    scan_scalar(indices, count, range.min, range.max);
+    return range;
+}
+
+static IndexRange scan_u16(const uint16_t *indices, size_t count) {
+    return scan_generic(indices, count);
+}
+
+static IndexRange scan_u32(const uint32_t *indices, size_t count) {
+    return scan_generic(indices, count);
+}
+#endif
+
+IndexRange get_index_range(const void *indices, SceGxmIndexFormat format, size_t count) {
+    if (count == 0) {
+        return {};
+    }
+
+    if (format == SCE_GXM_INDEX_FORMAT_U16) {
+        return scan_u16(static_cast<const uint16_t *>(indices), count);
+    }
+
+    return scan_u32(static_cast<const uint32_t *>(indices), count);
+}
+
+} // namespace gxm
@@ -15,7 +15,17 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
-#include <gxm/types.h>
+#include <gxm/functions.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSFER_USE_SSE2
+#endif
 
 namespace gxm {
 uint32_t get_bits_per_pixel(SceGxmTransferFormat Format) {
@@ -46,4 +56,238 @@ uint32_t get_bits_per_pixel(SceGxmTransferFormat Format) {
 
     return 0;
 }
+
+static uint32_t get_bytes_per_pixel(SceGxmTransferFormat format) {
+    return (get_bits_per_pixel(format) + 7) >> 3;
+}
+
+// Spread the lower 16 bits so there is a zero bit between each of them
+static uint64_t part_1_by_1(uint64_t v) {
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static int64_t get_pixel_offset(const TransferImage &image, uint32_t x, uint32_t y, uint32_t bytes_per_pixel) {
+    const uint64_t px = image.x + x;
+    const uint64_t py = image.y + y;
+
+    switch (image.type) {
+    case SCE_GXM_TRANSFER_TILED: {
+        // 32x32 tiles stored row after row, texels are linear inside a tile
+        const uint64_t width_in_tiles = (std::abs(image.stride) / bytes_per_pixel + 31) >> 5;
+        const uint64_t tile = (px >> 5) + width_in_tiles * (py >> 5);
+        return static_cast<int64_t>(((tile << 10) | (px & 31) | ((py & 31) << 5)) * bytes_per_pixel);
+    }
+    case SCE_GXM_TRANSFER_SWIZZLED:
+        // Morton order. The transfer does not give the surface height, so it is addressed as a square.
+        return static_cast<int64_t>((part_1_by_1(px) | (part_1_by_1(py) << 1)) * bytes_per_pixel);
+    default:
+        return static_cast<int64_t>(py) * image.stride + static_cast<int64_t>(px * bytes_per_pixel);
+    }
+}
+
+// Number of pixels starting at column x which follow each other in memory
+static uint32_t get_contiguous_pixels(const TransferImage &image, uint32_t x) {
+    const uint32_t px = image.x + x;
+
+    switch (image.type) {
+    case SCE_GXM_TRANSFER_TILED:
+        return 32 - (px & 31);
+    case SCE_GXM_TRANSFER_SWIZZLED:
+        return 2 - (px & 1);
+    default:
+        return UINT32_MAX;
+    }
+}
+
+// Walk the rectangle as runs of pixels which are contiguous in both images, so each run is a single bulk copy
+template <typename F>
+static void for_each_span(const TransferImage &src, const TransferImage &dest, uint32_t width, uint32_t height,
+    uint32_t src_bpp, uint32_t dest_bpp, F &&func) {
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width;) {
+            const uint32_t count = std::min({ width - x, get_contiguous_pixels(src, x), get_contiguous_pixels(dest, x) });
+            func(src.address + get_pixel_offset(src, x, y, src_bpp), dest.address + get_pixel_offset(dest, x, y, dest_bpp), count);
+            x += count;
+        }
+    }
+}
+
+static uint32_t read_pixel(const uint8_t *src, uint32_t bytes_per_pixel) {
+    uint32_t color = 0;
+    memcpy(&color, src, std::min<uint32_t>(bytes_per_pixel, sizeof(color)));
+    return color;
+}
+
+static bool passes_color_key(uint32_t color, SceGxmTransferColorKeyMode mode, uint32_t value, uint32_t mask) {
+    switch (mode) {
+    case SCE_GXM_TRANSFER_COLORKEY_PASS:
+        return (color & mask) == value;
+    case SCE_GXM_TRANSFER_COLORKEY_REJECT:
+        return (color & mask) != value;
+    default:
+        return true;
+    }
+}
+
+static void copy_color_keyed(uint8_t *dest, const uint8_t *src, uint32_t count, uint32_t bytes_per_pixel,
+    SceGxmTransferColorKeyMode mode, uint32_t value, uint32_t mask) {
+    uint32_t i = 0;
+
+#ifdef TRANSFER_USE_SSE2
+    if (bytes_per_pixel == 4) {
+        const __m128i key = _mm_set1_epi32(static_cast<int>(value));
+        const __m128i key_mask = _mm_set1_epi32(static_cast<int>(mask));
+        const __m128i invert = (mode == SCE_GXM_TRANSFER_COLORKEY_REJECT) ? _mm_set1_epi32(-1) : _mm_setzero_si128();
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128i src_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+            const __m128i dest_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i * 4));
+
+            // Lanes passing the key test take the source pixel, the others keep the destination one
+            const __m128i take = _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(src_pixels, key_mask), key), invert);
+            const __m128i result = _mm_or_si128(_mm_and_si128(take, src_pixels), _mm_andnot_si128(take, dest_pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 4), result);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (passes_color_key(read_pixel(src + i * bytes_per_pixel, bytes_per_pixel), mode, value, mask)) {
+            memcpy(dest + i * bytes_per_pixel, src + i * bytes_per_pixel, bytes_per_pixel);
+        }
+    }
+}
+
+void transfer_copy(const TransferImage &src, const TransferImage &dest, uint32_t width, uint32_t height,
+    SceGxmTransferColorKeyMode color_key_mode, uint32_t color_key_value, uint32_t color_key_mask) {
+    const uint32_t src_bpp = get_bytes_per_pixel(src.format);
+    const uint32_t dest_bpp = get_bytes_per_pixel(dest.format);
+    if ((src_bpp == 0) || (dest_bpp == 0)) {
+        return;
+    }
+
+    if (src_bpp != dest_bpp) {
+        // No format conversion yet, only the bytes both pixels have in common are copied
+        const uint32_t copy_size = std::min(src_bpp, dest_bpp);
+        for_each_span(src, dest, width, height, src_bpp, dest_bpp, [&](const uint8_t *src_span, uint8_t *dest_span, uint32_t count) {
+            for (uint32_t i = 0; i < count; i++) {
+                if (passes_color_key(read_pixel(src_span + i * src_bpp, src_bpp), color_key_mode, color_key_value, color_key_mask)) {
+                    memcpy(dest_span + i * dest_bpp, src_span + i * src_bpp, copy_size);
+                }
+            }
+        });
+
+        return;
+    }
+
+    if (color_key_mode == SCE_GXM_TRANSFER_COLORKEY_NONE) {
+        for_each_span(src, dest, width, height, src_bpp, dest_bpp, [&](const uint8_t *src_span, uint8_t *dest_span, uint32_t count) {
+            memcpy(dest_span, src_span, count * src_bpp);
+        });
+    } else {
+        for_each_span(src, dest, width, height, src_bpp, dest_bpp, [&](const uint8_t *src_span, uint8_t *dest_span, uint32_t count) {
+            copy_color_keyed(dest_span, src_span, count, src_bpp, color_key_mode, color_key_value, color_key_mask);
+        });
+    }
+}
+
+static bool has_8bit_channels(SceGxmTransferFormat format) {
+    switch (format) {
+    case SCE_GXM_TRANSFER_FORMAT_U8_R:
+    case SCE_GXM_TRANSFER_FORMAT_U8U8_GR:
+    case SCE_GXM_TRANSFER_FORMAT_U8U8U8_BGR:
+    case SCE_GXM_TRANSFER_FORMAT_U8U8U8U8_ABGR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint8_t average(uint8_t a, uint8_t b) {
+    return static_cast<uint8_t>((a + b + 1) >> 1);
+}
+
+// 2x2 box filter of one destination row, averaging vertically then horizontally like _mm_avg_epu8 would
+static void downscale_row(uint8_t *dest, const uint8_t *top, const uint8_t *bottom, uint32_t dest_width, uint32_t bytes_per_pixel) {
+    uint32_t x = 0;
+
+#ifdef TRANSFER_USE_SSE2
+    if (bytes_per_pixel == 4) {
+        for (; x + 4 <= dest_width; x += 4) {
+            const __m128i row_0 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(top + x * 8)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottom + x * 8)));
+            const __m128i row_1 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(top + x * 8 + 16)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottom + x * 8 + 16)));
+
+            // Split even and odd pixels, each lane then averages with its right neighbour
+            const __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(row_0), _mm_castsi128_ps(row_1), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(row_0), _mm_castsi128_ps(row_1), _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x * 4), _mm_avg_epu8(_mm_castps_si128(even), _mm_castps_si128(odd)));
+        }
+    }
+#endif
+
+    for (; x < dest_width; x++) {
+        const uint8_t *left_top = top + x * 2 * bytes_per_pixel;
+        const uint8_t *left_bottom = bottom + x * 2 * bytes_per_pixel;
+
+        for (uint32_t c = 0; c < bytes_per_pixel; c++) {
+            const uint8_t left = average(left_top[c], left_bottom[c]);
+            const uint8_t right = average(left_top[c + bytes_per_pixel], left_bottom[c + bytes_per_pixel]);
+            dest[x * bytes_per_pixel + c] = average(left, right);
+        }
+    }
+}
+
+void transfer_downscale(const TransferImage &src, const TransferImage &dest, uint32_t src_width, uint32_t src_height) {
+    const uint32_t src_bpp = get_bytes_per_pixel(src.format);
+    const uint32_t dest_bpp = get_bytes_per_pixel(dest.format);
+    if ((src_bpp == 0) || (dest_bpp == 0)) {
+        return;
+    }
+
+    const uint32_t dest_width = src_width / 2;
+    const uint32_t dest_height = src_height / 2;
+
+    if ((src.format == dest.format) && has_8bit_channels(src.format) && (src.type == SCE_GXM_TRANSFER_LINEAR) && (dest.type == SCE_GXM_TRANSFER_LINEAR)) {
+        for (uint32_t y = 0; y < dest_height; y++) {
+            const uint8_t *top = src.address + get_pixel_offset(src, 0, y * 2, src_bpp);
+            const uint8_t *bottom = src.address + get_pixel_offset(src, 0, y * 2 + 1, src_bpp);
+            downscale_row(dest.address + get_pixel_offset(dest, 0, y, dest_bpp), top, bottom, dest_width, src_bpp);
+        }
+
+        return;
+    }
+
+    // Packed or wide formats are point sampled
+    const uint32_t copy_size = std::min(src_bpp, dest_bpp);
+    for (uint32_t y = 0; y < dest_height; y++) {
+        for (uint32_t x = 0; x < dest_width; x++) {
+            memcpy(dest.address + get_pixel_offset(dest, x, y, dest_bpp), src.address + get_pixel_offset(src, x * 2, y * 2, src_bpp), copy_size);
+        }
+    }
+}
+
+void transfer_fill(const TransferImage &dest, uint32_t width, uint32_t height, uint32_t fill_color) {
+    const uint32_t bpp = get_bytes_per_pixel(dest.format);
+    if ((bpp == 0) || (width == 0)) {
+        return;
+    }
+
+    // One row worth of the fill pattern, every span is then a plain copy out of it
+    std::vector<uint8_t> pattern(static_cast<size_t>(width) * bpp);
+    for (uint32_t x = 0; x < width; x++) {
+        memcpy(&pattern[x * bpp], &fill_color, std::min<uint32_t>(bpp, sizeof(fill_color)));
+    }
+
+    TransferImage pattern_image{ pattern.data(), dest.format, SCE_GXM_TRANSFER_LINEAR, 0, 0, 0 };
+    for_each_span(pattern_image, dest, width, height, bpp, bpp, [&](const uint8_t *src_span, uint8_t *dest_span, uint32_t count) {
+        memcpy(dest_span, src_span, count * bpp);
+    });
+}
 } // namespace gxm
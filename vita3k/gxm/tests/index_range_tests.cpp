@@ -0,0 +1,108 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <gxm/functions.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+template <typename T>
+static void check_range(const std::vector<T> &indices, const SceGxmIndexFormat format) {
+    // Every length up to the full buffer, so each SIMD tail size gets covered
+    for (size_t count = 1; count <= indices.size(); count++) {
+        const auto [min, max] = std::minmax_element(indices.begin(), indices.begin() + count);
+        const gxm::IndexRange range = gxm::get_index_range(indices.data(), format, count);
+
+        ASSERT_EQ(range.min, *min) << "count " << count;
+        ASSERT_EQ(range.max, *max) << "count " << count;
+    }
+}
+
+TEST(index_range, u16_matches_reference) {
+    std::mt19937 rng(16);
+    std::uniform_int_distribution<uint32_t> dist(0, 0xFFFF);
+
+    std::vector<uint16_t> indices(67);
+    std::generate(indices.begin(), indices.end(), [&] { return static_cast<uint16_t>(dist(rng)); });
+    check_range(indices, SCE_GXM_INDEX_FORMAT_U16);
+
+    // Values on both sides of the sign bit
+    check_range(std::vector<uint16_t>{ 0x7FFF, 0x8000, 0xFFFF, 0x0000, 0x8001, 0x7FFE, 0x1234, 0xFFFE, 0x0001 }, SCE_GXM_INDEX_FORMAT_U16);
+}
+
+TEST(index_range, u32_matches_reference) {
+    std::mt19937 rng(32);
+    std::uniform_int_distribution<uint32_t> dist;
+
+    std::vector<uint32_t> indices(35);
+    std::generate(indices.begin(), indices.end(), [&] { return dist(rng); });
+    check_range(indices, SCE_GXM_INDEX_FORMAT_U32);
+
+    check_range(std::vector<uint32_t>{ 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, 0x0, 0x80000001, 0x7FFFFFFE, 0x1 }, SCE_GXM_INDEX_FORMAT_U32);
+}
+
+TEST(index_range, empty_range) {
+    const gxm::IndexRange range = gxm::get_index_range(nullptr, SCE_GXM_INDEX_FORMAT_U16, 0);
+    ASSERT_EQ(range.min, 0);
+    ASSERT_EQ(range.max, 0);
+}
+
+TEST(index_range, unaligned_start) {
+    std::vector<uint16_t> indices(40);
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = static_cast<uint16_t>(i * 3);
+    }
+
+    const gxm::IndexRange range = gxm::get_index_range(indices.data() + 1, SCE_GXM_INDEX_FORMAT_U16, indices.size() - 2);
+    ASSERT_EQ(range.min, 3);
+    ASSERT_EQ(range.max, 3 * 38);
+}
+
+// Not a pass/fail check, reports how the scan compares to std::minmax_element on a large mesh
+TEST(index_range, benchmark) {
+    constexpr size_t INDEX_COUNT = 1 << 20;
+    constexpr int ITERATIONS = 50;
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<uint32_t> dist(0, 0xFFFF);
+
+    std::vector<uint16_t> indices(INDEX_COUNT);
+    std::generate(indices.begin(), indices.end(), [&] { return static_cast<uint16_t>(dist(rng)); });
+
+    using clock = std::chrono::steady_clock;
+    uint64_t sink = 0;
+
+    const auto scalar_start = clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink += *std::minmax_element(indices.begin(), indices.end()).second;
+    }
+    const auto scalar_time = std::chrono::duration<double, std::micro>(clock::now() - scalar_start).count() / ITERATIONS;
+
+    const auto simd_start = clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink += gxm::get_index_range(indices.data(), SCE_GXM_INDEX_FORMAT_U16, indices.size()).max;
+    }
+    const auto simd_time = std::chrono::duration<double, std::micro>(clock::now() - simd_start).count() / ITERATIONS;
+
+    std::printf("index_range u16 x%zu: std::minmax_element %.1fus, get_index_range %.1fus\n", INDEX_COUNT, scalar_time, simd_time);
+    ASSERT_NE(sink, 0);
+}
@@ -0,0 +1,148 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <gxm/functions.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+static gxm::TransferImage make_image(std::vector<uint32_t> &pixels, SceGxmTransferType type, uint32_t width) {
+    return { reinterpret_cast<uint8_t *>(pixels.data()), SCE_GXM_TRANSFER_FORMAT_U8U8U8U8_ABGR, type, 0, 0, static_cast<int32_t>(width * 4) };
+}
+
+TEST(transfer, linear_copy_with_offsets) {
+    std::vector<uint32_t> src(16 * 16);
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = static_cast<uint32_t>(i);
+    }
+
+    std::vector<uint32_t> dest(16 * 16, 0xDEADBEEF);
+    gxm::TransferImage src_image = make_image(src, SCE_GXM_TRANSFER_LINEAR, 16);
+    gxm::TransferImage dest_image = make_image(dest, SCE_GXM_TRANSFER_LINEAR, 16);
+    src_image.x = 2;
+    src_image.y = 3;
+    dest_image.x = 5;
+    dest_image.y = 1;
+
+    gxm::transfer_copy(src_image, dest_image, 7, 4, SCE_GXM_TRANSFER_COLORKEY_NONE, 0, 0);
+
+    for (uint32_t y = 0; y < 16; y++) {
+        for (uint32_t x = 0; x < 16; x++) {
+            const bool inside = (x >= 5) && (x < 12) && (y >= 1) && (y < 5);
+            const uint32_t expected = inside ? src[(y - 1 + 3) * 16 + (x - 5 + 2)] : 0xDEADBEEF;
+            ASSERT_EQ(dest[y * 16 + x], expected) << x << "," << y;
+        }
+    }
+}
+
+TEST(transfer, tiled_round_trip) {
+    constexpr uint32_t WIDTH = 64;
+    constexpr uint32_t HEIGHT = 40;
+
+    std::vector<uint32_t> linear(WIDTH * HEIGHT);
+    for (size_t i = 0; i < linear.size(); i++) {
+        linear[i] = static_cast<uint32_t>(i * 2654435761u);
+    }
+
+    std::vector<uint32_t> tiled(WIDTH * 64);
+    std::vector<uint32_t> back(WIDTH * HEIGHT);
+    gxm::transfer_copy(make_image(linear, SCE_GXM_TRANSFER_LINEAR, WIDTH), make_image(tiled, SCE_GXM_TRANSFER_TILED, WIDTH), WIDTH, HEIGHT,
+        SCE_GXM_TRANSFER_COLORKEY_NONE, 0, 0);
+
+    // Pixel (33, 1) lives in the second tile, second row of that tile
+    ASSERT_EQ(tiled[1024 + 32 + 1], linear[1 * WIDTH + 33]);
+
+    gxm::transfer_copy(make_image(tiled, SCE_GXM_TRANSFER_TILED, WIDTH), make_image(back, SCE_GXM_TRANSFER_LINEAR, WIDTH), WIDTH, HEIGHT,
+        SCE_GXM_TRANSFER_COLORKEY_NONE, 0, 0);
+    ASSERT_EQ(back, linear);
+}
+
+TEST(transfer, swizzled_layout) {
+    std::vector<uint32_t> linear(8 * 8);
+    for (size_t i = 0; i < linear.size(); i++) {
+        linear[i] = static_cast<uint32_t>(i);
+    }
+
+    std::vector<uint32_t> swizzled(8 * 8);
+    gxm::transfer_copy(make_image(linear, SCE_GXM_TRANSFER_LINEAR, 8), make_image(swizzled, SCE_GXM_TRANSFER_SWIZZLED, 8), 8, 8,
+        SCE_GXM_TRANSFER_COLORKEY_NONE, 0, 0);
+
+    // Morton order: (0,0) (1,0) (0,1) (1,1) (2,0)...
+    ASSERT_EQ(swizzled[0], 0);
+    ASSERT_EQ(swizzled[1], 1);
+    ASSERT_EQ(swizzled[2], 8);
+    ASSERT_EQ(swizzled[3], 9);
+    ASSERT_EQ(swizzled[4], 2);
+    ASSERT_EQ(swizzled[63], 63);
+}
+
+TEST(transfer, color_key) {
+    std::vector<uint32_t> src(13);
+    for (size_t i = 0; i < src.size(); i++) {
+        src[i] = (i % 3 == 0) ? 0xFF00FF00 : static_cast<uint32_t>(0x11000000 + i);
+    }
+
+    std::vector<uint32_t> rejected(13, 0xAAAAAAAA);
+    std::vector<uint32_t> passed(13, 0xAAAAAAAA);
+    gxm::transfer_copy(make_image(src, SCE_GXM_TRANSFER_LINEAR, 13), make_image(rejected, SCE_GXM_TRANSFER_LINEAR, 13), 13, 1,
+        SCE_GXM_TRANSFER_COLORKEY_REJECT, 0x0000FF00, 0x00FFFFFF);
+    gxm::transfer_copy(make_image(src, SCE_GXM_TRANSFER_LINEAR, 13), make_image(passed, SCE_GXM_TRANSFER_LINEAR, 13), 13, 1,
+        SCE_GXM_TRANSFER_COLORKEY_PASS, 0x0000FF00, 0x00FFFFFF);
+
+    for (size_t i = 0; i < src.size(); i++) {
+        const bool keyed = (i % 3 == 0);
+        ASSERT_EQ(rejected[i], keyed ? 0xAAAAAAAA : src[i]) << i;
+        ASSERT_EQ(passed[i], keyed ? src[i] : 0xAAAAAAAA) << i;
+    }
+}
+
+TEST(transfer, downscale_box_filter) {
+    constexpr uint32_t WIDTH = 22;
+
+    std::vector<uint32_t> src(WIDTH * 2);
+    for (uint32_t x = 0; x < WIDTH; x++) {
+        src[x] = 0x10203040 + x;
+        src[WIDTH + x] = 0x30405060 + x * 3;
+    }
+
+    std::vector<uint32_t> dest(WIDTH / 2);
+    gxm::transfer_downscale(make_image(src, SCE_GXM_TRANSFER_LINEAR, WIDTH), make_image(dest, SCE_GXM_TRANSFER_LINEAR, WIDTH / 2), WIDTH, 2);
+
+    const auto average = [](uint32_t a, uint32_t b) { return (a + b + 1) >> 1; };
+    for (uint32_t x = 0; x < WIDTH / 2; x++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            const auto channel = [&](uint32_t index) { return (src[index] >> (c * 8)) & 0xFF; };
+            const uint32_t left = average(channel(x * 2), channel(WIDTH + x * 2));
+            const uint32_t right = average(channel(x * 2 + 1), channel(WIDTH + x * 2 + 1));
+            ASSERT_EQ((dest[x] >> (c * 8)) & 0xFF, average(left, right)) << x << " channel " << c;
+        }
+    }
+}
+
+TEST(transfer, fill_16bit) {
+    std::vector<uint16_t> dest(10 * 4, 0);
+    const gxm::TransferImage image{ reinterpret_cast<uint8_t *>(dest.data()), SCE_GXM_TRANSFER_FORMAT_U5U6U5_BGR, SCE_GXM_TRANSFER_LINEAR, 1, 1, 20 };
+    gxm::transfer_fill(image, 8, 2, 0x1234ABCD);
+
+    for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 10; x++) {
+            const bool inside = (x >= 1) && (x < 9) && (y >= 1) && (y < 3);
+            ASSERT_EQ(dest[y * 10 + x], inside ? 0xABCD : 0) << x << "," << y;
+        }
+    }
+}
@@ -22,7 +22,6 @@
 
 #include <app/functions.h>
 #include <boost/algorithm/string/trim.hpp>
-#include <crypto/aes.h>
 #include <io/device.h>
 
 #include <host/functions.h>
@@ -31,45 +30,9 @@
 #include <host/sfo.h>
 #include <host/state.h>
 
-#include <util/bytes.h>
 #include <util/log.h>
 #include <util/string_utils.h>
 
-// Credits to mmozeiko https://github.com/mmozeiko/pkg2zip
-
-static void ctr_add(uint8_t *counter, uint64_t n) {
-    for (int i = 15; i >= 0; i--) {
-        n = n + counter[i];
-        counter[i] = (uint8_t)n;
-        n >>= 8;
-    }
-}
-
-static void aes128_ctr_xor(aes_context *ctx, const uint8_t *iv, uint64_t block, uint8_t *input, size_t size) {
-    uint8_t tmp[16];
-    uint8_t counter[16];
-    for (uint32_t i = 0; i < 16; i++) {
-        counter[i] = iv[i];
-    }
-    ctr_add(counter, block);
-
-    while (size >= 16) {
-        aes_crypt_ecb(ctx, AES_ENCRYPT, counter, tmp);
-        for (uint32_t i = 0; i < 16; i++) {
-            *input++ ^= tmp[i];
-        }
-        ctr_add(counter, 1);
-        size -= 16;
-    }
-
-    if (size != 0) {
-        aes_crypt_ecb(ctx, AES_ENCRYPT, counter, tmp);
-        for (size_t i = 0; i < size; i++) {
-            *input++ ^= tmp[i];
-        }
-    }
-}
-
 bool decrypt_install_nonpdrm(HostState &host, std::string &drmlicpath, const std::string &title_path) {
     std::string title_id_src = title_path;
     std::string title_id_dst = title_path + "_dec";
@@ -105,65 +68,14 @@ bool decrypt_install_nonpdrm(HostState &host, std::string &drmlicpath, const std
 }
 
 bool install_pkg(const std::string &pkg, HostState &host, std::string &p_zRIF, const std::function<void(float)> &progress_callback) {
-    std::wstring pkg_path = string_utils::utf_to_wide(pkg);
-    fs::ifstream infile(pkg_path, std::ios::binary);
-    PkgHeader pkg_header;
-    PkgExtHeader ext_header;
-    infile.read(reinterpret_cast<char *>(&pkg_header), sizeof(PkgHeader));
-    infile.seekg(sizeof(PkgHeader));
-    infile.read(reinterpret_cast<char *>(&ext_header), sizeof(PkgExtHeader));
+    install::PkgSource source;
 
     progress_callback(0);
 
-    if (byte_swap(pkg_header.magic) != 0x7F504b47 && byte_swap(ext_header.magic) != 0x7F657874) {
-        LOG_ERROR("Not a valid pkg file!");
-        return false;
-    }
-
-    if (fs::file_size(pkg_path) < byte_swap(pkg_header.total_size)) {
-        LOG_ERROR("The pkg file is too small");
+    if (!source.open(string_utils::utf_to_wide(pkg)))
         return false;
-    }
-
-    if (fs::file_size(pkg_path) < byte_swap(pkg_header.data_offset) + byte_swap(pkg_header.file_count) * 32) {
-        LOG_ERROR("The pkg file is too small");
-        return false;
-    }
-
-    uint32_t info_offset = byte_swap(pkg_header.info_offset);
-    uint32_t content_type = 0;
-    uint32_t sfo_offset = 0;
-    uint32_t sfo_size = 0;
-    uint32_t items_offset = 0;
-    uint32_t items_size = 0;
-
-    for (uint32_t i = 0; i < byte_swap(pkg_header.info_count); i++) {
-        uint32_t block[4];
-        infile.seekg(info_offset);
-        infile.read((char *)block, sizeof(block));
-
-        auto type = byte_swap(block[0]);
-        auto size = byte_swap(block[1]);
-
-        switch (type) {
-        case 2:
-            content_type = byte_swap(block[2]);
-            break;
-        case 13:
-            items_offset = byte_swap(block[2]);
-            items_size = byte_swap(block[3]);
-            break;
-        case 14:
-            sfo_offset = byte_swap(block[2]);
-            sfo_size = byte_swap(block[3]);
-            break;
-        default:
-            break;
-        }
-
-        info_offset += 2 * sizeof(uint32_t) + size;
-    }
 
+    const uint32_t content_type = source.content_type();
     PkgType type;
 
     switch (content_type) {
@@ -182,35 +94,9 @@ bool install_pkg(const std::string &pkg, HostState &host, std::string &p_zRIF, c
         break;
     }
 
-    auto key_type = byte_swap(ext_header.data_type2) & 7;
-    aes_context aes_ctx;
-    uint8_t main_key[16];
-
-    switch (key_type) {
-    case 2:
-        aes_setkey_enc(&aes_ctx, pkg_vita_2, 128);
-        aes_crypt_ecb(&aes_ctx, AES_ENCRYPT, pkg_header.pkg_data_iv, main_key);
-        break;
-    case 3:
-        aes_setkey_enc(&aes_ctx, pkg_vita_3, 128);
-        aes_crypt_ecb(&aes_ctx, AES_ENCRYPT, pkg_header.pkg_data_iv, main_key);
-        break;
-    case 4:
-        aes_setkey_enc(&aes_ctx, pkg_vita_4, 128);
-        aes_crypt_ecb(&aes_ctx, AES_ENCRYPT, pkg_header.pkg_data_iv, main_key);
-        break;
-    default:
-        LOG_ERROR("Unknown encryption key");
-        return false;
-        break;
-    }
-
-    aes_setkey_enc(&aes_ctx, main_key, 128);
-
-    std::vector<uint8_t> sfo_buffer(sfo_size);
+    std::vector<uint8_t> sfo_buffer;
     SfoFile sfo_file;
-    infile.seekg(sfo_offset);
-    infile.read((char *)&sfo_buffer[0], sfo_size);
+    source.read_sfo(sfo_buffer);
     sfo::load(sfo_file, sfo_buffer);
     sfo::get_param_info(host, sfo_buffer);
 
@@ -226,7 +112,8 @@ bool install_pkg(const std::string &pkg, HostState &host, std::string &p_zRIF, c
     switch (type) {
     case PkgType::PKG_TYPE_VITA_APP:
         path /= fs::path("app") / host.app_title_id;
-        if (fs::exists(path))
+        // What an interrupted install of this same pkg left behind is kept, only its missing files get extracted
+        if (fs::exists(path) && !install::can_resume(path, source))
             fs::remove_all(path);
         host.app_title += " (App)";
         break;
@@ -245,50 +132,17 @@ bool install_pkg(const std::string &pkg, HostState &host, std::string &p_zRIF, c
         break;
     }
 
-    for (uint32_t i = 0; i < byte_swap(pkg_header.file_count); i++) {
-        PkgEntry entry;
-        uint64_t file_offset = items_offset + i * 32;
-        infile.seekg(byte_swap(pkg_header.data_offset) + file_offset, std::ios_base::beg);
-        infile.read(reinterpret_cast<char *>(&entry), sizeof(PkgEntry));
-        aes128_ctr_xor(&aes_ctx, pkg_header.pkg_data_iv, file_offset / 16, reinterpret_cast<unsigned char *>(&entry), sizeof(PkgEntry));
+    // Reading, decrypting and writing all overlap, extraction takes 60% of the progress bar
+    install::Options options;
+    options.progress = [&](const install::Progress &progress) {
+        if (progress.total != 0)
+            progress_callback(static_cast<float>(progress.written) / progress.total * 100.f * 0.6f);
+    };
 
-        if (fs::file_size(pkg_path) < byte_swap(pkg_header.data_offset) + byte_swap(entry.name_offset) + byte_swap(entry.name_size) || fs::file_size(pkg_path) < byte_swap(pkg_header.data_offset) + byte_swap(entry.data_offset) + byte_swap(entry.data_size)) {
-            LOG_ERROR("The pkg file size is too small, possibly corrupted");
-            return false;
-        }
-        const auto file_count = (float)byte_swap(pkg_header.file_count);
-        progress_callback(i / file_count * 100.f * 0.6f);
-        std::vector<unsigned char> name(byte_swap(entry.name_size));
-        infile.seekg(byte_swap(pkg_header.data_offset) + byte_swap(entry.name_offset));
-        infile.read((char *)&name[0], byte_swap(entry.name_size));
-        aes128_ctr_xor(&aes_ctx, pkg_header.pkg_data_iv, byte_swap(entry.name_offset) / 16, &name[0], byte_swap(entry.name_size));
-
-        auto string_name = std::string(name.begin(), name.end());
-        LOG_INFO(string_name);
-
-        if ((byte_swap(entry.type) & 0xFF) == 4 || (byte_swap(entry.type) & 0xFF) == 18) { // Directory
-            fs::create_directories(path.string() + "/" + string_name);
-        } else { // File
-            std::ofstream outfile(path.string() + "/" + string_name, std::ios::binary);
-
-            auto offset = byte_swap(entry.data_offset);
-            auto data_size = byte_swap(entry.data_size);
-            while (data_size != 0) {
-                unsigned char buffer[0x10000];
-                auto size = data_size < sizeof(buffer) ? data_size : sizeof(buffer);
-                infile.seekg(byte_swap(pkg_header.data_offset) + offset);
-                infile.read((char *)buffer, size);
-
-                aes128_ctr_xor(&aes_ctx, pkg_header.pkg_data_iv, offset / 16, buffer, size);
-
-                outfile.write((char *)buffer, size);
-                offset += size;
-                data_size -= size;
-            }
-            outfile.close();
-        }
+    if (install::run(source, path, options) != install::Result::DONE) {
+        LOG_ERROR("Failed to extract the pkg files, it is possibly corrupted");
+        return false;
     }
-    infile.close();
 
     std::string title_id_src = path.string();
     std::string title_id_dst = path.string() + "_dec";
@@ -0,0 +1,128 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Installing packages as a pipeline: one thread reads the source in order, workers decrypt or inflate
+// what it read, and the calling thread writes the files. The pieces in flight are limited by a memory
+// budget, so the reader waits for the writer rather than buffering whole files.
+//
+// Each file done is recorded in a journal next to the installed files, which lets an interrupted
+// install pick up where it stopped when run again on the same source.
+namespace install {
+
+struct Entry {
+    // Relative to the destination, with '/' as separator. run refuses sources with a path leading out of it.
+    std::string path;
+    bool directory = false;
+
+    // Of the installed file
+    std::uint64_t size = 0;
+};
+
+struct Piece {
+    std::size_t entry = 0;
+
+    // Bytes it adds to the installed file
+    std::uint64_t size = 0;
+
+    // As read from the source, then the output of transform once it ran
+    std::vector<std::uint8_t> data;
+
+    // Most memory held at once, data and the output of transform together. Zero means the size of data.
+    std::uint64_t memory = 0;
+
+    // Run on a worker, empty when the data read already is what gets written
+    std::function<bool(Piece &)> transform;
+};
+
+class Source {
+public:
+    virtual ~Source() = default;
+
+    virtual const std::vector<Entry> &entries() const = 0;
+
+    // Same for every run on the same package, the journal of another one is never used
+    virtual std::string identity() const = 0;
+
+    // Hand every piece of a file to emit in order, none of them making more than piece_size bytes.
+    // Only called from the reader thread, never for directories or empty files. Returns false if
+    // reading failed or emit did, emit failing when the install is stopped.
+    virtual bool read(std::size_t entry, std::uint64_t piece_size, const std::function<bool(Piece &&)> &emit) = 0;
+};
+
+struct Progress {
+    // Bytes of every file, the ones already installed by an earlier run counting as done
+    std::uint64_t total = 0;
+
+    // Bytes gone through each stage
+    std::uint64_t read = 0;
+    std::uint64_t processed = 0;
+    std::uint64_t written = 0;
+
+    std::uint64_t files = 0;
+    std::uint64_t files_written = 0;
+    std::uint64_t files_resumed = 0;
+
+    // Held by the pieces in flight, now and at most so far
+    std::uint64_t memory = 0;
+    std::uint64_t peak_memory = 0;
+};
+
+enum class Result {
+    DONE,
+    FAILED,
+    CANCELLED,
+};
+
+struct Options {
+    static constexpr std::uint64_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+    static constexpr std::uint64_t DEFAULT_PIECE_SIZE = 4 * 1024 * 1024;
+
+    // A single piece larger than the budget still goes through, alone
+    std::uint64_t memory_budget = DEFAULT_MEMORY_BUDGET;
+
+    // Multiple of 16, so that pieces of encrypted files start on a cipher block
+    std::uint64_t piece_size = DEFAULT_PIECE_SIZE;
+
+    // Zero means one less than the number of hardware threads
+    std::size_t worker_count = 0;
+
+    // Called on the calling thread every time a piece is written
+    std::function<void(const Progress &)> progress;
+
+    // Checked between pieces, the journal is kept so the install can be resumed
+    const std::atomic<bool> *cancel = nullptr;
+};
+
+// Name of the journal, in the destination until the install is done
+constexpr const char *JOURNAL_NAME = ".install_journal";
+
+// Whether the destination holds an interrupted install of this source
+bool can_resume(const fs::path &destination, const Source &source);
+
+Result run(Source &source, const fs::path &destination, const Options &options = {});
+
+} // namespace install
@@ -0,0 +1,54 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <install/pipeline.h>
+
+#include <miniz.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace install {
+
+// The files of a zip or vpk found under a directory of it. Small files are inflated on the workers,
+// larger ones as they are read since a deflate stream can only be inflated from its start.
+class ZipSource : public Source {
+    mz_zip_archive *zip;
+    std::string zip_identity;
+
+    std::vector<Entry> file_entries;
+    std::vector<mz_uint> indices;
+
+public:
+    // Only the files under prefix are installed, with the prefix left out of their path
+    ZipSource(mz_zip_archive *zip, const std::string &prefix);
+
+    const std::vector<Entry> &entries() const override {
+        return file_entries;
+    }
+
+    std::string identity() const override {
+        return zip_identity;
+    }
+
+    bool read(std::size_t entry, std::uint64_t piece_size, const std::function<bool(Piece &&)> &emit) override;
+};
+
+} // namespace install
@@ -0,0 +1,426 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <install/pipeline.h>
+
+#include <util/log.h>
+#include <util/thread_pool.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+namespace install {
+
+namespace {
+
+// Memory held by the pieces in flight. Taking waits until enough was given back, or the install stopped.
+class Budget {
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    const std::uint64_t limit;
+    std::uint64_t used = 0;
+    std::uint64_t peak = 0;
+    bool stopped = false;
+
+public:
+    explicit Budget(const std::uint64_t limit)
+        : limit(limit) {
+    }
+
+    bool take(const std::uint64_t size) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // A piece larger than the whole budget still goes through once nothing else is in flight
+        cond.wait(lock, [&]() {
+            return stopped || (used == 0) || (used + size <= limit);
+        });
+
+        if (stopped)
+            return false;
+
+        used += size;
+        peak = std::max(peak, used);
+        return true;
+    }
+
+    void give(const std::uint64_t size) {
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            used -= size;
+        }
+
+        cond.notify_all();
+    }
+
+    void stop() {
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            stopped = true;
+        }
+
+        cond.notify_all();
+    }
+
+    void usage(Progress &progress) {
+        const std::lock_guard<std::mutex> guard(mutex);
+        progress.memory = used;
+        progress.peak_memory = peak;
+    }
+};
+
+struct ProcessedPiece {
+    Piece piece;
+    bool ok = true;
+};
+
+} // namespace
+
+// Backslashes and drive letters are separators and roots on Windows, no package file is named with them
+static bool is_inside_destination(const std::string &path) {
+    if (path.empty() || (path.front() == '/') || (path.find_first_of("\\:") != std::string::npos))
+        return false;
+
+    return ("/" + path + "/").find("/../") == std::string::npos;
+}
+
+static fs::path journal_path(const fs::path &destination) {
+    return destination / JOURNAL_NAME;
+}
+
+// The first line is the identity of the source, then comes the index of every file done, one per line.
+// A line cut short by a crash is not a number and is ignored.
+static bool read_journal(const fs::path &destination, const std::string &identity, std::set<std::size_t> &done) {
+    fs::ifstream journal(journal_path(destination));
+
+    std::string line;
+    if (!journal || !std::getline(journal, line) || (line != identity))
+        return false;
+
+    while (std::getline(journal, line)) {
+        if (line.empty())
+            continue;
+
+        char *end = nullptr;
+        const std::size_t index = std::strtoull(line.c_str(), &end, 10);
+        if (*end == '\0')
+            done.insert(index);
+    }
+
+    return true;
+}
+
+bool can_resume(const fs::path &destination, const Source &source) {
+    std::set<std::size_t> done;
+    return read_journal(destination, source.identity(), done);
+}
+
+Result run(Source &source, const fs::path &destination, const Options &options) {
+    const std::vector<Entry> &entries = source.entries();
+    const std::string identity = source.identity();
+
+    // Checked before anything is written, whatever the source
+    for (const Entry &entry : entries) {
+        if (!is_inside_destination(entry.path)) {
+            LOG_ERROR("Refusing to install into {}, {} would be outside of it", destination.string(), entry.path);
+            return Result::FAILED;
+        }
+    }
+
+    std::set<std::size_t> done;
+    const bool resuming = read_journal(destination, identity, done);
+
+    boost::system::error_code error;
+    fs::create_directories(destination, error);
+    if (error) {
+        LOG_ERROR("Failed to create {}: {}", destination.string(), error.message());
+        return Result::FAILED;
+    }
+
+    Progress progress;
+
+    // Files left to install, in the order the reader goes through them
+    std::vector<std::size_t> files;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        const Entry &entry = entries[i];
+        const fs::path path = destination / entry.path;
+
+        fs::create_directories(entry.directory ? path : path.parent_path(), error);
+        if (error) {
+            LOG_ERROR("Failed to create the directory of {}: {}", path.string(), error.message());
+            return Result::FAILED;
+        }
+
+        if (entry.directory)
+            continue;
+
+        progress.total += entry.size;
+        progress.files++;
+
+        // Kept from the earlier run unless it was touched since
+        if (done.count(i) && fs::is_regular_file(path, error) && (fs::file_size(path, error) == entry.size)) {
+            progress.read += entry.size;
+            progress.processed += entry.size;
+            progress.written += entry.size;
+            progress.files_written++;
+            progress.files_resumed++;
+            continue;
+        }
+
+        files.push_back(i);
+    }
+
+    fs::ofstream journal;
+    if (resuming) {
+        LOG_INFO("Resuming the install in {}, {} of {} files are already there", destination.string(), progress.files_resumed, progress.files);
+        journal.open(journal_path(destination), std::ios::app);
+    } else {
+        journal.open(journal_path(destination), std::ios::trunc);
+        journal << identity << std::endl;
+    }
+
+    if (!journal) {
+        LOG_ERROR("Failed to open the install journal in {}", destination.string());
+        return Result::FAILED;
+    }
+
+    Budget budget(options.memory_budget);
+    util::ThreadPool workers(options.worker_count);
+
+    std::atomic<std::uint64_t> read_bytes(progress.read);
+    std::atomic<std::uint64_t> processed_bytes(progress.processed);
+    std::atomic<bool> stopping(false);
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cond;
+    std::deque<std::future<ProcessedPiece>> queue;
+    bool reader_done = false;
+    bool reader_failed = false;
+
+    const auto cancelled = [&]() {
+        return options.cancel && options.cancel->load();
+    };
+
+    const std::function<bool(Piece &&)> emit = [&](Piece &&piece) {
+        if (stopping || cancelled())
+            return false;
+
+        if (piece.memory == 0)
+            piece.memory = piece.data.size();
+
+        if (!budget.take(piece.memory))
+            return false;
+
+        read_bytes += piece.size;
+
+        std::future<ProcessedPiece> processed = workers.submit([piece = std::move(piece), &processed_bytes]() mutable {
+            ProcessedPiece result{ std::move(piece) };
+            if (result.piece.transform)
+                result.ok = result.piece.transform(result.piece);
+
+            processed_bytes += result.piece.size;
+            return result;
+        });
+
+        {
+            const std::lock_guard<std::mutex> guard(queue_mutex);
+            queue.push_back(std::move(processed));
+        }
+
+        queue_cond.notify_one();
+        return true;
+    };
+
+    std::thread reader([&]() {
+        bool ok = true;
+
+        for (const std::size_t index : files) {
+            if (entries[index].size == 0) {
+                Piece piece;
+                piece.entry = index;
+                ok = emit(std::move(piece));
+            } else {
+                ok = source.read(index, options.piece_size, emit);
+            }
+
+            if (!ok)
+                break;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(queue_mutex);
+            reader_done = true;
+            reader_failed = !ok;
+        }
+
+        queue_cond.notify_one();
+    });
+
+    const auto stop = [&]() {
+        stopping = true;
+        budget.stop();
+    };
+
+    Result result = Result::DONE;
+
+    fs::ofstream output;
+    std::size_t current = std::numeric_limits<std::size_t>::max();
+    std::uint64_t current_written = 0;
+    std::size_t next_file = 0;
+
+    const auto finish_file = [&]() {
+        output.close();
+        if (!output || (current_written != entries[current].size)) {
+            LOG_ERROR("Failed to install {}", entries[current].path);
+            return false;
+        }
+
+        journal << current << std::endl;
+        progress.files_written++;
+        return true;
+    };
+
+    // The writer, every piece comes in the order it was read
+    while (true) {
+        std::future<ProcessedPiece> next;
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cond.wait(lock, [&]() {
+                return !queue.empty() || reader_done;
+            });
+
+            if (queue.empty())
+                break;
+
+            next = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        ProcessedPiece processed = next.get();
+        const Piece &piece = processed.piece;
+
+        // Once stopped, what is left is only waited for
+        if (result != Result::DONE) {
+            budget.give(piece.memory);
+            continue;
+        }
+
+        bool ok = processed.ok && (piece.data.size() == piece.size);
+
+        if (ok && (piece.entry != current)) {
+            if (current != std::numeric_limits<std::size_t>::max())
+                ok = finish_file();
+
+            // A file the source skipped would be silently missing otherwise
+            if (ok && ((next_file == files.size()) || (files[next_file] != piece.entry))) {
+                LOG_ERROR("Pieces of {} came out of order", entries[piece.entry].path);
+                ok = false;
+            }
+
+            if (ok) {
+                next_file++;
+                current = piece.entry;
+                current_written = 0;
+
+                output.open(destination / entries[current].path, std::ios::binary | std::ios::trunc);
+                ok = output.is_open();
+            }
+        }
+
+        if (ok && (piece.size != 0)) {
+            output.write(reinterpret_cast<const char *>(piece.data.data()), piece.size);
+            ok = output.good();
+            current_written += piece.size;
+        }
+
+        budget.give(piece.memory);
+
+        if (!ok) {
+            LOG_ERROR("Failed to install {}", entries[piece.entry].path);
+            result = Result::FAILED;
+            stop();
+            continue;
+        }
+
+        progress.written += piece.size;
+
+        if (cancelled()) {
+            result = Result::CANCELLED;
+            stop();
+            continue;
+        }
+
+        if (options.progress) {
+            progress.read = read_bytes;
+            progress.processed = processed_bytes;
+            budget.usage(progress);
+            options.progress(progress);
+        }
+    }
+
+    reader.join();
+
+    // The last file written can be whole even though the install stopped right after it
+    bool finished = true;
+    if (current != std::numeric_limits<std::size_t>::max()) {
+        const bool whole = (current_written == entries[current].size);
+        if (((result == Result::DONE) && !reader_failed) || ((result != Result::FAILED) && whole))
+            finished = finish_file();
+    }
+
+    if (result == Result::DONE) {
+        if (reader_failed) {
+            result = cancelled() ? Result::CANCELLED : Result::FAILED;
+            if (result == Result::FAILED)
+                LOG_ERROR("Failed to read the package being installed in {}", destination.string());
+        } else if (!finished) {
+            result = Result::FAILED;
+        } else if (next_file != files.size()) {
+            LOG_ERROR("The package being installed in {} is missing files", destination.string());
+            result = Result::FAILED;
+        }
+    }
+
+    journal.close();
+
+    if (result == Result::DONE) {
+        fs::remove(journal_path(destination), error);
+
+        if (options.progress) {
+            progress.read = read_bytes;
+            progress.processed = processed_bytes;
+            budget.usage(progress);
+            options.progress(progress);
+        }
+    } else if (result == Result::CANCELLED) {
+        LOG_INFO("Install in {} cancelled, it can be resumed", destination.string());
+    }
+
+    return result;
+}
+
+} // namespace install
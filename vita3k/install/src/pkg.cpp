@@ -0,0 +1,204 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <install/pkg.h>
+
+#include <util/bytes.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace install {
+
+static void ctr_add(uint8_t *counter, uint64_t n) {
+    for (int i = 15; i >= 0; i--) {
+        n = n + counter[i];
+        counter[i] = (uint8_t)n;
+        n >>= 8;
+    }
+}
+
+void PkgSource::decrypt(const std::uint64_t offset, std::uint8_t *data, const std::size_t size) const {
+    uint8_t counter[16];
+    std::memcpy(counter, pkg_header.pkg_data_iv, sizeof(counter));
+    ctr_add(counter, offset / 16);
+
+    // Only reads the key schedule, the workers all share it
+    uint8_t stream_block[16];
+    size_t stream_offset = 0;
+    aes_crypt_ctr(const_cast<aes_context *>(&aes_ctx), size, &stream_offset, counter, stream_block, data, data);
+}
+
+bool PkgSource::open(const fs::path &path) {
+    file.open(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("Failed to open {}", path.string());
+        return false;
+    }
+
+    PkgExtHeader ext_header;
+    file.read(reinterpret_cast<char *>(&pkg_header), sizeof(PkgHeader));
+    file.seekg(sizeof(PkgHeader));
+    file.read(reinterpret_cast<char *>(&ext_header), sizeof(PkgExtHeader));
+
+    if (!file || (byte_swap(pkg_header.magic) != 0x7F504b47 && byte_swap(ext_header.magic) != 0x7F657874)) {
+        LOG_ERROR("Not a valid pkg file!");
+        return false;
+    }
+
+    const std::uint64_t file_size = fs::file_size(path);
+    const std::uint64_t data_offset = byte_swap(pkg_header.data_offset);
+    const std::uint32_t file_count = byte_swap(pkg_header.file_count);
+
+    if ((file_size < byte_swap(pkg_header.total_size)) || (file_size < data_offset + file_count * 32)) {
+        LOG_ERROR("The pkg file is too small");
+        return false;
+    }
+
+    uint32_t info_offset = byte_swap(pkg_header.info_offset);
+    uint32_t items_offset = 0;
+
+    for (uint32_t i = 0; i < byte_swap(pkg_header.info_count); i++) {
+        uint32_t block[4];
+        file.seekg(info_offset);
+        file.read((char *)block, sizeof(block));
+
+        auto type = byte_swap(block[0]);
+        auto size = byte_swap(block[1]);
+
+        switch (type) {
+        case 2:
+            pkg_content_type = byte_swap(block[2]);
+            break;
+        case 13:
+            items_offset = byte_swap(block[2]);
+            break;
+        case 14:
+            sfo_offset = byte_swap(block[2]);
+            sfo_size = byte_swap(block[3]);
+            break;
+        default:
+            break;
+        }
+
+        info_offset += 2 * sizeof(uint32_t) + size;
+    }
+
+    auto key_type = byte_swap(ext_header.data_type2) & 7;
+    uint8_t main_key[16];
+
+    switch (key_type) {
+    case 2:
+        aes_setkey_enc(&aes_ctx, pkg_vita_2, 128);
+        break;
+    case 3:
+        aes_setkey_enc(&aes_ctx, pkg_vita_3, 128);
+        break;
+    case 4:
+        aes_setkey_enc(&aes_ctx, pkg_vita_4, 128);
+        break;
+    default:
+        LOG_ERROR("Unknown encryption key");
+        return false;
+    }
+
+    aes_crypt_ecb(&aes_ctx, AES_ENCRYPT, pkg_header.pkg_data_iv, main_key);
+    aes_setkey_enc(&aes_ctx, main_key, 128);
+
+    for (uint32_t i = 0; i < file_count; i++) {
+        PkgEntry entry;
+        uint64_t file_offset = items_offset + i * 32;
+        file.seekg(data_offset + file_offset, std::ios_base::beg);
+        file.read(reinterpret_cast<char *>(&entry), sizeof(PkgEntry));
+        decrypt(file_offset, reinterpret_cast<unsigned char *>(&entry), sizeof(PkgEntry));
+
+        if (!file || file_size < data_offset + byte_swap(entry.name_offset) + byte_swap(entry.name_size) || file_size < data_offset + byte_swap(entry.data_offset) + byte_swap(entry.data_size)) {
+            LOG_ERROR("The pkg file size is too small, possibly corrupted");
+            return false;
+        }
+
+        std::vector<unsigned char> name(byte_swap(entry.name_size));
+        file.seekg(data_offset + byte_swap(entry.name_offset));
+        file.read(reinterpret_cast<char *>(name.data()), name.size());
+        decrypt(byte_swap(entry.name_offset), name.data(), name.size());
+
+        Entry file_entry;
+        file_entry.path = std::string(name.begin(), name.end());
+        file_entry.directory = ((byte_swap(entry.type) & 0xFF) == 4) || ((byte_swap(entry.type) & 0xFF) == 18);
+        file_entry.size = file_entry.directory ? 0 : byte_swap(entry.data_size);
+
+        file_entries.push_back(std::move(file_entry));
+        data_offsets.push_back(byte_swap(entry.data_offset));
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool PkgSource::read_sfo(std::vector<std::uint8_t> &sfo) {
+    sfo.resize(sfo_size);
+    file.seekg(sfo_offset);
+    file.read(reinterpret_cast<char *>(sfo.data()), sfo.size());
+
+    return static_cast<bool>(file);
+}
+
+std::string PkgSource::identity() const {
+    static const char HEX[] = "0123456789abcdef";
+
+    std::string digest;
+    for (const uint8_t byte : pkg_header.digest) {
+        digest += HEX[byte >> 4];
+        digest += HEX[byte & 0xF];
+    }
+
+    const std::string content_id(pkg_header.content_id, strnlen(pkg_header.content_id, sizeof(pkg_header.content_id)));
+    return "pkg " + content_id + " " + std::to_string(byte_swap(pkg_header.total_size)) + " " + digest;
+}
+
+bool PkgSource::read(const std::size_t entry, const std::uint64_t piece_size, const std::function<bool(Piece &&)> &emit) {
+    // Every piece has to start on a cipher block
+    const std::uint64_t step = std::max<std::uint64_t>(piece_size & ~15ULL, 16);
+    const std::uint64_t size = file_entries[entry].size;
+
+    for (std::uint64_t position = 0; position < size; position += step) {
+        const std::uint64_t offset = data_offsets[entry] + position;
+
+        Piece piece;
+        piece.entry = entry;
+        piece.size = std::min(step, size - position);
+        piece.data.resize(piece.size);
+
+        file.seekg(byte_swap(pkg_header.data_offset) + offset);
+        if (!file.read(reinterpret_cast<char *>(piece.data.data()), piece.size)) {
+            LOG_ERROR("Failed to read {} from the pkg", file_entries[entry].path);
+            return false;
+        }
+
+        piece.transform = [this, offset](Piece &piece) {
+            decrypt(offset, piece.data.data(), piece.data.size());
+            return true;
+        };
+
+        if (!emit(std::move(piece)))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace install
@@ -0,0 +1,118 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <install/zip.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+
+namespace install {
+
+ZipSource::ZipSource(mz_zip_archive *zip, const std::string &prefix)
+    : zip(zip) {
+    // The CRC of every file stands in for the whole archive, which is too large to hash
+    mz_ulong contents_crc = MZ_CRC32_INIT;
+
+    const mz_uint num_files = mz_zip_reader_get_num_files(zip);
+    for (mz_uint i = 0; i < num_files; i++) {
+        mz_zip_archive_file_stat file_stat;
+        if (!mz_zip_reader_file_stat(zip, i, &file_stat))
+            continue;
+
+        const std::string filename = file_stat.m_filename;
+        if (filename.compare(0, prefix.size(), prefix) != 0)
+            continue;
+
+        Entry entry;
+        entry.path = filename.substr(prefix.size());
+        entry.directory = mz_zip_reader_is_file_a_directory(zip, i);
+        entry.size = entry.directory ? 0 : file_stat.m_uncomp_size;
+
+        if (entry.directory && !entry.path.empty() && (entry.path.back() == '/'))
+            entry.path.pop_back();
+
+        if (entry.path.empty())
+            continue;
+
+        contents_crc = mz_crc32(contents_crc, reinterpret_cast<const mz_uint8 *>(&file_stat.m_crc32), sizeof(file_stat.m_crc32));
+        contents_crc = mz_crc32(contents_crc, reinterpret_cast<const mz_uint8 *>(filename.c_str()), filename.size());
+
+        file_entries.push_back(std::move(entry));
+        indices.push_back(i);
+    }
+
+    zip_identity = "zip " + prefix + " " + std::to_string(zip->m_archive_size) + " " + std::to_string(file_entries.size()) + " " + std::to_string(contents_crc);
+}
+
+bool ZipSource::read(const std::size_t entry, const std::uint64_t piece_size, const std::function<bool(Piece &&)> &emit) {
+    const mz_uint index = indices[entry];
+
+    mz_zip_archive_file_stat file_stat;
+    if (!mz_zip_reader_file_stat(zip, index, &file_stat))
+        return false;
+
+    if ((file_stat.m_method == MZ_DEFLATED) && (file_stat.m_comp_size <= piece_size) && (file_stat.m_uncomp_size <= piece_size)) {
+        Piece piece;
+        piece.entry = entry;
+        piece.size = file_stat.m_uncomp_size;
+        piece.memory = file_stat.m_comp_size + file_stat.m_uncomp_size;
+        piece.data.resize(file_stat.m_comp_size);
+
+        if (!mz_zip_reader_extract_to_mem(zip, index, piece.data.data(), piece.data.size(), MZ_ZIP_FLAG_COMPRESSED_DATA)) {
+            LOG_ERROR("miniz error: {} reading file: {}", mz_zip_get_error_string(mz_zip_get_last_error(zip)), file_stat.m_filename);
+            return false;
+        }
+
+        piece.transform = [crc = file_stat.m_crc32](Piece &piece) {
+            std::vector<std::uint8_t> output(piece.size);
+
+            const size_t inflated = tinfl_decompress_mem_to_mem(output.data(), output.size(), piece.data.data(), piece.data.size(), 0);
+            if ((inflated != output.size()) || (mz_crc32(MZ_CRC32_INIT, output.data(), output.size()) != crc))
+                return false;
+
+            piece.data = std::move(output);
+            return true;
+        };
+
+        return emit(std::move(piece));
+    }
+
+    mz_zip_reader_extract_iter_state *iter = mz_zip_reader_extract_iter_new(zip, index, 0);
+    if (!iter) {
+        LOG_ERROR("miniz error: {} reading file: {}", mz_zip_get_error_string(mz_zip_get_last_error(zip)), file_stat.m_filename);
+        return false;
+    }
+
+    bool ok = true;
+    for (std::uint64_t position = 0; ok && (position < file_stat.m_uncomp_size);) {
+        Piece piece;
+        piece.entry = entry;
+        piece.size = std::min(piece_size, file_stat.m_uncomp_size - position);
+        piece.data.resize(piece.size);
+
+        ok = (mz_zip_reader_extract_iter_read(iter, piece.data.data(), piece.data.size()) == piece.size);
+        position += piece.size;
+
+        ok = ok && emit(std::move(piece));
+    }
+
+    // This is where the CRC is checked, once everything was read
+    return mz_zip_reader_extract_iter_free(iter) && ok;
+}
+
+} // namespace install
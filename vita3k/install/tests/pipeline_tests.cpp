@@ -0,0 +1,308 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <install/pipeline.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+
+using namespace install;
+
+namespace {
+constexpr std::uint8_t KEY = 0x5A;
+
+// Files kept in memory, stored xored with KEY so the pieces have work to do on the workers
+class MemorySource : public Source {
+    std::vector<Entry> file_entries;
+    std::vector<std::vector<std::uint8_t>> contents;
+
+public:
+    std::string name = "memory";
+
+    // Reading this entry fails, as if the package was cut short
+    std::size_t fail_entry = ~std::size_t(0);
+    bool fail_transform = false;
+
+    std::map<std::size_t, int> reads;
+
+    void add_directory(const std::string &path) {
+        file_entries.push_back({ path, true, 0 });
+        contents.emplace_back();
+    }
+
+    void add_file(const std::string &path, const std::vector<std::uint8_t> &data) {
+        file_entries.push_back({ path, false, data.size() });
+
+        std::vector<std::uint8_t> stored(data);
+        for (std::uint8_t &byte : stored)
+            byte ^= KEY;
+
+        contents.push_back(std::move(stored));
+    }
+
+    const std::vector<Entry> &entries() const override {
+        return file_entries;
+    }
+
+    std::string identity() const override {
+        return name + " " + std::to_string(file_entries.size());
+    }
+
+    bool read(const std::size_t entry, const std::uint64_t piece_size, const std::function<bool(Piece &&)> &emit) override {
+        reads[entry]++;
+        if (entry == fail_entry)
+            return false;
+
+        const std::vector<std::uint8_t> &data = contents[entry];
+        for (std::uint64_t position = 0; position < data.size(); position += piece_size) {
+            Piece piece;
+            piece.entry = entry;
+            piece.size = std::min<std::uint64_t>(piece_size, data.size() - position);
+            piece.data.assign(data.begin() + position, data.begin() + position + piece.size);
+
+            piece.transform = [this](Piece &piece) {
+                for (std::uint8_t &byte : piece.data)
+                    byte ^= KEY;
+
+                return !fail_transform;
+            };
+
+            if (!emit(std::move(piece)))
+                return false;
+        }
+
+        return true;
+    }
+};
+
+std::vector<std::uint8_t> make_data(const std::size_t size, const std::uint32_t seed) {
+    std::vector<std::uint8_t> data(size);
+    std::uint32_t state = seed;
+    for (std::size_t i = 0; i < size; i++) {
+        state = state * 1664525 + 1013904223;
+        data[i] = static_cast<std::uint8_t>(state >> 24);
+    }
+
+    return data;
+}
+
+std::vector<std::uint8_t> read_file(const fs::path &path) {
+    fs::ifstream file(path, std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+class PipelineTest : public testing::Test {
+protected:
+    static constexpr std::uint64_t PIECE_SIZE = 64 * 1024;
+
+    fs::path root;
+    MemorySource source;
+    std::map<std::string, std::vector<std::uint8_t>> expected;
+
+    Options options;
+
+    void add_file(const std::string &path, const std::size_t size) {
+        expected[path] = make_data(size, static_cast<std::uint32_t>(expected.size() + 1));
+        source.add_file(path, expected[path]);
+    }
+
+    void check_files() {
+        for (const auto &[path, data] : expected) {
+            ASSERT_TRUE(fs::is_regular_file(root / path)) << path;
+            ASSERT_EQ(read_file(root / path), data) << path;
+        }
+    }
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-install-%%%%-%%%%");
+
+        source.add_directory("sce_sys");
+        add_file("sce_sys/param.sfo", 1000);
+        add_file("eboot.bin", PIECE_SIZE * 3 + 17);
+        add_file("empty.txt", 0);
+        source.add_directory("data/sound");
+        add_file("data/sound/music.at9", PIECE_SIZE * 8);
+        add_file("data/level.bin", PIECE_SIZE - 1);
+        add_file("data/deep/nested/file.bin", 12345);
+
+        options.piece_size = PIECE_SIZE;
+        options.worker_count = 2;
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+};
+} // namespace
+
+TEST_F(PipelineTest, installs_every_file) {
+    Progress last;
+    options.progress = [&](const Progress &progress) {
+        ASSERT_GE(progress.written, last.written);
+        ASSERT_LE(progress.written, progress.processed);
+        ASSERT_LE(progress.processed, progress.read);
+        last = progress;
+    };
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+
+    ASSERT_TRUE(fs::is_directory(root / "data/sound"));
+    ASSERT_FALSE(fs::exists(root / JOURNAL_NAME));
+
+    ASSERT_EQ(last.files, 6);
+    ASSERT_EQ(last.files_written, 6);
+    ASSERT_EQ(last.files_resumed, 0);
+    ASSERT_EQ(last.written, last.total);
+    ASSERT_EQ(last.read, last.total);
+}
+
+TEST_F(PipelineTest, stays_within_memory_budget) {
+    add_file("huge.bin", PIECE_SIZE * 64);
+
+    options.memory_budget = PIECE_SIZE * 3;
+    options.worker_count = 4;
+
+    std::uint64_t peak = 0;
+    options.progress = [&](const Progress &progress) {
+        ASSERT_LE(progress.memory, options.memory_budget);
+        peak = progress.peak_memory;
+    };
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+
+    ASSERT_GT(peak, 0);
+    ASSERT_LE(peak, options.memory_budget);
+}
+
+TEST_F(PipelineTest, piece_larger_than_budget_goes_alone) {
+    options.memory_budget = PIECE_SIZE / 2;
+
+    std::uint64_t peak = 0;
+    options.progress = [&](const Progress &progress) {
+        peak = progress.peak_memory;
+    };
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+    ASSERT_LE(peak, PIECE_SIZE);
+}
+
+TEST_F(PipelineTest, resumes_after_failure) {
+    source.fail_entry = 5;
+    ASSERT_EQ(run(source, root, options), Result::FAILED);
+    ASSERT_TRUE(can_resume(root, source));
+
+    source.fail_entry = ~std::size_t(0);
+    source.reads.clear();
+
+    Progress last;
+    options.progress = [&](const Progress &progress) {
+        last = progress;
+    };
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+    ASSERT_FALSE(can_resume(root, source));
+
+    // Everything before the file which failed was already there
+    ASSERT_EQ(last.files_resumed, 3);
+    for (std::size_t i = 0; i < 5; i++)
+        ASSERT_EQ(source.reads.count(i), 0) << i;
+
+    ASSERT_EQ(source.reads[5], 1);
+    ASSERT_EQ(source.reads[7], 1);
+}
+
+TEST_F(PipelineTest, resumes_after_cancel) {
+    std::atomic<bool> cancel(false);
+    options.cancel = &cancel;
+    options.memory_budget = PIECE_SIZE * 2;
+
+    int written = 0;
+    options.progress = [&](const Progress &) {
+        if (++written == 6)
+            cancel = true;
+    };
+
+    ASSERT_EQ(run(source, root, options), Result::CANCELLED);
+    ASSERT_TRUE(can_resume(root, source));
+
+    cancel = false;
+    options.progress = nullptr;
+    source.reads.clear();
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+
+    // The first files were done before the cancel
+    ASSERT_EQ(source.reads.count(1), 0);
+}
+
+TEST_F(PipelineTest, redoes_files_changed_since) {
+    source.fail_entry = 7;
+    ASSERT_EQ(run(source, root, options), Result::FAILED);
+
+    fs::resize_file(root / "eboot.bin", 10);
+
+    source.fail_entry = ~std::size_t(0);
+    source.reads.clear();
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+
+    ASSERT_EQ(source.reads[2], 1);
+    ASSERT_EQ(source.reads.count(1), 0);
+}
+
+TEST_F(PipelineTest, ignores_journal_of_another_package) {
+    source.fail_entry = 5;
+    ASSERT_EQ(run(source, root, options), Result::FAILED);
+
+    source.name = "other";
+    source.fail_entry = ~std::size_t(0);
+    source.reads.clear();
+    ASSERT_FALSE(can_resume(root, source));
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+    ASSERT_EQ(source.reads[1], 1);
+}
+
+TEST_F(PipelineTest, refuses_paths_outside_of_destination) {
+    for (const std::string path : { "../escape.bin", "data/../../escape.bin", "data/..", "/escape.bin", "..\\escape.bin", "C:escape.bin", "" }) {
+        MemorySource escaping;
+        escaping.add_file("eboot.bin", make_data(10, 1));
+        escaping.add_file(path, make_data(10, 2));
+
+        ASSERT_EQ(run(escaping, root, options), Result::FAILED) << path;
+        ASSERT_FALSE(fs::exists(root)) << path;
+    }
+
+    ASSERT_FALSE(fs::exists(root.parent_path() / "escape.bin"));
+}
+
+TEST_F(PipelineTest, fails_when_transform_fails) {
+    source.fail_transform = true;
+    ASSERT_EQ(run(source, root, options), Result::FAILED);
+
+    // Nothing was done, yet it can still be resumed from scratch
+    ASSERT_TRUE(can_resume(root, source));
+}
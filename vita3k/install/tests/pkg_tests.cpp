@@ -0,0 +1,275 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <install/pkg.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace install;
+
+namespace {
+struct TestEntry {
+    std::string path;
+    bool directory;
+    std::vector<std::uint8_t> data;
+};
+
+std::vector<std::uint8_t> make_data(const std::size_t size, const std::uint32_t seed) {
+    std::vector<std::uint8_t> data(size);
+    std::uint32_t state = seed;
+    for (std::size_t i = 0; i < size; i++) {
+        state = state * 1664525 + 1013904223;
+        data[i] = static_cast<std::uint8_t>(state >> 24);
+    }
+
+    return data;
+}
+
+std::vector<std::uint8_t> read_file(const fs::path &path) {
+    fs::ifstream file(path, std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write_be(std::vector<std::uint8_t> &buffer, const std::size_t offset, const std::uint64_t value, const std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        buffer[offset + i] = static_cast<std::uint8_t>(value >> ((size - i - 1) * 8));
+    }
+}
+
+std::size_t align16(const std::size_t size) {
+    return (size + 15) & ~std::size_t(15);
+}
+
+constexpr std::size_t INFO_OFFSET = 0x100;
+constexpr std::size_t SFO_OFFSET = 0x140;
+constexpr std::size_t DATA_OFFSET = 0x200;
+
+// Build a pkg laid out the way the official packer does: the table of files, then their names, then their data,
+// all encrypted with AES-CTR under the key derived from the IV
+std::vector<std::uint8_t> make_pkg(const std::vector<TestEntry> &entries, const std::vector<std::uint8_t> &sfo, const std::string &content_id, const std::uint8_t digest_seed) {
+    std::vector<std::uint8_t> data(entries.size() * 32);
+
+    std::vector<std::size_t> name_offsets;
+    for (const TestEntry &entry : entries) {
+        name_offsets.push_back(data.size());
+        data.insert(data.end(), entry.path.begin(), entry.path.end());
+        data.resize(align16(data.size()));
+    }
+
+    std::vector<std::size_t> data_offsets;
+    for (const TestEntry &entry : entries) {
+        data_offsets.push_back(data.size());
+        data.insert(data.end(), entry.data.begin(), entry.data.end());
+        data.resize(align16(data.size()));
+    }
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        write_be(data, i * 32, name_offsets[i], 4);
+        write_be(data, i * 32 + 4, entries[i].path.size(), 4);
+        write_be(data, i * 32 + 8, data_offsets[i], 8);
+        write_be(data, i * 32 + 16, entries[i].data.size(), 8);
+        write_be(data, i * 32 + 24, entries[i].directory ? 4 : 3, 4);
+    }
+
+    std::uint8_t iv[16];
+    for (std::uint8_t i = 0; i < 16; i++)
+        iv[i] = 0xF0 + i;
+
+    aes_context aes_ctx;
+    std::uint8_t main_key[16];
+    aes_setkey_enc(&aes_ctx, pkg_vita_2, 128);
+    aes_crypt_ecb(&aes_ctx, AES_ENCRYPT, iv, main_key);
+    aes_setkey_enc(&aes_ctx, main_key, 128);
+
+    std::uint8_t counter[16];
+    std::uint8_t stream_block[16];
+    std::size_t stream_offset = 0;
+    std::memcpy(counter, iv, sizeof(counter));
+    aes_crypt_ctr(&aes_ctx, data.size(), &stream_offset, counter, stream_block, data.data(), data.data());
+
+    std::vector<std::uint8_t> pkg(DATA_OFFSET);
+    write_be(pkg, 0x00, 0x7F504B47, 4);
+    write_be(pkg, 0x08, INFO_OFFSET, 4);
+    write_be(pkg, 0x0C, 3, 4);
+    write_be(pkg, 0x14, entries.size(), 4);
+    write_be(pkg, 0x18, DATA_OFFSET + data.size(), 8);
+    write_be(pkg, 0x20, DATA_OFFSET, 8);
+    write_be(pkg, 0x28, data.size(), 8);
+    std::memcpy(&pkg[0x30], content_id.data(), content_id.size());
+    std::memset(&pkg[0x60], digest_seed, 16);
+    std::memcpy(&pkg[0x70], iv, sizeof(iv));
+
+    // Extended header, only the key type matters
+    write_be(pkg, 0xC0, 0x7F657874, 4);
+    write_be(pkg, 0xE4, 2, 4);
+
+    // Content type, then where the table of files and the param.sfo are
+    const std::uint32_t info[3][4] = {
+        { 2, 8, 0x15, 0 },
+        { 13, 8, 0, static_cast<std::uint32_t>(entries.size() * 32) },
+        { 14, 8, SFO_OFFSET, static_cast<std::uint32_t>(sfo.size()) },
+    };
+
+    for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 4; j++)
+            write_be(pkg, INFO_OFFSET + i * 16 + j * 4, info[i][j], 4);
+    }
+
+    std::memcpy(&pkg[SFO_OFFSET], sfo.data(), sfo.size());
+
+    pkg.insert(pkg.end(), data.begin(), data.end());
+    return pkg;
+}
+
+class PkgTest : public testing::Test {
+protected:
+    fs::path root;
+    fs::path pkg_path;
+
+    std::vector<TestEntry> entries;
+    std::vector<std::uint8_t> sfo;
+
+    void write_pkg(const std::vector<std::uint8_t> &pkg) {
+        fs::ofstream file(pkg_path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(pkg.data()), pkg.size());
+    }
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-install-%%%%-%%%%");
+        fs::create_directories(root);
+        pkg_path = root / "test.pkg";
+
+        entries.push_back({ "sce_sys", true, {} });
+        entries.push_back({ "sce_sys/icon0.png", false, make_data(1000, 1) });
+        entries.push_back({ "eboot.bin", false, make_data(4096 + 7, 2) });
+        entries.push_back({ "empty.txt", false, {} });
+        entries.push_back({ "data", true, {} });
+        entries.push_back({ "data/level.bin", false, make_data(33, 3) });
+
+        sfo = make_data(64, 4);
+
+        write_pkg(make_pkg(entries, sfo, "UP0000-PCSE00000_00-0000000000000000", 0xAB));
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+};
+} // namespace
+
+TEST_F(PkgTest, reads_headers_and_files) {
+    PkgSource source;
+    ASSERT_TRUE(source.open(pkg_path));
+
+    ASSERT_EQ(source.content_type(), 0x15);
+
+    std::vector<std::uint8_t> pkg_sfo;
+    ASSERT_TRUE(source.read_sfo(pkg_sfo));
+    ASSERT_EQ(pkg_sfo, sfo);
+
+    ASSERT_EQ(source.entries().size(), entries.size());
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        ASSERT_EQ(source.entries()[i].path, entries[i].path);
+        ASSERT_EQ(source.entries()[i].directory, entries[i].directory);
+        ASSERT_EQ(source.entries()[i].size, entries[i].data.size());
+    }
+}
+
+TEST_F(PkgTest, installs_decrypted_files) {
+    PkgSource source;
+    ASSERT_TRUE(source.open(pkg_path));
+
+    const fs::path destination = root / "PCSE00000";
+
+    // Not a multiple of 16 on purpose, pieces still have to start on a cipher block
+    Options options;
+    options.piece_size = 100;
+    options.worker_count = 2;
+
+    ASSERT_EQ(run(source, destination, options), Result::DONE);
+
+    for (const TestEntry &entry : entries) {
+        if (entry.directory) {
+            ASSERT_TRUE(fs::is_directory(destination / entry.path)) << entry.path;
+        } else {
+            ASSERT_EQ(read_file(destination / entry.path), entry.data) << entry.path;
+        }
+    }
+}
+
+TEST_F(PkgTest, refuses_files_outside_of_the_destination) {
+    entries.push_back({ "../escape.bin", false, make_data(10, 5) });
+    write_pkg(make_pkg(entries, sfo, "UP0000-PCSE00000_00-0000000000000000", 0xAB));
+
+    PkgSource source;
+    ASSERT_TRUE(source.open(pkg_path));
+
+    ASSERT_EQ(run(source, root / "PCSE00000", Options()), Result::FAILED);
+    ASSERT_FALSE(fs::exists(root / "escape.bin"));
+    ASSERT_FALSE(fs::exists(root / "PCSE00000"));
+}
+
+TEST_F(PkgTest, pieces_start_on_cipher_blocks) {
+    PkgSource source;
+    ASSERT_TRUE(source.open(pkg_path));
+
+    std::vector<std::uint8_t> data;
+    ASSERT_TRUE(source.read(2, 100, [&](Piece &&piece) {
+        EXPECT_EQ(data.size() % 16, 0);
+        EXPECT_TRUE(piece.transform(piece));
+        data.insert(data.end(), piece.data.begin(), piece.data.end());
+        return true;
+    }));
+
+    ASSERT_EQ(data, entries[2].data);
+}
+
+TEST_F(PkgTest, identity_follows_the_package) {
+    PkgSource source;
+    ASSERT_TRUE(source.open(pkg_path));
+
+    const std::string identity = source.identity();
+    ASSERT_NE(identity.find("UP0000-PCSE00000_00-0000000000000000"), std::string::npos);
+
+    write_pkg(make_pkg(entries, sfo, "UP0000-PCSE00000_00-0000000000000000", 0xCD));
+
+    PkgSource other;
+    ASSERT_TRUE(other.open(pkg_path));
+    ASSERT_NE(other.identity(), identity);
+}
+
+TEST_F(PkgTest, rejects_invalid_packages) {
+    std::vector<std::uint8_t> pkg = make_pkg(entries, sfo, "UP0000-PCSE00000_00-0000000000000000", 0xAB);
+
+    // Cut short
+    write_pkg(std::vector<std::uint8_t>(pkg.begin(), pkg.end() - 16));
+    ASSERT_FALSE(PkgSource().open(pkg_path));
+
+    // Unknown key
+    std::vector<std::uint8_t> unknown_key = pkg;
+    write_be(unknown_key, 0xE4, 7, 4);
+    write_pkg(unknown_key);
+    ASSERT_FALSE(PkgSource().open(pkg_path));
+
+    // Not a pkg at all
+    write_pkg(std::vector<std::uint8_t>(pkg.size(), 0));
+    ASSERT_FALSE(PkgSource().open(pkg_path));
+
+    ASSERT_FALSE(PkgSource().open(root / "missing.pkg"));
+}
@@ -0,0 +1,207 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <install/zip.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+
+using namespace install;
+
+namespace {
+std::vector<std::uint8_t> make_data(const std::size_t size, const std::uint32_t seed) {
+    std::vector<std::uint8_t> data(size);
+    for (std::size_t i = 0; i < size; i++) {
+        // Compressible, but different from one file to the next
+        data[i] = static_cast<std::uint8_t>((i / 7) * seed + (i >> 12));
+    }
+
+    return data;
+}
+
+std::vector<std::uint8_t> read_file(const fs::path &path) {
+    fs::ifstream file(path, std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+class ZipTest : public testing::Test {
+protected:
+    static constexpr std::uint64_t PIECE_SIZE = 64 * 1024;
+
+    fs::path root;
+    std::vector<std::uint8_t> archive;
+    mz_zip_archive zip = {};
+
+    // Installed files, without the prefix
+    std::map<std::string, std::vector<std::uint8_t>> expected;
+
+    // Adds a file whose path leads out of the prefix
+    bool escape = false;
+
+    Options options;
+
+    void add(mz_zip_archive &writer, const std::string &name, const std::vector<std::uint8_t> &data, const mz_uint level) {
+        ASSERT_TRUE(mz_zip_writer_add_mem(&writer, name.c_str(), data.data(), data.size(), level));
+    }
+
+    void build(const std::function<void(std::vector<std::uint8_t> &)> &damage = nullptr) {
+        mz_zip_archive writer = {};
+        ASSERT_TRUE(mz_zip_writer_init_heap(&writer, 0, 0));
+
+        ASSERT_TRUE(mz_zip_writer_add_mem(&writer, "PCSE00000/sce_sys/", nullptr, 0, 0));
+        add(writer, "PCSE00000/sce_sys/param.sfo", expected["sce_sys/param.sfo"], MZ_DEFAULT_COMPRESSION);
+        add(writer, "PCSE00000/eboot.bin", expected["eboot.bin"], MZ_NO_COMPRESSION);
+        add(writer, "PCSE00000/data/big.bin", expected["data/big.bin"], MZ_DEFAULT_COMPRESSION);
+        add(writer, "PCSE00000/data/stored_big.bin", expected["data/stored_big.bin"], MZ_NO_COMPRESSION);
+        add(writer, "PCSE00000/empty.txt", {}, MZ_DEFAULT_COMPRESSION);
+        if (escape)
+            add(writer, "PCSE00000/../escape.bin", make_data(100, 9), MZ_DEFAULT_COMPRESSION);
+        add(writer, "PCSE00001/sce_sys/param.sfo", make_data(100, 11), MZ_DEFAULT_COMPRESSION);
+
+        void *buffer = nullptr;
+        size_t size = 0;
+        ASSERT_TRUE(mz_zip_writer_finalize_heap_archive(&writer, &buffer, &size));
+        archive.assign(static_cast<std::uint8_t *>(buffer), static_cast<std::uint8_t *>(buffer) + size);
+        mz_free(buffer);
+        mz_zip_writer_end(&writer);
+
+        if (damage)
+            damage(archive);
+
+        ASSERT_TRUE(mz_zip_reader_init_mem(&zip, archive.data(), archive.size(), 0));
+    }
+
+    void check_files() {
+        for (const auto &[path, data] : expected) {
+            ASSERT_TRUE(fs::is_regular_file(root / path)) << path;
+            ASSERT_EQ(read_file(root / path), data) << path;
+        }
+    }
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-install-%%%%-%%%%");
+
+        expected["sce_sys/param.sfo"] = make_data(1000, 3);
+        expected["eboot.bin"] = make_data(PIECE_SIZE / 2, 5);
+        expected["data/big.bin"] = make_data(PIECE_SIZE * 5 + 123, 7);
+        expected["data/stored_big.bin"] = make_data(PIECE_SIZE * 2 + 1, 13);
+        expected["empty.txt"] = {};
+
+        options.piece_size = PIECE_SIZE;
+        options.worker_count = 2;
+    }
+
+    void TearDown() override {
+        mz_zip_reader_end(&zip);
+        fs::remove_all(root);
+    }
+};
+} // namespace
+
+TEST_F(ZipTest, lists_files_under_prefix) {
+    build();
+    ZipSource source(&zip, "PCSE00000/");
+
+    std::vector<std::string> paths;
+    for (const Entry &entry : source.entries())
+        paths.push_back(entry.path + (entry.directory ? "/" : ""));
+
+    const std::vector<std::string> expected_paths = { "sce_sys/", "sce_sys/param.sfo", "eboot.bin", "data/big.bin", "data/stored_big.bin", "empty.txt" };
+    ASSERT_EQ(paths, expected_paths);
+}
+
+TEST_F(ZipTest, extracts_every_file) {
+    build();
+    ZipSource source(&zip, "PCSE00000/");
+
+    ASSERT_EQ(run(source, root, options), Result::DONE);
+    check_files();
+
+    ASSERT_TRUE(fs::is_directory(root / "sce_sys"));
+    ASSERT_FALSE(fs::exists(root / JOURNAL_NAME));
+}
+
+TEST_F(ZipTest, refuses_files_outside_of_the_prefix) {
+    escape = true;
+    build();
+    ZipSource source(&zip, "PCSE00000/");
+
+    ASSERT_EQ(run(source, root, options), Result::FAILED);
+    ASSERT_FALSE(fs::exists(root.parent_path() / "escape.bin"));
+    ASSERT_FALSE(fs::exists(root / "eboot.bin"));
+}
+
+TEST_F(ZipTest, small_files_inflate_on_workers) {
+    build();
+    ZipSource source(&zip, "PCSE00000/");
+
+    // The whole compressed file is read as one piece, inflated by its transform
+    std::vector<Piece> pieces;
+    ASSERT_TRUE(source.read(1, PIECE_SIZE, [&](Piece &&piece) {
+        pieces.push_back(std::move(piece));
+        return true;
+    }));
+
+    ASSERT_EQ(pieces.size(), 1);
+    ASSERT_TRUE(pieces[0].transform);
+    ASSERT_LT(pieces[0].data.size(), expected["sce_sys/param.sfo"].size());
+
+    ASSERT_TRUE(pieces[0].transform(pieces[0]));
+    ASSERT_EQ(pieces[0].data, expected["sce_sys/param.sfo"]);
+}
+
+TEST_F(ZipTest, large_files_come_in_pieces) {
+    build();
+    ZipSource source(&zip, "PCSE00000/");
+
+    std::vector<std::uint8_t> data;
+    ASSERT_TRUE(source.read(3, PIECE_SIZE, [&](Piece &&piece) {
+        EXPECT_LE(piece.size, PIECE_SIZE);
+        data.insert(data.end(), piece.data.begin(), piece.data.end());
+        return true;
+    }));
+
+    ASSERT_EQ(data, expected["data/big.bin"]);
+}
+
+TEST_F(ZipTest, identity_follows_the_contents) {
+    build();
+    const std::string identity = ZipSource(&zip, "PCSE00000/").identity();
+    ASSERT_EQ(ZipSource(&zip, "PCSE00000/").identity(), identity);
+    ASSERT_NE(ZipSource(&zip, "PCSE00001/").identity(), identity);
+
+    mz_zip_reader_end(&zip);
+    zip = {};
+    expected["eboot.bin"][0] ^= 1;
+    build();
+    ASSERT_NE(ZipSource(&zip, "PCSE00000/").identity(), identity);
+}
+
+TEST_F(ZipTest, fails_on_damaged_data) {
+    // Flip a byte in the middle of the stored file, only its CRC tells
+    build([&](std::vector<std::uint8_t> &archive) {
+        const std::vector<std::uint8_t> &stored = expected["eboot.bin"];
+        const auto position = std::search(archive.begin(), archive.end(), stored.begin(), stored.end());
+        ASSERT_NE(position, archive.end());
+        position[stored.size() / 2] ^= 0xFF;
+    });
+
+    ZipSource source(&zip, "PCSE00000/");
+    ASSERT_EQ(run(source, root, options), Result::FAILED);
+}
@@ -23,6 +23,7 @@
 #include <host/functions.h>
 #include <host/pkg.h>
 #include <host/sfo.h>
+#include <install/zip.h>
 #include <io/device.h>
 #include <io/functions.h>
 #include <io/vfs.h>
@@ -134,8 +135,13 @@ bool install_archive_content(HostState &host, GuiState *gui, const fs::path &arc
         return false;
     }
 
+    install::ZipSource source(zip.get(), content_path);
+
+    // An interrupted install of this same archive is picked up where it stopped instead of asking to reinstall
+    const auto resuming = install::can_resume(output_path, source);
+
     const auto created = fs::create_directories(output_path);
-    if (!created) {
+    if (!created && !resuming) {
         if (!gui || gui->file_menu.archive_install_dialog) {
             fs::remove_all(output_path);
         } else if (!gui->file_menu.archive_install_dialog) {
@@ -175,29 +181,17 @@ bool install_archive_content(HostState &host, GuiState *gui, const fs::path &arc
             progress_callback({ {}, {}, { file_progress * 0.7f + decrypt_progress * 0.3f } });
     };
 
-    int num_files = mz_zip_reader_get_num_files(zip.get());
-    for (auto i = 0; i < num_files; i++) {
-        mz_zip_archive_file_stat file_stat;
-        if (!mz_zip_reader_file_stat(zip.get(), i, &file_stat)) {
-            continue;
-        }
-        const std::string m_filename = file_stat.m_filename;
-        if (m_filename.find(content_path) != std::string::npos) {
-            file_progress = static_cast<float>(i) / num_files * 100.0f;
+    install::Options options;
+    options.progress = [&](const install::Progress &progress) {
+        if (progress.total != 0) {
+            file_progress = static_cast<float>(progress.written) / progress.total * 100.0f;
             update_progress();
-
-            std::string replace_filename = m_filename.substr(content_path.size());
-            const fs::path file_output = { output_path / replace_filename };
-            if (mz_zip_reader_is_file_a_directory(zip.get(), i)) {
-                fs::create_directories(file_output);
-            } else {
-                if (!fs::exists(file_output.parent_path()))
-                    fs::create_directories(file_output.parent_path());
-
-                LOG_INFO("Extracting {}", file_output.generic_path().string());
-                mz_zip_reader_extract_to_file(zip.get(), i, file_output.generic_path().string().c_str(), 0);
-            }
         }
+    };
+
+    if (install::run(source, output_path, options) != install::Result::DONE) {
+        LOG_ERROR("Failed to extract {} from {}", content_path, archive_path.string());
+        return false;
     }
 
     // Rename directory on correct name when is request, Todo of extract zip, no support unicode
@@ -0,0 +1,115 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/types.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Priorities of sceIoSetPriority, a lower value goes first
+constexpr int SCE_IO_PRIORITY_HIGHEST = 1;
+constexpr int SCE_IO_PRIORITY_LOWEST = 15;
+constexpr int SCE_IO_PRIORITY_DEFAULT = 8;
+
+enum class AsyncIoStatus {
+    UNKNOWN,
+    PENDING,
+    RUNNING,
+    DONE,
+};
+
+// Worker threads running the asynchronous IO requests of the guest.
+// Requests on the same fd keep their submission order and run one at a time, since they share the file
+// position. Between fds, the next request taken is the one of the fd with the best priority, then the oldest.
+// Requests without an fd, such as opening a file, are independent from everything else.
+class AsyncIoEngine {
+public:
+    typedef std::function<SceOff()> Work;
+    typedef std::function<void(SceUID, SceOff)> Callback;
+
+    explicit AsyncIoEngine(std::size_t thread_count = 2);
+    ~AsyncIoEngine();
+
+    // Queue work for the op handle. The callback is called from the worker once the work is done, then the
+    // result is kept until release.
+    void submit(SceUID op, SceUID fd, Work work, Callback done);
+
+    // Drop a request which has not started yet. It is then done with SCE_ERROR_ERRNO_ECANCELED, the callback
+    // being called from here.
+    bool cancel(SceUID op);
+
+    AsyncIoStatus status(SceUID op, SceOff *result = nullptr);
+
+    // Block until the request is done and return its result
+    SceOff wait(SceUID op);
+
+    // Forget a request which is done, returning false if it is unknown or still running
+    bool release(SceUID op);
+
+    void set_priority(SceUID fd, int priority);
+    int get_priority(SceUID fd);
+
+    // Back to the default priority, for when the fd is closed
+    void reset_priority(SceUID fd);
+
+private:
+    struct Request {
+        SceUID op;
+        std::uint64_t sequence;
+        Work work;
+        Callback done;
+    };
+
+    struct Operation {
+        AsyncIoStatus status = AsyncIoStatus::PENDING;
+        SceUID queue = 0;
+        SceOff result = 0;
+    };
+
+    // priority, sequence of the first request, queue
+    typedef std::tuple<int, std::uint64_t, SceUID> ReadyKey;
+
+    std::mutex mutex;
+    std::condition_variable work_cond;
+    std::condition_variable done_cond;
+    bool stopping = false;
+
+    std::uint64_t next_sequence = 0;
+    std::map<SceUID, std::deque<Request>> queues;
+    std::map<SceUID, int> priorities;
+    std::set<SceUID> busy_queues;
+    std::set<ReadyKey> ready;
+    std::map<SceUID, Operation> operations;
+
+    std::vector<std::thread> workers;
+
+    int priority_of(SceUID queue) const;
+    void make_ready(SceUID queue);
+    void unmake_ready(SceUID queue);
+    void finish(SceUID op, SceOff result, const Callback &done);
+    void worker_loop();
+};
@@ -0,0 +1,120 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/types.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+// Table of opened descriptors, safe to use from several threads at once.
+// Descriptors are spread over shards with their own lock, so threads working on different descriptors
+// don't wait on each other, and lookups of the same shard only take it shared. Entries are handed out
+// as shared pointers, which stay valid if the descriptor is closed while they are still used.
+template <typename T>
+class FdTable {
+    static constexpr std::size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<SceUID, std::shared_ptr<T>> entries;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+
+    // Descriptors are allocated in sequence, so consecutive ones end up in different shards
+    Shard &shard_of(const SceUID fd) {
+        return shards[static_cast<std::uint32_t>(fd) % SHARD_COUNT];
+    }
+
+    const Shard &shard_of(const SceUID fd) const {
+        return shards[static_cast<std::uint32_t>(fd) % SHARD_COUNT];
+    }
+
+public:
+    typedef std::shared_ptr<T> Handle;
+
+    // Returns an empty handle if there is no such descriptor
+    Handle find(const SceUID fd) const {
+        const Shard &shard = shard_of(fd);
+        const std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+        const auto entry = shard.entries.find(fd);
+        if (entry == shard.entries.end())
+            return {};
+
+        return entry->second;
+    }
+
+    template <typename... Args>
+    Handle emplace(const SceUID fd, Args &&...args) {
+        auto entry = std::make_shared<T>(std::forward<Args>(args)...);
+
+        Shard &shard = shard_of(fd);
+        const std::lock_guard<std::shared_mutex> lock(shard.mutex);
+        shard.entries.insert_or_assign(fd, entry);
+
+        return entry;
+    }
+
+    // Returns whether the descriptor was in the table
+    bool erase(const SceUID fd) {
+        Handle entry;
+
+        {
+            Shard &shard = shard_of(fd);
+            const std::lock_guard<std::shared_mutex> lock(shard.mutex);
+
+            const auto found = shard.entries.find(fd);
+            if (found == shard.entries.end())
+                return false;
+
+            entry = std::move(found->second);
+            shard.entries.erase(found);
+        }
+
+        // If this was the last reference, the entry is destroyed (and the file closed) outside of the lock
+        return true;
+    }
+
+    std::size_t size() const {
+        std::size_t count = 0;
+        for (const Shard &shard : shards) {
+            const std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            count += shard.entries.size();
+        }
+
+        return count;
+    }
+
+    void clear() {
+        for (Shard &shard : shards) {
+            std::unordered_map<SceUID, std::shared_ptr<T>> entries;
+
+            {
+                const std::lock_guard<std::shared_mutex> lock(shard.mutex);
+                entries.swap(shard.entries);
+            }
+        }
+    }
+};
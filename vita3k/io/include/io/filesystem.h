@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <memory>
 
 #include <util/fs.h>
@@ -74,3 +76,37 @@ inline dirent *get_system_dir_ptr(DirPtr dir) {
     return readdir(dir.get());
 }
 #endif
+
+// Read-only view of a whole file in host memory, shared by every user of the file
+class FileMapping {
+    const std::uint8_t *view = nullptr;
+    std::uint64_t length = 0;
+#ifdef WIN32
+    void *mapping_handle = nullptr;
+#endif
+
+    FileMapping() = default;
+
+    friend std::shared_ptr<const FileMapping> create_file_mapping(FILE *file);
+
+public:
+    FileMapping(const FileMapping &) = delete;
+    FileMapping &operator=(const FileMapping &) = delete;
+    ~FileMapping();
+
+    const std::uint8_t *data() const {
+        return view;
+    }
+
+    std::uint64_t size() const {
+        return length;
+    }
+
+    // Hint that the range is about to be read, and if reads will carry on sequentially after it
+    void will_need(std::uint64_t offset, std::uint64_t size, bool sequential) const;
+};
+
+typedef std::shared_ptr<const FileMapping> FileMappingPtr;
+
+// Returns an empty pointer if the file can't be mapped, e.g. if it is empty or not a regular file
+FileMappingPtr create_file_mapping(FILE *file);
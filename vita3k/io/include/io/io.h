@@ -18,7 +18,12 @@
 #pragma once
 
 constexpr int SCE_ERROR_ERRNO_ENOENT = 0x80010002; // Associated file or directory does not exist
+constexpr int SCE_ERROR_ERRNO_EBUSY = 0x80010010; // Device or resource busy
 constexpr int SCE_ERROR_ERRNO_EEXIST = 0x80010011; // File exists
 constexpr int SCE_ERROR_ERRNO_EMFILE = 0x80010018; // Too many files are open
 constexpr int SCE_ERROR_ERRNO_EBADFD = 0x80010051; // File descriptor is invalid for this operation
 constexpr int SCE_ERROR_ERRNO_EOPNOTSUPP = 0x8001005F; // Operation not supported
+constexpr int SCE_ERROR_ERRNO_ECANCELED = 0x8001008C; // Operation canceled
+
+// Same definition as in kernel/types.h, which may be included along
+#define SCE_ERROR_ERRNO_EINVAL 0x80010016 // Invalid argument
@@ -0,0 +1,63 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+
+// Finds host files regardless of case, for games relying on the case-insensitive filesystem of the Vita.
+// Each mount root is walked once when it is first needed, then the VFS keeps its index up to date with
+// the files it creates, removes and renames. Paths known to be missing are remembered too, so probing
+// for files which don't exist does not walk the tree again.
+class PathIndex {
+    struct Mount {
+        // Lowercase path to the path with its case on the host
+        std::map<std::string, fs::path> entries;
+        std::unordered_set<std::string> missing;
+    };
+
+    // By lowercase root path
+    typedef std::map<std::string, Mount> Mounts;
+
+    mutable std::shared_mutex mutex;
+    Mounts mounts;
+
+    // The mount the path is in, if any
+    Mounts::iterator find_mount(const std::string &key);
+    void insert_tree(Mount &mount, const fs::path &path);
+
+public:
+    // Get the path on the host matching the given path below the root, or an empty path if there is none
+    fs::path resolve(const fs::path &root, const fs::path &path);
+
+    // To be called after the file or directory was created, or moved in place
+    void add(const fs::path &path);
+
+    // To be called after the file or directory was removed, along with everything below it
+    void remove(const fs::path &path);
+
+    void rename(const fs::path &from, const fs::path &to);
+
+    void clear();
+
+    bool is_indexed(const fs::path &root) const;
+};
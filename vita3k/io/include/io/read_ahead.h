@@ -0,0 +1,172 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace util {
+class ThreadPool;
+}
+
+struct ReadAheadStats {
+    // Sequential reads served entirely from memory, and the ones which still had to go to the file
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+
+    std::uint64_t prefetched_bytes = 0;
+
+    // Read ahead, then thrown away before the guest got to it
+    std::uint64_t dropped_bytes = 0;
+
+    // Read ahead skipped because the budget was used up
+    std::uint64_t budget_rejections = 0;
+};
+
+// Bumped by every write to a host file, so data read ahead before the write is not used after it
+typedef std::shared_ptr<std::atomic<std::uint64_t>> FileVersion;
+
+// Read at the given offset of a file, returning the number of bytes read or a negative value on error
+typedef std::function<SceOff(void *data, SceSize size, SceOff offset)> ReadAtFunc;
+
+// Shared by every stream reading ahead: the budget of the blocks read ahead, the thread reading them
+// and the versions of the files. Safe to use from several threads at once.
+class ReadAheadCache {
+    friend class ReadAheadStream;
+
+    struct Counters {
+        std::atomic<std::uint64_t> hits = 0;
+        std::atomic<std::uint64_t> misses = 0;
+        std::atomic<std::uint64_t> prefetched_bytes = 0;
+        std::atomic<std::uint64_t> dropped_bytes = 0;
+        std::atomic<std::uint64_t> budget_rejections = 0;
+    };
+
+    std::atomic<std::size_t> budget;
+    std::atomic<std::size_t> used = 0;
+    Counters counters;
+
+    std::mutex versions_mutex;
+    std::unordered_map<std::string, std::weak_ptr<std::atomic<std::uint64_t>>> versions;
+
+    // Buffers of blocks gone, reused since fresh ones fault every page in again
+    std::mutex buffers_mutex;
+    std::vector<std::pair<std::size_t, std::unique_ptr<std::uint8_t[]>>> free_buffers;
+
+    std::unique_ptr<util::ThreadPool> worker;
+
+    bool reserve(std::size_t size);
+    void release(std::size_t size);
+
+    std::unique_ptr<std::uint8_t[]> take_buffer(std::size_t capacity);
+    void give_buffer(std::size_t capacity, std::unique_ptr<std::uint8_t[]> buffer);
+
+public:
+    // A budget of zero disables reading ahead. It is off unless asked for, on a fast disk the reads ahead
+    // cost more than they save.
+    explicit ReadAheadCache(std::size_t budget = 0);
+
+    // Logs the stats, if anything was read through the cache
+    ~ReadAheadCache();
+
+    bool enabled() const {
+        return budget != 0;
+    }
+
+    void set_budget(std::size_t new_budget) {
+        budget = new_budget;
+    }
+
+    std::size_t used_bytes() const {
+        return used;
+    }
+
+    // Every open of the same host path gets the same version
+    FileVersion version_of(const std::string &path);
+
+    ReadAheadStats stats() const;
+    void reset_stats();
+};
+
+// Read ahead of one opened file. Once a few reads in a row continue where the previous one ended, the
+// next block is read on the cache worker while the guest consumes the current one, and the block size
+// doubles with every block up to MAX_WINDOW. Any other access brings it back to plain reads.
+// Not safe to use from several threads at once, the file it belongs to takes care of that.
+class ReadAheadStream {
+    struct Block {
+        ReadAheadCache *cache = nullptr;
+        std::uint64_t version = 0;
+        SceOff offset = 0;
+
+        // Left uninitialized until read, there is no point in clearing megabytes about to be overwritten
+        std::unique_ptr<std::uint8_t[]> data;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+
+        // The file ended in this block
+        bool last = false;
+
+        // Bytes handed to the guest, the rest is counted as dropped
+        std::size_t consumed = 0;
+        std::size_t reserved = 0;
+
+        ~Block();
+    };
+
+    typedef std::shared_ptr<Block> BlockPtr;
+
+    ReadAheadCache &cache;
+    FileVersion version;
+    ReadAtFunc read_at;
+
+    BlockPtr current;
+    std::shared_future<BlockPtr> pending;
+
+    SceOff next_offset = 0;
+    unsigned sequential_reads = 0;
+    std::size_t window = 0;
+
+    bool is_valid(const BlockPtr &block, SceOff offset) const;
+    bool take_pending(SceOff offset);
+    void schedule();
+
+public:
+    // Reads in a row needed before reading ahead
+    static constexpr unsigned SEQUENTIAL_READS = 2;
+    static constexpr std::size_t MIN_WINDOW = 128 * 1024;
+    static constexpr std::size_t MAX_WINDOW = 2 * 1024 * 1024;
+
+    ReadAheadStream(ReadAheadCache &cache, FileVersion version, ReadAtFunc read_at);
+    ~ReadAheadStream();
+
+    // Same as read_at, served from the blocks read ahead when possible
+    SceOff read(void *data, SceSize size, SceOff offset);
+
+    // Drop everything read ahead
+    void reset();
+};
@@ -17,22 +17,74 @@
 
 #pragma once
 
+#include <io/async.h>
+#include <io/fd_table.h>
 #include <io/filesystem.h>
+#include <io/path_index.h>
+#include <io/read_ahead.h>
 #include <io/util.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <shared_mutex>
 #include <unordered_map>
 
+// Keeps the stdio stream of a file coherent with the positional reads and writes done on its descriptor,
+// shared by every copy of the FileStats
+struct FileSync {
+    // Exclusive for everything using the stream, shared for positional transfers
+    std::shared_mutex mutex;
+
+    // Written through the stream, but maybe not flushed to the descriptor yet
+    std::atomic<bool> unflushed_writes = false;
+
+    // Written through the descriptor, so the read buffer of the stream may be out of date
+    std::atomic<bool> stale_buffer = false;
+
+    // Position of mapped and read ahead files, which are not read through the stream. Guarded by the mutex.
+    SceOff position = 0;
+};
+
 // Class for all needed information to access files on Vita3K.
 class FileStats : public VitaStats {
     // Shared file pointer
     FilePtr wrapped_file;
+    std::shared_ptr<FileSync> sync;
+
+    // Set for read-only files which are read straight from memory instead of through the stream
+    FileMappingPtr mapping;
+
+    // Set for the other read-only files, which are read through the read ahead instead of the stream
+    std::shared_ptr<ReadAheadStream> read_ahead;
+
+    // Shared with every other open of the same host file, written files bump it
+    FileVersion version;
+
+    std::unique_lock<std::shared_mutex> lock_stream() const;
+    void flush_writes() const;
+    void enable_read_ahead(ReadAheadCache &cache);
+
+    // Whether the position is kept in the sync instead of the stream
+    bool has_own_position() const {
+        return mapping || read_ahead;
+    }
+
+    void written() const {
+        if (version)
+            (*version)++;
+    }
 
 public:
     // Constructor used for files
     // Based on https://codereview.stackexchange.com/questions/4679/
-    explicit FileStats(const char *vita, const std::string &t, const fs::path &file, const int open) {
+    // Read-only files may be mapped into memory, if it fails they are used through the stream like any other.
+    // Given a read ahead cache, sequential reads of the read-only files which are not mapped are read ahead.
+    explicit FileStats(const char *vita, const std::string &t, const fs::path &file, const int open, const bool map = false, ReadAheadCache *read_ahead_cache = nullptr) {
         wrapped_file = create_shared_file(file, open);
+        sync = std::make_shared<FileSync>();
+        if (map && wrapped_file && !can_write(open))
+            mapping = create_file_mapping(wrapped_file.get());
 
         file_info.vita_loc = vita;
         file_info.translated = t;
@@ -40,6 +92,9 @@ public:
         file_info.open_mode = open;
         file_info.file_mode = SCE_SO_IFREG | SCE_SO_IROTH;
         file_info.access_mode = SCE_S_IFREG;
+
+        if (read_ahead_cache && wrapped_file)
+            enable_read_ahead(*read_ahead_cache);
     }
 
     bool is_regular_file() const {
@@ -54,17 +109,31 @@ public:
         return can_write(file_info.open_mode);
     }
 
+    bool is_mapped() const {
+        return mapping != nullptr;
+    }
+
+    bool is_read_ahead() const {
+        return read_ahead != nullptr;
+    }
+
     // File operations
     FILE *get_file_pointer() const {
         return wrapped_file.get();
     }
 
-    // File functions
+    // File functions, safe to use from several threads at once
     SceOff read(void *input_data, int element_size, SceSize element_count) const;
     SceOff write(const void *data, SceSize size, int count) const;
     int truncate(const SceSize size) const;
-    bool seek(SceOff offset, SceIoSeekMode seek_mode) const;
+
+    // Returns the new position, or -1 on failure
+    SceOff seek(SceOff offset, SceIoSeekMode seek_mode) const;
     SceOff tell() const;
+
+    // Transfer at the given offset without moving the file position. Several of them run in parallel.
+    SceOff pread(void *data, SceSize size, SceOff offset) const;
+    SceOff pwrite(const void *data, SceSize size, SceOff offset) const;
 };
 
 // Class for implementing Directory structure; path names are wide for Windows, normal for else
@@ -93,9 +162,9 @@ public:
     }
 };
 
-typedef std::map<SceUID, TtyType> TtyFiles;
-typedef std::map<SceUID, FileStats> StdFiles;
-typedef std::map<SceUID, DirStats> DirEntries;
+typedef FdTable<TtyType> TtyFiles;
+typedef FdTable<FileStats> StdFiles;
+typedef FdTable<DirStats> DirEntries;
 
 struct IOState {
     struct DevicePaths {
@@ -114,11 +183,22 @@ struct IOState {
 
     bool redirect_stdio;
 
-    SceUID next_fd = 0;
+    // Before the tables, the files still open give their budget back to it when closed.
+    // Off until given the budget of the read-ahead-budget option.
+    ReadAheadCache read_ahead;
+
+    // Shared by every table, so a descriptor is only ever in one of them
+    std::atomic<SceUID> next_fd = 0;
     TtyFiles tty_files;
     StdFiles std_files;
     DirEntries dir_entries;
 
-    std::unordered_map<std::string, std::string> cachemap;
+    PathIndex path_index;
     bool case_isens_find_enabled = false;
+
+    // Read-only opens of app0 and vs0 files are read straight from a memory mapping of the file
+    bool map_read_only_files = true;
+
+    // Last, so the workers are stopped before anything they use goes away
+    std::unique_ptr<AsyncIoEngine> async;
 };
@@ -0,0 +1,240 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/async.h>
+#include <io/io.h>
+
+#include <algorithm>
+
+AsyncIoEngine::AsyncIoEngine(std::size_t thread_count) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+
+    for (std::size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back(&AsyncIoEngine::worker_loop, this);
+    }
+}
+
+AsyncIoEngine::~AsyncIoEngine() {
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+
+    work_cond.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+int AsyncIoEngine::priority_of(SceUID queue) const {
+    const auto priority = priorities.find(queue);
+    return (priority == priorities.end()) ? SCE_IO_PRIORITY_DEFAULT : priority->second;
+}
+
+void AsyncIoEngine::make_ready(SceUID queue) {
+    const auto requests = queues.find(queue);
+    if ((requests == queues.end()) || requests->second.empty() || busy_queues.count(queue)) {
+        return;
+    }
+
+    ready.emplace(priority_of(queue), requests->second.front().sequence, queue);
+}
+
+void AsyncIoEngine::unmake_ready(SceUID queue) {
+    const auto requests = queues.find(queue);
+    if ((requests == queues.end()) || requests->second.empty()) {
+        return;
+    }
+
+    ready.erase({ priority_of(queue), requests->second.front().sequence, queue });
+}
+
+void AsyncIoEngine::submit(SceUID op, SceUID fd, Work work, Callback done) {
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+
+        // Op handles are positive, so their negation never collides with an fd
+        const SceUID queue = (fd < 0) ? -op : fd;
+
+        Operation &operation = operations[op];
+        operation.status = AsyncIoStatus::PENDING;
+        operation.queue = queue;
+
+        std::deque<Request> &requests = queues[queue];
+        requests.push_back({ op, next_sequence++, std::move(work), std::move(done) });
+
+        if (requests.size() == 1) {
+            make_ready(queue);
+        }
+    }
+
+    work_cond.notify_one();
+}
+
+bool AsyncIoEngine::cancel(SceUID op) {
+    Callback done;
+
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+
+        const auto operation = operations.find(op);
+        if ((operation == operations.end()) || (operation->second.status != AsyncIoStatus::PENDING)) {
+            return false;
+        }
+
+        const SceUID queue = operation->second.queue;
+        std::deque<Request> &requests = queues[queue];
+
+        const auto request = std::find_if(requests.begin(), requests.end(), [op](const Request &request) {
+            return request.op == op;
+        });
+        if (request == requests.end()) {
+            return false;
+        }
+
+        unmake_ready(queue);
+        done = std::move(request->done);
+        requests.erase(request);
+
+        if (requests.empty()) {
+            queues.erase(queue);
+        } else {
+            make_ready(queue);
+        }
+
+        operation->second.status = AsyncIoStatus::RUNNING;
+    }
+
+    finish(op, SCE_ERROR_ERRNO_ECANCELED, done);
+    return true;
+}
+
+void AsyncIoEngine::finish(SceUID op, SceOff result, const Callback &done) {
+    // The callback comes first, so nobody releases the request while it is still being reported
+    if (done) {
+        done(op, result);
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(mutex);
+
+        Operation &operation = operations[op];
+        operation.status = AsyncIoStatus::DONE;
+        operation.result = result;
+    }
+
+    done_cond.notify_all();
+}
+
+AsyncIoStatus AsyncIoEngine::status(SceUID op, SceOff *result) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    const auto operation = operations.find(op);
+    if (operation == operations.end()) {
+        return AsyncIoStatus::UNKNOWN;
+    }
+
+    if (result && (operation->second.status == AsyncIoStatus::DONE)) {
+        *result = operation->second.result;
+    }
+
+    return operation->second.status;
+}
+
+SceOff AsyncIoEngine::wait(SceUID op) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto operation = operations.find(op);
+    done_cond.wait(lock, [&] {
+        operation = operations.find(op);
+        return (operation == operations.end()) || (operation->second.status == AsyncIoStatus::DONE);
+    });
+
+    return (operation == operations.end()) ? SCE_ERROR_ERRNO_EBADFD : operation->second.result;
+}
+
+bool AsyncIoEngine::release(SceUID op) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    const auto operation = operations.find(op);
+    if ((operation == operations.end()) || (operation->second.status != AsyncIoStatus::DONE)) {
+        return false;
+    }
+
+    operations.erase(operation);
+    return true;
+}
+
+void AsyncIoEngine::set_priority(SceUID fd, int priority) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    // The waiting request of the fd is sorted again with its new priority
+    unmake_ready(fd);
+    priorities[fd] = priority;
+    make_ready(fd);
+}
+
+int AsyncIoEngine::get_priority(SceUID fd) {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return priority_of(fd);
+}
+
+void AsyncIoEngine::reset_priority(SceUID fd) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    unmake_ready(fd);
+    priorities.erase(fd);
+    make_ready(fd);
+}
+
+void AsyncIoEngine::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        work_cond.wait(lock, [&] { return stopping || !ready.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        const SceUID queue = std::get<2>(*ready.begin());
+        ready.erase(ready.begin());
+
+        std::deque<Request> &requests = queues[queue];
+        Request request = std::move(requests.front());
+        requests.pop_front();
+
+        busy_queues.insert(queue);
+        operations[request.op].status = AsyncIoStatus::RUNNING;
+
+        lock.unlock();
+        const SceOff result = request.work();
+        lock.lock();
+
+        // The next request of the fd can start while this one is being finished
+        busy_queues.erase(queue);
+        if (queues[queue].empty()) {
+            queues.erase(queue);
+        } else {
+            make_ready(queue);
+            work_cond.notify_one();
+        }
+
+        lock.unlock();
+        finish(request.op, result, request.done);
+        lock.lock();
+    }
+}
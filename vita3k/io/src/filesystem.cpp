@@ -18,6 +18,18 @@
 #include <io/filesystem.h>
 #include <io/util.h>
 
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
 #ifdef WIN32
 // To open wide files for Boost.Filesystem, we also need the appropriate wide mode flags for Windows, and normal flags for other OS
 const wchar_t *translate_open_mode(const int flags) {
@@ -52,3 +64,73 @@ const char *translate_open_mode(const int flags) {
     return "rb";
 }
 #endif
+
+#ifdef WIN32
+FileMapping::~FileMapping() {
+    if (view)
+        UnmapViewOfFile(view);
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+}
+
+// Windows prefetches mapped views on its own, so there is nothing to hint
+void FileMapping::will_need(const std::uint64_t offset, const std::uint64_t size, const bool sequential) const {
+}
+
+FileMappingPtr create_file_mapping(FILE *file) {
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK)
+        return {};
+
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart <= 0)
+        return {};
+
+    std::shared_ptr<FileMapping> mapping(new FileMapping());
+    mapping->mapping_handle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping->mapping_handle)
+        return {};
+
+    mapping->view = static_cast<const std::uint8_t *>(MapViewOfFile(mapping->mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (!mapping->view)
+        return {};
+
+    mapping->length = file_size.QuadPart;
+    return mapping;
+}
+#else
+FileMapping::~FileMapping() {
+    if (view)
+        munmap(const_cast<std::uint8_t *>(view), length);
+}
+
+void FileMapping::will_need(const std::uint64_t offset, const std::uint64_t size, const bool sequential) const {
+    static const std::uint64_t page_size = sysconf(_SC_PAGESIZE);
+
+    // madvise wants a page aligned address
+    const std::uint64_t start = offset & ~(page_size - 1);
+    const std::uint64_t end = std::min(offset + size, length);
+    void *const address = const_cast<std::uint8_t *>(view + start);
+
+    if (sequential)
+        madvise(address, length - start, MADV_SEQUENTIAL);
+    madvise(address, end - start, MADV_WILLNEED);
+}
+
+FileMappingPtr create_file_mapping(FILE *file) {
+    const int fd = fileno(file);
+
+    struct stat sb;
+    if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode) || sb.st_size <= 0)
+        return {};
+
+    void *const view = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+        return {};
+
+    std::shared_ptr<FileMapping> mapping(new FileMapping());
+    mapping->view = static_cast<const std::uint8_t *>(view);
+    mapping->length = sb.st_size;
+    return mapping;
+}
+#endif
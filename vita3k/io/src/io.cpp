@@ -126,6 +126,7 @@ bool init(IOState &io, const fs::path &base_path, const fs::path &pref_path, boo
     fs::create_directory(base_path / "texturelog");
 
     io.redirect_stdio = redirect_stdio;
+    io.async = std::make_unique<AsyncIoEngine>();
 
 #ifndef WIN32
     io.case_isens_find_enabled = true;
@@ -155,7 +156,7 @@ bool init_savedata_app_path(IOState &io, const fs::path &pref_path) {
     return true;
 }
 
-bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path) {
+fs::path find_case_isens_path(IOState &io, const VitaIoDevice device, const fs::path &translated_path, const fs::path &system_path) {
     std::string final_path{};
 
     switch (device) {
@@ -170,25 +171,11 @@ bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &tra
         break;
     }
     default: {
-        return false;
-    }
+        return fs::path{};
     }
-
-    for (const auto &file : fs::recursive_directory_iterator(final_path)) {
-        io.cachemap.insert(std::make_pair(string_utils::tolower(file.path().string()), file.path().string()));
     }
 
-    return true;
-}
-
-fs::path find_in_cache(IOState &io, const std::string &system_path) {
-    const auto find_path = io.cachemap.find(system_path);
-
-    if (find_path != io.cachemap.end()) {
-        return fs::path{ find_path->second.c_str() };
-    } else {
-        return fs::path{};
-    }
+    return io.path_index.resolve(final_path, system_path);
 }
 
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths) {
@@ -287,6 +274,9 @@ SceUID open_file(IOState &io, const char *path, const int flags, const std::wstr
         return fd;
     }
 
+    // Decided before app0 is redirected to ux0 by the translation
+    const bool map_file = io.map_read_only_files && !(flags & SCE_O_WRONLY) && (device == VitaIoDevice::app0 || device == VitaIoDevice::vs0);
+
     const auto translated_path = translate_path(path, device, io.device_paths);
     if (translated_path.empty()) {
         LOG_ERROR("Cannot translate path: {}", path);
@@ -299,21 +289,14 @@ SceUID open_file(IOState &io, const char *path, const int flags, const std::wstr
         if (!(flags & SCE_O_CREAT)) {
             if (io.case_isens_find_enabled) {
                 // Attempt a case-insensitive file search.
-                const auto original_system_path = system_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                if (!cached_path.empty()) {
-                    system_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", system_path.string());
-                } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, system_path);
-                    system_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                    if (!system_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", system_path.string());
-                    } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_system_path.string(), path);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                    }
+                const auto found_path = find_case_isens_path(io, device_for_icase, translated_path, system_path);
+                if (found_path.empty()) {
+                    LOG_ERROR("Missing file at {} (target path: {})", system_path.string(), path);
+                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
                 }
+
+                system_path = found_path;
+                LOG_TRACE("Found file on case-sensitive filesystem at {}", system_path.string());
             } else {
                 LOG_ERROR("Missing file at {} (target path: {})", system_path.string(), path);
                 return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
@@ -323,12 +306,13 @@ SceUID open_file(IOState &io, const char *path, const int flags, const std::wstr
                 fs::create_directories(system_path.parent_path());
             }
             std::ofstream file(system_path.string());
+            io.path_index.add(system_path);
         }
     }
 
     const auto normalized_path = device::construct_normalized_path(device, translated_path);
 
-    FileStats f{ path, normalized_path, system_path, flags };
+    FileStats f{ path, normalized_path, system_path, flags, map_file, &io.read_ahead };
     const auto fd = io.next_fd++;
     io.std_files.emplace(fd, f);
 
@@ -341,15 +325,15 @@ int read_file(void *data, IOState &io, const SceUID fd, const SceSize size, cons
     assert(size >= 0);
 
     const auto file = io.std_files.find(fd);
-    if (file != io.std_files.end()) {
-        const auto read = file->second.read(data, 1, size);
+    if (file) {
+        const auto read = file->read(data, 1, size);
         LOG_TRACE_IF(log_file_op, "{}: Reading {} bytes of fd {}", export_name, read, log_hex(fd));
         return static_cast<int>(read);
     }
 
     const auto tty_file = io.tty_files.find(fd);
-    if (tty_file != io.tty_files.end()) {
-        if (tty_file->second == TTY_IN) {
+    if (tty_file) {
+        if (*tty_file == TTY_IN) {
             std::cin.read(reinterpret_cast<char *>(data), size);
             LOG_TRACE_IF(log_file_op, "{}: Reading terminal fd: {}, size: {}", export_name, log_hex(fd), size);
             return size;
@@ -360,6 +344,24 @@ int read_file(void *data, IOState &io, const SceUID fd, const SceSize size, cons
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
+int pread_file(void *data, IOState &io, const SceUID fd, const SceSize size, const SceOff offset, const char *export_name) {
+    assert(data != nullptr);
+
+    if (offset < 0)
+        return IO_ERROR(SCE_ERROR_ERRNO_EINVAL);
+
+    const auto file = io.std_files.find(fd);
+    if (!file)
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    const auto read = file->pread(data, size, offset);
+    if (read < 0)
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    LOG_TRACE_IF(log_file_op, "{}: Reading {} bytes of fd {} at offset {}", export_name, read, log_hex(fd), log_hex(offset));
+    return static_cast<int>(read);
+}
+
 int write_file(SceUID fd, const void *data, const SceSize size, const IOState &io, const char *export_name) {
     assert(data != nullptr);
     assert(size >= 0);
@@ -370,8 +372,8 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     }
 
     const auto tty_file = io.tty_files.find(fd);
-    if (tty_file != io.tty_files.end()) {
-        if (tty_file->second & TTY_OUT) {
+    if (tty_file) {
+        if (*tty_file & TTY_OUT) {
             std::string s(reinterpret_cast<char const *>(data), size);
 
             // trim newline
@@ -389,15 +391,15 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     }
 
     const auto file = io.std_files.find(fd);
-    if (file == io.std_files.end())
+    if (!file)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-    if (!fs::is_directory(file->second.get_system_location().parent_path())) {
+    if (!fs::is_directory(file->get_system_location().parent_path())) {
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT); // TODO: Is it the right error code?
     }
 
-    if (file->second.can_write_file()) {
-        const auto written = file->second.write(data, 1, size);
+    if (file->can_write_file()) {
+        const auto written = file->write(data, 1, size);
         LOG_TRACE_IF(log_file_op, "{}: Writing to fd: {}, size: {}", export_name, log_hex(fd), size);
         return static_cast<int>(written);
     }
@@ -405,14 +407,32 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
+int pwrite_file(SceUID fd, const void *data, const SceSize size, const SceOff offset, const IOState &io, const char *export_name) {
+    assert(data != nullptr);
+
+    if (offset < 0)
+        return IO_ERROR(SCE_ERROR_ERRNO_EINVAL);
+
+    const auto file = io.std_files.find(fd);
+    if (!file || !file->can_write_file())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    const auto written = file->pwrite(data, size, offset);
+    if (written < 0)
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    LOG_TRACE_IF(log_file_op, "{}: Writing to fd: {}, size: {}, offset: {}", export_name, log_hex(fd), size, log_hex(offset));
+    return static_cast<int>(written);
+}
+
 int truncate_file(const SceUID fd, unsigned long long length, const IOState &io, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
     const auto file = io.std_files.find(fd);
-    if (file == io.std_files.end())
+    if (!file)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
-    auto trunc = file->second.truncate(length);
+    auto trunc = file->truncate(length);
     LOG_TRACE_IF(log_file_op, "{}: Truncating fd: {}, to size: {}", export_name, log_hex(fd), length);
     return trunc;
 }
@@ -425,9 +445,11 @@ SceOff seek_file(const SceUID fd, const SceOff offset, const SceIoSeekMode whenc
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
     const auto file = io.std_files.find(fd);
-    if (file == io.std_files.end())
+    if (!file)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
-    if (!file->second.seek(offset, whence))
+
+    const auto position = file->seek(offset, whence);
+    if (position < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
     const auto log_mode = [](const SceIoSeekMode whence) -> const char * {
@@ -441,7 +463,7 @@ SceOff seek_file(const SceUID fd, const SceOff offset, const SceIoSeekMode whenc
     };
 
     LOG_TRACE_IF(log_file_op, "{}: Seeking fd: {}, offset: {}, whence: {}", export_name, log_hex(fd), log_hex(offset), log_mode(whence));
-    return file->second.tell();
+    return position;
 }
 
 SceOff tell_file(IOState &io, const SceUID fd, const char *export_name) {
@@ -450,11 +472,11 @@ SceOff tell_file(IOState &io, const SceUID fd, const char *export_name) {
 
     const auto std_file = io.std_files.find(fd);
 
-    if (std_file == io.std_files.end()) {
+    if (!std_file) {
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
     }
 
-    return std_file->second.tell();
+    return std_file->tell();
 }
 
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstring &pref_path, const char *export_name,
@@ -478,21 +500,14 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstrin
         if (!fs::exists(file_path)) {
             if (io.case_isens_find_enabled) {
                 // Attempt a case-insensitive file search.
-                const auto original_file_path = file_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(file_path.string()));
-                if (!cached_path.empty()) {
-                    file_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", file_path.string());
-                } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, file_path);
-                    file_path = find_in_cache(io, string_utils::tolower(file_path.string()));
-                    if (!file_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", file_path.string());
-                    } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_file_path.string(), file);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                    }
+                const auto found_path = find_case_isens_path(io, device_for_icase, translated_path, file_path);
+                if (found_path.empty()) {
+                    LOG_ERROR("Missing file at {} (target path: {})", file_path.string(), file);
+                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
                 }
+
+                file_path = found_path;
+                LOG_TRACE("Found file on case-sensitive filesystem at {}", file_path.string());
             } else {
                 LOG_ERROR("Missing file at {} (target path: {})", file_path.string(), file);
                 return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
@@ -501,13 +516,13 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstrin
         LOG_TRACE_IF(log_file_op, "{}: Statting file: {} ({})", export_name, file, device::construct_normalized_path(device, translated_path));
     } else { // We have previously opened and defined the location
         const auto fd_file = io.std_files.find(fd);
-        if (fd_file == io.std_files.end())
+        if (!fd_file)
             return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-        file_path = fd_file->second.get_system_location();
+        file_path = fd_file->get_system_location();
         LOG_TRACE_IF(log_file_op, "{}: Statting fd: {}", export_name, log_hex(fd));
 
-        statp->st_attr = fd_file->second.get_file_mode();
+        statp->st_attr = fd_file->get_file_mode();
     }
 
     std::uint64_t last_access_time_ticks;
@@ -558,11 +573,11 @@ int stat_file_by_fd(IOState &io, const SceUID fd, SceIoStat *statp, const std::w
     memset(statp, '\0', sizeof(SceIoStat));
 
     const auto std_file = io.std_files.find(fd);
-    if (std_file == io.std_files.end()) {
+    if (!std_file) {
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
     }
 
-    return stat_file(io, std_file->second.get_vita_loc(), statp, pref_path, export_name, fd);
+    return stat_file(io, std_file->get_vita_loc(), statp, pref_path, export_name, fd);
 }
 
 int close_file(IOState &io, const SceUID fd, const char *export_name) {
@@ -602,6 +617,45 @@ int remove_file(IOState &io, const char *file, const std::wstring &pref_path, co
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
 
+    io.path_index.remove(emulated_path);
+
+    return 0;
+}
+
+int rename_file(IOState &io, const char *old_name, const char *new_name, const std::wstring &pref_path, const char *export_name) {
+    auto old_device = device::get_device(old_name);
+    auto new_device = device::get_device(new_name);
+    if (old_device == VitaIoDevice::_INVALID || new_device == VitaIoDevice::_INVALID) {
+        LOG_ERROR("Cannot find device for path: {} or {}", old_name, new_name);
+        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+    }
+
+    const auto old_translated_path = translate_path(old_name, old_device, io.device_paths);
+    const auto new_translated_path = translate_path(new_name, new_device, io.device_paths);
+    if (old_translated_path.empty() || new_translated_path.empty()) {
+        LOG_ERROR("Cannot translate path: {} or {}", old_name, new_name);
+        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+    }
+
+    const auto old_path = device::construct_emulated_path(old_device, old_translated_path, pref_path, io.redirect_stdio);
+    const auto new_path = device::construct_emulated_path(new_device, new_translated_path, pref_path, io.redirect_stdio);
+    if (!fs::exists(old_path)) {
+        LOG_ERROR("File does not exist at path: {} (target path: {})", old_path.string(), old_name);
+        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+    }
+
+    LOG_TRACE_IF(log_file_op, "{}: Renaming {} ({}) to {} ({})", export_name, old_name, device::construct_normalized_path(old_device, old_translated_path),
+        new_name, device::construct_normalized_path(new_device, new_translated_path));
+
+    boost::system::error_code error;
+    fs::rename(old_path, new_path, error);
+    if (error) {
+        LOG_ERROR("Cannot rename {} to {}: {}", old_name, new_name, error.message());
+        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
+    }
+
+    io.path_index.rename(old_path, new_path);
+
     return 0;
 }
 
@@ -614,21 +668,14 @@ SceUID open_dir(IOState &io, const char *path, const std::wstring &pref_path, co
     if (!fs::exists(dir_path)) {
         if (io.case_isens_find_enabled) {
             // Attempt a case-insensitive file search.
-            const auto original_dir_path = dir_path;
-            const auto cached_path = find_in_cache(io, string_utils::tolower(dir_path.string()));
-            if (!cached_path.empty()) {
-                dir_path = cached_path;
-                LOG_TRACE("Found cached directory path at {}", dir_path.string());
-            } else {
-                const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, dir_path);
-                dir_path = find_in_cache(io, string_utils::tolower(dir_path.string().substr(0, dir_path.string().size() - 1)));
-                if (!dir_path.empty() && path_found) {
-                    LOG_TRACE("Found directory on case-sensitive filesystem at {}", dir_path.string());
-                } else {
-                    LOG_ERROR("Directory does not exist at {} (target path: {})", original_dir_path.string(), path);
-                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                }
+            const auto found_path = find_case_isens_path(io, device_for_icase, translated_path, dir_path);
+            if (found_path.empty()) {
+                LOG_ERROR("Directory does not exist at {} (target path: {})", dir_path.string(), path);
+                return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
             }
+
+            dir_path = found_path;
+            LOG_TRACE("Found directory on case-sensitive filesystem at {}", dir_path.string());
         } else {
             LOG_ERROR("Directory does not exist at: {} (target path: {})", dir_path.string(), path);
             return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
@@ -658,21 +705,21 @@ SceUID read_dir(IOState &io, const SceUID fd, SceIoDirent *dent, const std::wstr
 
     const auto dir = io.dir_entries.find(fd);
 
-    if (dir != io.dir_entries.end()) {
+    if (dir) {
         // Refuse any fd that is not explicitly a directory
-        if (!dir->second.is_directory())
+        if (!dir->is_directory())
             return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-        const auto d = dir->second.get_dir_ptr();
+        const auto d = dir->get_dir_ptr();
         if (!d)
             return 0;
 
         const auto d_name_utf8 = get_file_in_dir(d);
         strncpy(dent->d_name, d_name_utf8.c_str(), sizeof(dent->d_name));
 
-        const auto cur_path = dir->second.get_system_location() / d_name_utf8;
+        const auto cur_path = dir->get_system_location() / d_name_utf8;
         if (!(cur_path.filename_is_dot() || cur_path.filename_is_dot_dot())) {
-            const auto file_path = std::string(dir->second.get_vita_loc()) + '/' + d_name_utf8;
+            const auto file_path = std::string(dir->get_vita_loc()) + '/' + d_name_utf8;
 
             LOG_TRACE_IF(log_file_op, "{}: Reading entry {} of fd: {}", export_name, file_path, log_hex(fd));
             if (stat_file(io, file_path.c_str(), &dent->d_stat, pref_path, export_name) < 0)
@@ -695,8 +742,11 @@ int create_dir(IOState &io, const char *dir, int mode, const std::wstring &pref_
     }
 
     const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
-    if (recursive)
-        return fs::create_directories(emulated_path);
+    if (recursive) {
+        const bool created = fs::create_directories(emulated_path);
+        io.path_index.add(emulated_path);
+        return created;
+    }
     if (fs::exists(emulated_path))
         return IO_ERROR(SCE_ERROR_ERRNO_EEXIST);
 
@@ -711,6 +761,8 @@ int create_dir(IOState &io, const char *dir, int mode, const std::wstring &pref_
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
 
+    io.path_index.add(emulated_path);
+
     return 0;
 }
 
@@ -718,11 +770,11 @@ int close_dir(IOState &io, const SceUID fd, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
 
-    const auto erased_entries = io.dir_entries.erase(fd);
+    const bool erased = io.dir_entries.erase(fd);
 
     LOG_TRACE_IF(log_file_op, "{}: Closing dir fd: {}", export_name, log_hex(fd));
 
-    if (erased_entries == 0)
+    if (!erased)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
     return 0;
@@ -743,10 +795,13 @@ int remove_dir(IOState &io, const char *dir, const std::wstring &pref_path, cons
 
     LOG_TRACE_IF(log_file_op, "{}: Removing dir {} ({})", export_name, dir, device::construct_normalized_path(device, translated_path));
 
-    if (!fs::remove_all(device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio))) {
+    const auto emulated_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
+    if (!fs::remove_all(emulated_path)) {
         LOG_ERROR("Cannot remove dir: {} ({})", dir, device::construct_normalized_path(device, translated_path));
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
     }
 
+    io.path_index.remove(emulated_path);
+
     return 0;
 }
@@ -0,0 +1,143 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/path_index.h>
+
+#include <util/string_utils.h>
+
+#include <mutex>
+
+// Lowercase, with forward slashes and without trailing ones, so every spelling of a path gives the same key
+static std::string make_key(const fs::path &path) {
+    std::string key = string_utils::tolower(path.generic_path().string());
+    while ((key.size() > 1) && (key.back() == '/'))
+        key.pop_back();
+
+    return key;
+}
+
+static bool is_below(const std::string &key, const std::string &root_key) {
+    return (key.size() > root_key.size()) && (key.compare(0, root_key.size(), root_key) == 0) && (key[root_key.size()] == '/');
+}
+
+PathIndex::Mounts::iterator PathIndex::find_mount(const std::string &key) {
+    for (auto mount = mounts.begin(); mount != mounts.end(); mount++) {
+        if ((key == mount->first) || is_below(key, mount->first))
+            return mount;
+    }
+
+    return mounts.end();
+}
+
+void PathIndex::insert_tree(Mount &mount, const fs::path &path) {
+    mount.entries.insert_or_assign(make_key(path), path);
+
+    boost::system::error_code error;
+    if (!fs::is_directory(path, error))
+        return;
+
+    for (fs::recursive_directory_iterator file(path, error), end; !error && (file != end); file.increment(error)) {
+        mount.entries.insert_or_assign(make_key(file->path()), file->path());
+    }
+}
+
+fs::path PathIndex::resolve(const fs::path &root, const fs::path &path) {
+    const std::string root_key = make_key(root);
+    const std::string key = make_key(path);
+
+    {
+        const std::shared_lock<std::shared_mutex> lock(mutex);
+
+        const auto mount = mounts.find(root_key);
+        if (mount != mounts.end()) {
+            const auto entry = mount->second.entries.find(key);
+            if (entry != mount->second.entries.end())
+                return entry->second;
+
+            if (mount->second.missing.contains(key))
+                return {};
+        }
+    }
+
+    const std::lock_guard<std::shared_mutex> lock(mutex);
+
+    auto mount = mounts.find(root_key);
+    if (mount == mounts.end()) {
+        mount = mounts.emplace(root_key, Mount{}).first;
+        insert_tree(mount->second, root);
+    }
+
+    const auto entry = mount->second.entries.find(key);
+    if (entry != mount->second.entries.end())
+        return entry->second;
+
+    mount->second.missing.insert(key);
+    return {};
+}
+
+void PathIndex::add(const fs::path &path) {
+    const std::lock_guard<std::shared_mutex> lock(mutex);
+
+    const auto mount = find_mount(make_key(path));
+    if (mount == mounts.end())
+        return;
+
+    // The parents may just have been created as well, up to the first one which is already known
+    for (fs::path parent = path.parent_path(); is_below(make_key(parent), mount->first); parent = parent.parent_path()) {
+        if (!mount->second.entries.emplace(make_key(parent), parent).second)
+            break;
+    }
+
+    insert_tree(mount->second, path);
+
+    // Anything below the new path may exist now
+    mount->second.missing.clear();
+}
+
+void PathIndex::remove(const fs::path &path) {
+    const std::lock_guard<std::shared_mutex> lock(mutex);
+
+    const std::string key = make_key(path);
+    const auto mount = find_mount(key);
+    if (mount == mounts.end())
+        return;
+
+    Mount &removed_from = mount->second;
+    removed_from.entries.erase(key);
+
+    // Everything below it sorts right after the key followed by a slash
+    const std::string prefix = key + '/';
+    auto entry = removed_from.entries.lower_bound(prefix);
+    while ((entry != removed_from.entries.end()) && (entry->first.compare(0, prefix.size(), prefix) == 0)) {
+        entry = removed_from.entries.erase(entry);
+    }
+}
+
+void PathIndex::rename(const fs::path &from, const fs::path &to) {
+    remove(from);
+    add(to);
+}
+
+void PathIndex::clear() {
+    const std::lock_guard<std::shared_mutex> lock(mutex);
+    mounts.clear();
+}
+
+bool PathIndex::is_indexed(const fs::path &root) const {
+    const std::shared_lock<std::shared_mutex> lock(mutex);
+    return mounts.contains(make_key(root));
+}
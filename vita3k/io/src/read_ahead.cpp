@@ -0,0 +1,269 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/read_ahead.h>
+
+#include <util/log.h>
+#include <util/thread_pool.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Blocks are read one at a time per stream, two threads are enough to keep a couple of streams going
+static constexpr std::size_t READ_AHEAD_THREADS = 2;
+
+// A stream reading ahead needs two buffers, this is enough for a couple of them
+static constexpr std::size_t MAX_FREE_BUFFERS = 4;
+
+ReadAheadCache::ReadAheadCache(const std::size_t budget)
+    : budget(budget)
+    , worker(std::make_unique<util::ThreadPool>(READ_AHEAD_THREADS)) {
+}
+
+ReadAheadCache::~ReadAheadCache() {
+    // Waits for the blocks still being read, which release their budget on the way out
+    worker.reset();
+
+    const ReadAheadStats totals = stats();
+    if ((totals.hits != 0) || (totals.misses != 0)) {
+        LOG_INFO("Read ahead: {} hits, {} misses, {} bytes read ahead of which {} dropped, {} blocks over budget",
+            totals.hits, totals.misses, totals.prefetched_bytes, totals.dropped_bytes, totals.budget_rejections);
+    }
+}
+
+bool ReadAheadCache::reserve(const std::size_t size) {
+    std::size_t current = used;
+    do {
+        if (current + size > budget)
+            return false;
+    } while (!used.compare_exchange_weak(current, current + size));
+
+    return true;
+}
+
+void ReadAheadCache::release(const std::size_t size) {
+    used -= size;
+}
+
+std::unique_ptr<std::uint8_t[]> ReadAheadCache::take_buffer(const std::size_t capacity) {
+    {
+        const std::lock_guard<std::mutex> guard(buffers_mutex);
+
+        const auto buffer = std::find_if(free_buffers.begin(), free_buffers.end(), [capacity](const auto &free_buffer) {
+            return free_buffer.first == capacity;
+        });
+
+        if (buffer != free_buffers.end()) {
+            std::unique_ptr<std::uint8_t[]> result = std::move(buffer->second);
+            free_buffers.erase(buffer);
+            return result;
+        }
+    }
+
+    return std::make_unique_for_overwrite<std::uint8_t[]>(capacity);
+}
+
+void ReadAheadCache::give_buffer(const std::size_t capacity, std::unique_ptr<std::uint8_t[]> buffer) {
+    const std::lock_guard<std::mutex> guard(buffers_mutex);
+
+    // The oldest ones go first, they are the most likely to be of a size nobody uses anymore
+    if (free_buffers.size() >= MAX_FREE_BUFFERS)
+        free_buffers.erase(free_buffers.begin());
+
+    free_buffers.emplace_back(capacity, std::move(buffer));
+}
+
+FileVersion ReadAheadCache::version_of(const std::string &path) {
+    const std::lock_guard<std::mutex> guard(versions_mutex);
+
+    FileVersion version = versions[path].lock();
+    if (!version) {
+        version = std::make_shared<std::atomic<std::uint64_t>>(0);
+        versions[path] = version;
+
+        // Forget the files nobody has opened anymore, once in a while
+        if ((versions.size() % 64) == 0)
+            std::erase_if(versions, [](const auto &entry) { return entry.second.expired(); });
+    }
+
+    return version;
+}
+
+ReadAheadStats ReadAheadCache::stats() const {
+    ReadAheadStats result;
+    result.hits = counters.hits;
+    result.misses = counters.misses;
+    result.prefetched_bytes = counters.prefetched_bytes;
+    result.dropped_bytes = counters.dropped_bytes;
+    result.budget_rejections = counters.budget_rejections;
+
+    return result;
+}
+
+void ReadAheadCache::reset_stats() {
+    counters.hits = 0;
+    counters.misses = 0;
+    counters.prefetched_bytes = 0;
+    counters.dropped_bytes = 0;
+    counters.budget_rejections = 0;
+}
+
+ReadAheadStream::Block::~Block() {
+    cache->counters.dropped_bytes += size - std::min(consumed, size);
+    cache->release(reserved);
+
+    if (data)
+        cache->give_buffer(capacity, std::move(data));
+}
+
+ReadAheadStream::ReadAheadStream(ReadAheadCache &cache, FileVersion version, ReadAtFunc read_at)
+    : cache(cache)
+    , version(std::move(version))
+    , read_at(std::move(read_at)) {
+}
+
+ReadAheadStream::~ReadAheadStream() {
+    reset();
+}
+
+bool ReadAheadStream::is_valid(const BlockPtr &block, const SceOff offset) const {
+    return block && (block->version == *version) && (offset >= block->offset) && (offset < block->offset + static_cast<SceOff>(block->size));
+}
+
+bool ReadAheadStream::take_pending(const SceOff offset) {
+    if (!pending.valid())
+        return false;
+
+    BlockPtr block = pending.get();
+    pending = {};
+
+    if (!is_valid(block, offset))
+        return false;
+
+    current = std::move(block);
+    return true;
+}
+
+void ReadAheadStream::schedule() {
+    if (pending.valid())
+        return;
+
+    // Nothing left to read once the file ended
+    if (current && current->last && (current->version == *version))
+        return;
+
+    const SceOff start = (current && (current->version == *version)) ? std::max(next_offset, current->offset + static_cast<SceOff>(current->size)) : next_offset;
+
+    window = (window == 0) ? MIN_WINDOW : std::min(window * 2, MAX_WINDOW);
+    if (!cache.reserve(window)) {
+        cache.counters.budget_rejections++;
+        window = 0;
+        return;
+    }
+
+    auto block = std::make_shared<Block>();
+    block->cache = &cache;
+    block->reserved = window;
+    block->offset = start;
+
+    // The version is taken before reading, a write in the meantime makes the block stale
+    block->version = *version;
+
+    // The stream may be gone by the time this runs, so it only uses what it holds
+    pending = cache.worker->submit([block, read_at = read_at, size = window]() -> BlockPtr {
+                           block->data = block->cache->take_buffer(size);
+                           block->capacity = size;
+
+                           const SceOff read = read_at(block->data.get(), static_cast<SceSize>(size), block->offset);
+                           block->size = static_cast<std::size_t>(std::max<SceOff>(read, 0));
+                           block->last = (read < static_cast<SceOff>(size));
+
+                           block->cache->counters.prefetched_bytes += block->size;
+                           return block;
+                       })
+                  .share();
+}
+
+SceOff ReadAheadStream::read(void *data, const SceSize size, const SceOff offset) {
+    if (offset != next_offset) {
+        // Random access, what was read ahead is kept only if this happens to fall in it
+        if (!is_valid(current, offset))
+            current.reset();
+        pending = {};
+
+        sequential_reads = 0;
+        window = 0;
+    } else if (sequential_reads < SEQUENTIAL_READS) {
+        sequential_reads++;
+    }
+
+    std::uint8_t *output = static_cast<std::uint8_t *>(data);
+    SceOff done = 0;
+
+    while (done < size) {
+        const SceOff position = offset + done;
+        if (!is_valid(current, position)) {
+            current.reset();
+            if (!take_pending(position))
+                break;
+        }
+
+        const std::size_t in_block = static_cast<std::size_t>(position - current->offset);
+        const std::size_t count = std::min<std::size_t>(current->size - in_block, size - done);
+
+        std::memcpy(output + done, current->data.get() + in_block, count);
+        current->consumed = std::max(current->consumed, in_block + count);
+        done += count;
+    }
+
+    const bool from_memory = (done == size);
+    if (!from_memory) {
+        const SceOff read = read_at(output + done, size - done, offset + done);
+        if (read < 0) {
+            next_offset = -1;
+            return (done != 0) ? done : read;
+        }
+
+        done += read;
+    }
+
+    // Only the reads which are worth reading ahead count
+    if (window != 0) {
+        if (from_memory)
+            cache.counters.hits++;
+        else
+            cache.counters.misses++;
+    }
+
+    next_offset = offset + done;
+
+    if ((sequential_reads >= SEQUENTIAL_READS) && cache.enabled())
+        schedule();
+
+    return done;
+}
+
+void ReadAheadStream::reset() {
+    current.reset();
+
+    // The block being read holds its own reference, it goes away by itself once done
+    pending = {};
+
+    next_offset = 0;
+    sequential_reads = 0;
+    window = 0;
+}
@@ -16,20 +16,92 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
 #include <io.h>
 #else
 #define _FILE_OFFSET_BITS 64
 #include <stdio.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+
+#include <cerrno>
 #endif
 
 #include <io/state.h>
 
+#include <algorithm>
+#include <cstring>
+
+// Reads from a mapping at least this large hint the system to fetch the range ahead
+static constexpr SceSize LARGE_MAPPED_READ = 256 * 1024;
+
+static SceOff read_mapped(const FileMapping &mapping, void *data, const SceSize size, const SceOff offset, const bool sequential) {
+    if (static_cast<std::uint64_t>(offset) >= mapping.size())
+        return 0;
+
+    const std::uint64_t count = std::min<std::uint64_t>(size, mapping.size() - offset);
+    if (count >= LARGE_MAPPED_READ)
+        mapping.will_need(offset, count, sequential);
+
+    std::memcpy(data, mapping.data() + offset, count);
+    return count;
+}
+
+static SceOff file_length(FILE *file) {
+#ifdef _WIN32
+    return _filelengthi64(_fileno(file));
+#else
+    struct stat status;
+    if (fstat(fileno(file), &status) != 0)
+        return -1;
+    return status.st_size;
+#endif
+}
+
+std::unique_lock<std::shared_mutex> FileStats::lock_stream() const {
+    std::unique_lock<std::shared_mutex> lock(sync->mutex);
+
+    // Flushing drops whatever the stream had read ahead, and puts the descriptor back at the stream position
+    if (sync->stale_buffer.exchange(false)) {
+        fflush(wrapped_file.get());
+    }
+
+    return lock;
+}
+
+void FileStats::flush_writes() const {
+    if (sync->unflushed_writes) {
+        const std::lock_guard<std::shared_mutex> guard(sync->mutex);
+        if (sync->unflushed_writes.exchange(false)) {
+            fflush(wrapped_file.get());
+        }
+    }
+}
+
 SceOff FileStats::read(void *input_data, const int element_size, const SceSize element_count) const {
     if (!wrapped_file)
         return -1;
 
+    const auto lock = lock_stream();
+
+    if (mapping) {
+        // Like fread, only whole elements count
+        const SceOff read = read_mapped(*mapping, input_data, element_size * element_count, sync->position, true) / element_size;
+        sync->position += read * element_size;
+        return read;
+    }
+
+    if (read_ahead) {
+        const SceOff read = read_ahead->read(input_data, element_size * element_count, sync->position);
+        if (read < 0)
+            return 0;
+
+        sync->position += read - (read % element_size);
+        return read / element_size;
+    }
+
     return fread(input_data, element_size, element_count, wrapped_file.get());
 }
 
@@ -37,20 +109,31 @@ SceOff FileStats::write(const void *data, const SceSize size, const int count) c
     if (!can_write_file())
         return -1;
 
-    return fwrite(data, size, count, get_file_pointer());
+    const auto lock = lock_stream();
+    sync->unflushed_writes = true;
+    const SceOff result = fwrite(data, size, count, get_file_pointer());
+    written();
+    return result;
 }
 
 int FileStats::truncate(const SceSize size) const {
+    const auto lock = lock_stream();
+    fflush(get_file_pointer());
+    sync->unflushed_writes = false;
+
 #ifdef _WIN32
-    return _chsize_s(_fileno(get_file_pointer()), size);
+    const int result = _chsize_s(_fileno(get_file_pointer()), size);
 #else
-    return ftruncate(fileno(get_file_pointer()), size);
+    const int result = ftruncate(fileno(get_file_pointer()), size);
 #endif
+
+    written();
+    return result;
 }
 
-bool FileStats::seek(const SceOff offset, const SceIoSeekMode seek_mode) const {
+SceOff FileStats::seek(const SceOff offset, const SceIoSeekMode seek_mode) const {
     if (!wrapped_file)
-        return false;
+        return -1;
 
     auto base = SEEK_SET;
     switch (seek_mode) {
@@ -64,13 +147,34 @@ bool FileStats::seek(const SceOff offset, const SceIoSeekMode seek_mode) const {
         base = SEEK_END;
         break;
     default:
-        return false;
+        return -1;
+    }
+
+    // Seeking and reading back the position must not be split by another thread
+    const auto lock = lock_stream();
+
+    if (has_own_position()) {
+        SceOff position = offset;
+        if (base == SEEK_CUR)
+            position += sync->position;
+        else if (base == SEEK_END)
+            position += mapping ? static_cast<SceOff>(mapping->size()) : file_length(wrapped_file.get());
+
+        if (position < 0)
+            return -1;
+
+        sync->position = position;
+        return position;
     }
 
 #ifdef _WIN32
-    return _fseeki64(wrapped_file.get(), offset, base) == 0;
+    if (_fseeki64(wrapped_file.get(), offset, base) != 0)
+        return -1;
+    return _ftelli64(wrapped_file.get());
 #else
-    return fseeko(wrapped_file.get(), offset, base) == 0;
+    if (fseeko(wrapped_file.get(), offset, base) != 0)
+        return -1;
+    return ftello(wrapped_file.get());
 #endif
 }
 
@@ -78,9 +182,136 @@ SceOff FileStats::tell() const {
     if (!wrapped_file)
         return -1;
 
+    const auto lock = lock_stream();
+
+    if (has_own_position())
+        return sync->position;
+
 #ifdef _WIN32
     return _ftelli64(wrapped_file.get());
 #else
     return ftello(wrapped_file.get());
 #endif
 }
+
+#ifdef _WIN32
+// With a synchronous handle, overlapped transfers still move the file pointer, so it is put back after.
+// The stream lock is held for this, which serializes positional transfers on Windows.
+template <typename Transfer>
+static SceOff transfer_at(FILE *file, SceSize size, SceOff offset, Transfer transfer) {
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    if (handle == INVALID_HANDLE_VALUE)
+        return -1;
+
+    LARGE_INTEGER position = {};
+    if (!SetFilePointerEx(handle, position, &position, FILE_CURRENT))
+        return -1;
+
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(offset) >> 32);
+
+    DWORD transferred = 0;
+    const BOOL success = transfer(handle, static_cast<DWORD>(size), &transferred, &overlapped);
+    const bool at_end = !success && (GetLastError() == ERROR_HANDLE_EOF);
+
+    SetFilePointerEx(handle, position, nullptr, FILE_BEGIN);
+
+    if (!success && !at_end)
+        return -1;
+    return transferred;
+}
+#else
+// Loop until everything is transferred, as a transfer may be cut short by signals
+template <typename Transfer>
+static SceOff transfer_at(FILE *file, SceSize size, SceOff offset, Transfer transfer) {
+    const int fd = fileno(file);
+
+    SceOff done = 0;
+    while (done < size) {
+        const ssize_t result = transfer(fd, static_cast<std::size_t>(size - done), static_cast<off_t>(offset + done), done);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            return (done != 0) ? done : -1;
+        }
+
+        if (result == 0)
+            break;
+
+        done += result;
+    }
+
+    return done;
+}
+#endif
+
+SceOff FileStats::pread(void *data, const SceSize size, const SceOff offset) const {
+    if (!wrapped_file || (offset < 0))
+        return -1;
+
+    // The mapping never changes, so there is nothing to lock
+    if (mapping)
+        return read_mapped(*mapping, data, size, offset, false);
+
+    // Anything written through the stream must reach the descriptor first
+    flush_writes();
+
+#ifdef _WIN32
+    const auto lock = lock_stream();
+    return transfer_at(wrapped_file.get(), size, offset, [data](HANDLE handle, DWORD count, DWORD *transferred, OVERLAPPED *overlapped) {
+        return ReadFile(handle, data, count, transferred, overlapped);
+    });
+#else
+    const std::shared_lock<std::shared_mutex> lock(sync->mutex);
+    return transfer_at(wrapped_file.get(), size, offset, [data](int fd, std::size_t count, off_t position, SceOff done) {
+        return ::pread(fd, static_cast<std::uint8_t *>(data) + done, count, position);
+    });
+#endif
+}
+
+SceOff FileStats::pwrite(const void *data, const SceSize size, const SceOff offset) const {
+    if (!can_write_file() || (offset < 0))
+        return -1;
+
+    flush_writes();
+
+#ifdef _WIN32
+    const auto lock = lock_stream();
+    const SceOff result = transfer_at(wrapped_file.get(), size, offset, [data](HANDLE handle, DWORD count, DWORD *transferred, OVERLAPPED *overlapped) {
+        return WriteFile(handle, data, count, transferred, overlapped);
+    });
+#else
+    const std::shared_lock<std::shared_mutex> lock(sync->mutex);
+    const SceOff result = transfer_at(wrapped_file.get(), size, offset, [data](int fd, std::size_t count, off_t position, SceOff done) {
+        return ::pwrite(fd, static_cast<const std::uint8_t *>(data) + done, count, position);
+    });
+#endif
+
+    sync->stale_buffer = true;
+    written();
+    return result;
+}
+
+void FileStats::enable_read_ahead(ReadAheadCache &cache) {
+    version = cache.version_of(file_info.sys_loc.string());
+
+    // Writable files go through the stream, mapped ones are read ahead by the system already
+    if (mapping || can_write(file_info.open_mode) || !cache.enabled())
+        return;
+
+    // Reads ahead run on the cache worker without the stream lock, so they must not touch the stream. On
+    // Windows the file pointer they move is not used by files read ahead, their position is in the sync.
+    const FilePtr file = wrapped_file;
+    read_ahead = std::make_shared<ReadAheadStream>(cache, version, [file](void *data, const SceSize size, const SceOff offset) -> SceOff {
+#ifdef _WIN32
+        return transfer_at(file.get(), size, offset, [data](HANDLE handle, DWORD count, DWORD *transferred, OVERLAPPED *overlapped) {
+            return ReadFile(handle, data, count, transferred, overlapped);
+        });
+#else
+        return transfer_at(file.get(), size, offset, [data](int fd, std::size_t count, off_t position, SceOff done) {
+            return ::pread(fd, static_cast<std::uint8_t *>(data) + done, count, position);
+        });
+#endif
+    });
+}
@@ -0,0 +1,268 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "vfs_fixture.h"
+
+#include <io/async.h>
+#include <io/io.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+// A data file on ux0 of a temporary VFS
+class AsyncIoTest : public VfsTest {
+protected:
+    static constexpr std::size_t FILE_SIZE = 0x10000;
+    static constexpr const char *FILE_PATH = "ux0:data/async.bin";
+
+    std::vector<std::uint8_t> contents;
+
+    void SetUp() override {
+        VfsTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+
+        contents.resize(FILE_SIZE);
+        for (std::size_t i = 0; i < FILE_SIZE; i++) {
+            contents[i] = static_cast<std::uint8_t>(i * 7 + (i >> 8));
+        }
+
+        write_data_file("async.bin", contents);
+    }
+
+    void TearDown() override {
+        // The workers may still use the files
+        io.async.reset();
+        VfsTest::TearDown();
+    }
+
+    SceUID open(AsyncIoEngine &engine, SceUID op, int flags = SCE_O_RDONLY) {
+        engine.submit(op, invalid_fd, [this, flags]() { return open_file(io, FILE_PATH, flags, pref_path, "test"); }, nullptr);
+        return static_cast<SceUID>(engine.wait(op));
+    }
+};
+
+// Holds the only worker of an engine until released
+struct Gate {
+    std::promise<void> entered;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    AsyncIoEngine::Work work() {
+        return [this]() {
+            entered.set_value();
+            released.wait();
+            return SceOff(0);
+        };
+    }
+};
+} // namespace
+
+TEST_F(AsyncIoTest, open_seek_read) {
+    AsyncIoEngine &engine = *io.async;
+
+    const SceUID fd = open(engine, 1);
+    ASSERT_GE(fd, 0);
+
+    std::vector<std::uint8_t> buffer(256);
+    engine.submit(2, fd, [&]() { return seek_file(fd, 100, SCE_SEEK_SET, io, "test"); }, nullptr);
+    engine.submit(3, fd, [&]() { return SceOff(read_file(buffer.data(), io, fd, 256, "test")); }, nullptr);
+
+    ASSERT_EQ(engine.wait(3), 256);
+    ASSERT_EQ(engine.wait(2), 100);
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), contents.begin() + 100));
+
+    ASSERT_TRUE(engine.release(2));
+    ASSERT_EQ(engine.status(2), AsyncIoStatus::UNKNOWN);
+}
+
+TEST_F(AsyncIoTest, same_fd_keeps_order) {
+    AsyncIoEngine engine(4);
+
+    const SceUID fd = open(engine, 1);
+    ASSERT_GE(fd, 0);
+
+    // Each read continues from the position left by the previous one
+    constexpr SceSize chunk = 0x1000;
+    std::vector<std::uint8_t> buffer(FILE_SIZE);
+    for (SceUID i = 0; i < FILE_SIZE / chunk; i++) {
+        std::uint8_t *dest = buffer.data() + i * chunk;
+        engine.submit(10 + i, fd, [&, dest]() { return SceOff(read_file(dest, io, fd, chunk, "test")); }, nullptr);
+    }
+
+    for (SceUID i = 0; i < FILE_SIZE / chunk; i++) {
+        ASSERT_EQ(engine.wait(10 + i), chunk);
+    }
+
+    ASSERT_EQ(buffer, contents);
+}
+
+TEST_F(AsyncIoTest, write_then_read_back) {
+    AsyncIoEngine &engine = *io.async;
+
+    const SceUID fd = open(engine, 1, SCE_O_RDWR);
+    ASSERT_GE(fd, 0);
+
+    const std::vector<std::uint8_t> data(64, 0xAB);
+    std::vector<std::uint8_t> result(64);
+
+    engine.submit(2, fd, [&]() { return SceOff(write_file(fd, data.data(), 64, io, "test")); }, nullptr);
+    engine.submit(3, fd, [&]() { return seek_file(fd, 0, SCE_SEEK_SET, io, "test"); }, nullptr);
+    engine.submit(4, fd, [&]() { return SceOff(read_file(result.data(), io, fd, 64, "test")); }, nullptr);
+    engine.submit(5, fd, [&]() { return SceOff(close_file(io, fd, "test")); }, nullptr);
+
+    ASSERT_EQ(engine.wait(2), 64);
+    ASSERT_EQ(engine.wait(4), 64);
+    ASSERT_EQ(engine.wait(5), 0);
+    ASSERT_EQ(result, data);
+}
+
+TEST_F(AsyncIoTest, missing_file_reports_error) {
+    AsyncIoEngine &engine = *io.async;
+
+    engine.submit(1, invalid_fd, [&]() { return open_file(io, "ux0:data/missing.bin", SCE_O_RDONLY, pref_path, "test"); }, nullptr);
+    ASSERT_EQ(engine.wait(1), SCE_ERROR_ERRNO_ENOENT);
+}
+
+// Async requests open and close descriptors on the workers while the guest thread does the same
+TEST_F(AsyncIoTest, workers_and_guest_share_descriptor_tables) {
+    constexpr SceUID REQUEST_COUNT = 200;
+    AsyncIoEngine engine(4);
+
+    for (SceUID op = 1; op <= REQUEST_COUNT; op++) {
+        engine.submit(op, invalid_fd, [&, op]() {
+            const SceUID fd = open_file(io, FILE_PATH, SCE_O_RDONLY, pref_path, "test");
+            if (fd < 0)
+                return SceOff(fd);
+
+            std::uint8_t byte = 0;
+            const int read = pread_file(&byte, io, fd, 1, op, "test");
+            close_file(io, fd, "test");
+            return ((read == 1) && (byte == contents[op])) ? SceOff(0) : SceOff(-1);
+        },
+            nullptr);
+    }
+
+    int guest_errors = 0;
+    for (SceUID i = 0; i < REQUEST_COUNT; i++) {
+        const SceUID fd = open_file(io, FILE_PATH, SCE_O_RDONLY, pref_path, "test");
+        const SceUID dir = open_dir(io, "ux0:data", pref_path, "test");
+        if ((fd < 0) || (dir < 0) || (close_file(io, fd, "test") != 0) || (close_dir(io, dir, "test") != 0))
+            guest_errors++;
+    }
+
+    for (SceUID op = 1; op <= REQUEST_COUNT; op++) {
+        ASSERT_EQ(engine.wait(op), 0);
+    }
+
+    ASSERT_EQ(guest_errors, 0);
+    ASSERT_EQ(io.std_files.size(), 0);
+    ASSERT_EQ(io.dir_entries.size(), 0);
+}
+
+TEST(async_io, priority_order) {
+    AsyncIoEngine engine(1);
+    Gate gate;
+
+    engine.submit(1, 100, gate.work(), nullptr);
+    gate.entered.get_future().wait();
+
+    std::mutex order_mutex;
+    std::vector<SceUID> order;
+    const auto record = [&](SceUID op) {
+        return [&, op]() {
+            const std::lock_guard<std::mutex> guard(order_mutex);
+            order.push_back(op);
+            return SceOff(0);
+        };
+    };
+
+    engine.set_priority(10, SCE_IO_PRIORITY_LOWEST);
+    engine.submit(2, 10, record(2), nullptr);
+    engine.submit(3, 10, record(3), nullptr);
+    engine.submit(4, 20, record(4), nullptr);
+    engine.submit(5, 30, record(5), nullptr);
+
+    // Raised while already waiting
+    engine.set_priority(30, SCE_IO_PRIORITY_HIGHEST);
+    ASSERT_EQ(engine.get_priority(30), SCE_IO_PRIORITY_HIGHEST);
+    ASSERT_EQ(engine.get_priority(20), SCE_IO_PRIORITY_DEFAULT);
+
+    gate.release.set_value();
+    engine.wait(2);
+    engine.wait(3);
+    engine.wait(4);
+    engine.wait(5);
+
+    ASSERT_EQ(order, (std::vector<SceUID>{ 5, 4, 2, 3 }));
+
+    engine.reset_priority(10);
+    ASSERT_EQ(engine.get_priority(10), SCE_IO_PRIORITY_DEFAULT);
+}
+
+TEST(async_io, cancel_pending) {
+    AsyncIoEngine engine(1);
+    Gate gate;
+
+    engine.submit(1, 100, gate.work(), nullptr);
+    gate.entered.get_future().wait();
+
+    std::atomic<bool> ran = false;
+    SceOff reported = 0;
+    engine.submit(
+        2, 100, [&]() {
+            ran = true;
+            return SceOff(1);
+        },
+        [&](SceUID, SceOff result) { reported = result; });
+    engine.submit(3, 100, []() { return SceOff(3); }, nullptr);
+
+    // Running requests can't be canceled
+    ASSERT_FALSE(engine.cancel(1));
+    ASSERT_TRUE(engine.cancel(2));
+    ASSERT_FALSE(engine.cancel(2));
+    ASSERT_EQ(reported, SCE_ERROR_ERRNO_ECANCELED);
+
+    SceOff result = 0;
+    ASSERT_EQ(engine.status(2, &result), AsyncIoStatus::DONE);
+    ASSERT_EQ(result, SCE_ERROR_ERRNO_ECANCELED);
+
+    gate.release.set_value();
+    ASSERT_EQ(engine.wait(3), 3);
+    ASSERT_FALSE(ran);
+}
+
+TEST(async_io, callback_before_done) {
+    AsyncIoEngine engine(2);
+
+    std::atomic<bool> called = false;
+    engine.submit(
+        1, invalid_fd, []() { return SceOff(42); },
+        [&](SceUID op, SceOff result) {
+            // Still reported as running, so the op can't be released under the callback
+            called = (op == 1) && (result == 42) && (engine.status(1) == AsyncIoStatus::RUNNING);
+        });
+
+    ASSERT_EQ(engine.wait(1), 42);
+    ASSERT_TRUE(called);
+    ASSERT_TRUE(engine.release(1));
+    ASSERT_FALSE(engine.release(1));
+}
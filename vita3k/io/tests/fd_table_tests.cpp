@@ -0,0 +1,182 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "vfs_fixture.h"
+
+#include <io/fd_table.h>
+#include <io/io.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(fd_table, find_emplace_erase) {
+    FdTable<int> table;
+    ASSERT_EQ(table.find(1), nullptr);
+
+    table.emplace(1, 10);
+    table.emplace(17, 20);
+    ASSERT_EQ(table.size(), 2);
+    ASSERT_EQ(*table.find(1), 10);
+    ASSERT_EQ(*table.find(17), 20);
+
+    ASSERT_TRUE(table.erase(1));
+    ASSERT_FALSE(table.erase(1));
+    ASSERT_EQ(table.find(1), nullptr);
+    ASSERT_EQ(table.size(), 1);
+
+    table.clear();
+    ASSERT_EQ(table.size(), 0);
+}
+
+TEST(fd_table, handle_outlives_erase) {
+    FdTable<std::string> table;
+    table.emplace(3, "still here");
+
+    const auto handle = table.find(3);
+    ASSERT_TRUE(table.erase(3));
+    ASSERT_EQ(*handle, "still here");
+}
+
+TEST(fd_table, concurrent_insert_find_erase) {
+    constexpr int THREAD_COUNT = 8;
+    constexpr int FDS_PER_THREAD = 2000;
+
+    FdTable<int> table;
+    std::atomic<int> next_fd = 0;
+    std::atomic<int> errors = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < FDS_PER_THREAD; i++) {
+                const int fd = next_fd++;
+                table.emplace(fd, fd * 3);
+
+                const auto entry = table.find(fd);
+                if (!entry || (*entry != fd * 3))
+                    errors++;
+
+                // Look at descriptors owned by other threads too, they may or may not be there
+                const auto other = table.find(fd / 2);
+                if (other && (*other != (fd / 2) * 3))
+                    errors++;
+
+                if ((i % 2) && !table.erase(fd))
+                    errors++;
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(errors, 0);
+    ASSERT_EQ(table.size(), THREAD_COUNT * FDS_PER_THREAD / 2);
+}
+
+namespace {
+// Several files on ux0 of a temporary VFS
+class FdStressTest : public VfsTest {
+protected:
+    static constexpr int FILE_COUNT = 16;
+    static constexpr std::size_t FILE_SIZE = 0x4000;
+
+    static std::string vita_path(int index) {
+        return "ux0:data/stress" + std::to_string(index) + ".bin";
+    }
+
+    static std::uint8_t byte_at(int index, std::size_t offset) {
+        return static_cast<std::uint8_t>(index * 31 + offset * 7 + (offset >> 8));
+    }
+
+    void SetUp() override {
+        VfsTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+
+        for (int index = 0; index < FILE_COUNT; index++) {
+            std::vector<std::uint8_t> contents(FILE_SIZE);
+            for (std::size_t i = 0; i < FILE_SIZE; i++) {
+                contents[i] = byte_at(index, i);
+            }
+
+            write_data_file("stress" + std::to_string(index) + ".bin", contents);
+        }
+    }
+};
+} // namespace
+
+TEST_F(FdStressTest, open_read_close_from_many_threads) {
+    constexpr int THREAD_COUNT = 8;
+    constexpr int ROUNDS = 200;
+
+    // Kept open for the whole test, read by every thread while descriptors come and go around it
+    const SceUID shared_fd = open_file(io, vita_path(0).c_str(), SCE_O_RDONLY, pref_path, "test");
+    ASSERT_GE(shared_fd, 0);
+
+    std::atomic<int> errors = 0;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<std::uint8_t> buffer(0x100);
+
+            for (int round = 0; round < ROUNDS; round++) {
+                const int index = (t + round) % FILE_COUNT;
+                const SceUID fd = open_file(io, vita_path(index).c_str(), SCE_O_RDONLY, pref_path, "test");
+                if (fd < 0) {
+                    errors++;
+                    continue;
+                }
+
+                const std::size_t offset = (round * 0x100) % FILE_SIZE;
+                if (seek_file(fd, offset, SCE_SEEK_SET, io, "test") != static_cast<SceOff>(offset)
+                    || read_file(buffer.data(), io, fd, buffer.size(), "test") != static_cast<int>(buffer.size())) {
+                    errors++;
+                }
+
+                for (std::size_t i = 0; i < buffer.size(); i++) {
+                    if (buffer[i] != byte_at(index, offset + i)) {
+                        errors++;
+                        break;
+                    }
+                }
+
+                if (pread_file(buffer.data(), io, shared_fd, buffer.size(), offset, "test") != static_cast<int>(buffer.size())
+                    || buffer[0] != byte_at(0, offset)) {
+                    errors++;
+                }
+
+                if (close_file(io, fd, "test") != 0)
+                    errors++;
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(errors, 0);
+    ASSERT_EQ(io.std_files.size(), 1);
+    ASSERT_EQ(close_file(io, shared_fd, "test"), 0);
+    ASSERT_EQ(io.std_files.size(), 0);
+}
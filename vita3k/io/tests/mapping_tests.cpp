@@ -0,0 +1,114 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/state.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+class MappedFileTest : public testing::Test {
+protected:
+    static constexpr std::size_t FILE_SIZE = 0x100000;
+
+    fs::path path;
+    std::vector<std::uint8_t> contents;
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / fs::unique_path("vita3k-io-%%%%-%%%%.bin");
+
+        contents.resize(FILE_SIZE);
+        for (std::size_t i = 0; i < FILE_SIZE; i++) {
+            contents[i] = static_cast<std::uint8_t>(i * 13 + (i >> 10));
+        }
+
+        std::ofstream file(path.string(), std::ios::binary);
+        file.write(reinterpret_cast<const char *>(contents.data()), contents.size());
+    }
+
+    void TearDown() override {
+        fs::remove(path);
+    }
+};
+} // namespace
+
+TEST_F(MappedFileTest, reads_match_stream) {
+    const FileStats mapped("app0:file.bin", "app0:file.bin", path, SCE_O_RDONLY, true);
+    const FileStats stream("app0:file.bin", "app0:file.bin", path, SCE_O_RDONLY);
+    ASSERT_TRUE(mapped.is_mapped());
+    ASSERT_FALSE(stream.is_mapped());
+
+    std::vector<std::uint8_t> from_mapping(0x60000);
+    std::vector<std::uint8_t> from_stream(0x60000);
+
+    // The second read is large enough to give the hints, and cut short by the end of the file
+    for (int i = 0; i < 3; i++) {
+        const SceOff mapped_read = mapped.read(from_mapping.data(), 1, from_mapping.size());
+        ASSERT_EQ(mapped_read, stream.read(from_stream.data(), 1, from_stream.size()));
+        ASSERT_TRUE(std::equal(from_mapping.begin(), from_mapping.begin() + mapped_read, from_stream.begin()));
+        ASSERT_EQ(mapped.tell(), stream.tell());
+    }
+
+    ASSERT_EQ(mapped.tell(), FILE_SIZE);
+}
+
+TEST_F(MappedFileTest, seek_and_pread) {
+    const FileStats mapped("app0:file.bin", "app0:file.bin", path, SCE_O_RDONLY, true);
+    ASSERT_TRUE(mapped.is_mapped());
+
+    ASSERT_EQ(mapped.seek(0x100, SCE_SEEK_SET), 0x100);
+    ASSERT_EQ(mapped.seek(0x10, SCE_SEEK_CUR), 0x110);
+    ASSERT_EQ(mapped.seek(-0x10, SCE_SEEK_END), FILE_SIZE - 0x10);
+    ASSERT_EQ(mapped.seek(-1, SCE_SEEK_SET), -1);
+    ASSERT_EQ(mapped.tell(), FILE_SIZE - 0x10);
+
+    std::uint32_t value = 0;
+    ASSERT_EQ(mapped.read(&value, sizeof(value), 1), 1);
+    ASSERT_EQ(std::memcmp(&value, &contents[FILE_SIZE - 0x10], sizeof(value)), 0);
+
+    // Past the end reads nothing
+    ASSERT_EQ(mapped.seek(FILE_SIZE + 0x10, SCE_SEEK_SET), FILE_SIZE + 0x10);
+    ASSERT_EQ(mapped.read(&value, 1, sizeof(value)), 0);
+
+    std::vector<std::uint8_t> buffer(0x1000);
+    ASSERT_EQ(mapped.pread(buffer.data(), buffer.size(), 0x8000), buffer.size());
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), contents.begin() + 0x8000));
+    ASSERT_EQ(mapped.tell(), FILE_SIZE + 0x10);
+}
+
+TEST_F(MappedFileTest, fallback_to_stream) {
+    // Writable files are never mapped
+    const FileStats writable("ux0:file.bin", "ux0:file.bin", path, SCE_O_RDWR, true);
+    ASSERT_FALSE(writable.is_mapped());
+
+    // Neither are empty ones, which can't be
+    const fs::path empty_path = fs::temp_directory_path() / fs::unique_path("vita3k-io-%%%%-%%%%.bin");
+    std::ofstream(empty_path.string()).close();
+
+    {
+        const FileStats empty("app0:empty.bin", "app0:empty.bin", empty_path, SCE_O_RDONLY, true);
+        ASSERT_FALSE(empty.is_mapped());
+
+        std::uint8_t byte = 0;
+        ASSERT_EQ(empty.read(&byte, 1, 1), 0);
+    }
+
+    fs::remove(empty_path);
+}
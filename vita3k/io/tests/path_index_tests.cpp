@@ -0,0 +1,114 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/path_index.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+namespace {
+// A title directory with mixed-case names, like the ones extracted from a case-insensitive filesystem
+class PathIndexTest : public testing::Test {
+protected:
+    fs::path root;
+    PathIndex index;
+
+    void create_file(const fs::path &path) {
+        fs::create_directories(path.parent_path());
+        std::ofstream(path.string()).close();
+    }
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-io-%%%%-%%%%") / "PCSE00000";
+
+        create_file(root / "eboot.bin");
+        create_file(root / "Data" / "Level1" / "Map.DAT");
+        create_file(root / "Data" / "Level1" / "enemies.bin");
+        create_file(root / "SOUND" / "Bgm" / "Title.at9");
+        create_file(root / "sce_sys" / "param.sfo");
+    }
+
+    void TearDown() override {
+        fs::remove_all(root.parent_path());
+    }
+};
+} // namespace
+
+TEST_F(PathIndexTest, resolves_any_case) {
+    ASSERT_FALSE(index.is_indexed(root));
+
+    ASSERT_EQ(index.resolve(root, root / "data" / "level1" / "map.dat"), root / "Data" / "Level1" / "Map.DAT");
+    ASSERT_TRUE(index.is_indexed(root));
+
+    ASSERT_EQ(index.resolve(root, root / "sound/BGM/TITLE.AT9"), root / "SOUND" / "Bgm" / "Title.at9");
+    ASSERT_EQ(index.resolve(root, root / "EBOOT.BIN"), root / "eboot.bin");
+
+    // Directories too, with or without a trailing slash
+    ASSERT_EQ(index.resolve(root, root / "DATA" / "LEVEL1" / ""), root / "Data" / "Level1");
+    ASSERT_EQ(index.resolve(root, root / "sce_sys"), root / "sce_sys");
+}
+
+TEST_F(PathIndexTest, remembers_missing_paths) {
+    ASSERT_TRUE(index.resolve(root, root / "patch" / "data.bin").empty());
+
+    // Not walked again, so a file created behind its back stays unknown
+    create_file(root / "patch" / "data.bin");
+    ASSERT_TRUE(index.resolve(root, root / "PATCH" / "DATA.BIN").empty());
+    ASSERT_TRUE(index.resolve(root, root / "patch" / "data.bin").empty());
+
+    // Until it is told about it, which forgets what it knew to be missing
+    index.add(root / "patch" / "data.bin");
+    ASSERT_EQ(index.resolve(root, root / "PATCH" / "DATA.BIN"), root / "patch" / "data.bin");
+    ASSERT_EQ(index.resolve(root, root / "Patch"), root / "patch");
+}
+
+TEST_F(PathIndexTest, follows_vfs_changes) {
+    ASSERT_FALSE(index.resolve(root, root / "eboot.bin").empty());
+
+    fs::remove(root / "eboot.bin");
+    index.remove(root / "eboot.bin");
+    ASSERT_TRUE(index.resolve(root, root / "EBOOT.BIN").empty());
+
+    // Removing a directory removes everything below it, but nothing else sharing its prefix
+    create_file(root / "Data2" / "keep.bin");
+    index.add(root / "Data2" / "keep.bin");
+    fs::remove_all(root / "Data");
+    index.remove(root / "Data");
+    ASSERT_TRUE(index.resolve(root, root / "data" / "level1" / "map.dat").empty());
+    ASSERT_TRUE(index.resolve(root, root / "data" / "level1").empty());
+    ASSERT_EQ(index.resolve(root, root / "DATA2" / "KEEP.BIN"), root / "Data2" / "keep.bin");
+
+    // A renamed directory moves along with what is below it
+    fs::rename(root / "SOUND", root / "Audio");
+    index.rename(root / "SOUND", root / "Audio");
+    ASSERT_TRUE(index.resolve(root, root / "sound" / "bgm" / "title.at9").empty());
+    ASSERT_EQ(index.resolve(root, root / "audio" / "bgm" / "title.at9"), root / "Audio" / "Bgm" / "Title.at9");
+}
+
+TEST_F(PathIndexTest, ignores_paths_outside_of_mounts) {
+    const fs::path other = root.parent_path() / "other.bin";
+    create_file(other);
+
+    index.add(other);
+    ASSERT_FALSE(index.is_indexed(root.parent_path()));
+
+    ASSERT_FALSE(index.resolve(root, root / "eboot.bin").empty());
+    index.add(other);
+    index.remove(other);
+    ASSERT_FALSE(index.resolve(root, root / "EBOOT.bin").empty());
+}
@@ -0,0 +1,145 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "vfs_fixture.h"
+
+#include <io/io.h>
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+// A large file on ux0 of a temporary VFS
+class PositionalIoTest : public VfsTest {
+protected:
+    static constexpr std::size_t FILE_SIZE = 32 * 1024 * 1024;
+    static constexpr const char *FILE_PATH = "ux0:data/positional.bin";
+
+    std::vector<std::uint8_t> contents;
+
+    void SetUp() override {
+        VfsTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+
+        contents.resize(FILE_SIZE);
+        std::mt19937 generator(1234);
+        for (auto &byte : contents) {
+            byte = static_cast<std::uint8_t>(generator());
+        }
+
+        write_data_file("positional.bin", contents);
+    }
+
+    SceUID open(int flags = SCE_O_RDONLY) {
+        return open_file(io, FILE_PATH, flags, pref_path, "test");
+    }
+};
+} // namespace
+
+TEST_F(PositionalIoTest, pread_keeps_position) {
+    const SceUID fd = open();
+    ASSERT_GE(fd, 0);
+
+    ASSERT_EQ(seek_file(fd, 100, SCE_SEEK_SET, io, "test"), 100);
+
+    std::vector<std::uint8_t> buffer(0x1000);
+    ASSERT_EQ(pread_file(buffer.data(), io, fd, buffer.size(), 0x10000, "test"), buffer.size());
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), contents.begin() + 0x10000));
+    ASSERT_EQ(tell_file(io, fd, "test"), 100);
+
+    // Past the end is a short read, not an error
+    ASSERT_EQ(pread_file(buffer.data(), io, fd, buffer.size(), FILE_SIZE - 0x10, "test"), 0x10);
+    ASSERT_EQ(pread_file(buffer.data(), io, fd, buffer.size(), FILE_SIZE, "test"), 0);
+    ASSERT_EQ(pread_file(buffer.data(), io, fd, buffer.size(), -1, "test"), SCE_ERROR_ERRNO_EINVAL);
+
+    ASSERT_EQ(close_file(io, fd, "test"), 0);
+}
+
+TEST_F(PositionalIoTest, concurrent_reads_on_one_fd) {
+    constexpr std::size_t THREAD_COUNT = 8;
+    constexpr std::size_t READS_PER_THREAD = 256;
+    constexpr std::size_t MAX_READ = 0x20000;
+
+    const SceUID fd = open();
+    ASSERT_GE(fd, 0);
+
+    std::atomic<std::size_t> mismatches = 0;
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 generator(static_cast<std::uint32_t>(t));
+            std::vector<std::uint8_t> buffer(MAX_READ);
+
+            for (std::size_t i = 0; i < READS_PER_THREAD; i++) {
+                const SceSize size = generator() % MAX_READ + 1;
+                const SceOff offset = generator() % (FILE_SIZE - size);
+
+                if (pread_file(buffer.data(), io, fd, size, offset, "test") != static_cast<int>(size)
+                    || !std::equal(buffer.begin(), buffer.begin() + size, contents.begin() + offset)) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+
+    // Sequential reads through the file position, alongside the positional ones
+    std::vector<std::uint8_t> chunk(0x10000);
+    for (std::size_t offset = 0; offset < FILE_SIZE; offset += chunk.size()) {
+        ASSERT_EQ(read_file(chunk.data(), io, fd, chunk.size(), "test"), chunk.size());
+        ASSERT_TRUE(std::equal(chunk.begin(), chunk.end(), contents.begin() + offset));
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(mismatches, 0);
+    ASSERT_EQ(tell_file(io, fd, "test"), FILE_SIZE);
+
+    ASSERT_EQ(close_file(io, fd, "test"), 0);
+}
+
+TEST_F(PositionalIoTest, pwrite_is_seen_by_buffered_reads) {
+    const SceUID fd = open(SCE_O_RDWR);
+    ASSERT_GE(fd, 0);
+
+    // Fill the stream buffer with the old contents
+    std::uint8_t byte = 0;
+    ASSERT_EQ(read_file(&byte, io, fd, 1, "test"), 1);
+    ASSERT_EQ(byte, contents[0]);
+
+    const std::vector<std::uint8_t> patch(0x100, 0xAB);
+    ASSERT_EQ(pwrite_file(fd, patch.data(), patch.size(), 0x80, io, "test"), patch.size());
+    ASSERT_EQ(tell_file(io, fd, "test"), 1);
+
+    std::vector<std::uint8_t> buffer(0x200);
+    ASSERT_EQ(read_file(buffer.data(), io, fd, buffer.size(), "test"), buffer.size());
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.begin() + 0x7F, contents.begin() + 1));
+    ASSERT_TRUE(std::equal(buffer.begin() + 0x7F, buffer.begin() + 0x17F, patch.begin()));
+
+    // And buffered writes are flushed before a positional read
+    ASSERT_EQ(write_file(fd, patch.data(), 0x10, io, "test"), 0x10);
+    ASSERT_EQ(pread_file(buffer.data(), io, fd, 0x10, 0x201, "test"), 0x10);
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.begin() + 0x10, patch.begin()));
+
+    ASSERT_EQ(close_file(io, fd, "test"), 0);
+}
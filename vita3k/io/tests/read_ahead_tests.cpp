@@ -0,0 +1,197 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/state.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+class ReadAheadTest : public testing::Test {
+protected:
+    static constexpr std::size_t FILE_SIZE = 0x800000;
+    static constexpr std::size_t CHUNK_SIZE = 0x1000;
+
+    fs::path path;
+    std::vector<std::uint8_t> contents;
+    ReadAheadCache cache{ 64 * 1024 * 1024 };
+
+    void SetUp() override {
+        path = fs::temp_directory_path() / fs::unique_path("vita3k-io-%%%%-%%%%.bin");
+
+        contents.resize(FILE_SIZE);
+        for (std::size_t i = 0; i < FILE_SIZE; i++) {
+            contents[i] = static_cast<std::uint8_t>(i * 7 + (i >> 12));
+        }
+
+        std::ofstream file(path.string(), std::ios::binary);
+        file.write(reinterpret_cast<const char *>(contents.data()), contents.size());
+    }
+
+    void TearDown() override {
+        fs::remove(path);
+    }
+
+    FileStats open(const int flags) {
+        return FileStats("ux0:file.bin", "ux0:file.bin", path, flags, false, &cache);
+    }
+
+    void expect_read(const FileStats &file, const std::size_t size) {
+        const SceOff position = file.tell();
+        const std::size_t expected = std::min<std::size_t>(size, FILE_SIZE - position);
+
+        std::vector<std::uint8_t> data(size);
+        ASSERT_EQ(file.read(data.data(), 1, size), expected);
+        ASSERT_EQ(std::memcmp(data.data(), contents.data() + position, expected), 0) << "at " << position;
+        ASSERT_EQ(file.tell(), position + expected);
+    }
+};
+} // namespace
+
+TEST_F(ReadAheadTest, only_read_only_files) {
+    const FileStats reader = open(SCE_O_RDONLY);
+    const FileStats writer = open(SCE_O_RDWR);
+    ASSERT_TRUE(reader.is_read_ahead());
+    ASSERT_FALSE(writer.is_read_ahead());
+
+    ReadAheadCache disabled(0);
+    const FileStats unbuffered("ux0:file.bin", "ux0:file.bin", path, SCE_O_RDONLY, false, &disabled);
+    ASSERT_FALSE(unbuffered.is_read_ahead());
+}
+
+TEST_F(ReadAheadTest, sequential_reads) {
+    const FileStats file = open(SCE_O_RDONLY);
+
+    for (std::size_t i = 0; i < FILE_SIZE / CHUNK_SIZE; i++) {
+        expect_read(file, CHUNK_SIZE);
+    }
+
+    // At the end
+    std::uint8_t byte;
+    ASSERT_EQ(file.read(&byte, 1, 1), 0);
+
+    const ReadAheadStats stats = cache.stats();
+    ASSERT_GT(stats.hits, stats.misses * 10);
+    ASSERT_GE(stats.prefetched_bytes, FILE_SIZE / 2);
+}
+
+TEST_F(ReadAheadTest, odd_sizes_and_seeks) {
+    const FileStats file = open(SCE_O_RDONLY);
+
+    const std::size_t sizes[] = { 1, 4095, 0x8000, 17, 0x20001, 3 };
+    for (int round = 0; round < 4; round++) {
+        for (const std::size_t size : sizes) {
+            expect_read(file, size);
+        }
+    }
+
+    // Back, forward, from the end, then sequential again
+    ASSERT_EQ(file.seek(0x1234, SCE_SEEK_SET), 0x1234);
+    expect_read(file, 0x3000);
+    ASSERT_EQ(file.seek(0x100000, SCE_SEEK_CUR), 0x1234 + 0x3000 + 0x100000);
+    expect_read(file, 0x10);
+    ASSERT_EQ(file.seek(-0x10000, SCE_SEEK_END), FILE_SIZE - 0x10000);
+    for (int i = 0; i < 20; i++) {
+        expect_read(file, 0x1000);
+    }
+    ASSERT_EQ(file.tell(), FILE_SIZE);
+    ASSERT_EQ(file.seek(-1, SCE_SEEK_SET), -1);
+}
+
+TEST_F(ReadAheadTest, writes_are_seen) {
+    const FileStats reader = open(SCE_O_RDONLY);
+
+    for (int i = 0; i < 8; i++) {
+        expect_read(reader, CHUNK_SIZE);
+    }
+
+    // Right where the reader is going, which was read ahead already
+    {
+        const FileStats writer = open(SCE_O_RDWR);
+        const SceOff position = reader.tell();
+
+        std::vector<std::uint8_t> patch(CHUNK_SIZE * 3, 0xAB);
+        ASSERT_EQ(writer.pwrite(patch.data(), patch.size(), position + 10), patch.size());
+        std::memcpy(contents.data() + position + 10, patch.data(), patch.size());
+    }
+
+    for (int i = 0; i < 8; i++) {
+        expect_read(reader, CHUNK_SIZE);
+    }
+
+    // Through the stream this time, seen once it is flushed
+    {
+        const FileStats writer = open(SCE_O_RDWR);
+        const SceOff position = reader.tell() + CHUNK_SIZE;
+        ASSERT_EQ(writer.seek(position, SCE_SEEK_SET), position);
+
+        std::vector<std::uint8_t> patch(100, 0xCD);
+        ASSERT_EQ(writer.write(patch.data(), 1, patch.size()), patch.size());
+        std::memcpy(contents.data() + position, patch.data(), patch.size());
+    }
+
+    for (int i = 0; i < 8; i++) {
+        expect_read(reader, CHUNK_SIZE);
+    }
+
+    // Cut short, then read up to the new end
+    {
+        const FileStats writer = open(SCE_O_RDWR);
+        ASSERT_EQ(writer.truncate(reader.tell() + 100), 0);
+    }
+
+    std::vector<std::uint8_t> data(CHUNK_SIZE);
+    ASSERT_EQ(reader.read(data.data(), 1, CHUNK_SIZE), 100);
+}
+
+TEST_F(ReadAheadTest, budget_limits_reading_ahead) {
+    cache.set_budget(ReadAheadStream::MIN_WINDOW);
+
+    const FileStats first = open(SCE_O_RDONLY);
+    const FileStats second = open(SCE_O_RDONLY);
+
+    for (int i = 0; i < 64; i++) {
+        expect_read(first, CHUNK_SIZE);
+        expect_read(second, CHUNK_SIZE);
+        ASSERT_LE(cache.used_bytes(), ReadAheadStream::MIN_WINDOW);
+    }
+
+    ASSERT_GT(cache.stats().budget_rejections, 0);
+}
+
+TEST_F(ReadAheadTest, budget_is_given_back) {
+    {
+        const FileStats file = open(SCE_O_RDONLY);
+        for (int i = 0; i < 64; i++) {
+            expect_read(file, CHUNK_SIZE);
+        }
+
+        ASSERT_GT(cache.used_bytes(), 0);
+    }
+
+    // Blocks still being read go away once done
+    for (int i = 0; (i < 1000) && (cache.used_bytes() != 0); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_EQ(cache.used_bytes(), 0);
+}
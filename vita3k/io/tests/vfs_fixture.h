@@ -0,0 +1,53 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <io/functions.h>
+#include <io/state.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A VFS in its own temporary directory, removed once the test is done
+class VfsTest : public testing::Test {
+protected:
+    fs::path root;
+    std::wstring pref_path;
+    IOState io;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-io-%%%%-%%%%");
+        pref_path = (root / "pref").wstring();
+        ASSERT_TRUE(init(io, root / "base", root / "pref", false));
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+
+    // Writes a file in ux0:data and returns its path on the guest side
+    std::string write_data_file(const std::string &name, const std::vector<std::uint8_t> &contents) {
+        std::ofstream file((root / "pref" / "ux0" / "data" / name).string(), std::ios::binary);
+        file.write(reinterpret_cast<const char *>(contents.data()), contents.size());
+        return "ux0:data/" + name;
+    }
+};
@@ -65,6 +65,16 @@ public:
         return reinterpret_cast<T *>(it->second.get());
     }
 
+    // Same as get, for objects which may not have been created yet
+    template <typename T>
+    T *find() {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objs.find(TypeInfo::registered<T>::index);
+        if (it == objs.end())
+            return nullptr;
+        return reinterpret_cast<T *>(it->second.get());
+    }
+
     template <typename T, typename... Args>
     bool create(Args &&...args) {
         std::lock_guard<std::mutex> lock(mutex);
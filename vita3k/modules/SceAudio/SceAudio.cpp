@@ -19,6 +19,7 @@
 #include "SceAudio_tracy.h"
 #include "Tracy.hpp"
 
+#include <audio/functions.h>
 #include <util/lock_and_find.h>
 
 EXPORT(int, sceAudioOutGetAdopt, SceAudioOutPortType type) {
@@ -81,18 +82,15 @@ EXPORT(int, sceAudioOutOpenPort, SceAudioOutPortType type, int len, int freq, Sc
     }
 
     const int channels = (mode == SCE_AUDIO_OUT_MODE_MONO) ? 1 : 2;
-    const AudioStreamPtr stream(SDL_NewAudioStream(AUDIO_S16LSB, channels, freq, host.audio.ro.spec.format, host.audio.ro.spec.channels, host.audio.ro.spec.freq), SDL_FreeAudioStream);
-    if (!stream) {
+    const AudioOutPortPtr port = create_out_port(host.audio, len, freq, channels);
+    if (!port) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_NOT_OPENED);
     }
 
-    const AudioOutPortPtr port = std::make_shared<AudioOutPort>();
-    port->ro.len_bytes = len * channels * sizeof(int16_t);
-    port->shared.stream = stream;
-
-    const std::lock_guard<std::mutex> lock(host.audio.shared.mutex);
-    const int port_id = host.audio.shared.next_port_id++;
-    host.audio.shared.out_ports.emplace(port_id, port);
+    const int port_id = add_out_port(host.audio, port);
+    if (port_id == 0) {
+        return RET_ERROR(SCE_AUDIO_OUT_ERROR_PORT_FULL);
+    }
 
     return port_id;
 }
@@ -116,20 +114,21 @@ EXPORT(int, sceAudioOutOutput, int port, const void *buf) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
     }
 
-    // Put audio to the port's stream and see how much is left to play.
-    std::unique_lock<std::mutex> lock(prt->shared.mutex);
-    SDL_AudioStreamPut(prt->shared.stream.get(), buf, prt->ro.len_bytes);
-    const int available = SDL_AudioStreamAvailable(prt->shared.stream.get());
+    queue_out_port(*prt, buf);
 
     // If there's lots of audio left to play, stop this thread.
-    // The audio callback will wake it up later when it's running out of data.
-    if (available > host.audio.ro.spec.size) {
-        prt->shared.thread = thread_id;
-        lock.unlock();
+    // The mixer will wake it up later when it's running out of data.
+    if (is_out_port_full(host.audio, *prt)) {
+        prt->thread = thread_id;
 
         std::unique_lock<std::mutex> mlock(thread->mutex);
-        if (thread->status != ThreadStatus::run)
+        // The mixer may also have drained the port before it could see this thread, then nobody would wake it up
+        if ((thread->status != ThreadStatus::run) || !is_out_port_full(host.audio, *prt)) {
+            SceUID waiting = thread_id;
+            prt->thread.compare_exchange_strong(waiting, -1);
             return 0;
+        }
+
         thread->status = ThreadStatus::wait;
         thread->status_cond.wait(mlock, [&]() { return thread->status == ThreadStatus::run; });
     }
@@ -151,11 +150,7 @@ EXPORT(int, sceAudioOutGetRestSample, int port) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
     }
 
-    const int bytes_available = SDL_AudioStreamAvailable(prt->shared.stream.get());
-    assert(host.audio.ro.spec.format == AUDIO_S16LSB);
-
-    // we have the number of bytes left, we can convert it back to the number of samples left
-    return bytes_available / (host.audio.ro.spec.channels * sizeof(int16_t));
+    return get_out_port_rest(host.audio, *prt);
 }
 
 EXPORT(int, sceAudioOutOpenExtPort) {
@@ -178,8 +173,7 @@ EXPORT(int, sceAudioOutReleasePort, int port) {
     // --- Tracy logging --- END
 #endif
 
-    const std::lock_guard<std::mutex> guard(host.audio.shared.mutex);
-    if (!host.audio.shared.out_ports.erase(port)) {
+    if (!remove_out_port(host.audio, port)) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
     }
 
@@ -283,13 +277,10 @@ EXPORT(int, sceAudioOutSetVolume, int port, SceAudioOutChannelFlag ch, int *vol)
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
 
     // Unsure of what happens if only one channel is selected, this will break if program passes a size 1 int array
-    const int left = (ch & SCE_AUDIO_VOLUME_FLAG_L_CH) ? vol[0] : prt->left_channel_volume;
-    const int right = (ch & SCE_AUDIO_VOLUME_FLAG_R_CH) ? vol[1] : prt->right_channel_volume;
-    const float volume_level = (static_cast<float>(left + right) / static_cast<float>(SCE_AUDIO_VOLUME_0DB * 2));
-    const int volume = static_cast<int>(SDL_MIX_MAXVOLUME * volume_level);
+    const int left = (ch & SCE_AUDIO_VOLUME_FLAG_L_CH) ? vol[0] : prt->left_channel_volume.load();
+    const int right = (ch & SCE_AUDIO_VOLUME_FLAG_R_CH) ? vol[1] : prt->right_channel_volume.load();
 
-    prt->volume = volume;
-    // then update channel volumes in case there was a change
+    // The mixer applies them per channel on its next pass
     prt->left_channel_volume = left;
     prt->right_channel_volume = right;
 
@@ -208,25 +208,15 @@ static int decode_audio_frames(HostState &host, const char *export_name, SceAudi
     uint8_t *es_data = ctrl->es_data.get(host.mem);
     uint8_t *pcm_data = ctrl->pcm_data.get(host.mem);
 
-    ctrl->es_size_used = 0;
-    ctrl->pcm_size_given = 0;
-
-    for (uint32_t frame = 0; frame < nb_frames; frame++) {
-        DecoderSize size;
-        if (!decoder->send(es_data, ctrl->es_size_max)
-            || !decoder->receive(pcm_data, &size)) {
-            return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
-        }
+    DecoderBatch batch;
+    const bool success = decoder->decode_frames(es_data, ctrl->es_size_max, pcm_data, nb_frames, batch);
 
-        uint32_t es_size_used = std::min(decoder->get_es_size(), ctrl->es_size_max);
-        assert(es_size_used <= ctrl->es_size_max);
-        ctrl->es_size_used += es_size_used;
-        es_data += es_size_used;
+    ctrl->es_size_used = batch.es_size;
+    ctrl->pcm_size_given = batch.samples * decoder->get(DecoderQuery::CHANNELS) * sizeof(int16_t);
+    assert(ctrl->pcm_size_given <= ctrl->pcm_size_max * nb_frames);
 
-        uint32_t pcm_size_given = size.samples * decoder->get(DecoderQuery::CHANNELS) * sizeof(int16_t);
-        assert(pcm_size_given <= ctrl->pcm_size_max);
-        ctrl->pcm_size_given += pcm_size_given;
-        pcm_data += pcm_size_given;
+    if (!success) {
+        return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
     }
 
     return 0;
@@ -297,27 +287,25 @@ EXPORT(int, sceAudiodecPartlyDecode, SceAudiodecCtrl *ctrl, SceUInt32 samples_of
 
     // TODO: if the offset is too big, do not decode the first superframes (doesn't seem to happen with libatrac)
     const uint32_t bytes_per_sample = decoder->get(DecoderQuery::CHANNELS) * sizeof(int16_t);
-    ctrl->es_size_used = 0;
-    ctrl->pcm_size_given = 0;
-    std::vector<uint8_t> temp_storage;
-    temp_storage.reserve((samples_offset + samples_to_decode) * bytes_per_sample);
-
-    while (ctrl->pcm_size_given < (samples_offset + samples_to_decode) * bytes_per_sample) {
-        DecoderSize size;
-        if (!decoder->send(es_data, ctrl->es_size_max)) {
-            return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
-        }
-        const uint32_t es_size_used = decoder->get_es_size();
-        assert(es_size_used <= ctrl->es_size_max);
-        ctrl->es_size_used += es_size_used;
-        es_data += es_size_used;
-
-        decoder->receive(nullptr, &size);
-        const uint32_t pcm_size_given = size.samples * bytes_per_sample;
-        ctrl->pcm_size_given += pcm_size_given;
-        const uint32_t old_size = temp_storage.size();
-        temp_storage.resize(old_size + pcm_size_given);
-        decoder->receive(temp_storage.data() + old_size, &size);
+    const uint32_t samples_per_frame = decoder->get(DecoderQuery::AT9_SAMPLE_PER_FRAME);
+    if (samples_per_frame == 0) {
+        return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
+    }
+
+    const uint32_t frame_count = (samples_offset + samples_to_decode + samples_per_frame - 1) / samples_per_frame;
+
+    // Kept between calls, libatrac calls this for every frame
+    thread_local std::vector<uint8_t> temp_storage;
+    temp_storage.resize(frame_count * samples_per_frame * bytes_per_sample);
+
+    DecoderBatch batch;
+    const bool success = decoder->decode_frames(es_data, ctrl->es_size_max, temp_storage.data(), frame_count, batch);
+
+    ctrl->es_size_used = batch.es_size;
+    ctrl->pcm_size_given = batch.samples * bytes_per_sample;
+
+    if (!success) {
+        return RET_ERROR(SCE_AUDIODEC_ERROR_API_FAIL);
     }
 
     memcpy(pcm_data + samples_offset * bytes_per_sample, temp_storage.data() + samples_offset * bytes_per_sample, samples_to_decode * bytes_per_sample);
@@ -334,13 +334,12 @@ EXPORT(bool, sceAvPlayerGetAudioData, SceUID player_handle, SceAvPlayerFrameInfo
                 player_info->player.last_sample_count * sizeof(int16_t) * player_info->player.last_channels, true);
         }
     } else {
-        std::vector<int16_t> data = player_info->player.receive_audio();
-
-        if (data.empty())
+        PlayerAudioFrame frame;
+        if (!player_info->player.receive_audio(frame))
             return false;
 
-        buffer = get_buffer(player_info, MediaType::AUDIO, host.mem, (uint32_t)data.size() * sizeof(int16_t), false);
-        std::memcpy(buffer.get(host.mem), data.data(), data.size() * sizeof(int16_t));
+        buffer = get_buffer(player_info, MediaType::AUDIO, host.mem, (uint32_t)frame.data.size() * sizeof(int16_t), false);
+        std::memcpy(buffer.get(host.mem), frame.data.data(), frame.data.size() * sizeof(int16_t));
     }
 
     frame_info->timestamp = player_info->player.last_timestamp;
@@ -371,11 +370,12 @@ EXPORT(uint32_t, sceAvPlayerGetStreamInfo, SceUID player_handle, uint stream_no,
         stream_info->stream_details.video.aspect_ratio = static_cast<float>(size.width) / static_cast<float>(size.height);
         strcpy(stream_info->stream_details.video.language, "ENG");
     } else if (stream_no == 1) { // audio
-        player_info->player.receive_audio(); // TODO: Get audio info without skipping data frames
+        PlayerAudioFrame info;
+        player_info->player.peek_audio(info);
         stream_info->stream_type = MediaType::AUDIO;
-        stream_info->stream_details.audio.channels = player_info->player.last_channels;
-        stream_info->stream_details.audio.sample_rate = player_info->player.last_sample_rate;
-        stream_info->stream_details.audio.size = player_info->player.last_channels * player_info->player.last_sample_count * sizeof(int16_t);
+        stream_info->stream_details.audio.channels = info.channels;
+        stream_info->stream_details.audio.sample_rate = info.sample_rate;
+        stream_info->stream_details.audio.size = info.channels * info.sample_count * sizeof(int16_t);
         strcpy(stream_info->stream_details.audio.language, "ENG");
     } else {
         return SCE_AVPLAYER_ERROR_INVALID_ARGUMENT;
@@ -409,10 +409,14 @@ EXPORT(bool, sceAvPlayerGetVideoData, SceUID player_handle, SceAvPlayerFrameInfo
             else
                 buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), false);
         } else {
-            buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), true);
-
-            std::vector<uint8_t> data = player_info->player.receive_video();
-            std::memcpy(buffer.get(host.mem), data.data(), data.size());
+            PlayerVideoFrame frame;
+            if (player_info->player.receive_video(frame)) {
+                buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), true);
+                std::memcpy(buffer.get(host.mem), frame.data.data(), frame.data.size());
+            } else {
+                // The decoding thread is behind, show the last frame once more
+                buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), false);
+            }
         }
     } else {
         buffer = get_buffer(player_info, MediaType::VIDEO, host.mem, H264DecoderState::buffer_size(size), false);
@@ -459,11 +463,19 @@ EXPORT(bool, sceAvPlayerIsActive, SceUID player_handle) {
     const auto state = host.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
 
-    return !player_info->player.video_playing.empty();
+    return player_info->player.is_active();
 }
 
-EXPORT(int, sceAvPlayerJumpToTime) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceAvPlayerJumpToTime, SceUID player_handle, uint64_t time) {
+    const auto state = host.kernel.obj_store.get<AvPlayerState>();
+    const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
+    if (!player_info) {
+        return RET_ERROR(SCE_AVPLAYER_ERROR_INVALID_ARGUMENT);
+    }
+
+    player_info->player.seek(time);
+    player_info->last_frame_time = current_time();
+    return 0;
 }
 
 EXPORT(int, sceAvPlayerPause, SceUID player_handle) {
@@ -503,9 +515,7 @@ EXPORT(int, sceAvPlayerSetTrickSpeed) {
 EXPORT(int, sceAvPlayerStart, SceUID player_handle) {
     const auto state = host.kernel.obj_store.get<AvPlayerState>();
     const PlayerPtr &player_info = lock_and_find(player_handle, state->players, state->mutex);
-    if (!player_info->player.videos_queue.empty()) {
-        player_info->player.pop_video();
-    }
+    player_info->player.pop_video();
     run_event_callback(host, thread_id, player_info, SCE_AVPLAYER_STATE_PLAY, 0, Ptr<void>(0));
     return 0;
 }
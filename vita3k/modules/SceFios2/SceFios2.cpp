@@ -17,44 +17,737 @@
 
 #include "SceFios2.h"
 
+#include <fios/cache.h>
+#include <fios/overlay.h>
+#include <fios/psarc.h>
+#include <io/async.h>
+#include <io/device.h>
+#include <io/fd_table.h>
+#include <io/functions.h>
+#include <io/io.h>
+#include <io/state.h>
+#include <rtc/rtc.h>
+#include <util/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <tuple>
+
+typedef int32_t SceFiosHandle;
+typedef SceFiosHandle SceFiosFH;
+typedef SceFiosHandle SceFiosOp;
+typedef int64_t SceFiosOffset;
+typedef int64_t SceFiosSize;
+
+// Nanoseconds, both for points in time and for intervals
+typedef int64_t SceFiosTime;
+typedef int64_t SceFiosTimeInterval;
+
+// Seconds since 1970
+typedef uint64_t SceFiosDate;
+
+enum SceFiosErrorCode : uint32_t {
+    SCE_FIOS_ERROR_UNIMPLEMENTED = 0x80820001,
+    SCE_FIOS_ERROR_CANCELLED = 0x80820002,
+    SCE_FIOS_ERROR_BAD_PATH = 0x80820003,
+    SCE_FIOS_ERROR_BAD_FH = 0x80820004,
+    SCE_FIOS_ERROR_BAD_DH = 0x80820005,
+    SCE_FIOS_ERROR_BAD_OP = 0x80820006,
+    SCE_FIOS_ERROR_BAD_ORDER = 0x80820007,
+    SCE_FIOS_ERROR_BAD_PTR = 0x80820008,
+    SCE_FIOS_ERROR_BAD_SIZE = 0x80820009,
+    SCE_FIOS_ERROR_BAD_OFFSET = 0x8082000A,
+    SCE_FIOS_ERROR_BAD_RESOLVE_TYPE = 0x8082000B,
+    SCE_FIOS_ERROR_ACCESS = 0x8082000C,
+    SCE_FIOS_ERROR_NOT_A_FILE = 0x8082000D,
+    SCE_FIOS_ERROR_BAD_ARCHIVE = 0x8082000E,
+    SCE_FIOS_ERROR_BAD_OVERLAY = 0x8082000F,
+};
+
+enum SceFiosOpenFlags : uint32_t {
+    SCE_FIOS_O_READ = 0x1,
+    SCE_FIOS_O_WRITE = 0x2,
+    SCE_FIOS_O_APPEND = 0x4,
+    SCE_FIOS_O_CREAT = 0x8,
+    SCE_FIOS_O_TRUNC = 0x10,
+};
+
+enum SceFiosStatFlags : uint32_t {
+    SCE_FIOS_STATUS_DIRECTORY = 0x1,
+    SCE_FIOS_STATUS_READABLE = 0x2,
+    SCE_FIOS_STATUS_WRITABLE = 0x4,
+};
+
+// Reason passed to the callback of an op
+enum SceFiosOpEvent : uint32_t {
+    SCE_FIOS_OPEVENT_COMPLETE = 1,
+    SCE_FIOS_OPEVENT_DELETE = 2,
+};
+
+enum SceFiosWhence : int32_t {
+    SCE_FIOS_SEEK_SET = 0,
+    SCE_FIOS_SEEK_CUR = 1,
+    SCE_FIOS_SEEK_END = 2,
+};
+
+constexpr size_t SCE_FIOS_OVERLAY_PATH_MAX = 292;
+constexpr int SCE_FIOS_DEFAULT_DECOMPRESSOR_THREADS = 2;
+
+struct SceFiosBuffer {
+    Ptr<void> pPtr;
+    uint32_t length;
+};
+
+struct SceFiosOpAttr {
+    SceFiosTime deadline;
+    Ptr<void> pCallback;
+    Ptr<void> pCallbackContext;
+    uint32_t priority : 8;
+    uint32_t opflags : 24;
+    uint32_t userTag;
+    Ptr<void> userPtr;
+    Ptr<void> pReserved;
+};
+
+struct SceFiosOpenParams {
+    uint32_t openFlags : 16;
+    uint32_t opFlags : 16;
+    uint32_t reserved;
+    SceFiosBuffer buffer;
+};
+
+struct SceFiosStat {
+    SceFiosOffset fileSize;
+    SceFiosDate accessDate;
+    SceFiosDate modificationDate;
+    SceFiosDate creationDate;
+    uint32_t statFlags;
+    uint32_t reserved;
+    int64_t uid;
+    int64_t gid;
+    int64_t dev;
+    int64_t ino;
+    int64_t mode;
+};
+
+struct SceFiosOverlay {
+    uint8_t type;
+    uint8_t order;
+    uint16_t dst_len;
+    uint16_t src_len;
+    uint16_t unk2;
+    SceUID pid;
+    int32_t id;
+    char dst[SCE_FIOS_OVERLAY_PATH_MAX];
+    char src[SCE_FIOS_OVERLAY_PATH_MAX];
+};
+
+struct FiosArchive {
+    IOState &io;
+
+    // Archive file opened on the VFS
+    SceUID fd = invalid_fd;
+
+    // Without trailing slash
+    std::string mount_point;
+    fios::Psarc psarc;
+
+    FiosArchive(IOState &io, const SceUID fd)
+        : io(io)
+        , fd(fd) {
+    }
+
+    ~FiosArchive() {
+        close_file(io, fd, "sceFiosArchiveUnmount");
+    }
+};
+
+typedef std::shared_ptr<FiosArchive> FiosArchivePtr;
+
+struct FiosFile {
+    IOState &io;
+
+    // Set if the file is on the VFS
+    SceUID fd = invalid_fd;
+
+    // Set if the file is inside a mounted archive
+    FiosArchivePtr archive;
+    const fios::PsarcEntry *entry = nullptr;
+
+    // Set on the handle of a mounted archive
+    FiosArchivePtr mounted;
+
+    std::mutex mutex;
+    SceFiosOffset position = 0;
+
+    explicit FiosFile(IOState &io)
+        : io(io) {
+    }
+
+    ~FiosFile() {
+        if (fd != invalid_fd)
+            close_file(io, fd, "sceFiosFHClose");
+    }
+};
+
+struct FiosOp {
+    SceFiosSize request_count = 0;
+    SceFiosOffset offset = 0;
+    bool cancelled = false;
+
+    // From the op attributes, called once the op is done and once it is deleted
+    Ptr<void> callback;
+    Ptr<void> callback_context;
+};
+
+struct FiosState {
+    // Guards everything but the file handles, which have their own locking
+    std::mutex mutex;
+
+    // Longest mount point first, so nested mounts are looked at before their parent
+    std::vector<FiosArchivePtr> mounts;
+
+    FdTable<FiosFile> files;
+    std::map<SceFiosOp, FiosOp> ops;
+
+    fios::OverlayTable overlays;
+    fios::BlockCache cache;
+
+    // The thread reading takes part in decompression, so it is not counted in the pool
+    int decompressor_threads = SCE_FIOS_DEFAULT_DECOMPRESSOR_THREADS;
+    std::shared_ptr<util::ThreadPool> decompressors = std::make_shared<util::ThreadPool>(SCE_FIOS_DEFAULT_DECOMPRESSOR_THREADS - 1);
+
+    // Asynchronous ops on the same file handle run in order, like the requests of sceIo on an fd
+    AsyncIoEngine engine;
+
+    // Guest thread the op callbacks run on, one at a time and in the order the ops are done
+    ThreadStatePtr callback_thread;
+    util::ThreadPool callbacks{ 1 };
+
+    ~FiosState() {
+        std::vector<SceFiosOp> pending;
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            for (const auto &op : ops)
+                pending.push_back(op.first);
+        }
+
+        // Callbacks wait for the engine to report their op done, so no op may be left running once they stop
+        for (const SceFiosOp op : pending) {
+            engine.cancel(op);
+            engine.wait(op);
+        }
+    }
+};
+
+// Where a path really is, once overlays and archives are accounted for
+struct FiosLocation {
+    std::string path;
+    FiosArchivePtr archive;
+    const fios::PsarcEntry *entry = nullptr;
+};
+
+// FIOS paths may also be written as /app0/path instead of app0:/path
+static std::string to_vita_path(const std::string &path) {
+    if (path.empty() || (path.front() != '/'))
+        return path;
+
+    const std::size_t end = path.find('/', 1);
+    const std::string device = path.substr(1, end - 1) + ':';
+    if (device::get_device(device) == VitaIoDevice::_INVALID)
+        return path;
+
+    return (end == std::string::npos) ? device : device + path.substr(end);
+}
+
+static std::pair<FiosArchivePtr, const fios::PsarcEntry *> find_in_archives(FiosState &state, const std::string &path) {
+    const std::lock_guard<std::mutex> guard(state.mutex);
+
+    for (const FiosArchivePtr &archive : state.mounts) {
+        const std::string &mount_point = archive->mount_point;
+        if ((path.compare(0, mount_point.size(), mount_point) != 0) || ((path.size() > mount_point.size()) && (path[mount_point.size()] != '/')))
+            continue;
+
+        const fios::PsarcEntry *entry = archive->psarc.find(path.substr(mount_point.size()));
+        if (entry)
+            return { archive, entry };
+    }
+
+    return {};
+}
+
+static int stat_vfs(HostState &host, const std::string &path, SceIoStat &stat, const char *export_name) {
+    return stat_file(host.io, to_vita_path(path).c_str(), &stat, host.pref_path, export_name);
+}
+
+static FiosLocation locate(HostState &host, FiosState &state, const std::string &path, const bool for_write, const char *export_name) {
+    const auto mtime = [&](const std::string &candidate) -> std::optional<std::uint64_t> {
+        if (find_in_archives(state, candidate).second)
+            return 0;
+
+        SceIoStat stat;
+        if (stat_vfs(host, candidate, stat, export_name) < 0)
+            return std::nullopt;
+
+        return __RtcPspTimeToTicks(&stat.st_mtime);
+    };
+
+    FiosLocation location;
+    location.path = state.overlays.resolve(path, for_write, mtime);
+    std::tie(location.archive, location.entry) = find_in_archives(state, location.path);
+
+    return location;
+}
+
+static std::shared_ptr<util::ThreadPool> get_decompressors(FiosState &state) {
+    const std::lock_guard<std::mutex> guard(state.mutex);
+    return state.decompressors;
+}
+
+static SceFiosDate to_fios_date(const SceDateTime &date) {
+    const std::uint64_t ticks = __RtcPspTimeToTicks(&date);
+    return (ticks > RTC_OFFSET) ? (ticks - RTC_OFFSET) / VITA_CLOCKS_PER_SEC : 0;
+}
+
+static int stat_location(HostState &host, const FiosLocation &location, SceFiosStat *out, const char *export_name) {
+    SceFiosStat result{};
+
+    if (location.entry) {
+        result.fileSize = location.entry->size;
+        result.statFlags = SCE_FIOS_STATUS_READABLE;
+    } else {
+        SceIoStat stat;
+        const int error = stat_vfs(host, location.path, stat, export_name);
+        if (error < 0)
+            return error;
+
+        result.fileSize = stat.st_size;
+        result.accessDate = to_fios_date(stat.st_atime);
+        result.modificationDate = to_fios_date(stat.st_mtime);
+        result.creationDate = to_fios_date(stat.st_ctime);
+        result.mode = stat.st_mode;
+        result.statFlags = SCE_FIOS_STATUS_READABLE;
+        if (stat.st_mode & SCE_S_IFDIR)
+            result.statFlags |= SCE_FIOS_STATUS_DIRECTORY;
+        if (stat.st_mode & SCE_S_IWUSR)
+            result.statFlags |= SCE_FIOS_STATUS_WRITABLE;
+    }
+
+    if (out)
+        *out = result;
+
+    return 0;
+}
+
+static SceFiosSize read_file_at(HostState &host, FiosState &state, const FiosFile &file, void *data, const SceFiosSize size, const SceFiosOffset offset, const char *export_name) {
+    if (!data)
+        return static_cast<int>(SCE_FIOS_ERROR_BAD_PTR);
+    if (size < 0)
+        return static_cast<int>(SCE_FIOS_ERROR_BAD_SIZE);
+    if (offset < 0)
+        return static_cast<int>(SCE_FIOS_ERROR_BAD_OFFSET);
+
+    if (file.entry) {
+        const std::int64_t read = file.archive->psarc.read(*file.entry, data, size, offset, state.cache, get_decompressors(state).get());
+        if (read < 0) {
+            LOG_ERROR("Failed to decompress {} at offset {}", file.entry->path, offset);
+            return static_cast<int>(SCE_FIOS_ERROR_BAD_ARCHIVE);
+        }
+
+        return read;
+    }
+
+    if (file.fd == invalid_fd)
+        return static_cast<int>(SCE_FIOS_ERROR_NOT_A_FILE);
+
+    return pread_file(data, host.io, file.fd, static_cast<SceSize>(std::min<SceFiosSize>(size, UINT32_MAX)), offset, export_name);
+}
+
+static SceFiosSize get_file_size(HostState &host, const FiosFile &file, const char *export_name) {
+    if (file.entry)
+        return file.entry->size;
+
+    SceIoStat stat;
+    const int error = stat_file_by_fd(host.io, file.fd, &stat, host.pref_path, export_name);
+    if (error < 0)
+        return error;
+
+    return stat.st_size;
+}
+
+static int stat_fh(HostState &host, const FiosFile &file, SceFiosStat *out, const char *export_name) {
+    if (!out)
+        return SCE_FIOS_ERROR_BAD_PTR;
+
+    SceFiosStat stat{};
+    stat.fileSize = get_file_size(host, file, export_name);
+    if (stat.fileSize < 0)
+        return static_cast<int>(stat.fileSize);
+
+    // Archives are read only
+    stat.statFlags = SCE_FIOS_STATUS_READABLE;
+    if (!file.entry)
+        stat.statFlags |= SCE_FIOS_STATUS_WRITABLE;
+
+    *out = stat;
+    return 0;
+}
+
+static int open_fh(HostState &host, FiosState &state, SceFiosFH *out_fh, const char *path, const SceFiosOpenParams *params, const char *export_name) {
+    if (!out_fh || !path)
+        return SCE_FIOS_ERROR_BAD_PTR;
+
+    const uint32_t flags = params ? params->openFlags : SCE_FIOS_O_READ;
+    const bool for_write = flags & (SCE_FIOS_O_WRITE | SCE_FIOS_O_APPEND | SCE_FIOS_O_CREAT | SCE_FIOS_O_TRUNC);
+    const FiosLocation location = locate(host, state, path, for_write, export_name);
+
+    SceUID fd = invalid_fd;
+    if (location.entry) {
+        // Archives are read only
+        if (for_write)
+            return SCE_FIOS_ERROR_ACCESS;
+    } else {
+        int io_flags = 0;
+        if (flags & SCE_FIOS_O_READ)
+            io_flags |= SCE_O_RDONLY;
+        if (flags & SCE_FIOS_O_WRITE)
+            io_flags |= SCE_O_WRONLY;
+        if (flags & SCE_FIOS_O_APPEND)
+            io_flags |= SCE_O_APPEND;
+        if (flags & SCE_FIOS_O_CREAT)
+            io_flags |= SCE_O_CREAT;
+        if (flags & SCE_FIOS_O_TRUNC)
+            io_flags |= SCE_O_TRUNC;
+
+        fd = open_file(host.io, to_vita_path(location.path).c_str(), io_flags, host.pref_path, export_name);
+        if (fd < 0)
+            return SCE_FIOS_ERROR_BAD_PATH;
+    }
+
+    const SceFiosFH fh = host.kernel.get_next_uid();
+    const auto file = state.files.emplace(fh, host.io);
+    file->fd = fd;
+    file->archive = location.archive;
+    file->entry = location.entry;
+
+    *out_fh = fh;
+    return 0;
+}
+
+// The index is kept on the host, but the guest still expects the size of the buffer the real library needs
+static int get_mount_buffer_size(HostState &host, FiosState &state, const char *archive_path, const char *export_name) {
+    if (!archive_path)
+        return SCE_FIOS_ERROR_BAD_PTR;
+
+    const FiosLocation location = locate(host, state, archive_path, false, export_name);
+    const SceUID fd = open_file(host.io, to_vita_path(location.path).c_str(), SCE_O_RDONLY, host.pref_path, export_name);
+    if (fd < 0)
+        return SCE_FIOS_ERROR_BAD_PATH;
+
+    fios::Psarc psarc;
+    const bool opened = psarc.open([&](void *data, std::uint64_t size, std::uint64_t offset) -> std::int64_t {
+        return pread_file(data, host.io, fd, static_cast<SceSize>(size), static_cast<SceOff>(offset), export_name);
+    });
+    close_file(host.io, fd, export_name);
+
+    if (!opened)
+        return SCE_FIOS_ERROR_BAD_ARCHIVE;
+
+    return static_cast<int>(psarc.index_size());
+}
+
+static int mount_archive(HostState &host, FiosState &state, SceFiosFH *out_fh, const char *archive_path, const char *mount_point, const char *export_name) {
+    if (!out_fh || !archive_path || !mount_point)
+        return SCE_FIOS_ERROR_BAD_PTR;
+
+    const FiosLocation location = locate(host, state, archive_path, false, export_name);
+    const SceUID fd = open_file(host.io, to_vita_path(location.path).c_str(), SCE_O_RDONLY, host.pref_path, export_name);
+    if (fd < 0)
+        return SCE_FIOS_ERROR_BAD_PATH;
+
+    const auto archive = std::make_shared<FiosArchive>(host.io, fd);
+    archive->mount_point = mount_point;
+    while ((archive->mount_point.size() > 1) && (archive->mount_point.back() == '/'))
+        archive->mount_point.pop_back();
+
+    IOState &io = host.io;
+    const bool opened = archive->psarc.open([&io, fd](void *data, std::uint64_t size, std::uint64_t offset) -> std::int64_t {
+        return pread_file(data, io, fd, static_cast<SceSize>(size), static_cast<SceOff>(offset), "sceFiosArchiveMount");
+    });
+
+    if (!opened) {
+        LOG_ERROR("{} is not a supported archive", archive_path);
+        return SCE_FIOS_ERROR_BAD_ARCHIVE;
+    }
+
+    const SceFiosFH fh = host.kernel.get_next_uid();
+    state.files.emplace(fh, host.io)->mounted = archive;
+
+    {
+        const std::lock_guard<std::mutex> guard(state.mutex);
+
+        const auto position = std::find_if(state.mounts.begin(), state.mounts.end(), [&](const FiosArchivePtr &mounted) {
+            return mounted->mount_point.size() < archive->mount_point.size();
+        });
+        state.mounts.insert(position, archive);
+    }
+
+    LOG_INFO("Mounted {} at {} ({} files)", archive_path, archive->mount_point, archive->psarc.entries().size());
+
+    *out_fh = fh;
+    return 0;
+}
+
+static int unmount_archive(FiosState &state, const SceFiosFH fh) {
+    const auto file = state.files.find(fh);
+    if (!file || !file->mounted)
+        return SCE_FIOS_ERROR_BAD_FH;
+
+    {
+        const std::lock_guard<std::mutex> guard(state.mutex);
+        state.mounts.erase(std::remove(state.mounts.begin(), state.mounts.end(), file->mounted), state.mounts.end());
+    }
+
+    state.cache.flush(file->mounted->psarc.id());
+    state.files.erase(fh);
+
+    return 0;
+}
+
+static int prefetch_file(FiosState &state, const FiosFile &file, const SceFiosOffset offset, const SceFiosSize size) {
+    // Only archives are worth it, the VFS already goes through the cache of the host
+    if (!file.entry)
+        return 0;
+
+    if (!file.archive->psarc.prefetch(*file.entry, size, offset, state.cache, get_decompressors(state).get()))
+        return SCE_FIOS_ERROR_BAD_ARCHIVE;
+
+    return 0;
+}
+
+static int prefetch_path(HostState &host, FiosState &state, const char *path, const SceFiosOffset offset, const SceFiosSize size, const char *export_name) {
+    if (!path)
+        return SCE_FIOS_ERROR_BAD_PTR;
+
+    const FiosLocation location = locate(host, state, path, false, export_name);
+    if (!location.entry)
+        return 0;
+
+    FiosFile file(host.io);
+    file.archive = location.archive;
+    file.entry = location.entry;
+
+    return prefetch_file(state, file, offset, size);
+}
+
+// Read a whole range of a file by path, the way sceFiosFileRead does
+static SceFiosSize read_path(HostState &host, FiosState &state, const char *path, void *data, const SceFiosSize size, const SceFiosOffset offset, const char *export_name) {
+    SceFiosFH fh = 0;
+    const int error = open_fh(host, state, &fh, path, nullptr, export_name);
+    if (error < 0)
+        return error;
+
+    const SceFiosSize read = read_file_at(host, state, *state.files.find(fh), data, size, offset, export_name);
+    state.files.erase(fh);
+
+    return read;
+}
+
+static bool is_cached(HostState &host, FiosState &state, const char *path, const SceFiosOffset offset, const SceFiosSize size, const char *export_name) {
+    if (!path)
+        return false;
+
+    const FiosLocation location = locate(host, state, path, false, export_name);
+    if (!location.entry)
+        return false;
+
+    return location.archive->psarc.is_cached(*location.entry, size, offset, state.cache);
+}
+
+// Results of ops are either an error or the number of bytes done
+static int op_error(const SceOff result) {
+    if (result == SCE_ERROR_ERRNO_ECANCELED)
+        return SCE_FIOS_ERROR_CANCELLED;
+
+    return (result < 0) ? static_cast<int>(result) : 0;
+}
+
+static void call_op_callback(FiosState &state, const SceFiosOp op, const FiosOp &info, const SceFiosOpEvent event, const int error) {
+    if (!info.callback || !state.callback_thread)
+        return;
+
+    state.callbacks.submit([&state, op, info, event, error]() {
+        // The engine reports the op done right after the worker is through with it. The guest expects
+        // to find it done from the callback, and may even delete it from there.
+        state.engine.wait(op);
+        state.callback_thread->run_guest_function(info.callback.address(), { info.callback_context.address(), static_cast<uint32_t>(op), event, static_cast<uint32_t>(error) });
+    });
+}
+
+static SceFiosOp submit_op(HostState &host, FiosState &state, const SceFiosOpAttr *attr, const SceFiosFH fh, const SceFiosSize request_count, const SceFiosOffset offset, AsyncIoEngine::Work work) {
+    const SceFiosOp op = host.kernel.get_next_uid();
+
+    FiosOp info{ request_count, offset };
+    if (attr) {
+        info.callback = attr->pCallback;
+        info.callback_context = attr->pCallbackContext;
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(state.mutex);
+        state.ops[op] = info;
+    }
+
+    AsyncIoEngine::Callback done;
+    if (info.callback) {
+        done = [&state, info](SceUID op, SceOff result) {
+            call_op_callback(state, op, info, SCE_FIOS_OPEVENT_COMPLETE, op_error(result));
+        };
+    }
+
+    state.engine.submit(op, fh, std::move(work), std::move(done));
+    return op;
+}
+
+static bool has_op(FiosState &state, const SceFiosOp op) {
+    const std::lock_guard<std::mutex> guard(state.mutex);
+    return state.ops.contains(op);
+}
+
+static void delete_op(FiosState &state, const SceFiosOp op) {
+    // The op may still be using guest buffers, so it is only forgotten once done
+    state.engine.cancel(op);
+    state.engine.wait(op);
+    state.engine.release(op);
+
+    FiosOp info;
+    {
+        const std::lock_guard<std::mutex> guard(state.mutex);
+        const auto entry = state.ops.find(op);
+        if (entry == state.ops.end())
+            return;
+
+        info = entry->second;
+        state.ops.erase(entry);
+    }
+
+    call_op_callback(state, op, info, SCE_FIOS_OPEVENT_DELETE, 0);
+}
+
+static void fill_overlay(const fios::Overlay &overlay, SceFiosOverlay *out) {
+    std::memset(out, 0, sizeof(SceFiosOverlay));
+    out->type = static_cast<uint8_t>(overlay.type);
+    out->order = overlay.order;
+    out->id = overlay.id;
+    out->dst_len = static_cast<uint16_t>(std::min(overlay.dst.size(), SCE_FIOS_OVERLAY_PATH_MAX - 1));
+    out->src_len = static_cast<uint16_t>(std::min(overlay.src.size(), SCE_FIOS_OVERLAY_PATH_MAX - 1));
+    std::memcpy(out->dst, overlay.dst.data(), out->dst_len);
+    std::memcpy(out->src, overlay.src.data(), out->src_len);
+}
+
+static bool read_overlay(const SceFiosOverlay *in, fios::Overlay &overlay) {
+    if (in->type > static_cast<uint8_t>(fios::OverlayType::WRITABLE))
+        return false;
+
+    overlay.type = static_cast<fios::OverlayType>(in->type);
+    overlay.order = in->order;
+    overlay.dst = std::string(in->dst, strnlen(in->dst, SCE_FIOS_OVERLAY_PATH_MAX));
+    overlay.src = std::string(in->src, strnlen(in->src, SCE_FIOS_OVERLAY_PATH_MAX));
+
+    return !overlay.dst.empty() && !overlay.src.empty();
+}
+
 EXPORT(int, sceFiosArchiveGetDecompressorThreadCount) {
-    return UNIMPLEMENTED();
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    return state->decompressor_threads;
 }
 
-EXPORT(int, sceFiosArchiveGetMountBufferSize) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosArchiveGetMountBufferSize, const SceFiosOpAttr *attr, const char *archive_path, Ptr<void> params) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string archive(archive_path ? archive_path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, archive, export_name]() -> SceOff {
+        return get_mount_buffer_size(host, *state, archive.c_str(), export_name);
+    });
 }
 
-EXPORT(int, sceFiosArchiveGetMountBufferSizeSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosArchiveGetMountBufferSizeSync, const SceFiosOpAttr *attr, const char *archive_path, Ptr<void> params) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    const int size = get_mount_buffer_size(host, *state, archive_path, export_name);
+    if (size < 0)
+        return RET_ERROR(size);
+
+    return size;
 }
 
-EXPORT(int, sceFiosArchiveMount) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosArchiveMount, const SceFiosOpAttr *attr, SceFiosFH *out_fh, const char *archive_path, const char *mount_point, Ptr<void> mount_buffer, uint32_t mount_buffer_length, Ptr<void> params) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string archive(archive_path ? archive_path : "");
+    const std::string mount(mount_point ? mount_point : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, out_fh, archive, mount, export_name]() -> SceOff {
+        return mount_archive(host, *state, out_fh, archive.c_str(), mount.c_str(), export_name);
+    });
 }
 
-EXPORT(int, sceFiosArchiveMountSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosArchiveMountSync, const SceFiosOpAttr *attr, SceFiosFH *out_fh, const char *archive_path, const char *mount_point, Ptr<void> mount_buffer, uint32_t mount_buffer_length, Ptr<void> params) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    const int error = mount_archive(host, *state, out_fh, archive_path, mount_point, export_name);
+    if (error < 0)
+        return RET_ERROR(error);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosArchiveSetDecompressorThreadCount) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosArchiveSetDecompressorThreadCount, const int thread_count) {
+    if (thread_count < 1)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_SIZE);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    // Reads still going on keep the old pool alive until they are done
+    if (thread_count != state->decompressor_threads) {
+        state->decompressor_threads = thread_count;
+        state->decompressors = std::make_shared<util::ThreadPool>(thread_count - 1);
+    }
+
+    return thread_count;
 }
 
-EXPORT(int, sceFiosArchiveUnmount) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosArchiveUnmount, const SceFiosOpAttr *attr, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    return submit_op(host, *state, attr, fh, 0, 0, [state, fh]() -> SceOff {
+        return unmount_archive(*state, fh);
+    });
 }
 
-EXPORT(int, sceFiosArchiveUnmountSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosArchiveUnmountSync, const SceFiosOpAttr *attr, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    const int error = unmount_archive(*state, fh);
+    if (error < 0)
+        return RET_ERROR(error);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosCacheContainsFileRangeSync) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosCacheContainsFileRangeSync, const SceFiosOpAttr *attr, const char *path, const SceFiosOffset offset, const SceFiosSize size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    return is_cached(host, *state, path, offset, size, export_name);
 }
 
-EXPORT(int, sceFiosCacheContainsFileSync) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosCacheContainsFileSync, const SceFiosOpAttr *attr, const char *path) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    return is_cached(host, *state, path, 0, INT64_MAX, export_name);
 }
 
 EXPORT(int, sceFiosCacheFlushFileRangeSync) {
@@ -66,35 +759,79 @@ EXPORT(int, sceFiosCacheFlushFileSync) {
 }
 
 EXPORT(int, sceFiosCacheFlushSync) {
-    return UNIMPLEMENTED();
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    state->cache.flush();
+
+    return 0;
 }
 
-EXPORT(int, sceFiosCachePrefetchFH) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosCachePrefetchFH, const SceFiosOpAttr *attr, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return submit_op(host, *state, attr, fh, 0, 0, [state, file]() -> SceOff {
+        return prefetch_file(*state, *file, 0, INT64_MAX);
+    });
 }
 
-EXPORT(int, sceFiosCachePrefetchFHRange) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosCachePrefetchFHRange, const SceFiosOpAttr *attr, const SceFiosFH fh, const SceFiosOffset offset, const SceFiosSize size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return submit_op(host, *state, attr, fh, size, offset, [state, file, offset, size]() -> SceOff {
+        return prefetch_file(*state, *file, offset, size);
+    });
 }
 
-EXPORT(int, sceFiosCachePrefetchFHRangeSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosCachePrefetchFHRangeSync, const SceFiosOpAttr *attr, const SceFiosFH fh, const SceFiosOffset offset, const SceFiosSize size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return prefetch_file(*state, *file, offset, size);
 }
 
-EXPORT(int, sceFiosCachePrefetchFHSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosCachePrefetchFHSync, const SceFiosOpAttr *attr, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return prefetch_file(*state, *file, 0, INT64_MAX);
 }
 
-EXPORT(int, sceFiosCachePrefetchFile) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosCachePrefetchFile, const SceFiosOpAttr *attr, const char *path) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, file_path, export_name]() -> SceOff {
+        return prefetch_path(host, *state, file_path.c_str(), 0, INT64_MAX, export_name);
+    });
 }
 
-EXPORT(int, sceFiosCachePrefetchFileRange) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosCachePrefetchFileRange, const SceFiosOpAttr *attr, const char *path, const SceFiosOffset offset, const SceFiosSize size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, size, offset, [&host, state, file_path, offset, size, export_name]() -> SceOff {
+        return prefetch_path(host, *state, file_path.c_str(), offset, size, export_name);
+    });
 }
 
 EXPORT(int, sceFiosCancelAllOps) {
-    return UNIMPLEMENTED();
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    for (auto &[op, info] : state->ops) {
+        info.cancelled = state->engine.cancel(op) || info.cancelled;
+    }
+
+    return 0;
 }
 
 EXPORT(int, sceFiosChangeStat) {
@@ -106,7 +843,12 @@ EXPORT(int, sceFiosChangeStatSync) {
 }
 
 EXPORT(int, sceFiosCloseAllFiles) {
-    return UNIMPLEMENTED();
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    // Mounted archives stay, they are only reached by path
+    state->files.clear();
+
+    return 0;
 }
 
 EXPORT(int, sceFiosDHClose) {
@@ -229,20 +971,43 @@ EXPORT(int, sceFiosDirectoryExistsSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosExists) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosExists, const SceFiosOpAttr *attr, const char *path, bool *out_exists) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, file_path, out_exists, export_name]() -> SceOff {
+        if (!out_exists)
+            return static_cast<int>(SCE_FIOS_ERROR_BAD_PTR);
+
+        *out_exists = stat_location(host, locate(host, *state, file_path, false, export_name), nullptr, export_name) == 0;
+        return 0;
+    });
 }
 
-EXPORT(int, sceFiosExistsSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosExistsSync, const SceFiosOpAttr *attr, const char *path, bool *out_exists) {
+    if (!path || !out_exists)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    *out_exists = stat_location(host, locate(host, *state, path, false, export_name), nullptr, export_name) == 0;
+
+    return 0;
 }
 
-EXPORT(int, sceFiosFHClose) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFHClose, const SceFiosOpAttr *attr, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    return submit_op(host, *state, attr, fh, 0, 0, [state, fh]() -> SceOff {
+        return state->files.erase(fh) ? 0 : static_cast<int>(SCE_FIOS_ERROR_BAD_FH);
+    });
 }
 
-EXPORT(int, sceFiosFHCloseSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosFHCloseSync, const SceFiosOpAttr *attr, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!state->files.erase(fh))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return 0;
 }
 
 EXPORT(int, sceFiosFHGetOpenParams) {
@@ -253,8 +1018,13 @@ EXPORT(int, sceFiosFHGetPath) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFHGetSize) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosFHGetSize, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return get_file_size(host, *file, export_name);
 }
 
 EXPORT(int, sceFiosFHIoctl) {
@@ -265,12 +1035,24 @@ EXPORT(int, sceFiosFHIoctlSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFHOpen) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFHOpen, const SceFiosOpAttr *attr, SceFiosFH *out_fh, const char *path, const SceFiosOpenParams *params) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+    const std::optional<SceFiosOpenParams> open_params = params ? std::optional(*params) : std::nullopt;
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, out_fh, file_path, open_params, export_name]() -> SceOff {
+        return open_fh(host, *state, out_fh, file_path.c_str(), open_params ? &*open_params : nullptr, export_name);
+    });
 }
 
-EXPORT(int, sceFiosFHOpenSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosFHOpenSync, const SceFiosOpAttr *attr, SceFiosFH *out_fh, const char *path, const SceFiosOpenParams *params) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    const int error = open_fh(host, *state, out_fh, path, params, export_name);
+    if (error < 0)
+        return RET_ERROR(error);
+
+    return 0;
 }
 
 EXPORT(int, sceFiosFHOpenWithMode) {
@@ -281,12 +1063,24 @@ EXPORT(int, sceFiosFHOpenWithModeSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFHPread) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFHPread, const SceFiosOpAttr *attr, const SceFiosFH fh, void *data, const SceFiosSize size, const SceFiosOffset offset) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return submit_op(host, *state, attr, fh, size, offset, [&host, state, file, data, size, offset, export_name]() -> SceOff {
+        return read_file_at(host, *state, *file, data, size, offset, export_name);
+    });
 }
 
-EXPORT(int, sceFiosFHPreadSync) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosFHPreadSync, const SceFiosOpAttr *attr, const SceFiosFH fh, void *data, const SceFiosSize size, const SceFiosOffset offset) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return read_file_at(host, *state, *file, data, size, offset, export_name);
 }
 
 EXPORT(int, sceFiosFHPreadv) {
@@ -313,12 +1107,37 @@ EXPORT(int, sceFiosFHPwritevSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFHRead) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFHRead, const SceFiosOpAttr *attr, const SceFiosFH fh, void *data, const SceFiosSize size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    // Ops of the same handle run in order, so the position is taken when the read starts
+    return submit_op(host, *state, attr, fh, size, 0, [&host, state, file, data, size, export_name]() -> SceOff {
+        const std::lock_guard<std::mutex> guard(file->mutex);
+
+        const SceFiosSize read = read_file_at(host, *state, *file, data, size, file->position, export_name);
+        if (read > 0)
+            file->position += read;
+
+        return read;
+    });
 }
 
-EXPORT(int, sceFiosFHReadSync) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosFHReadSync, const SceFiosOpAttr *attr, const SceFiosFH fh, void *data, const SceFiosSize size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    const std::lock_guard<std::mutex> guard(file->mutex);
+
+    const SceFiosSize read = read_file_at(host, *state, *file, data, size, file->position, export_name);
+    if (read > 0)
+        file->position += read;
+
+    return read;
 }
 
 EXPORT(int, sceFiosFHReadv) {
@@ -329,16 +1148,59 @@ EXPORT(int, sceFiosFHReadvSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFHSeek) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOffset, sceFiosFHSeek, const SceFiosFH fh, const SceFiosOffset offset, const SceFiosWhence whence) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    const std::lock_guard<std::mutex> guard(file->mutex);
+
+    SceFiosOffset base = 0;
+    switch (whence) {
+    case SCE_FIOS_SEEK_SET:
+        break;
+    case SCE_FIOS_SEEK_CUR:
+        base = file->position;
+        break;
+    case SCE_FIOS_SEEK_END:
+        base = get_file_size(host, *file, export_name);
+        if (base < 0)
+            return base;
+        break;
+    default:
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OFFSET);
+    }
+
+    if (base + offset < 0)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OFFSET);
+
+    file->position = base + offset;
+    return file->position;
 }
 
-EXPORT(int, sceFiosFHStat) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFHStat, const SceFiosOpAttr *attr, const SceFiosFH fh, SceFiosStat *out_stat) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    return submit_op(host, *state, attr, fh, 0, 0, [&host, file, out_stat, export_name]() -> SceOff {
+        return stat_fh(host, *file, out_stat, export_name);
+    });
 }
 
-EXPORT(int, sceFiosFHStatSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosFHStatSync, const SceFiosOpAttr *attr, const SceFiosFH fh, SceFiosStat *out_stat) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    const int error = stat_fh(host, *file, out_stat, export_name);
+    if (error < 0)
+        return RET_ERROR(error);
+
+    return 0;
 }
 
 EXPORT(int, sceFiosFHSync) {
@@ -349,8 +1211,14 @@ EXPORT(int, sceFiosFHSyncSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFHTell) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOffset, sceFiosFHTell, const SceFiosFH fh) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const auto file = state->files.find(fh);
+    if (!file)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_FH);
+
+    const std::lock_guard<std::mutex> guard(file->mutex);
+    return file->position;
 }
 
 EXPORT(int, sceFiosFHToFileno) {
@@ -389,28 +1257,77 @@ EXPORT(int, sceFiosFileDeleteSync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosFileExists) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFileExists, const SceFiosOpAttr *attr, const char *path, bool *out_exists) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, file_path, out_exists, export_name]() -> SceOff {
+        if (!out_exists)
+            return static_cast<int>(SCE_FIOS_ERROR_BAD_PTR);
+
+        SceFiosStat stat;
+        *out_exists = (stat_location(host, locate(host, *state, file_path, false, export_name), &stat, export_name) == 0) && !(stat.statFlags & SCE_FIOS_STATUS_DIRECTORY);
+        return 0;
+    });
 }
 
-EXPORT(int, sceFiosFileExistsSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosFileExistsSync, const SceFiosOpAttr *attr, const char *path, bool *out_exists) {
+    if (!path || !out_exists)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    SceFiosStat stat;
+    *out_exists = (stat_location(host, locate(host, *state, path, false, export_name), &stat, export_name) == 0) && !(stat.statFlags & SCE_FIOS_STATUS_DIRECTORY);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosFileGetSize) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFileGetSize, const SceFiosOpAttr *attr, const char *path, SceFiosSize *out_size) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, file_path, out_size, export_name]() -> SceOff {
+        if (!out_size)
+            return static_cast<int>(SCE_FIOS_ERROR_BAD_PTR);
+
+        SceFiosStat stat;
+        const int error = stat_location(host, locate(host, *state, file_path, false, export_name), &stat, export_name);
+        if (error < 0)
+            return error;
+
+        *out_size = stat.fileSize;
+        return 0;
+    });
 }
 
-EXPORT(int, sceFiosFileGetSizeSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosFileGetSizeSync, const SceFiosOpAttr *attr, const char *path, SceFiosSize *out_size) {
+    if (!path || !out_size)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    SceFiosStat stat;
+    const int error = stat_location(host, locate(host, *state, path, false, export_name), &stat, export_name);
+    if (error < 0)
+        return RET_ERROR(error);
+
+    *out_size = stat.fileSize;
+    return 0;
 }
 
-EXPORT(int, sceFiosFileRead) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosFileRead, const SceFiosOpAttr *attr, const char *path, void *data, const SceFiosSize size, const SceFiosOffset offset) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, size, offset, [&host, state, file_path, data, size, offset, export_name]() -> SceOff {
+        return read_path(host, *state, file_path.c_str(), data, size, offset, export_name);
+    });
 }
 
-EXPORT(int, sceFiosFileReadSync) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosFileReadSync, const SceFiosOpAttr *attr, const char *path, void *data, const SceFiosSize size, const SceFiosOffset offset) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    return read_path(host, *state, path, data, size, offset, export_name);
 }
 
 EXPORT(int, sceFiosFileTruncate) {
@@ -458,7 +1375,8 @@ EXPORT(int, sceFiosGetSuspendCount) {
 }
 
 EXPORT(int, sceFiosIOFilterAdd) {
-    return UNIMPLEMENTED();
+    STUBBED("archives are always handled by our own dearchiver");
+    return 0;
 }
 
 EXPORT(int, sceFiosIOFilterCache) {
@@ -470,43 +1388,79 @@ EXPORT(int, sceFiosIOFilterGetInfo) {
 }
 
 EXPORT(int, sceFiosIOFilterPsarcDearchiver) {
-    return UNIMPLEMENTED();
+    return 0;
 }
 
 EXPORT(int, sceFiosIOFilterRemove) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosInitialize) {
-    return UNIMPLEMENTED();
+// The parameters only size the buffers and threads of the real library, we have no use for them
+EXPORT(int, sceFiosInitialize, Ptr<void> params) {
+    if (!host.kernel.obj_store.find<FiosState>()) {
+        host.kernel.obj_store.create<FiosState>();
+        host.kernel.obj_store.get<FiosState>()->callback_thread = host.kernel.create_thread(host.mem, "SceFiosCallback");
+    }
+
+    return 0;
 }
 
-EXPORT(int, sceFiosIsIdle) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosIsIdle) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    return std::all_of(state->ops.begin(), state->ops.end(), [&](const auto &op) {
+        return state->engine.status(op.first) == AsyncIoStatus::DONE;
+    });
 }
 
-EXPORT(int, sceFiosIsInitialized) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosIsInitialized, Ptr<void> out_params) {
+    return host.kernel.obj_store.find<FiosState>() != nullptr;
 }
 
 EXPORT(int, sceFiosIsSuspended) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosIsValidHandle) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosIsValidHandle, const SceFiosHandle handle) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    return state->files.find(handle) || has_op(*state, handle);
 }
 
-EXPORT(int, sceFiosOpCancel) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOpCancel, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    const auto info = state->ops.find(op);
+    if (info == state->ops.end())
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    // Too late if it already started
+    if (state->engine.cancel(op))
+        info->second.cancelled = true;
+
+    return 0;
 }
 
-EXPORT(int, sceFiosOpDelete) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOpDelete, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!has_op(*state, op))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    delete_op(*state, op);
+    return 0;
 }
 
-EXPORT(int, sceFiosOpGetActualCount) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosOpGetActualCount, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!has_op(*state, op))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    SceOff result = 0;
+    if (state->engine.status(op, &result) != AsyncIoStatus::DONE)
+        return 0;
+
+    return std::max<SceOff>(result, 0);
 }
 
 EXPORT(int, sceFiosOpGetAttr) {
@@ -517,28 +1471,56 @@ EXPORT(int, sceFiosOpGetBuffer) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosOpGetError) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOpGetError, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!has_op(*state, op))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    // Nothing went wrong yet while it is still going on
+    SceOff result = 0;
+    if (state->engine.status(op, &result) != AsyncIoStatus::DONE)
+        return 0;
+
+    return op_error(result);
 }
 
-EXPORT(int, sceFiosOpGetOffset) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOffset, sceFiosOpGetOffset, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    const auto info = state->ops.find(op);
+    if (info == state->ops.end())
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    return info->second.offset;
 }
 
 EXPORT(int, sceFiosOpGetPath) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosOpGetRequestCount) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosOpGetRequestCount, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    const auto info = state->ops.find(op);
+    if (info == state->ops.end())
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    return info->second.request_count;
 }
 
-EXPORT(int, sceFiosOpIsCancelled) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosOpIsCancelled, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::lock_guard<std::mutex> guard(state->mutex);
+
+    const auto info = state->ops.find(op);
+    return (info != state->ops.end()) && info->second.cancelled;
 }
 
-EXPORT(int, sceFiosOpIsDone) {
-    return UNIMPLEMENTED();
+EXPORT(bool, sceFiosOpIsDone, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    return state->engine.status(op) == AsyncIoStatus::DONE;
 }
 
 EXPORT(int, sceFiosOpReschedule) {
@@ -549,44 +1531,117 @@ EXPORT(int, sceFiosOpRescheduleWithPriority) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosOpSyncWait) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOpSyncWait, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!has_op(*state, op))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    const SceOff result = state->engine.wait(op);
+    delete_op(*state, op);
+
+    return op_error(result);
 }
 
-EXPORT(int, sceFiosOpSyncWaitForIO) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosSize, sceFiosOpSyncWaitForIO, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!has_op(*state, op))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    const SceOff result = state->engine.wait(op);
+    delete_op(*state, op);
+
+    return (result < 0) ? op_error(result) : result;
 }
 
-EXPORT(int, sceFiosOpWait) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOpWait, const SceFiosOp op) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!has_op(*state, op))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OP);
+
+    return op_error(state->engine.wait(op));
 }
 
 EXPORT(int, sceFiosOpWaitUntil) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosOverlayAdd) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayAdd, const SceFiosOverlay *overlay, int32_t *out_id) {
+    if (!overlay || !out_id)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    fios::Overlay new_overlay;
+    if (!read_overlay(overlay, new_overlay))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    *out_id = state->overlays.add(new_overlay);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosOverlayGetInfo) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayGetInfo, const int32_t id, SceFiosOverlay *out_overlay) {
+    if (!out_overlay)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::optional<fios::Overlay> overlay = state->overlays.get(id);
+    if (!overlay)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    fill_overlay(*overlay, out_overlay);
+    return 0;
 }
 
-EXPORT(int, sceFiosOverlayGetList) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayGetList, int32_t *out_ids, const uint32_t max_ids, uint32_t *out_count) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::vector<std::int32_t> ids = state->overlays.list();
+
+    if (out_ids) {
+        std::copy_n(ids.begin(), std::min<std::size_t>(ids.size(), max_ids), out_ids);
+    }
+
+    if (out_count)
+        *out_count = static_cast<uint32_t>(ids.size());
+
+    return 0;
 }
 
-EXPORT(int, sceFiosOverlayModify) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayModify, const int32_t id, const SceFiosOverlay *overlay) {
+    if (!overlay)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    fios::Overlay new_overlay;
+    if (!read_overlay(overlay, new_overlay))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!state->overlays.modify(id, new_overlay))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosOverlayRemove) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayRemove, const int32_t id) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    if (!state->overlays.remove(id))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosOverlayResolveSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayResolveSync, const int resolve_flag, const char *path, char *out_path, const uint32_t max_path) {
+    if (!path || !out_path)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    // Anything but zero resolves for writing
+    const FiosLocation location = locate(host, *state, path, resolve_flag != 0, export_name);
+    if (location.path.size() >= max_path)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_SIZE);
+
+    std::memcpy(out_path, location.path.c_str(), location.path.size() + 1);
+    return 0;
 }
 
 EXPORT(int, sceFiosPathNormalize) {
@@ -633,12 +1688,29 @@ EXPORT(int, sceFiosShutdownAndCancelOps) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceFiosStat) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosOp, sceFiosStat, const SceFiosOpAttr *attr, const char *path, SceFiosStat *out_stat) {
+    const auto state = host.kernel.obj_store.get<FiosState>();
+    const std::string file_path(path ? path : "");
+
+    return submit_op(host, *state, attr, invalid_fd, 0, 0, [&host, state, file_path, out_stat, export_name]() -> SceOff {
+        if (!out_stat)
+            return static_cast<int>(SCE_FIOS_ERROR_BAD_PTR);
+
+        return stat_location(host, locate(host, *state, file_path, false, export_name), out_stat, export_name);
+    });
 }
 
-EXPORT(int, sceFiosStatSync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosStatSync, const SceFiosOpAttr *attr, const char *path, SceFiosStat *out_stat) {
+    if (!path || !out_stat)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    const auto state = host.kernel.obj_store.get<FiosState>();
+
+    const int error = stat_location(host, locate(host, *state, path, false, export_name), out_stat, export_name);
+    if (error < 0)
+        return RET_ERROR(error);
+
+    return 0;
 }
 
 EXPORT(int, sceFiosStatisticsGet) {
@@ -666,19 +1738,28 @@ EXPORT(int, sceFiosSyncSync) {
 }
 
 EXPORT(int, sceFiosTerminate) {
-    return UNIMPLEMENTED();
+    const auto state = host.kernel.obj_store.find<FiosState>();
+    const ThreadStatePtr callback_thread = state ? state->callback_thread : nullptr;
+
+    host.kernel.obj_store.erase<FiosState>();
+
+    // Only once the callbacks are over
+    if (callback_thread)
+        host.kernel.exit_delete_thread(callback_thread);
+
+    return 0;
 }
 
-EXPORT(int, sceFiosTimeGetCurrent) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosTime, sceFiosTimeGetCurrent) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-EXPORT(int, sceFiosTimeIntervalFromNanoseconds) {
-    return UNIMPLEMENTED();
+EXPORT(SceFiosTimeInterval, sceFiosTimeIntervalFromNanoseconds, const int64_t ns) {
+    return ns;
 }
 
-EXPORT(int, sceFiosTimeIntervalToNanoseconds) {
-    return UNIMPLEMENTED();
+EXPORT(int64_t, sceFiosTimeIntervalToNanoseconds, const SceFiosTimeInterval interval) {
+    return interval;
 }
 
 EXPORT(int, sceFiosUpdateParameters) {
@@ -378,6 +378,90 @@ static VertexCacheHash hash_data(const void *data, size_t size) {
     return VertexCacheHash(hash);
 }
 
+static constexpr std::size_t MAX_INDEX_RANGE_CACHE_SIZE = 1024;
+
+// Get the range of vertices referenced by a draw. With the hashless cache enabled, the result is kept
+// until the guest writes to the index buffer again, so static meshes skip the scan entirely.
+static gxm::IndexRange get_index_range(HostState &host, const void *indices, SceGxmIndexFormat format, uint32_t count) {
+    if (!host.cfg.hashless_texture_cache || (count == 0)) {
+        return gxm::get_index_range(indices, format, count);
+    }
+
+    const Address address = Ptr<const void>(indices, host.mem).address();
+    const IndexRangeCacheKey key{ address, count, format };
+
+    const std::lock_guard<std::mutex> guard(host.gxm.index_range_cache_lock);
+    auto &cache = host.gxm.index_range_cache;
+
+    auto ite = cache.find(key);
+    if (ite == cache.end()) {
+        if (cache.size() >= MAX_INDEX_RANGE_CACHE_SIZE) {
+            // Protection blocks of dropped entries stay around until their next write, which is harmless
+            cache.clear();
+        }
+
+        ite = cache.emplace(key, std::make_shared<IndexRangeCacheInfo>()).first;
+    } else if (!ite->second->dirty) {
+        return ite->second->range;
+    }
+
+    // Protect before scanning, so a write racing with the scan still marks the result as stale
+    const std::shared_ptr<IndexRangeCacheInfo> info = ite->second;
+    info->dirty = false;
+    add_protect(host.mem, address, count * gxm::index_element_size(format), MEM_PERM_READONLY, [info](Address, bool) {
+        info->dirty = true;
+        return true;
+    });
+
+    info->range = gxm::get_index_range(indices, format, count);
+    return info->range;
+}
+
+// Queue a transfer on the transfer worker. Once the sync object is released by the display queue and previous
+// scenes, the transfer runs with the sync object held, then the notification is written.
+static void submit_transfer(HostState &host, Ptr<SceGxmSyncObject> sync_object, const Ptr<SceGxmNotification> notification, std::function<void()> transfer) {
+    SceGxmSyncObject *sync = sync_object ? sync_object.get(host.mem) : nullptr;
+    MemState &mem = host.mem;
+
+    auto task = [sync, notification, &mem, transfer = std::move(transfer)]() {
+        if (sync) {
+            renderer::wishlist(sync, (renderer::SyncObjectSubject)(renderer::SyncObjectSubject::DisplayQueue | renderer::SyncObjectSubject::Fragment));
+            renderer::subject_in_progress(sync, renderer::SyncObjectSubject::Fragment);
+        }
+
+        transfer();
+
+        if (sync) {
+            renderer::subject_done(sync, renderer::SyncObjectSubject::Fragment);
+        }
+
+        if (notification) {
+            volatile uint32_t *val = notification.get(mem)->address.get(mem);
+            *val = notification.get(mem)->value;
+        }
+    };
+
+    const std::lock_guard<std::mutex> guard(host.gxm.transfer_lock);
+    if (!host.gxm.transfer_worker) {
+        task();
+        return;
+    }
+
+    host.gxm.last_transfer = host.gxm.transfer_worker->submit(std::move(task)).share();
+}
+
+static void wait_for_transfers(GxmState &gxm) {
+    std::shared_future<void> last_transfer;
+    {
+        const std::lock_guard<std::mutex> guard(gxm.transfer_lock);
+        last_transfer = gxm.last_transfer;
+    }
+
+    if (last_transfer.valid()) {
+        last_transfer.wait();
+    }
+}
+
 static bool operator<(const SceGxmRegisteredProgram &a, const SceGxmRegisteredProgram &b) {
     return a.program < b.program;
 }
@@ -1343,14 +1427,7 @@ static int gxmDrawElementGeneral(HostState &host, const char *export_name, const
 
     // Update vertex data. We should stores a copy of the data to pass it to GPU later, since another scene
     // may start to overwrite stuff when this scene is being processed in our queue (in case of OpenGL).
-    size_t max_index = 0;
-    if (indexType == SCE_GXM_INDEX_FORMAT_U16) {
-        const uint16_t *const data = static_cast<const uint16_t *>(indexData);
-        max_index = *std::max_element(&data[0], &data[indexCount]);
-    } else {
-        const uint32_t *const data = static_cast<const uint32_t *>(indexData);
-        max_index = *std::max_element(&data[0], &data[indexCount]);
-    }
+    const size_t max_index = get_index_range(host, indexData, indexType, indexCount).max;
 
     size_t max_data_length[SCE_GXM_MAX_VERTEX_STREAMS] = {};
     std::uint32_t stream_used = 0;
@@ -1458,14 +1535,7 @@ EXPORT(int, sceGxmDrawPrecomputed, SceGxmContext *context, SceGxmPrecomputedDraw
 
     // Update vertex data. We should stores a copy of the data to pass it to GPU later, since another scene
     // may start to overwrite stuff when this scene is being processed in our queue (in case of OpenGL).
-    size_t max_index = 0;
-    if (draw->index_format == SCE_GXM_INDEX_FORMAT_U16) {
-        const uint16_t *const data = draw->index_data.cast<const uint16_t>().get(host.mem);
-        max_index = *std::max_element(&data[0], &data[draw->vertex_count]);
-    } else {
-        const uint32_t *const data = draw->index_data.cast<const uint32_t>().get(host.mem);
-        max_index = *std::max_element(&data[0], &data[draw->vertex_count]);
-    }
+    const size_t max_index = get_index_range(host, draw->index_data.get(host.mem), draw->index_format, draw->vertex_count).max;
 
     const auto frag_paramters = gxp::program_parameters(fragment_program_gxp);
     SceGxmTexture *frag_textures = fragment_state ? fragment_state->textures.get(host.mem) : context->state.textures.data();
@@ -1859,6 +1929,7 @@ EXPORT(int, sceGxmInitialize, const SceGxmInitializeParams *params) {
 
     SDL_CreateThread(&thread_function, "SceGxmDisplayQueue", &gxm_params);
     SDL_SemWait(gxm_params.host_may_destroy_params.get());
+    host.gxm.transfer_worker = std::make_unique<util::ThreadPool>(1);
     host.gxm.notification_region = Ptr<uint32_t>(alloc(host.mem, MB(1), "SceGxmNotificationRegion"));
     memset(host.gxm.notification_region.get(host.mem), 0, MB(1));
     return 0;
@@ -3538,12 +3609,17 @@ EXPORT(int, sceGxmSyncObjectDestroy, Ptr<SceGxmSyncObject> syncObject) {
     if (!syncObject)
         return RET_ERROR(SCE_GXM_ERROR_INVALID_POINTER);
 
+    // A queued transfer may still be holding it
+    wait_for_transfers(host.gxm);
     free(host.mem, syncObject);
 
     return 0;
 }
 
 EXPORT(int, sceGxmTerminate) {
+    wait_for_transfers(host.gxm);
+    host.gxm.transfer_worker.reset();
+
     const ThreadStatePtr thread = lock_and_find(host.gxm.display_queue_thread, host.kernel.threads, host.kernel.mutex);
     host.kernel.exit_delete_thread(thread);
     return 0;
@@ -4060,10 +4136,8 @@ EXPORT(int, sceGxmTransferCopy, uint32_t width, uint32_t height, uint32_t colorK
     if (!srcAddress || !destAddress)
         return RET_ERROR(SCE_GXM_ERROR_INVALID_POINTER);
 
-    const auto src_type_is_linear = srcType == SCE_GXM_TRANSFER_LINEAR;
     const auto src_type_is_tiled = srcType == SCE_GXM_TRANSFER_TILED;
     const auto src_type_is_swizzled = srcType == SCE_GXM_TRANSFER_SWIZZLED;
-    const auto dest_type_is_linear = destType == SCE_GXM_TRANSFER_LINEAR;
     const auto dest_type_is_tiled = destType == SCE_GXM_TRANSFER_TILED;
     const auto dest_type_is_swizzled = destType == SCE_GXM_TRANSFER_SWIZZLED;
 
@@ -4071,54 +4145,13 @@ EXPORT(int, sceGxmTransferCopy, uint32_t width, uint32_t height, uint32_t colorK
     if (is_invalide_value)
         return RET_ERROR(SCE_GXM_ERROR_INVALID_VALUE);
 
-    if (!syncFlags && src_type_is_linear && dest_type_is_linear) {
-        const auto src_bpp = gxm::get_bits_per_pixel(srcFormat);
-        const auto dest_bpp = gxm::get_bits_per_pixel(destFormat);
-        const uint32_t src_bytes_per_pixel = (src_bpp + 7) >> 3;
-        const uint32_t dest_bytes_per_pixel = (dest_bpp + 7) >> 3;
-
-        for (uint32_t y = 0; y < height; y++) {
-            for (uint32_t x = 0; x < width; x++) {
-                // Set offset of source and destination
-                const auto src_offset = ((x + srcX) * src_bytes_per_pixel) + ((y + srcY) * srcStride);
-                const auto dest_offset = ((x + destX) * dest_bytes_per_pixel) + ((y + destY) * destStride);
-
-                // Set pointer of source and destination
-                const auto src_ptr = (uint8_t *)srcAddress + src_offset;
-                auto dest_ptr = (uint8_t *)destAddress + dest_offset;
-
-                // Set color of source
-                const auto src_color = *(uint32_t *)src_ptr;
-
-                // Copy result in destination depending color Key
-                switch (colorKeyMode) {
-                case SCE_GXM_TRANSFER_COLORKEY_NONE:
-                    memcpy(dest_ptr, src_ptr, dest_bytes_per_pixel);
-                    break;
-                case SCE_GXM_TRANSFER_COLORKEY_PASS:
-                    if ((src_color & colorKeyMask) == colorKeyValue)
-                        memcpy(dest_ptr, src_ptr, dest_bytes_per_pixel);
-                    break;
-                case SCE_GXM_TRANSFER_COLORKEY_REJECT:
-                    if ((src_color & colorKeyMask) != colorKeyValue)
-                        memcpy(dest_ptr, src_ptr, dest_bytes_per_pixel);
-                    break;
-                default: break;
-                }
-            }
-        }
-    } else
-        STUBBED("No support syncFlags & convertion of SceGxmTransferType yet");
-
-    if (syncObject) {
-        SceGxmSyncObject *sync = syncObject.get(host.mem);
-        renderer::wishlist(sync, (renderer::SyncObjectSubject)(renderer::SyncObjectSubject::DisplayQueue | renderer::SyncObjectSubject::Fragment));
-    }
+    // Vertex and fragment sync are covered by waiting on the sync object before the transfer runs
+    const gxm::TransferImage src{ (uint8_t *)srcAddress, srcFormat, srcType, srcX, srcY, srcStride };
+    const gxm::TransferImage dest{ (uint8_t *)destAddress, destFormat, destType, destX, destY, destStride };
 
-    if (notification) {
-        volatile uint32_t *val = notification.get(host.mem)->address.get(host.mem);
-        *val = notification.get(host.mem)->value;
-    }
+    submit_transfer(host, syncObject, notification, [=]() {
+        gxm::transfer_copy(src, dest, width, height, colorKeyMode, colorKeyValue, colorKeyMask);
+    });
 
     return 0;
 }
@@ -4130,38 +4163,12 @@ EXPORT(int, sceGxmTransferDownscale, SceGxmTransferFormat srcFormat, const void
     if (!srcAddress || !destAddress)
         return RET_ERROR(SCE_GXM_ERROR_INVALID_POINTER);
 
-    if (!syncFlags) {
-        const auto src_bpp = gxm::get_bits_per_pixel(srcFormat);
-        const auto dest_bpp = gxm::get_bits_per_pixel(destFormat);
-        const uint32_t src_bytes_per_pixel = (src_bpp + 7) >> 3;
-        const uint32_t dest_bytes_per_pixel = (dest_bpp + 7) >> 3;
-
-        for (uint32_t y = 0; y < srcHeight; y += 2) {
-            for (uint32_t x = 0; x < srcWidth; x += 2) {
-                // Set offset of source and destination
-                const auto src_offset = ((x + srcX) * src_bytes_per_pixel) + ((y + srcY) * srcStride);
-                const auto dest_offset = (y / 2 + destY) * destStride + (x / 2 + destX) * dest_bytes_per_pixel;
-
-                // Set pointer of source and destination
-                const auto src_ptr = (uint8_t *)srcAddress + src_offset;
-                auto dest_ptr = (uint8_t *)destAddress + dest_offset;
-
-                // Copy result in destination
-                memcpy(dest_ptr, src_ptr, dest_bytes_per_pixel);
-            }
-        }
-    } else
-        STUBBED("No support syncFlags yet");
-
-    if (syncObject) {
-        SceGxmSyncObject *sync = syncObject.get(host.mem);
-        renderer::wishlist(sync, (renderer::SyncObjectSubject)(renderer::SyncObjectSubject::DisplayQueue || renderer::SyncObjectSubject::Fragment));
-    }
+    const gxm::TransferImage src{ (uint8_t *)srcAddress, srcFormat, SCE_GXM_TRANSFER_LINEAR, srcX, srcY, srcStride };
+    const gxm::TransferImage dest{ (uint8_t *)destAddress, destFormat, SCE_GXM_TRANSFER_LINEAR, destX, destY, destStride };
 
-    if (notification) {
-        volatile uint32_t *val = notification.get(host.mem)->address.get(host.mem);
-        *val = notification.get(host.mem)->value;
-    }
+    submit_transfer(host, syncObject, notification, [=]() {
+        gxm::transfer_downscale(src, dest, srcWidth, srcHeight);
+    });
 
     return 0;
 }
@@ -4172,40 +4179,18 @@ EXPORT(int, sceGxmTransferFill, uint32_t fillColor, SceGxmTransferFormat destFor
     if (!destAddress)
         return RET_ERROR(SCE_GXM_ERROR_INVALID_POINTER);
 
-    const auto bpp = gxm::get_bits_per_pixel(destFormat);
-
-    if (!syncFlags) {
-        const uint32_t bytes_per_pixel = (bpp + 7) >> 3;
-        for (uint32_t y = 0; y < destHeight; y++) {
-            for (uint32_t x = 0; x < destWidth; x++) {
-                // Set offset of destination
-                const auto dest_offset = ((x + destX) * bytes_per_pixel) + ((y + destY) * destStride);
-
-                // Set pointer of destination
-                auto dest_ptr = (uint8_t *)destAddress + dest_offset;
-
-                // Fill color in destination
-                memcpy(dest_ptr, &fillColor, bytes_per_pixel);
-            }
-        }
-    } else
-        STUBBED("No support syncFlags yet");
-
-    if (syncObject) {
-        SceGxmSyncObject *sync = syncObject.get(host.mem);
-        renderer::wishlist(sync, (renderer::SyncObjectSubject)(renderer::SyncObjectSubject::DisplayQueue | renderer::SyncObjectSubject::Fragment));
-    }
+    const gxm::TransferImage dest{ (uint8_t *)destAddress, destFormat, SCE_GXM_TRANSFER_LINEAR, destX, destY, destStride };
 
-    if (notification) {
-        volatile uint32_t *val = notification.get(host.mem)->address.get(host.mem);
-        *val = notification.get(host.mem)->value;
-    }
+    submit_transfer(host, syncObject, notification, [=]() {
+        gxm::transfer_fill(dest, destWidth, destHeight, fillColor);
+    });
 
     return 0;
 }
 
 EXPORT(int, sceGxmTransferFinish) {
-    return UNIMPLEMENTED();
+    wait_for_transfers(host.gxm);
+    return 0;
 }
 
 EXPORT(int, sceGxmUnmapFragmentUsseMemory, void *base) {
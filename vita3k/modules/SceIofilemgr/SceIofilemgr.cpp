@@ -17,7 +17,50 @@
 
 #include "SceIofilemgr.h"
 
+#include <io/async.h>
 #include <io/functions.h>
+#include <io/io.h>
+#include <kernel/state.h>
+#include <kernel/sync_primitives.h>
+
+#include <string>
+
+// Pattern set on the event of an op handle once the request is done, its user data being the result
+constexpr SceUInt32 SCE_IO_ASYNC_EVENT_COMPLETE = 0x1;
+
+// Every asynchronous request gets its own simple event as op handle, which the guest can wait on
+// The work runs on the IO workers, next to guest threads: it must only reach IOState through the locked descriptor tables
+static SceUID submit_async(HostState &host, SceUID thread_id, const char *export_name, SceUID fd, AsyncIoEngine::Work work) {
+    const SceUID op = simple_event_create(host.kernel, host.mem, export_name, "SceIoAsyncOp", thread_id, 0, 0);
+    if (op < 0) {
+        return op;
+    }
+
+    KernelState &kernel = host.kernel;
+    host.io.async->submit(op, fd, std::move(work), [&kernel, thread_id, export_name](SceUID op, SceOff result) {
+        simple_event_setorpulse(kernel, export_name, thread_id, op, SCE_IO_ASYNC_EVENT_COMPLETE, static_cast<SceUInt64>(result), true);
+    });
+
+    return op;
+}
+
+// Release the op handle of a finished request
+static int complete_async(HostState &host, SceUID thread_id, const char *export_name, SceUID op, SceOff *result) {
+    switch (host.io.async->status(op, result)) {
+    case AsyncIoStatus::UNKNOWN:
+        return SCE_ERROR_ERRNO_EBADFD;
+    case AsyncIoStatus::PENDING:
+    case AsyncIoStatus::RUNNING:
+        return SCE_ERROR_ERRNO_EBUSY;
+    case AsyncIoStatus::DONE:
+        break;
+    }
+
+    host.io.async->release(op);
+    simple_event_delete(host.kernel, export_name, thread_id, op);
+
+    return 0;
+}
 
 EXPORT(int, _sceIoChstat) {
     return UNIMPLEMENTED();
@@ -31,8 +74,20 @@ EXPORT(int, _sceIoChstatByFd) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceIoCompleteMultiple) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoCompleteMultiple, SceIoAsyncParam *params, const int count) {
+    if (!params || (count < 0)) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    int completed = 0;
+    for (int i = 0; i < count; i++) {
+        params[i].error = complete_async(host, thread_id, export_name, params[i].op, &params[i].result);
+        if (params[i].error == 0) {
+            completed++;
+        }
+    }
+
+    return completed;
 }
 
 EXPORT(int, _sceIoDevctl) {
@@ -79,8 +134,17 @@ EXPORT(SceOff, _sceIoLseek, const SceUID fd, Ptr<_sceIoLseekOpt> opt) {
     return seek_file(fd, opt.get(host.mem)->offset, opt.get(host.mem)->whence, host.io, export_name);
 }
 
-EXPORT(int, _sceIoLseekAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoLseekAsync, const SceUID fd, Ptr<_sceIoLseekOpt> opt) {
+    if (!opt) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    const SceOff offset = opt.get(host.mem)->offset;
+    const SceIoSeekMode whence = opt.get(host.mem)->whence;
+
+    return submit_async(host, thread_id, export_name, fd, [&host, fd, offset, whence, export_name]() {
+        return seek_file(fd, offset, whence, host.io, export_name);
+    });
 }
 
 EXPORT(int, _sceIoMkdir, const char *dir, const SceMode mode) {
@@ -99,24 +163,55 @@ EXPORT(int, _sceIoOpen, const char *file, const int flags, const SceMode mode) {
     return open_file(host.io, file, flags, host.pref_path, export_name);
 }
 
-EXPORT(int, _sceIoOpenAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoOpenAsync, const char *file, const int flags, const SceMode mode) {
+    if (file == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    // The guest may reuse the path buffer before the request runs
+    const std::string path = file;
+
+    return submit_async(host, thread_id, export_name, invalid_fd, [&host, path, flags, export_name]() {
+        return open_file(host.io, path.c_str(), flags, host.pref_path, export_name);
+    });
 }
 
-EXPORT(int, _sceIoPread) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoPread, const SceUID fd, void *data, const SceSize size, Ptr<_sceIoPreadOpt> opt) {
+    if (!data || !opt) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    return pread_file(data, host.io, fd, size, opt.get(host.mem)->offset, export_name);
 }
 
-EXPORT(int, _sceIoPreadAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoPreadAsync, const SceUID fd, void *data, const SceSize size, Ptr<_sceIoPreadOpt> opt) {
+    if (!data || !opt) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    const SceOff offset = opt.get(host.mem)->offset;
+    return submit_async(host, thread_id, export_name, fd, [&host, fd, data, size, offset, export_name]() {
+        return pread_file(data, host.io, fd, size, offset, export_name);
+    });
 }
 
-EXPORT(int, _sceIoPwrite) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoPwrite, const SceUID fd, const void *data, const SceSize size, Ptr<_sceIoPwriteOpt> opt) {
+    if (!data || !opt) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    return pwrite_file(fd, data, size, opt.get(host.mem)->offset, host.io, export_name);
 }
 
-EXPORT(int, _sceIoPwriteAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoPwriteAsync, const SceUID fd, const void *data, const SceSize size, Ptr<_sceIoPwriteOpt> opt) {
+    if (!data || !opt) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    const SceOff offset = opt.get(host.mem)->offset;
+    return submit_async(host, thread_id, export_name, fd, [&host, fd, data, size, offset, export_name]() {
+        return pwrite_file(fd, data, size, offset, host.io, export_name);
+    });
 }
 
 EXPORT(int, _sceIoRemove) {
@@ -127,12 +222,25 @@ EXPORT(int, _sceIoRemoveAsync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceIoRename) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoRename, const char *old_name, const char *new_name) {
+    if (old_name == nullptr || new_name == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    return rename_file(host.io, old_name, new_name, host.pref_path, export_name);
 }
 
-EXPORT(int, _sceIoRenameAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, _sceIoRenameAsync, const char *old_name, const char *new_name) {
+    if (old_name == nullptr || new_name == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    const std::string old_path = old_name;
+    const std::string new_path = new_name;
+
+    return submit_async(host, thread_id, export_name, invalid_fd, [&host, old_path, new_path, export_name]() {
+        return rename_file(host.io, old_path.c_str(), new_path.c_str(), host.pref_path, export_name);
+    });
 }
 
 EXPORT(int, _sceIoRmdir) {
@@ -151,8 +259,17 @@ EXPORT(int, _sceIoSyncAsync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoCancel) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoCancel, const SceUID op) {
+    if (host.io.async->cancel(op)) {
+        return 0;
+    }
+
+    if (host.io.async->status(op) == AsyncIoStatus::UNKNOWN) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    }
+
+    // Already running or done
+    return RET_ERROR(SCE_ERROR_ERRNO_EBUSY);
 }
 
 EXPORT(int, sceIoChstatByFdAsync) {
@@ -163,12 +280,21 @@ EXPORT(int, sceIoClose, const SceUID fd) {
     return close_file(host.io, fd, export_name);
 }
 
-EXPORT(int, sceIoCloseAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoCloseAsync, const SceUID fd) {
+    return submit_async(host, thread_id, export_name, fd, [&host, fd, export_name]() {
+        const int result = close_file(host.io, fd, export_name);
+        host.io.async->reset_priority(fd);
+        return result;
+    });
 }
 
-EXPORT(int, sceIoComplete) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoComplete, const SceUID op) {
+    const int error = complete_async(host, thread_id, export_name, op, nullptr);
+    if (error < 0) {
+        return RET_ERROR(error);
+    }
+
+    return 0;
 }
 
 EXPORT(int, sceIoDclose, const SceUID fd) {
@@ -191,8 +317,12 @@ EXPORT(int, sceIoFlockForSystem) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoGetPriority) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoGetPriority, const SceUID fd) {
+    if (fd < 0) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    }
+
+    return host.io.async->get_priority(fd);
 }
 
 EXPORT(int, sceIoGetPriorityForSystem) {
@@ -223,12 +353,27 @@ EXPORT(int, sceIoRead, const SceUID fd, void *data, const SceSize size) {
     return read_file(data, host.io, fd, size, export_name);
 }
 
-EXPORT(int, sceIoReadAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoReadAsync, const SceUID fd, void *data, const SceSize size) {
+    if (data == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    return submit_async(host, thread_id, export_name, fd, [&host, fd, data, size, export_name]() {
+        return read_file(data, host.io, fd, size, export_name);
+    });
 }
 
-EXPORT(int, sceIoSetPriority) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoSetPriority, const SceUID fd, const int priority) {
+    if (fd < 0) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    }
+
+    if ((priority < SCE_IO_PRIORITY_HIGHEST) || (priority > SCE_IO_PRIORITY_LOWEST)) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    host.io.async->set_priority(fd, priority);
+    return 0;
 }
 
 EXPORT(int, sceIoSetPriorityForSystem) {
@@ -259,8 +404,14 @@ EXPORT(int, sceIoWrite, const SceUID fd, const void *data, const SceSize size) {
     return write_file(fd, data, size, host.io, export_name);
 }
 
-EXPORT(int, sceIoWriteAsync) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoWriteAsync, const SceUID fd, const void *data, const SceSize size) {
+    if (data == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+
+    return submit_async(host, thread_id, export_name, fd, [&host, fd, data, size, export_name]() {
+        return write_file(fd, data, size, host.io, export_name);
+    });
 }
 
 BRIDGE_IMPL(_sceIoChstat)
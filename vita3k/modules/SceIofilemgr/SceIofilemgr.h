@@ -25,6 +25,21 @@ typedef struct _sceIoLseekOpt {
     uint32_t unk;
 } _sceIoLseekOpt;
 
+// The offset is 64-bit, so it doesn't fit in registers after the other arguments
+typedef struct _sceIoPreadOpt {
+    SceOff offset;
+    uint32_t unk[2];
+} _sceIoPreadOpt;
+
+typedef _sceIoPreadOpt _sceIoPwriteOpt;
+
+// Entry of _sceIoCompleteMultiple, the error and result are written back for each op handle
+typedef struct SceIoAsyncParam {
+    SceUID op;
+    int32_t error;
+    SceOff result;
+} SceIoAsyncParam;
+
 EXPORT(int, _sceIoDopen, const char *dir);
 EXPORT(int, _sceIoDread, const SceUID fd, SceIoDirent *dir);
 EXPORT(int, _sceIoMkdir, const char *dir, const SceMode mode);
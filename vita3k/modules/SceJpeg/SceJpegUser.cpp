@@ -19,11 +19,28 @@
 
 #include <codec/state.h>
 
-typedef std::shared_ptr<DecoderState> DecoderPtr;
-
 struct MJpegState {
     bool initialized = false;
-    DecoderPtr decoder;
+    std::shared_ptr<MjpegDecoderState> decoder;
+
+    // Pictures decoded straight to RGBA go through here first
+    std::vector<uint8_t> ycbcr;
+};
+
+// Values shared with the jpeg library of the PSP
+enum SceJpegErrorCode : uint32_t {
+    SCE_JPEG_ERROR_INVALID_STATE = 0x80650039,
+    SCE_JPEG_ERROR_INVALID_VALUE = 0x80650051,
+};
+
+enum SceJpegColorSpace : int32_t {
+    SCE_JPEG_CS_YCBCR = 0x00020000,
+};
+
+enum SceJpegPixelFormat : int32_t {
+    SCE_JPEG_NO_CSC_OUTPUT = -1,
+    SCE_JPEG_PIXEL_RGBA8888 = 0,
+    SCE_JPEG_PIXEL_BGRA8888 = 4,
 };
 
 struct SceJpegMJpegInitInfo {
@@ -51,22 +68,75 @@ EXPORT(int, sceJpegCreateSplitDecoder) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceJpegCsc) {
-    return UNIMPLEMENTED();
+// The low byte of the sampling is the vertical factor, the one above it the horizontal one
+static YCbCrSampling get_sampling(int32_t sampling) {
+    const uint32_t h_factor = (sampling >> 8) & 0xFF;
+    const uint32_t v_factor = sampling & 0xFF;
+
+    return {
+        (h_factor >= 4) ? 2u : (h_factor >= 2) ? 1u : 0u,
+        (v_factor >= 2) ? 1u : 0u,
+    };
 }
 
-EXPORT(int, sceJpegDecodeMJpeg) {
-    return UNIMPLEMENTED();
+static int32_t get_color_space(YCbCrSampling sampling) {
+    return SCE_JPEG_CS_YCBCR | ((1 << sampling.h_shift) << 8) | (1 << sampling.v_shift);
+}
+
+static int csc(uint8_t *rgba, const uint8_t *ycbcr, int32_t size, int32_t frame_width, int32_t format, int32_t sampling) {
+    const uint32_t width = size >> 16u;
+    const uint32_t height = size & (~0u >> 16u);
+    const uint32_t pitch = (frame_width > 0) ? frame_width : width;
+
+    convert_ycbcr_to_rgba(ycbcr, rgba, width, height, pitch, get_sampling(sampling), format == SCE_JPEG_PIXEL_BGRA8888);
+
+    return 0;
+}
+
+EXPORT(int, sceJpegCsc, uint8_t *rgba, const uint8_t *ycbcr,
+    int32_t size, int32_t frame_width, int32_t format, int32_t sampling) {
+    return csc(rgba, ycbcr, size, frame_width, format, sampling);
+}
+
+EXPORT(int, sceJpegDecodeMJpeg, const uint8_t *jpeg_data, uint32_t jpeg_size,
+    uint8_t *output, uint32_t output_size, int mode, void *buffer, uint32_t buffer_size) {
+    const auto state = host.kernel.obj_store.find<MJpegState>();
+    if (!state)
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_STATE);
+
+    // The size comes first, the picture is only written once it is known to fit
+    DecoderSize size = {};
+    if (!state->decoder->send(jpeg_data, jpeg_size) || !state->decoder->receive(nullptr, &size))
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
+
+    if (static_cast<uint64_t>(size.width) * size.height * 4 > output_size)
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
+
+    state->ycbcr.resize(ycbcr_buffer_size(size.width, size.height, state->decoder->sampling));
+    if (!state->decoder->receive(state->ycbcr.data(), &size))
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
+
+    convert_ycbcr_to_rgba(state->ycbcr.data(), output, size.width, size.height, size.width, state->decoder->sampling, false);
+
+    // Top 16 bits = width, bottom 16 bits = height.
+    return (size.width << 16u) | size.height;
 }
 
 EXPORT(int, sceJpegDecodeMJpegYCbCr, const uint8_t *jpeg_data, uint32_t jpeg_size,
     uint8_t *output, uint32_t output_size, int mode, void *buffer, uint32_t buffer_size) {
-    const auto state = host.kernel.obj_store.get<MJpegState>();
+    const auto state = host.kernel.obj_store.find<MJpegState>();
+    if (!state)
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_STATE);
 
     DecoderSize size = {};
+    if (!state->decoder->send(jpeg_data, jpeg_size) || !state->decoder->receive(nullptr, &size))
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
 
-    state->decoder->send(jpeg_data, jpeg_size);
-    state->decoder->receive(output, &size);
+    if (ycbcr_buffer_size(size.width, size.height, state->decoder->sampling) > output_size)
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
+
+    if (!state->decoder->receive(output, &size))
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
 
     // Top 16 bits = width, bottom 16 bits = height.
     return (size.width << 16u) | size.height;
@@ -84,17 +154,22 @@ EXPORT(int, sceJpegFinishMJpeg) {
 
 EXPORT(int, sceJpegGetOutputInfo, const uint8_t *jpeg_data, uint32_t jpeg_size,
     int32_t format, int32_t mode, SceJpegOutputInfo *output) {
-    const auto state = host.kernel.obj_store.get<MJpegState>();
+    const auto state = host.kernel.obj_store.find<MJpegState>();
+    if (!state)
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_STATE);
 
     DecoderSize size = {};
-
-    state->decoder->send(jpeg_data, jpeg_size);
-    state->decoder->receive(nullptr, &size);
+    if (!state->decoder->send(jpeg_data, jpeg_size) || !state->decoder->receive(nullptr, &size))
+        return RET_ERROR(SCE_JPEG_ERROR_INVALID_VALUE);
 
     output->width = size.width;
     output->height = size.height;
-    output->color_space = 2u << 16u;
-    output->output_size = size.width * size.height * 3;
+    output->color_space = get_color_space(state->decoder->sampling);
+    if (format == SCE_JPEG_NO_CSC_OUTPUT) {
+        output->output_size = ycbcr_buffer_size(size.width, size.height, state->decoder->sampling);
+    } else {
+        output->output_size = size.width * size.height * 4;
+    }
 
     return 0;
 }
@@ -116,14 +191,9 @@ EXPORT(int, sceJpegInitMJpegWithParam, const SceJpegMJpegInitInfo *info) {
     return 0;
 }
 
-EXPORT(int, sceJpegMJpegCsc, uint8_t *rgba, const uint8_t *yuv,
-    int32_t size, int32_t image_width, int32_t format, int32_t sampling) {
-    uint32_t width = size >> 16u;
-    uint32_t height = size & (~0u >> 16u);
-
-    convert_yuv_to_rgb(yuv, rgba, width, height);
-
-    return 0;
+EXPORT(int, sceJpegMJpegCsc, uint8_t *rgba, const uint8_t *ycbcr,
+    int32_t size, int32_t frame_width, int32_t format, int32_t sampling) {
+    return csc(rgba, ycbcr, size, frame_width, format, sampling);
 }
 
 EXPORT(int, sceJpegSplitDecodeMJpeg) {
@@ -471,14 +471,7 @@ EXPORT(int, sceIoOpenAsync) {
 }
 
 EXPORT(SceSSize, sceIoPread, SceUID fd, void *buf, SceSize nbyte, SceOff offset) {
-    auto pos = tell_file(host.io, fd, export_name);
-    if (pos < 0) {
-        return static_cast<SceSSize>(pos);
-    }
-    seek_file(fd, offset, SCE_SEEK_SET, host.io, export_name);
-    const auto res = read_file(buf, host.io, fd, nbyte, export_name);
-    seek_file(fd, pos, SCE_SEEK_SET, host.io, export_name);
-    return res;
+    return pread_file(buf, host.io, fd, nbyte, offset, export_name);
 }
 
 EXPORT(int, sceIoPreadAsync) {
@@ -486,14 +479,7 @@ EXPORT(int, sceIoPreadAsync) {
 }
 
 EXPORT(SceSSize, sceIoPwrite, SceUID fd, const void *buf, SceSize nbyte, SceOff offset) {
-    auto pos = tell_file(host.io, fd, export_name);
-    if (pos < 0) {
-        return static_cast<SceSSize>(pos);
-    }
-    seek_file(fd, offset, SCE_SEEK_SET, host.io, export_name);
-    const auto res = write_file(fd, buf, nbyte, host.io, export_name);
-    seek_file(fd, pos, SCE_SEEK_SET, host.io, export_name);
-    return res;
+    return pwrite_file(fd, buf, nbyte, offset, host.io, export_name);
 }
 
 EXPORT(int, sceIoPwriteAsync) {
@@ -515,8 +501,11 @@ EXPORT(int, sceIoRemoveAsync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoRename) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoRename, const char *old_name, const char *new_name) {
+    if (old_name == nullptr || new_name == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    return rename_file(host.io, old_name, new_name, host.pref_path, export_name);
 }
 
 EXPORT(int, sceIoRenameAsync) {
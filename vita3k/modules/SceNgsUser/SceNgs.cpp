@@ -294,6 +294,8 @@ EXPORT(SceUInt32, sceNgsSystemInit, Ptr<void> memspace, const std::uint32_t mems
     }
 
     *handle = memspace.cast<ngs::System>();
+    handle->get(host.mem)->voice_scheduler.set_thread_count(std::max(host.cfg.ngs_thread_count, 0));
+
     return SCE_NGS_OK;
 }
 
@@ -17,136 +17,591 @@
 
 #include "SceSas.h"
 
-EXPORT(int, sceSasCore) {
-    return UNIMPLEMENTED();
+#include <sas/state.h>
+
+#include <util/log.h>
+
+#include <cstring>
+#include <string>
+
+enum SceSasError : uint32_t {
+    SCE_SAS_ERROR_INVALID_GRAIN = 0x80420001,
+    SCE_SAS_ERROR_INVALID_MAX_VOICES = 0x80420002,
+    SCE_SAS_ERROR_INVALID_OUTPUT_MODE = 0x80420003,
+    SCE_SAS_ERROR_INVALID_VOICE = 0x80420010,
+    SCE_SAS_ERROR_INVALID_PITCH = 0x80420011,
+    SCE_SAS_ERROR_INVALID_ADSR_CURVE_MODE = 0x80420013,
+    SCE_SAS_ERROR_INVALID_PARAMETER = 0x80420014,
+    SCE_SAS_ERROR_INVALID_LOOP_POS = 0x80420015,
+    SCE_SAS_ERROR_INVALID_VOLUME = 0x80420018,
+    SCE_SAS_ERROR_INVALID_ADSR_RATE = 0x80420019,
+    SCE_SAS_ERROR_INVALID_PCM_SIZE = 0x8042001A,
+    SCE_SAS_ERROR_REV_INVALID_TYPE = 0x80420020,
+    SCE_SAS_ERROR_REV_INVALID_FEEDBACK = 0x80420021,
+    SCE_SAS_ERROR_REV_INVALID_DELAY_TIME = 0x80420022,
+    SCE_SAS_ERROR_REV_INVALID_VOLUME = 0x80420023,
+    SCE_SAS_ERROR_NOT_INIT = 0x80420100,
+};
+
+// Guest memory the system was given, only handed back on exit. The mixer state itself lives on the host.
+struct SasState {
+    sas::State mixer;
+    bool initialized = false;
+    Ptr<void> buffer;
+    uint32_t buffer_size = 0;
+};
+
+// Base size of the system, plus the size of each voice
+constexpr uint32_t SAS_SYSTEM_MEMORY_SIZE = 0x4000;
+constexpr uint32_t SAS_VOICE_MEMORY_SIZE = 0x400;
+
+struct SasConfig {
+    uint32_t grain = sas::DEFAULT_GRAIN;
+    uint32_t voices = sas::MAX_VOICES;
+};
+
+// The configuration is a string of options such as "numGrains=256 numVoices=32"
+static SasConfig parse_config(const char *config) {
+    SasConfig result;
+    if (!config) {
+        return result;
+    }
+
+    const std::string text(config);
+    const auto read_option = [&](const char *name, uint32_t &value) {
+        const std::size_t pos = text.find(name);
+        if (pos != std::string::npos) {
+            value = static_cast<uint32_t>(std::strtoul(text.c_str() + pos + std::strlen(name), nullptr, 10));
+        }
+    };
+
+    read_option("numGrains=", result.grain);
+    read_option("numVoices=", result.voices);
+
+    return result;
+}
+
+static bool is_valid_grain(uint32_t grain) {
+    return (grain >= sas::MIN_GRAIN) && (grain <= sas::MAX_GRAIN);
+}
+
+static int check_config(const SasConfig &config) {
+    if (!is_valid_grain(config.grain)) {
+        return SCE_SAS_ERROR_INVALID_GRAIN;
+    }
+
+    if ((config.voices == 0) || (config.voices > sas::MAX_VOICES)) {
+        return SCE_SAS_ERROR_INVALID_MAX_VOICES;
+    }
+
+    return 0;
+}
+
+// Lock the state and, if a voice is given, check it exists. Any error is left in the result.
+struct SasLock {
+    SasState *state = nullptr;
+    std::unique_lock<std::mutex> lock;
+    int error = 0;
+
+    SasLock(HostState &host, int32_t voice = -1) {
+        state = host.kernel.obj_store.find<SasState>();
+        if (!state) {
+            error = SCE_SAS_ERROR_NOT_INIT;
+            return;
+        }
+
+        lock = std::unique_lock<std::mutex>(state->mixer.mutex);
+        if (!state->initialized) {
+            error = SCE_SAS_ERROR_NOT_INIT;
+        } else if ((voice != -1) && ((voice < 0) || (static_cast<std::size_t>(voice) >= state->mixer.voices.size()))) {
+            error = SCE_SAS_ERROR_INVALID_VOICE;
+        }
+    }
+
+    sas::Voice &voice(int32_t index) {
+        return state->mixer.voices[index];
+    }
+};
+
+static int init(HostState &host, const char *export_name, const SasConfig &config, Ptr<void> buffer, uint32_t buffer_size) {
+    const int error = check_config(config);
+    if (error < 0) {
+        return RET_ERROR(error);
+    }
+
+    host.kernel.obj_store.create<SasState>();
+    SasState *state = host.kernel.obj_store.get<SasState>();
+
+    const std::lock_guard<std::mutex> guard(state->mixer.mutex);
+    state->mixer.init(config.voices, config.grain);
+    state->buffer = buffer;
+    state->buffer_size = buffer_size;
+    state->initialized = true;
+
+    return 0;
+}
+
+EXPORT(int, sceSasCore, int16_t *output) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!output) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    sas.state->mixer.render(output);
+    return 0;
+}
+
+EXPORT(int, sceSasCoreWithMix, int16_t *in_out, int32_t left_volume, int32_t right_volume) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!in_out) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    if ((left_volume < 0) || (left_volume > sas::VOLUME_MAX) || (right_volume < 0) || (right_volume > sas::VOLUME_MAX)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOLUME);
+    }
+
+    sas.state->mixer.render(in_out, in_out, left_volume, right_volume);
+    return 0;
 }
 
-EXPORT(int, sceSasCoreWithMix) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasExit, Ptr<void> *buffer, uint32_t *buffer_size) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (buffer) {
+        *buffer = sas.state->buffer;
+    }
+    if (buffer_size) {
+        *buffer_size = sas.state->buffer_size;
+    }
+
+    // Keep the state itself, another thread may be waiting on its lock
+    sas.state->mixer.voices.clear();
+    sas.state->initialized = false;
+
+    return 0;
 }
 
-EXPORT(int, sceSasExit) {
-    return UNIMPLEMENTED();
+static int get_peak(HostState &host, const char *export_name, sas::Peak sas::State::*peak, int32_t *left, int32_t *right) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!left || !right) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    *left = (sas.state->mixer.*peak).left;
+    *right = (sas.state->mixer.*peak).right;
+    return 0;
 }
 
-EXPORT(int, sceSasGetDryPeak) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasGetDryPeak, int32_t *left, int32_t *right) {
+    return get_peak(host, export_name, &sas::State::dry_peak, left, right);
 }
 
-EXPORT(int, sceSasGetEndState) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasGetEndState, int32_t voice) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    return sas.voice(voice).has_ended ? 1 : 0;
 }
 
-EXPORT(int, sceSasGetEnvelope) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasGetEnvelope, int32_t voice) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    return sas.voice(voice).envelope.height;
 }
 
 EXPORT(int, sceSasGetGrain) {
-    return UNIMPLEMENTED();
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    return static_cast<int>(sas.state->mixer.grain);
 }
 
-EXPORT(int, sceSasGetNeededMemorySize) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasGetNeededMemorySize, const char *config, uint32_t *size) {
+    if (!size) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    const SasConfig parsed = parse_config(config);
+    const int error = check_config(parsed);
+    if (error < 0) {
+        return RET_ERROR(error);
+    }
+
+    *size = SAS_SYSTEM_MEMORY_SIZE + parsed.voices * SAS_VOICE_MEMORY_SIZE;
+    return 0;
 }
 
 EXPORT(int, sceSasGetOutputmode) {
-    return UNIMPLEMENTED();
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    return static_cast<int>(sas.state->mixer.output_mode);
+}
+
+EXPORT(int, sceSasGetPauseState, int32_t voice) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    return sas.voice(voice).is_paused ? 1 : 0;
+}
+
+EXPORT(int, sceSasGetPreMasterPeak, int32_t *left, int32_t *right) {
+    return get_peak(host, export_name, &sas::State::pre_master_peak, left, right);
 }
 
-EXPORT(int, sceSasGetPauseState) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasGetWetPeak, int32_t *left, int32_t *right) {
+    return get_peak(host, export_name, &sas::State::wet_peak, left, right);
 }
 
-EXPORT(int, sceSasGetPreMasterPeak) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasInit, const char *config, Ptr<void> buffer, uint32_t buffer_size) {
+    return init(host, export_name, parse_config(config), buffer, buffer_size);
 }
 
-EXPORT(int, sceSasGetWetPeak) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasInitWithGrain, const char *config, uint32_t grain, Ptr<void> buffer, uint32_t buffer_size) {
+    SasConfig parsed = parse_config(config);
+    parsed.grain = grain;
+
+    return init(host, export_name, parsed, buffer, buffer_size);
 }
 
-EXPORT(int, sceSasInit) {
-    return UNIMPLEMENTED();
+static bool is_valid_rate(int32_t rate) {
+    return (rate >= 0) && (rate <= sas::ENVELOPE_MAX);
 }
 
-EXPORT(int, sceSasInitWithGrain) {
-    return UNIMPLEMENTED();
+static bool is_valid_curve_mode(uint32_t mode) {
+    return mode <= static_cast<uint32_t>(sas::CurveMode::DIRECT);
 }
 
-EXPORT(int, sceSasSetADSR) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetADSR, int32_t voice, uint32_t flags, int32_t attack, int32_t decay, int32_t sustain, int32_t release) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    const int32_t rates[4] = { attack, decay, sustain, release };
+    for (std::size_t i = 0; i < 4; i++) {
+        if ((flags & (1 << i)) && !is_valid_rate(rates[i])) {
+            return RET_ERROR(SCE_SAS_ERROR_INVALID_ADSR_RATE);
+        }
+    }
+
+    sas::Envelope &envelope = sas.voice(voice).envelope;
+    for (std::size_t i = 0; i < 4; i++) {
+        if (flags & (1 << i)) {
+            envelope.rates[i] = rates[i];
+        }
+    }
+
+    return 0;
 }
 
-EXPORT(int, sceSasSetADSRmode) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetADSRmode, int32_t voice, uint32_t flags, uint32_t attack, uint32_t decay, uint32_t sustain, uint32_t release) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    const uint32_t modes[4] = { attack, decay, sustain, release };
+    for (std::size_t i = 0; i < 4; i++) {
+        if ((flags & (1 << i)) && !is_valid_curve_mode(modes[i])) {
+            return RET_ERROR(SCE_SAS_ERROR_INVALID_ADSR_CURVE_MODE);
+        }
+    }
+
+    sas::Envelope &envelope = sas.voice(voice).envelope;
+    for (std::size_t i = 0; i < 4; i++) {
+        if (flags & (1 << i)) {
+            envelope.modes[i] = static_cast<sas::CurveMode>(modes[i]);
+        }
+    }
+
+    return 0;
 }
 
-EXPORT(int, sceSasSetDistortion) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetDistortion, int32_t voice, int32_t distortion) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if ((distortion < 0) || (distortion > sas::VOLUME_MAX)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    sas.voice(voice).distortion = distortion;
+    return 0;
 }
 
-EXPORT(int, sceSasSetEffect) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetEffect, int32_t dry, int32_t wet) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    sas.state->mixer.effect.dry = (dry != 0);
+    sas.state->mixer.effect.wet = (wet != 0);
+    return 0;
 }
 
-EXPORT(int, sceSasSetEffectParam) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetEffectParam, uint32_t delay, uint32_t feedback) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (delay > sas::MAX_EFFECT_PARAM) {
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_DELAY_TIME);
+    }
+
+    if (feedback > sas::MAX_EFFECT_PARAM) {
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_FEEDBACK);
+    }
+
+    sas::Effect &effect = sas.state->mixer.effect;
+    effect.delay = delay;
+    effect.feedback = feedback;
+    effect.configure();
+
+    return 0;
 }
 
-EXPORT(int, sceSasSetEffectType) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetEffectType, int32_t type) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if ((type < static_cast<int32_t>(sas::EffectType::OFF)) || (type > static_cast<int32_t>(sas::EffectType::PIPE))) {
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_TYPE);
+    }
+
+    sas::Effect &effect = sas.state->mixer.effect;
+    effect.type = static_cast<sas::EffectType>(type);
+    effect.configure();
+
+    return 0;
 }
 
-EXPORT(int, sceSasSetEffectVolume) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetEffectVolume, int32_t left, int32_t right) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if ((left < 0) || (left > sas::VOLUME_MAX) || (right < 0) || (right > sas::VOLUME_MAX)) {
+        return RET_ERROR(SCE_SAS_ERROR_REV_INVALID_VOLUME);
+    }
+
+    sas.state->mixer.effect.volume[0] = left;
+    sas.state->mixer.effect.volume[1] = right;
+    return 0;
 }
 
-EXPORT(int, sceSasSetGrain) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetGrain, uint32_t grain) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!is_valid_grain(grain)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_GRAIN);
+    }
+
+    sas.state->mixer.set_grain(grain);
+    return 0;
 }
 
-EXPORT(int, sceSasSetKeyOff) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetKeyOff, int32_t voice) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    sas.voice(voice).key_off();
+    return 0;
 }
 
-EXPORT(int, sceSasSetKeyOn) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetKeyOn, int32_t voice) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    sas.voice(voice).key_on();
+    return 0;
 }
 
-EXPORT(int, sceSasSetNoise) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetNoise, int32_t voice, uint32_t clock) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (clock > 63) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    sas.voice(voice).set_noise(clock);
+    return 0;
 }
 
-EXPORT(int, sceSasSetOutputmode) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetOutputmode, uint32_t mode) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (mode > static_cast<uint32_t>(sas::OutputMode::MULTICHANNEL)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_OUTPUT_MODE);
+    }
+
+    if (mode == static_cast<uint32_t>(sas::OutputMode::MULTICHANNEL)) {
+        LOG_WARN("Multichannel output is not supported, mixing as stereo");
+    }
+
+    sas.state->mixer.output_mode = static_cast<sas::OutputMode>(mode);
+    return 0;
 }
 
-EXPORT(int, sceSasSetPause) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetPause, uint32_t voice_bits, int32_t pause) {
+    SasLock sas(host);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    std::vector<sas::Voice> &voices = sas.state->mixer.voices;
+    for (std::size_t i = 0; i < voices.size(); i++) {
+        if (voice_bits & (1u << i)) {
+            voices[i].is_paused = (pause != 0);
+        }
+    }
+
+    return 0;
 }
 
-EXPORT(int, sceSasSetPitch) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetPitch, int32_t voice, int32_t pitch) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if ((pitch <= 0) || (pitch > sas::MAX_PITCH)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PITCH);
+    }
+
+    sas.voice(voice).pitch = pitch;
+    return 0;
 }
 
-EXPORT(int, sceSasSetSL) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetSL, int32_t voice, int32_t level) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!is_valid_rate(level)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    sas.voice(voice).envelope.sustain_level = level;
+    return 0;
 }
 
-EXPORT(int, sceSasSetSimpleADSR) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetSimpleADSR, int32_t voice, uint32_t adsr1, uint32_t adsr2) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    sas.voice(voice).envelope.set_simple(adsr1, adsr2);
+    return 0;
 }
 
-EXPORT(int, sceSasSetVoice) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetVoice, int32_t voice, const uint8_t *vag, uint32_t size, uint32_t loop) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!vag || (size == 0) || (size % sas::VAG_FRAME_SIZE) || (loop > 1)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    sas.voice(voice).set_vag(vag, size, loop != 0);
+    return 0;
 }
 
-EXPORT(int, sceSasSetVoicePCM) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetVoicePCM, int32_t voice, const int16_t *pcm, uint32_t samples, int32_t loop_position) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    if (!pcm) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PARAMETER);
+    }
+
+    if (samples == 0) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_PCM_SIZE);
+    }
+
+    // -1 plays the samples once
+    if ((loop_position < -1) || (loop_position >= static_cast<int32_t>(samples))) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_LOOP_POS);
+    }
+
+    sas.voice(voice).set_pcm(pcm, samples, loop_position);
+    return 0;
 }
 
-EXPORT(int, sceSasSetVolume) {
-    return UNIMPLEMENTED();
+EXPORT(int, sceSasSetVolume, int32_t voice, int32_t left, int32_t right, int32_t wet_left, int32_t wet_right) {
+    SasLock sas(host, voice);
+    if (sas.error < 0) {
+        return RET_ERROR(sas.error);
+    }
+
+    const auto is_valid_volume = [](int32_t volume) {
+        return (volume >= -sas::VOLUME_MAX) && (volume <= sas::VOLUME_MAX);
+    };
+
+    if (!is_valid_volume(left) || !is_valid_volume(right) || !is_valid_volume(wet_left) || !is_valid_volume(wet_right)) {
+        return RET_ERROR(SCE_SAS_ERROR_INVALID_VOLUME);
+    }
+
+    sas::Voice &target = sas.voice(voice);
+    target.volume[0] = left;
+    target.volume[1] = right;
+    target.wet_volume[0] = wet_left;
+    target.wet_volume[1] = wet_right;
+
+    return 0;
 }
 
 BRIDGE_IMPL(sceSasCore)
@@ -137,7 +137,8 @@ EXPORT(int, sceAvcdecCreateDecoder, uint32_t codec_type, SceAvcdecCtrl *decoder,
     SceUID handle = host.kernel.get_next_uid();
     decoder->handle = handle;
 
-    state->decoders[handle] = std::make_shared<H264DecoderState>(query->horizontal, query->vertical);
+    state->decoders[handle] = std::make_shared<H264DecoderState>(query->horizontal, query->vertical,
+        decoder->frameBuf.pBuf.cast<uint8_t>().get(host.mem), decoder->frameBuf.size);
 
     return 0;
 }
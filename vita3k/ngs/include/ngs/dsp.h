@@ -0,0 +1,149 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Effects for the interleaved stereo float blocks voices exchange. Everything works on a whole block
+// at once, with the state of both channels side by side so the inner loops stay short and branchless.
+namespace ngs::dsp {
+enum class FilterType : std::int32_t {
+    OFF = 0,
+    LOW_PASS = 1,
+    HIGH_PASS = 2,
+    BAND_PASS = 3,
+    NOTCH = 4,
+    PEAK = 5,
+    LOW_SHELF = 6,
+    HIGH_SHELF = 7,
+};
+
+// Normalized so that a0 is 1
+struct BiquadCoefficients {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+};
+
+// Audio EQ cookbook designs. Gain is linear and only used by the peak and shelf filters.
+BiquadCoefficients design_biquad(FilterType type, float sample_rate, float frequency, float q, float gain);
+
+// Magnitude of the response of the filter at the given frequency
+double biquad_response(const BiquadCoefficients &coefficients, float sample_rate, float frequency);
+
+static constexpr std::size_t MAX_BIQUAD_BANDS = 4;
+
+// Transposed direct form II biquads applied one after the other
+struct BiquadCascade {
+    BiquadCoefficients bands[MAX_BIQUAD_BANDS];
+    float z1[MAX_BIQUAD_BANDS][2] = {};
+    float z2[MAX_BIQUAD_BANDS][2] = {};
+    std::uint32_t band_count = 0;
+
+    void reset();
+    void process(float *samples, std::size_t frames);
+};
+
+struct CompressorSettings {
+    float threshold_db;
+    float ratio;
+    float attack_ms;
+    float release_ms;
+    float makeup_db;
+    bool rms;
+};
+
+// Feed-forward compressor, both channels share the same gain so the stereo image does not move
+struct Compressor {
+    float envelope = 0.0f;
+
+    float attack = 0.0f;
+    float release = 0.0f;
+    float threshold_db = 0.0f;
+    float slope = 0.0f;
+    float makeup_db = 0.0f;
+    bool rms = false;
+
+    void configure(const CompressorSettings &settings, float sample_rate);
+    void process(float *samples, std::size_t frames);
+
+    // Gain in dB applied once the envelope has settled on the given level
+    float static_gain_db(float level_db) const;
+};
+
+struct DistortionSettings {
+    float drive;
+    float clip_level;
+    float wet;
+    float dry;
+};
+
+// Cubic soft clipper, linear around zero and reaching clip_level at drive * x == clip_level
+void distort(float *samples, std::size_t count, const DistortionSettings &settings);
+
+struct ReverbSettings {
+    float decay_time; // Seconds for the tail to fall by 60 dB
+    float decay_hf_ratio; // Decay time of the high frequencies relative to decay_time
+    float pre_delay; // Seconds
+    float diffusion; // [0, 1]
+    float wet;
+    float dry;
+};
+
+// Schroeder-Moorer reverberator: parallel damped combs followed by series allpasses, tuned like
+// Freeverb. The delay lines are independent, so each one is run over the whole block before the next.
+struct Reverb {
+    static constexpr std::size_t COMB_COUNT = 4;
+    static constexpr std::size_t ALLPASS_COUNT = 2;
+
+    // Large enough for the tuning below up to 48 kHz
+    static constexpr std::size_t MAX_COMB_LENGTH = 1600;
+    static constexpr std::size_t MAX_ALLPASS_LENGTH = 640;
+    static constexpr std::size_t MAX_PRE_DELAY = 4800;
+
+    struct Line {
+        std::uint32_t length;
+        std::uint32_t position;
+    };
+
+    float combs[COMB_COUNT][2][MAX_COMB_LENGTH];
+    Line comb_lines[COMB_COUNT][2];
+    float comb_feedback[COMB_COUNT][2];
+    float comb_filter[COMB_COUNT][2];
+
+    float allpasses[ALLPASS_COUNT][2][MAX_ALLPASS_LENGTH];
+    Line allpass_lines[ALLPASS_COUNT][2];
+
+    float pre_delay[MAX_PRE_DELAY];
+    Line pre_delay_line;
+
+    float damping;
+    float allpass_gain;
+    float wet;
+    float dry;
+    float rate;
+
+    // The delay lines are only cleared when the sample rate changes
+    void configure(const ReverbSettings &settings, float sample_rate);
+    void reset();
+    void process(float *samples, std::size_t frames);
+};
+} // namespace ngs::dsp
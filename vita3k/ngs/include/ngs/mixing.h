@@ -0,0 +1,45 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels for the interleaved stereo float buffers voices exchange. The vectorized versions give
+// exactly the same results as the scalar ones, which are also used for the leftover samples.
+namespace ngs {
+// Mix frames of src into dest through the patch volume matrix, clamping the result to [-1, 1]
+void mix_stereo(float *dest, const float *src, const float (&matrix)[2][2], std::size_t frames);
+void mix_stereo_scalar(float *dest, const float *src, const float (&matrix)[2][2], std::size_t frames);
+
+void apply_gain(float *samples, float gain, std::size_t count);
+void apply_gain_scalar(float *samples, float gain, std::size_t count);
+
+// Saturating, rounds toward zero
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count);
+void float_to_s16_scalar(const float *src, std::int16_t *dest, std::size_t count);
+
+void s16_to_float(const std::int16_t *src, float *dest, std::size_t count);
+void s16_to_float_scalar(const std::int16_t *src, float *dest, std::size_t count);
+
+void interleave(const float *left, const float *right, float *dest, std::size_t frames);
+void interleave_scalar(const float *left, const float *right, float *dest, std::size_t frames);
+
+void deinterleave(const float *src, float *left, float *right, std::size_t frames);
+void deinterleave_scalar(const float *src, float *left, float *right, std::size_t frames);
+} // namespace ngs
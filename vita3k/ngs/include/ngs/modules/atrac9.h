@@ -20,8 +20,6 @@
 #include <codec/state.h>
 #include <ngs/system.h>
 
-struct SwrContext;
-
 namespace ngs::atrac9 {
 enum {
     SCE_NGS_AT9_END_OF_DATA = 0,
@@ -76,8 +74,8 @@ struct State {
     std::int8_t current_loop_count = 0;
     std::uint32_t decoded_samples_pending = 0;
     std::uint32_t decoded_passed = 0;
-    // used if the input must be resampled
-    SwrContext *swr = nullptr;
+    // used if the input must be resampled, owned by the resampler pool of the system
+    Resampler *resampler = nullptr;
     // set to true if all the input has been read but not all data has been processed
     bool is_finished = false;
 };
@@ -88,20 +86,18 @@ private:
     std::uint32_t last_config;
     std::vector<uint8_t> temp_buffer;
 
-    static SwrContext *swr_mono_to_stereo;
-    static SwrContext *swr_stereo;
-
     // return false if data could not be decoded (error or no more data available)
-    bool decode_more_data(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, const Parameters *params, State *state, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock);
+    bool decode_more_data(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, const Parameters *params, State *state, std::unique_lock<std::mutex> &voice_lock);
 
 public:
     explicit Module();
 
-    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) override;
     std::uint32_t module_id() const override { return 0x5CAA; }
     std::size_t get_buffer_parameter_size() const override;
     void on_state_change(ModuleData &v, const VoiceState previous) override;
     void on_param_change(const MemState &mem, ModuleData &data) override;
+    void on_release(ModuleData &data) override;
 };
 
 void get_buffer_parameter(std::uint32_t start_sample, std::uint32_t num_samples, std::uint32_t info, SkipBufferInfo &parameter);
@@ -0,0 +1,53 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <ngs/dsp.h>
+#include <ngs/system.h>
+
+namespace ngs::compressor {
+enum DetectionMode : SceInt32 {
+    DETECTION_PEAK = 0,
+    DETECTION_RMS = 1,
+};
+
+struct Parameters {
+    ngs::ParametersDescriptor descriptor;
+    SceFloat32 threshold; // dB
+    SceFloat32 ratio;
+    SceFloat32 attack_time; // Milliseconds
+    SceFloat32 release_time; // Milliseconds
+    SceFloat32 makeup_gain; // dB
+    DetectionMode detection;
+};
+
+struct State {
+    Parameters last_params;
+    bool configured = false;
+    dsp::Compressor compressor;
+};
+
+struct Module : public ngs::Module {
+public:
+    explicit Module();
+
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) override;
+    std::size_t get_buffer_parameter_size() const override;
+    void on_state_change(ModuleData &data, const VoiceState previous) override;
+};
+} // namespace ngs::compressor
@@ -17,15 +17,37 @@
 
 #pragma once
 
+#include <ngs/dsp.h>
 #include <ngs/system.h>
 
 namespace ngs::equalizer {
+static constexpr std::size_t MAX_FILTERS = dsp::MAX_BIQUAD_BANDS;
+
+struct FilterParameters {
+    SceInt32 type; // dsp::FilterType
+    SceFloat32 frequency;
+    SceFloat32 resonance;
+    SceFloat32 gain;
+};
+
+struct Parameters {
+    ngs::ParametersDescriptor descriptor;
+    FilterParameters filters[MAX_FILTERS];
+};
+
+struct State {
+    Parameters last_params;
+    bool configured = false;
+    dsp::BiquadCascade filters;
+};
+
 struct Module : public ngs::Module {
 public:
     explicit Module();
 
-    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) override;
     std::uint32_t module_id() const override { return 0x5CEC; }
     std::size_t get_buffer_parameter_size() const override;
+    void on_state_change(ModuleData &data, const VoiceState previous) override;
 };
 } // namespace ngs::equalizer
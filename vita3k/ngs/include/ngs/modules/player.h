@@ -20,8 +20,6 @@
 #include <codec/state.h>
 #include <ngs/system.h>
 
-struct SwrContext;
-
 namespace ngs::player {
 enum {
     SCE_NGS_PLAYER_END_OF_DATA = 0,
@@ -58,8 +56,8 @@ struct State {
     std::uint32_t decoded_samples_passed = 0;
     // needed for he_adpcm because a same decoder can be used for many voices
     std::int32_t adpcm_history[4] = { 0, 0, 0, 0 };
-    // used if the input must be resampled
-    SwrContext *swr = nullptr;
+    // used if the input must be resampled, owned by the resampler pool of the system
+    Resampler *resampler = nullptr;
 };
 
 struct Parameters {
@@ -98,10 +96,11 @@ private:
 
 public:
     explicit Module();
-    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) override;
     std::uint32_t module_id() const override { return 0x5CE6; }
     std::size_t get_buffer_parameter_size() const override;
     void on_state_change(ModuleData &v, const VoiceState previous) override;
     void on_param_change(const MemState &mem, ModuleData &data) override;
+    void on_release(ModuleData &data) override;
 };
 } // namespace ngs::player
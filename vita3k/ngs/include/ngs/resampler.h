@@ -0,0 +1,101 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ngs {
+enum class ResamplerFormat : std::uint8_t {
+    S16,
+    F32,
+};
+
+struct ResamplerKey {
+    std::int32_t in_rate;
+    std::int32_t out_rate;
+    std::int32_t channels; // 1 or 2
+    ResamplerFormat format;
+
+    bool operator==(const ResamplerKey &rhs) const = default;
+};
+
+struct ResamplerKeyHash {
+    std::size_t operator()(const ResamplerKey &key) const;
+};
+
+// Converts interleaved samples in the format of its key to interleaved stereo float at the output rate.
+// Keeps the history of the stream it converts, so one instance must only ever be fed by one voice.
+struct Resampler {
+    const ResamplerKey key;
+
+    explicit Resampler(const ResamplerKey &key)
+        : key(key) {}
+    virtual ~Resampler() = default;
+
+    // Most frames convert can produce from the given amount of input
+    virtual std::int32_t get_out_frames(std::int32_t in_frames) const = 0;
+    // Returns the amount of frames written
+    virtual std::int32_t convert(const std::uint8_t *src, std::int32_t in_frames, float *dest, std::int32_t max_out_frames) = 0;
+    // Forget the history, like a freshly created resampler
+    virtual void reset() = 0;
+};
+
+// Linear interpolation, no filtering at all
+struct LinearResampler : public Resampler {
+    explicit LinearResampler(const ResamplerKey &key);
+
+    std::int32_t get_out_frames(std::int32_t in_frames) const override;
+    std::int32_t convert(const std::uint8_t *src, std::int32_t in_frames, float *dest, std::int32_t max_out_frames) override;
+    void reset() override;
+
+private:
+    double step;
+    // Position of the next output frame, 0 being the last frame of the previous call
+    double position;
+    float last[2];
+};
+
+// Linear interpolation where it is good enough, FFmpeg's filter otherwise
+std::unique_ptr<Resampler> create_resampler(const ResamplerKey &key);
+
+// Owns every resampler of an NGS system. Voices keep the one they were handed for as long as its key
+// matches what they play, so voices at different rates never reconfigure each other's resampler.
+struct ResamplerPool {
+    // Returns a resampler for the key, reusing one that was released if possible
+    Resampler *acquire(const ResamplerKey &key);
+    void release(Resampler *resampler);
+
+    // Swap the resampler of a voice for one matching the key, if it does not already match
+    Resampler *rebind(Resampler *&current, const ResamplerKey &key);
+
+    std::size_t size();
+
+    // Linear interpolation is only used for rates within a sixteenth of the output rate
+    static bool is_linear_enough(const ResamplerKey &key);
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Resampler>> resamplers;
+    std::unordered_map<ResamplerKey, std::vector<Resampler *>, ResamplerKeyHash> available;
+};
+} // namespace ngs
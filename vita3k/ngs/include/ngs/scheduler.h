@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <util/thread_pool.h>
 #include <util/types.h>
 
 #include <mem/ptr.h>
@@ -24,8 +25,10 @@
 #include <thread>
 
 #include <condition_variable>
+#include <memory>
 #include <optional>
 #include <queue>
+#include <unordered_map>
 #include <vector>
 
 struct MemState;
@@ -58,6 +61,37 @@ struct OperationPending {
     };
 };
 
+// Voices of a rack share its modules, so they are always processed in order by the same thread
+struct VoiceGroup {
+    Rack *rack;
+    std::vector<Voice *> voices;
+
+    // Position of each voice in the queue
+    std::vector<std::size_t> positions;
+};
+
+// Voice which reached its end while its group was processed, its callback is run once the stage is done
+struct FinishedVoice {
+    std::size_t position;
+    Voice *voice;
+    std::uint32_t module_id;
+};
+
+// A voice only receives data from voices of earlier stages, so the groups of a stage can run in parallel
+struct VoiceStage {
+    std::vector<VoiceGroup> groups;
+};
+
+// Snapshot of the patch topology between the queued voices, only rebuilt when the queue or a patch changes
+struct VoiceGraph {
+    std::vector<Voice *> voices;
+    std::vector<VoiceStage> stages;
+
+    // Voices patched into each voice, in queue order. Inputs are mixed in this order no matter
+    // how many threads are used, so the output is the same as when running serially.
+    std::unordered_map<Voice *, std::vector<Voice *>> sources;
+};
+
 struct VoiceScheduler {
     std::vector<Voice *> queue;
     std::queue<OperationPending> operations_pending;
@@ -66,7 +100,16 @@ struct VoiceScheduler {
     std::condition_variable_any condvar;
     bool is_updating = false;
 
+    // Guest callbacks share the calling thread, only one voice can run one at a time
+    std::mutex callback_mutex;
+
 protected:
+    std::shared_ptr<const VoiceGraph> graph;
+    bool graph_dirty = true;
+
+    // Null when voices are processed on the updating thread only
+    std::unique_ptr<util::ThreadPool> workers;
+
     bool deque_voice_impl(Voice *voice);
     void deque_insert(const MemState &mem, Voice *voice);
 
@@ -74,9 +117,16 @@ protected:
 
     std::int32_t get_position(Voice *v);
 
+    void rebuild_graph(const MemState &mem);
+    void process_group(KernelState &kern, const MemState &mem, const SceUID thread_id, const VoiceGraph &current, const VoiceGroup &group, std::vector<FinishedVoice> &finished);
+    void finish_voices(KernelState &kern, const MemState &mem, const SceUID thread_id, std::vector<std::vector<FinishedVoice>> &finished);
+
 public:
     bool deque_voice(Voice *voice);
 
+    // Zero picks a count from the host core count, one processes everything on the updating thread
+    void set_thread_count(std::size_t count);
+
     bool play(const MemState &mem, Voice *voice);
     bool pause(Voice *voice);
     bool resume(const MemState &mem, Voice *voice);
@@ -27,6 +27,7 @@
 
 #include <mem/mempool.h>
 #include <ngs/common.h>
+#include <ngs/resampler.h>
 #include <ngs/scheduler.h>
 
 struct MemState;
@@ -140,11 +141,13 @@ struct Module {
         : buss_type(buss_type) {}
     virtual ~Module() = default;
 
-    virtual bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) = 0;
+    virtual bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) = 0;
     virtual std::uint32_t module_id() const { return 0; }
     virtual std::size_t get_buffer_parameter_size() const = 0;
     virtual void on_state_change(ModuleData &v, const VoiceState previous) {}
     virtual void on_param_change(const MemState &mem, ModuleData &data) {}
+    // Called for every voice of the rack when the rack is released, before the voice is destroyed
+    virtual void on_release(ModuleData &data) {}
 };
 
 static constexpr std::uint32_t MAX_VOICE_OUTPUT = 8;
@@ -276,6 +279,7 @@ struct System : public MempoolObject {
     std::int32_t sample_rate;
 
     VoiceScheduler voice_scheduler;
+    ResamplerPool resamplers;
 
     explicit System(const Ptr<void> memspace, const std::uint32_t memspace_size);
     static std::uint32_t get_required_memspace_size(SystemInitParameters *parameters);
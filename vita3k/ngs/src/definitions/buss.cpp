@@ -0,0 +1,56 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/definitions/buss.h>
+#include <ngs/modules/compressor.h>
+#include <ngs/modules/distortion.h>
+#include <ngs/modules/equalizer.h>
+#include <ngs/modules/reverb.h>
+
+namespace ngs::buss {
+void EqualizerVoiceDefinition::new_modules(std::vector<std::unique_ptr<ngs::Module>> &mods) {
+    mods.push_back(std::make_unique<ngs::equalizer::Module>());
+}
+
+std::size_t EqualizerVoiceDefinition::get_total_buffer_parameter_size() const {
+    return sizeof(ngs::equalizer::Parameters);
+}
+
+void ReverbVoiceDefinition::new_modules(std::vector<std::unique_ptr<ngs::Module>> &mods) {
+    mods.push_back(std::make_unique<ngs::reverb::Module>());
+}
+
+std::size_t ReverbVoiceDefinition::get_total_buffer_parameter_size() const {
+    return sizeof(ngs::reverb::Parameters);
+}
+
+void CompressorVoiceDefinition::new_modules(std::vector<std::unique_ptr<ngs::Module>> &mods) {
+    mods.push_back(std::make_unique<ngs::compressor::Module>());
+}
+
+std::size_t CompressorVoiceDefinition::get_total_buffer_parameter_size() const {
+    return sizeof(ngs::compressor::Parameters);
+}
+
+void DistortionVoiceDefinition::new_modules(std::vector<std::unique_ptr<ngs::Module>> &mods) {
+    mods.push_back(std::make_unique<ngs::distortion::Module>());
+}
+
+std::size_t DistortionVoiceDefinition::get_total_buffer_parameter_size() const {
+    return sizeof(ngs::distortion::Parameters);
+}
+} // namespace ngs::buss
@@ -17,6 +17,7 @@
 
 #include <ngs/definitions/scream.h>
 #include <ngs/modules/atrac9.h>
+#include <ngs/modules/distortion.h>
 #include <ngs/modules/equalizer.h>
 #include <ngs/modules/player.h>
 #include <util/log.h>
@@ -29,7 +30,7 @@ void PlayerVoiceDefinition::new_modules(std::vector<std::unique_ptr<ngs::Module>
     // I guess the scream modules are the same as the usual ones
     mods.push_back(std::make_unique<ngs::player::Module>());
     mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_ENVELOPE
-    mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_DISTORTION
+    mods.push_back(std::make_unique<ngs::distortion::Module>()); // SCE_NGS_SCREAM_VOICE_DISTORTION
     mods.push_back(std::make_unique<ngs::equalizer::Module>()); // SCE_NGS_SCREAM_VOICE_EQ
     mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_SEND_1_FILTER
     mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_SEND_2_FILTER
@@ -44,7 +45,7 @@ void Atrac9VoiceDefinition::new_modules(std::vector<std::unique_ptr<ngs::Module>
 
     mods.push_back(std::make_unique<ngs::atrac9::Module>());
     mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_ENVELOPE
-    mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_DISTORTION
+    mods.push_back(std::make_unique<ngs::distortion::Module>()); // SCE_NGS_SCREAM_VOICE_DISTORTION
     mods.push_back(std::make_unique<ngs::equalizer::Module>()); // SCE_NGS_SCREAM_VOICE_EQ
     mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_SEND_1_FILTER
     mods.push_back(nullptr); // SCE_NGS_SCREAM_VOICE_SEND_2_FILTER
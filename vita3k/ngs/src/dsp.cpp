@@ -0,0 +1,383 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <numbers>
+
+namespace ngs::dsp {
+BiquadCoefficients design_biquad(FilterType type, float sample_rate, float frequency, float q, float gain) {
+    if ((type == FilterType::OFF) || (sample_rate <= 0.0f)) {
+        return {};
+    }
+
+    // Past Nyquist the designs fold back, and a null Q divides by zero
+    frequency = std::clamp(frequency, 1.0f, sample_rate * 0.49f);
+    q = std::max(q, 0.01f);
+    gain = std::max(gain, 1e-5f);
+
+    const double w0 = 2.0 * std::numbers::pi * frequency / sample_rate;
+    const double cos_w0 = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a = std::sqrt(static_cast<double>(gain));
+    const double sqrt_a_alpha = 2.0 * std::sqrt(a) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (type) {
+    case FilterType::LOW_PASS:
+        b0 = (1.0 - cos_w0) / 2.0;
+        b1 = 1.0 - cos_w0;
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+
+    case FilterType::HIGH_PASS:
+        b0 = (1.0 + cos_w0) / 2.0;
+        b1 = -(1.0 + cos_w0);
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+
+    case FilterType::BAND_PASS:
+        // Constant 0 dB peak gain
+        b0 = alpha;
+        b1 = 0.0;
+        b2 = -alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+
+    case FilterType::NOTCH:
+        b0 = 1.0;
+        b1 = -2.0 * cos_w0;
+        b2 = 1.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha;
+        break;
+
+    case FilterType::PEAK:
+        b0 = 1.0 + alpha * a;
+        b1 = -2.0 * cos_w0;
+        b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a;
+        a1 = -2.0 * cos_w0;
+        a2 = 1.0 - alpha / a;
+        break;
+
+    case FilterType::LOW_SHELF:
+        b0 = a * ((a + 1.0) - (a - 1.0) * cos_w0 + sqrt_a_alpha);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cos_w0);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cos_w0 - sqrt_a_alpha);
+        a0 = (a + 1.0) + (a - 1.0) * cos_w0 + sqrt_a_alpha;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cos_w0);
+        a2 = (a + 1.0) + (a - 1.0) * cos_w0 - sqrt_a_alpha;
+        break;
+
+    case FilterType::HIGH_SHELF:
+        b0 = a * ((a + 1.0) + (a - 1.0) * cos_w0 + sqrt_a_alpha);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cos_w0);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cos_w0 - sqrt_a_alpha);
+        a0 = (a + 1.0) - (a - 1.0) * cos_w0 + sqrt_a_alpha;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cos_w0);
+        a2 = (a + 1.0) - (a - 1.0) * cos_w0 - sqrt_a_alpha;
+        break;
+
+    default:
+        return {};
+    }
+
+    return {
+        static_cast<float>(b0 / a0),
+        static_cast<float>(b1 / a0),
+        static_cast<float>(b2 / a0),
+        static_cast<float>(a1 / a0),
+        static_cast<float>(a2 / a0),
+    };
+}
+
+double biquad_response(const BiquadCoefficients &coefficients, float sample_rate, float frequency) {
+    const double w = 2.0 * std::numbers::pi * frequency / sample_rate;
+    const std::complex<double> z1 = std::polar(1.0, -w);
+    const std::complex<double> z2 = z1 * z1;
+
+    const std::complex<double> numerator = static_cast<double>(coefficients.b0) + static_cast<double>(coefficients.b1) * z1 + static_cast<double>(coefficients.b2) * z2;
+    const std::complex<double> denominator = 1.0 + static_cast<double>(coefficients.a1) * z1 + static_cast<double>(coefficients.a2) * z2;
+
+    return std::abs(numerator / denominator);
+}
+
+void BiquadCascade::reset() {
+    std::memset(z1, 0, sizeof(z1));
+    std::memset(z2, 0, sizeof(z2));
+}
+
+void BiquadCascade::process(float *samples, std::size_t frames) {
+    // Band by band over the whole block, so the coefficients stay in registers and the only
+    // dependency chain left is the one of the filter itself
+    for (std::uint32_t band = 0; band < band_count; band++) {
+        const BiquadCoefficients c = bands[band];
+        float s1[2] = { z1[band][0], z1[band][1] };
+        float s2[2] = { z2[band][0], z2[band][1] };
+
+        for (std::size_t i = 0; i < frames; i++) {
+            for (int ch = 0; ch < 2; ch++) {
+                const float x = samples[i * 2 + ch];
+                const float y = c.b0 * x + s1[ch];
+                s1[ch] = c.b1 * x - c.a1 * y + s2[ch];
+                s2[ch] = c.b2 * x - c.a2 * y;
+                samples[i * 2 + ch] = y;
+            }
+        }
+
+        z1[band][0] = s1[0];
+        z1[band][1] = s1[1];
+        z2[band][0] = s2[0];
+        z2[band][1] = s2[1];
+    }
+}
+
+static float time_constant(float ms, float sample_rate) {
+    if (ms <= 0.0f) {
+        return 0.0f;
+    }
+
+    return std::exp(-1.0f / (ms * 0.001f * sample_rate));
+}
+
+void Compressor::configure(const CompressorSettings &settings, float sample_rate) {
+    attack = time_constant(settings.attack_ms, sample_rate);
+    release = time_constant(settings.release_ms, sample_rate);
+    threshold_db = settings.threshold_db;
+    slope = 1.0f / std::max(settings.ratio, 1.0f) - 1.0f;
+    makeup_db = settings.makeup_db;
+
+    // The envelope holds power instead of amplitude when switching to RMS
+    if (rms != settings.rms) {
+        envelope = 0.0f;
+    }
+
+    rms = settings.rms;
+}
+
+float Compressor::static_gain_db(float level_db) const {
+    const float over = std::max(level_db - threshold_db, 0.0f);
+    return over * slope + makeup_db;
+}
+
+void Compressor::process(float *samples, std::size_t frames) {
+    // Powers and amplitudes under this are treated as silence, this keeps the logarithm finite
+    constexpr float silence = 1e-10f;
+    const float level_scale = rms ? 10.0f : 20.0f;
+
+    float env = envelope;
+
+    for (std::size_t i = 0; i < frames; i++) {
+        const float left = samples[i * 2];
+        const float right = samples[i * 2 + 1];
+
+        const float level = rms ? (left * left + right * right) * 0.5f : std::max(std::abs(left), std::abs(right));
+        const float coefficient = (level > env) ? attack : release;
+        env = level + coefficient * (env - level);
+
+        const float level_db = level_scale * std::log10(std::max(env, silence));
+        const float gain = std::pow(10.0f, static_gain_db(level_db) / 20.0f);
+
+        samples[i * 2] = left * gain;
+        samples[i * 2 + 1] = right * gain;
+    }
+
+    envelope = env;
+}
+
+void distort(float *samples, std::size_t count, const DistortionSettings &settings) {
+    const float clip = (settings.clip_level > 0.0f) ? settings.clip_level : 1.0f;
+    const float scale = settings.drive / clip;
+
+    for (std::size_t i = 0; i < count; i++) {
+        const float x = samples[i];
+        const float driven = std::clamp(x * scale, -1.0f, 1.0f);
+        const float shaped = clip * (1.5f * driven - 0.5f * driven * driven * driven);
+
+        samples[i] = settings.wet * shaped + settings.dry * x;
+    }
+}
+
+// Freeverb tuning at 44.1 kHz, the right channel is offset to decorrelate both sides
+static constexpr std::uint32_t COMB_TUNING[Reverb::COMB_COUNT] = { 1116, 1188, 1277, 1356 };
+static constexpr std::uint32_t ALLPASS_TUNING[Reverb::ALLPASS_COUNT] = { 556, 441 };
+static constexpr std::uint32_t STEREO_SPREAD = 23;
+static constexpr float TUNING_RATE = 44100.0f;
+
+// The combs ring up to 1 / (1 - feedback), so the input has to be scaled down a lot
+static constexpr float REVERB_INPUT_GAIN = 0.03f;
+
+static std::uint32_t scale_length(std::uint32_t length, float sample_rate, std::size_t max_length) {
+    const auto scaled = static_cast<std::uint32_t>(std::lround(length * sample_rate / TUNING_RATE));
+    return std::clamp<std::uint32_t>(scaled, 1, static_cast<std::uint32_t>(max_length));
+}
+
+void Reverb::configure(const ReverbSettings &settings, float sample_rate) {
+    // Only the pre-delay depends on the settings, so the tail survives parameter changes
+    const bool lengths_changed = (rate != sample_rate);
+    rate = sample_rate;
+
+    const float decay_time = std::max(settings.decay_time, 0.01f);
+
+    for (std::size_t comb = 0; comb < COMB_COUNT; comb++) {
+        for (std::size_t ch = 0; ch < 2; ch++) {
+            const std::uint32_t length = scale_length(COMB_TUNING[comb] + static_cast<std::uint32_t>(ch) * STEREO_SPREAD, sample_rate, MAX_COMB_LENGTH);
+            comb_lines[comb][ch].length = length;
+
+            // Each trip around the loop must lose length / (decay_time * sample_rate) of 60 dB
+            comb_feedback[comb][ch] = std::pow(10.0f, -3.0f * static_cast<float>(length) / (decay_time * sample_rate));
+        }
+    }
+
+    for (std::size_t allpass = 0; allpass < ALLPASS_COUNT; allpass++) {
+        for (std::size_t ch = 0; ch < 2; ch++) {
+            allpass_lines[allpass][ch].length = scale_length(ALLPASS_TUNING[allpass] + static_cast<std::uint32_t>(ch) * STEREO_SPREAD, sample_rate, MAX_ALLPASS_LENGTH);
+        }
+    }
+
+    pre_delay_line.length = std::min(static_cast<std::uint32_t>(std::max(settings.pre_delay, 0.0f) * sample_rate), static_cast<std::uint32_t>(MAX_PRE_DELAY));
+    if (pre_delay_line.position >= pre_delay_line.length) {
+        pre_delay_line.position = 0;
+    }
+
+    // High frequencies die out faster as the ratio goes under 1, above 1 they are left alone
+    damping = std::clamp(1.0f - settings.decay_hf_ratio, 0.0f, 0.9f);
+    allpass_gain = 0.5f * std::clamp(settings.diffusion, 0.0f, 1.0f);
+    wet = settings.wet;
+    dry = settings.dry;
+
+    if (lengths_changed) {
+        reset();
+    }
+}
+
+void Reverb::reset() {
+    std::memset(combs, 0, sizeof(combs));
+    std::memset(comb_filter, 0, sizeof(comb_filter));
+    std::memset(allpasses, 0, sizeof(allpasses));
+    std::memset(pre_delay, 0, sizeof(pre_delay));
+
+    for (auto &lines : comb_lines) {
+        lines[0].position = lines[1].position = 0;
+    }
+
+    for (auto &lines : allpass_lines) {
+        lines[0].position = lines[1].position = 0;
+    }
+
+    pre_delay_line.position = 0;
+}
+
+void Reverb::process(float *samples, std::size_t frames) {
+    constexpr std::size_t CHUNK = 256;
+
+    float input[CHUNK];
+    float output[2][CHUNK];
+
+    for (std::size_t offset = 0; offset < frames; offset += CHUNK) {
+        const std::size_t count = std::min(CHUNK, frames - offset);
+        float *block = samples + offset * 2;
+
+        for (std::size_t i = 0; i < count; i++) {
+            input[i] = (block[i * 2] + block[i * 2 + 1]) * REVERB_INPUT_GAIN;
+        }
+
+        if (pre_delay_line.length != 0) {
+            std::uint32_t position = pre_delay_line.position;
+
+            for (std::size_t i = 0; i < count; i++) {
+                const float delayed = pre_delay[position];
+                pre_delay[position] = input[i];
+                input[i] = delayed;
+
+                if (++position == pre_delay_line.length) {
+                    position = 0;
+                }
+            }
+
+            pre_delay_line.position = position;
+        }
+
+        std::memset(output, 0, sizeof(output));
+
+        for (std::size_t comb = 0; comb < COMB_COUNT; comb++) {
+            for (std::size_t ch = 0; ch < 2; ch++) {
+                float *buffer = combs[comb][ch];
+                const std::uint32_t length = comb_lines[comb][ch].length;
+                std::uint32_t position = comb_lines[comb][ch].position;
+                const float feedback = comb_feedback[comb][ch];
+                float filter = comb_filter[comb][ch];
+
+                for (std::size_t i = 0; i < count; i++) {
+                    const float delayed = buffer[position];
+                    filter = delayed * (1.0f - damping) + filter * damping;
+                    buffer[position] = input[i] + filter * feedback;
+                    output[ch][i] += delayed;
+
+                    if (++position == length) {
+                        position = 0;
+                    }
+                }
+
+                comb_lines[comb][ch].position = position;
+                comb_filter[comb][ch] = filter;
+            }
+        }
+
+        for (std::size_t allpass = 0; allpass < ALLPASS_COUNT; allpass++) {
+            for (std::size_t ch = 0; ch < 2; ch++) {
+                float *buffer = allpasses[allpass][ch];
+                const std::uint32_t length = allpass_lines[allpass][ch].length;
+                std::uint32_t position = allpass_lines[allpass][ch].position;
+
+                for (std::size_t i = 0; i < count; i++) {
+                    const float delayed = buffer[position];
+                    const float in = output[ch][i];
+                    buffer[position] = in + delayed * allpass_gain;
+                    output[ch][i] = delayed - in;
+
+                    if (++position == length) {
+                        position = 0;
+                    }
+                }
+
+                allpass_lines[allpass][ch].position = position;
+            }
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            block[i * 2] = block[i * 2] * dry + output[0][i] * wet;
+            block[i * 2 + 1] = block[i * 2 + 1] * dry + output[1][i] * wet;
+        }
+    }
+}
+} // namespace ngs::dsp
@@ -0,0 +1,318 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/mixing.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIXING_USE_SSE2
+#ifdef __AVX2__
+#include <immintrin.h>
+#define MIXING_USE_AVX2
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIXING_USE_NEON
+#endif
+
+namespace ngs {
+static constexpr float S16_SCALE = 32768.0f;
+
+// The vector min/max below are ordered so that they match std::clamp, NaN included
+void mix_stereo_scalar(float *dest, const float *src, const float (&matrix)[2][2], std::size_t frames) {
+    for (std::size_t k = 0; k < frames; k++) {
+        const float left = src[k * 2];
+        const float right = src[k * 2 + 1];
+
+        dest[k * 2] = std::clamp(dest[k * 2] + left * matrix[0][0] + right * matrix[1][0], -1.0f, 1.0f);
+        dest[k * 2 + 1] = std::clamp(dest[k * 2 + 1] + left * matrix[0][1] + right * matrix[1][1], -1.0f, 1.0f);
+    }
+}
+
+void apply_gain_scalar(float *samples, float gain, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        samples[i] *= gain;
+    }
+}
+
+void float_to_s16_scalar(const float *src, std::int16_t *dest, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        dest[i] = static_cast<std::int16_t>(std::clamp(src[i] * S16_SCALE, -32768.0f, 32767.0f));
+    }
+}
+
+void s16_to_float_scalar(const std::int16_t *src, float *dest, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        dest[i] = static_cast<float>(src[i]) * (1.0f / S16_SCALE);
+    }
+}
+
+void interleave_scalar(const float *left, const float *right, float *dest, std::size_t frames) {
+    for (std::size_t k = 0; k < frames; k++) {
+        dest[k * 2] = left[k];
+        dest[k * 2 + 1] = right[k];
+    }
+}
+
+void deinterleave_scalar(const float *src, float *left, float *right, std::size_t frames) {
+    for (std::size_t k = 0; k < frames; k++) {
+        left[k] = src[k * 2];
+        right[k] = src[k * 2 + 1];
+    }
+}
+
+#ifdef MIXING_USE_SSE2
+void mix_stereo(float *dest, const float *src, const float (&matrix)[2][2], std::size_t frames) {
+    std::size_t k = 0;
+
+#ifdef MIXING_USE_AVX2
+    {
+        // Shuffles stay within 128-bit lanes, so each lane is laid out like the SSE2 version
+        const __m256 left_gains = _mm256_setr_ps(matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1]);
+        const __m256 right_gains = _mm256_setr_ps(matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1]);
+        const __m256 low = _mm256_set1_ps(-1.0f);
+        const __m256 high = _mm256_set1_ps(1.0f);
+
+        for (; k + 4 <= frames; k += 4) {
+            const __m256 input = _mm256_loadu_ps(src + k * 2);
+            const __m256 lefts = _mm256_shuffle_ps(input, input, _MM_SHUFFLE(2, 2, 0, 0));
+            const __m256 rights = _mm256_shuffle_ps(input, input, _MM_SHUFFLE(3, 3, 1, 1));
+
+            __m256 mixed = _mm256_add_ps(_mm256_loadu_ps(dest + k * 2), _mm256_mul_ps(lefts, left_gains));
+            mixed = _mm256_add_ps(mixed, _mm256_mul_ps(rights, right_gains));
+            mixed = _mm256_min_ps(high, _mm256_max_ps(low, mixed));
+
+            _mm256_storeu_ps(dest + k * 2, mixed);
+        }
+    }
+#endif
+
+    const __m128 left_gains = _mm_setr_ps(matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1]);
+    const __m128 right_gains = _mm_setr_ps(matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1]);
+    const __m128 low = _mm_set1_ps(-1.0f);
+    const __m128 high = _mm_set1_ps(1.0f);
+
+    // Two frames at a time. Left and right are broadcast to both channels so the sum is done
+    // in the same order as the scalar code for each of them.
+    for (; k + 2 <= frames; k += 2) {
+        const __m128 input = _mm_loadu_ps(src + k * 2);
+        const __m128 lefts = _mm_shuffle_ps(input, input, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 rights = _mm_shuffle_ps(input, input, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128 mixed = _mm_add_ps(_mm_loadu_ps(dest + k * 2), _mm_mul_ps(lefts, left_gains));
+        mixed = _mm_add_ps(mixed, _mm_mul_ps(rights, right_gains));
+        mixed = _mm_min_ps(high, _mm_max_ps(low, mixed));
+
+        _mm_storeu_ps(dest + k * 2, mixed);
+    }
+
+    mix_stereo_scalar(dest + k * 2, src + k * 2, matrix, frames - k);
+}
+
+void apply_gain(float *samples, float gain, std::size_t count) {
+    std::size_t i = 0;
+
+#ifdef MIXING_USE_AVX2
+    const __m256 gains8 = _mm256_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), gains8));
+    }
+#endif
+
+    const __m128 gains = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gains));
+    }
+
+    apply_gain_scalar(samples + i, gain, count - i);
+}
+
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count) {
+    const __m128 scale = _mm_set1_ps(S16_SCALE);
+    const __m128 low = _mm_set1_ps(-32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 first = _mm_min_ps(high, _mm_max_ps(low, _mm_mul_ps(_mm_loadu_ps(src + i), scale)));
+        const __m128 second = _mm_min_ps(high, _mm_max_ps(low, _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale)));
+
+        // Already in range, the saturation of the pack never kicks in
+        const __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(first), _mm_cvttps_epi32(second));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), packed);
+    }
+
+    float_to_s16_scalar(src + i, dest + i, count - i);
+}
+
+void s16_to_float(const std::int16_t *src, float *dest, std::size_t count) {
+    const __m128 scale = _mm_set1_ps(1.0f / S16_SCALE);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+        // Put each value in the upper half of a 32-bit lane, then shift it down keeping the sign
+        const __m128i first = _mm_srai_epi32(_mm_unpacklo_epi16(input, input), 16);
+        const __m128i second = _mm_srai_epi32(_mm_unpackhi_epi16(input, input), 16);
+
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(first), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(second), scale));
+    }
+
+    s16_to_float_scalar(src + i, dest + i, count - i);
+}
+
+void interleave(const float *left, const float *right, float *dest, std::size_t frames) {
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const __m128 lefts = _mm_loadu_ps(left + k);
+        const __m128 rights = _mm_loadu_ps(right + k);
+
+        _mm_storeu_ps(dest + k * 2, _mm_unpacklo_ps(lefts, rights));
+        _mm_storeu_ps(dest + k * 2 + 4, _mm_unpackhi_ps(lefts, rights));
+    }
+
+    interleave_scalar(left + k, right + k, dest + k * 2, frames - k);
+}
+
+void deinterleave(const float *src, float *left, float *right, std::size_t frames) {
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const __m128 first = _mm_loadu_ps(src + k * 2);
+        const __m128 second = _mm_loadu_ps(src + k * 2 + 4);
+
+        _mm_storeu_ps(left + k, _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + k, _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    deinterleave_scalar(src + k * 2, left + k, right + k, frames - k);
+}
+#elif defined(MIXING_USE_NEON)
+void mix_stereo(float *dest, const float *src, const float (&matrix)[2][2], std::size_t frames) {
+    const float left_gain_values[4] = { matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1] };
+    const float right_gain_values[4] = { matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1] };
+    const float32x4_t left_gains = vld1q_f32(left_gain_values);
+    const float32x4_t right_gains = vld1q_f32(right_gain_values);
+    const float32x4_t low = vdupq_n_f32(-1.0f);
+    const float32x4_t high = vdupq_n_f32(1.0f);
+
+    std::size_t k = 0;
+    for (; k + 2 <= frames; k += 2) {
+        const float32x4_t input = vld1q_f32(src + k * 2);
+        const float32x4_t lefts = vtrn1q_f32(input, input);
+        const float32x4_t rights = vtrn2q_f32(input, input);
+
+        // Separate multiplies and adds, a fused multiply-add would not round like the scalar code
+        float32x4_t mixed = vaddq_f32(vld1q_f32(dest + k * 2), vmulq_f32(lefts, left_gains));
+        mixed = vaddq_f32(mixed, vmulq_f32(rights, right_gains));
+
+        // vmin/vmax propagate NaN where std::clamp keeps the value, select instead
+        mixed = vbslq_f32(vcltq_f32(mixed, low), low, mixed);
+        mixed = vbslq_f32(vcltq_f32(high, mixed), high, mixed);
+
+        vst1q_f32(dest + k * 2, mixed);
+    }
+
+    mix_stereo_scalar(dest + k * 2, src + k * 2, matrix, frames - k);
+}
+
+void apply_gain(float *samples, float gain, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(samples + i, vmulq_n_f32(vld1q_f32(samples + i), gain));
+    }
+
+    apply_gain_scalar(samples + i, gain, count - i);
+}
+
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count) {
+    const float32x4_t low = vdupq_n_f32(-32768.0f);
+    const float32x4_t high = vdupq_n_f32(32767.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t first = vminq_f32(high, vmaxq_f32(low, vmulq_n_f32(vld1q_f32(src + i), S16_SCALE)));
+        const float32x4_t second = vminq_f32(high, vmaxq_f32(low, vmulq_n_f32(vld1q_f32(src + i + 4), S16_SCALE)));
+
+        const int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(first)), vqmovn_s32(vcvtq_s32_f32(second)));
+        vst1q_s16(dest + i, packed);
+    }
+
+    float_to_s16_scalar(src + i, dest + i, count - i);
+}
+
+void s16_to_float(const std::int16_t *src, float *dest, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t input = vld1q_s16(src + i);
+
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(input))), 1.0f / S16_SCALE));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(input))), 1.0f / S16_SCALE));
+    }
+
+    s16_to_float_scalar(src + i, dest + i, count - i);
+}
+
+void interleave(const float *left, const float *right, float *dest, std::size_t frames) {
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const float32x4x2_t frames_data = { vld1q_f32(left + k), vld1q_f32(right + k) };
+        vst2q_f32(dest + k * 2, frames_data);
+    }
+
+    interleave_scalar(left + k, right + k, dest + k * 2, frames - k);
+}
+
+void deinterleave(const float *src, float *left, float *right, std::size_t frames) {
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const float32x4x2_t frames_data = vld2q_f32(src + k * 2);
+        vst1q_f32(left + k, frames_data.val[0]);
+        vst1q_f32(right + k, frames_data.val[1]);
+    }
+
+    deinterleave_scalar(src + k * 2, left + k, right + k, frames - k);
+}
+#else
+void mix_stereo(float *dest, const float *src, const float (&matrix)[2][2], std::size_t frames) {
+    mix_stereo_scalar(dest, src, matrix, frames);
+}
+
+void apply_gain(float *samples, float gain, std::size_t count) {
+    apply_gain_scalar(samples, gain, count);
+}
+
+void float_to_s16(const float *src, std::int16_t *dest, std::size_t count) {
+    float_to_s16_scalar(src, dest, count);
+}
+
+void s16_to_float(const std::int16_t *src, float *dest, std::size_t count) {
+    s16_to_float_scalar(src, dest, count);
+}
+
+void interleave(const float *left, const float *right, float *dest, std::size_t frames) {
+    interleave_scalar(left, right, dest, frames);
+}
+
+void deinterleave(const float *src, float *left, float *right, std::size_t frames) {
+    deinterleave_scalar(src, left, right, frames);
+}
+#endif
+} // namespace ngs
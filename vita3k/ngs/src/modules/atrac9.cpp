@@ -15,19 +15,16 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <ngs/mixing.h>
 #include <ngs/modules/atrac9.h>
 #include <util/bytes.h>
 #include <util/log.h>
 
-extern "C" {
-#include <libswresample/swresample.h>
-}
+#include <atomic>
+#include <numbers>
 
 namespace ngs::atrac9 {
 
-SwrContext *Module::swr_mono_to_stereo = nullptr;
-SwrContext *Module::swr_stereo = nullptr;
-
 Module::Module()
     : ngs::Module(ngs::BussType::BUSS_ATRAC9)
     , last_config(0) {}
@@ -73,6 +70,10 @@ void Module::on_state_change(ModuleData &data, const VoiceState previous) {
     } else if (data.parent->is_keyed_off) {
         state->samples_generated_since_key_on = 0;
         state->bytes_consumed_since_key_on = 0;
+
+        // let another voice use it in the meantime
+        data.parent->rack->system->resamplers.release(state->resampler);
+        state->resampler = nullptr;
     }
 }
 
@@ -81,13 +82,24 @@ void Module::on_param_change(const MemState &mem, ModuleData &data) {
     const Parameters *old_params = reinterpret_cast<Parameters *>(data.last_info.data());
     const Parameters *new_params = reinterpret_cast<Parameters *>(data.info.data.get(mem));
 
-    // if playback scaling changed, reset the resampler
-    if (state->swr && (old_params->playback_frequency != new_params->playback_frequency || old_params->playback_scalar != new_params->playback_scalar)) {
-        swr_free(&state->swr);
+    // if playback scaling changed, start over with a fresh resampler
+    if (state->resampler && (old_params->playback_frequency != new_params->playback_frequency || old_params->playback_scalar != new_params->playback_scalar)) {
+        data.parent->rack->system->resamplers.release(state->resampler);
+        state->resampler = nullptr;
     }
 }
 
-bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, const Parameters *params, State *state, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
+void Module::on_release(ModuleData &data) {
+    // Never processed, so it never got a resampler
+    if (data.voice_state_data.empty())
+        return;
+
+    State *state = data.get_state<State>();
+    data.parent->rack->system->resamplers.release(state->resampler);
+    state->resampler = nullptr;
+}
+
+bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, const Parameters *params, State *state, std::unique_lock<std::mutex> &voice_lock) {
     int current_buffer = state->current_buffer;
     const BufferParameters &bufparam = params->buffer_params[current_buffer];
 
@@ -100,7 +112,6 @@ bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceU
         const std::int32_t prev_index = state->current_buffer;
 
         voice_lock.unlock();
-        scheduler_lock.unlock();
 
         state->current_loop_count++;
 
@@ -124,7 +135,6 @@ bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceU
                 params->buffer_params[state->current_buffer].buffer.address());
         }
 
-        scheduler_lock.lock();
         voice_lock.lock();
 
         state->current_byte_position_in_buffer = 0;
@@ -215,33 +225,18 @@ bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceU
         DecoderSize decoder_size;
         decoder->receive(temporary_bytes.data(), &decoder_size);
 
-        SwrContext *swr;
+        float *superframe_data = reinterpret_cast<float *>(decoded_superframe_samples.data() + decoded_superframe_pos);
+        const std::int16_t *frame_samples = reinterpret_cast<const std::int16_t *>(temporary_bytes.data());
         if (channel_count == 1) {
-            if (!swr_mono_to_stereo) {
-                swr_mono_to_stereo = swr_alloc_set_opts(nullptr,
-                    AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, 480000,
-                    AV_CH_LAYOUT_MONO, AV_SAMPLE_FMT_S16, 480000,
-                    0, nullptr);
-                swr_init(swr_mono_to_stereo);
-            }
-
-            swr = swr_mono_to_stereo;
+            // Same level as an FFmpeg upmix, the center channel goes to both sides at -3dB
+            std::vector<float> mono_samples(decoder_size.samples);
+            s16_to_float(frame_samples, mono_samples.data(), decoder_size.samples);
+            apply_gain(mono_samples.data(), 1.0f / std::numbers::sqrt2_v<float>, decoder_size.samples);
+            interleave(mono_samples.data(), mono_samples.data(), superframe_data, decoder_size.samples);
         } else {
-            if (!swr_stereo) {
-                swr_stereo = swr_alloc_set_opts(nullptr,
-                    AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, 480000,
-                    AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_S16, 480000,
-                    0, nullptr);
-                swr_init(swr_stereo);
-            }
-
-            swr = swr_stereo;
+            s16_to_float(frame_samples, superframe_data, decoder_size.samples * 2);
         }
 
-        const uint8_t *swr_data_in = reinterpret_cast<uint8_t *>(temporary_bytes.data());
-        uint8_t *swr_data_out = reinterpret_cast<uint8_t *>(decoded_superframe_samples.data() + decoded_superframe_pos);
-        const int result = swr_convert(swr, &swr_data_out, decoder_size.samples, &swr_data_in, decoder_size.samples);
-
         decoded_superframe_pos += decoder_size.samples * sizeof(float) * 2;
         input += decoder->get_es_size();
         state->current_byte_position_in_buffer += decoder->get_es_size();
@@ -249,31 +244,23 @@ bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceU
 
     const int32_t sample_rate = data.parent->rack->system->sample_rate;
     if (params->playback_scalar != 1 || static_cast<int>(round(params->playback_frequency)) != sample_rate) {
-        static bool LOG_PLAYBACK_SCALING = true;
-        LOG_INFO_IF(LOG_PLAYBACK_SCALING, "The currently running game requests playback rate scaling when decoding audio. Audio might crackle.");
-        LOG_PLAYBACK_SCALING = false;
+        // Racks are decoded on several threads
+        static std::atomic<bool> LOG_PLAYBACK_SCALING = true;
+        LOG_INFO_IF(LOG_PLAYBACK_SCALING.exchange(false), "The currently running game requests playback rate scaling when decoding audio. Audio might crackle.");
 
         // resample the audio
         int src_sample_rate = static_cast<int>(params->playback_frequency);
         if (params->playback_scalar != 1.0)
             src_sample_rate *= params->playback_scalar;
 
-        if (!state->swr) {
-            state->swr = swr_alloc_set_opts(nullptr,
-                AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, sample_rate,
-                AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, src_sample_rate,
-                0, nullptr);
+        Resampler *resampler = data.parent->rack->system->resamplers.rebind(state->resampler, { src_sample_rate, sample_rate, 2, ResamplerFormat::F32 });
 
-            swr_init(state->swr);
-        }
         // assume the skipped samples happen before the scaling
-        int scaled_samples_amount = swr_get_out_samples(state->swr, decoded_size);
+        int scaled_samples_amount = resampler->get_out_frames(decoded_size);
         std::vector<std::uint8_t> scaled_data(scaled_samples_amount * sizeof(float) * 2, 0);
 
-        uint8_t *scaled_dest_data = scaled_data.data();
         const uint8_t *scaled_src_data = decoded_superframe_samples.data() + decoded_start_offset * sizeof(float) * 2;
-        scaled_samples_amount = swr_convert(state->swr, &scaled_dest_data, scaled_samples_amount, &scaled_src_data, samples_per_superframe);
-        assert(scaled_samples_amount > 0);
+        scaled_samples_amount = resampler->convert(scaled_src_data, decoded_size, reinterpret_cast<float *>(scaled_data.data()), scaled_samples_amount);
 
         // Allocate memory to accommodate the result of the scaling process into the queue for the final audio buffer
         data.extra_storage.resize(curr_pos + scaled_samples_amount * sizeof(float) * 2);
@@ -290,12 +277,10 @@ bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceU
 
     if (got_decode_error) {
         voice_lock.unlock();
-        scheduler_lock.unlock();
 
         data.invoke_callback(kern, mem, thread_id, SCE_NGS_AT9_DECODE_ERROR, state->current_byte_position_in_buffer,
             params->buffer_params[state->current_buffer].buffer.address());
 
-        scheduler_lock.lock();
         voice_lock.lock();
 
         // clear the context or we'll get en error next time we cant to decode
@@ -313,7 +298,7 @@ bool Module::decode_more_data(KernelState &kern, const MemState &mem, const SceU
     return true;
 }
 
-bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
     const Parameters *params = data.get_parameters<Parameters>(mem);
     State *state = data.get_state<State>();
     assert(state);
@@ -331,7 +316,7 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
 
     // call decode more data until we either have an error or reached end of data
     while (static_cast<std::int32_t>(state->decoded_samples_pending) < data.parent->rack->system->granularity) {
-        if (!decode_more_data(kern, mem, thread_id, data, params, state, scheduler_lock, voice_lock)) {
+        if (!decode_more_data(kern, mem, thread_id, data, params, state, voice_lock)) {
             state->is_finished = true;
             break;
         }
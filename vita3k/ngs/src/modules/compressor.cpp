@@ -0,0 +1,73 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/modules/compressor.h>
+
+#include <cstring>
+
+namespace ngs::compressor {
+Module::Module()
+    : ngs::Module(ngs::BussType::BUSS_COMPRESSOR) {}
+
+std::size_t Module::get_buffer_parameter_size() const {
+    return sizeof(Parameters);
+}
+
+void Module::on_state_change(ModuleData &data, const VoiceState previous) {
+    if (data.parent->state == VOICE_STATE_AVAILABLE) {
+        data.get_state<State>()->compressor.envelope = 0.0f;
+    }
+}
+
+static void configure(State &state, const Parameters &params, float sample_rate) {
+    const dsp::CompressorSettings settings = {
+        params.threshold,
+        params.ratio,
+        params.attack_time,
+        params.release_time,
+        params.makeup_gain,
+        params.detection == DETECTION_RMS,
+    };
+
+    state.compressor.configure(settings, sample_rate);
+    state.last_params = params;
+    state.configured = true;
+}
+
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
+    VoiceProduct &product = data.parent->products[0];
+
+    if (!product.data && !data.parent->inputs.inputs.empty()) {
+        product.data = data.parent->inputs.inputs[0].data();
+    }
+
+    const Parameters *params = data.get_parameters<Parameters>(mem);
+
+    if (data.is_bypassed || !product.data || !params) {
+        return false;
+    }
+
+    State *state = data.get_state<State>();
+
+    if (!state->configured || std::memcmp(&state->last_params, params, sizeof(Parameters)) != 0) {
+        configure(*state, *params, static_cast<float>(data.parent->rack->system->sample_rate));
+    }
+
+    state->compressor.process(reinterpret_cast<float *>(product.data), data.parent->rack->system->granularity);
+    return false;
+}
+} // namespace ngs::compressor
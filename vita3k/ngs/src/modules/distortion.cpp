@@ -0,0 +1,53 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+#include <ngs/modules/distortion.h>
+
+namespace ngs::distortion {
+Module::Module()
+    : ngs::Module(ngs::BussType::BUSS_DISTORTION) {}
+
+std::size_t Module::get_buffer_parameter_size() const {
+    return sizeof(Parameters);
+}
+
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
+    VoiceProduct &product = data.parent->products[0];
+
+    if (!product.data && !data.parent->inputs.inputs.empty()) {
+        product.data = data.parent->inputs.inputs[0].data();
+    }
+
+    const Parameters *params = data.get_parameters<Parameters>(mem);
+
+    if (data.is_bypassed || !product.data || !params) {
+        return false;
+    }
+
+    // Parameters left zeroed would mute the voice, treat them as never set
+    if ((params->wet_gain == 0.0f) && (params->dry_gain == 0.0f)) {
+        return false;
+    }
+
+    // The clipper has no memory, so there is nothing to keep between two granules
+    const dsp::DistortionSettings settings = { params->drive, params->clip_level, params->wet_gain, params->dry_gain };
+    dsp::distort(reinterpret_cast<float *>(product.data), data.parent->rack->system->granularity * 2, settings);
+
+    return false;
+}
+} // namespace ngs::distortion
@@ -16,26 +16,57 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <ngs/modules/equalizer.h>
-#include <util/log.h>
+
+#include <cstring>
 
 namespace ngs::equalizer {
 Module::Module()
     : ngs::Module(ngs::BussType::BUSS_EQUALIZATION) {}
 
 std::size_t Module::get_buffer_parameter_size() const {
-    return default_normal_parameter_size;
+    return sizeof(Parameters);
+}
+
+void Module::on_state_change(ModuleData &data, const VoiceState previous) {
+    if (data.parent->state == VOICE_STATE_AVAILABLE) {
+        data.get_state<State>()->filters.reset();
+    }
+}
+
+static void configure(State &state, const Parameters &params, float sample_rate) {
+    state.filters.band_count = 0;
+
+    for (const FilterParameters &filter : params.filters) {
+        const auto type = static_cast<dsp::FilterType>(filter.type);
+        if ((type <= dsp::FilterType::OFF) || (type > dsp::FilterType::HIGH_SHELF)) {
+            continue;
+        }
+
+        state.filters.bands[state.filters.band_count++] = dsp::design_biquad(type, sample_rate, filter.frequency, filter.resonance, filter.gain);
+    }
+
+    state.last_params = params;
+    state.configured = true;
 }
 
-bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
-    if (!data.is_bypassed) {
-        // TODO: Proper implement it, for now just lower volume lol
-        float *product_before = reinterpret_cast<float *>(data.parent->products[0].data);
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
+    VoiceProduct &product = data.parent->products[0];
+
+    // An equalizer buss has no module before it, it filters what was patched into the voice
+    if (!product.data && !data.parent->inputs.inputs.empty()) {
+        product.data = data.parent->inputs.inputs[0].data();
+    }
+
+    const Parameters *params = data.get_parameters<Parameters>(mem);
 
-        if (product_before) {
-            for (std::int32_t i = 0; i < data.parent->rack->system->granularity * 2; i++) {
-                product_before[i] *= 0.5f;
-            }
+    if (!data.is_bypassed && product.data && params) {
+        State *state = data.get_state<State>();
+
+        if (!state->configured || std::memcmp(&state->last_params, params, sizeof(Parameters)) != 0) {
+            configure(*state, *params, static_cast<float>(data.parent->rack->system->sample_rate));
         }
+
+        state->filters.process(reinterpret_cast<float *>(product.data), data.parent->rack->system->granularity);
     }
 
     // It should do some modifications to create 4 outputs, but I'm not sure what yet kkk
@@ -15,6 +15,7 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <ngs/mixing.h>
 #include <ngs/modules/master.h>
 #include <util/log.h>
 
@@ -26,7 +27,7 @@ Module::Module()
     : ngs::Module(ngs::BussType::BUSS_MASTER) {
 }
 
-bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
     // Merge all voices. This buss manually outputs 2 channels
     if (data.voice_state_data.empty()) {
         data.voice_state_data.resize(data.parent->rack->system->granularity * sizeof(std::uint16_t) * 2);
@@ -42,9 +43,7 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
     float *source_data = reinterpret_cast<float *>(data.parent->inputs.inputs[0].data());
 
     // Convert FLTP to S16
-    for (std::uint32_t i = 0; i < data.parent->rack->system->granularity * 2; i++) {
-        dest_data[i] = static_cast<std::int16_t>(std::clamp(source_data[i] * 32768.0f, -32768.0f, 32767.0f));
-    }
+    float_to_s16(source_data, dest_data, data.parent->rack->system->granularity * 2);
 
     return false;
 }
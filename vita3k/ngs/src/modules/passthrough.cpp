@@ -26,7 +26,7 @@ std::size_t Module::get_buffer_parameter_size() const {
     return default_passthrough_parameter_size;
 }
 
-bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
     if (data.parent->inputs.inputs.empty()) {
         return false;
     }
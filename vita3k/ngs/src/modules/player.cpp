@@ -18,11 +18,6 @@
 #include <ngs/modules/player.h>
 #include <util/log.h>
 
-extern "C" {
-#include <libswresample/swresample.h>
-}
-
-#include <cassert>
 #include <cstring>
 
 namespace ngs::player {
@@ -44,8 +39,8 @@ void Module::on_state_change(ModuleData &data, const VoiceState previous) {
         state->bytes_consumed_since_key_on = 0;
 
         std::fill_n(state->adpcm_history, 4, 0);
-        if (state->swr)
-            swr_free(&state->swr);
+        data.parent->rack->system->resamplers.release(state->resampler);
+        state->resampler = nullptr;
     }
 }
 
@@ -54,13 +49,24 @@ void Module::on_param_change(const MemState &mem, ModuleData &data) {
     const Parameters *old_params = reinterpret_cast<Parameters *>(data.last_info.data());
     const Parameters *new_params = reinterpret_cast<Parameters *>(data.info.data.get(mem));
 
-    // if playback scaling changed, reset the resampler
-    if (state->swr && (old_params->playback_frequency != new_params->playback_frequency || old_params->playback_scalar != new_params->playback_scalar)) {
-        swr_free(&state->swr);
+    // if playback scaling changed, start over with a fresh resampler
+    if (state->resampler && (old_params->playback_frequency != new_params->playback_frequency || old_params->playback_scalar != new_params->playback_scalar)) {
+        data.parent->rack->system->resamplers.release(state->resampler);
+        state->resampler = nullptr;
     }
 }
 
-bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) {
+void Module::on_release(ModuleData &data) {
+    // Never processed, so it never got a resampler
+    if (data.voice_state_data.empty())
+        return;
+
+    State *state = data.get_state<State>();
+    data.parent->rack->system->resamplers.release(state->resampler);
+    state->resampler = nullptr;
+}
+
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
     Parameters *params = data.get_parameters<Parameters>(mem);
     State *state = data.get_state<State>();
     bool finished = false;
@@ -132,14 +138,12 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
                         state->current_loop_count = 0;
 
                         voice_lock.unlock();
-                        scheduler_lock.unlock();
 
                         if (state->current_buffer == -1) {
                             data.invoke_callback(kern, mem, thread_id, SCE_NGS_PLAYER_END_OF_DATA, 0, 0);
                             finished = true;
                             // TODO: Free all occupied input routes
                             // unroute_occupied(mem, voice);
-                            scheduler_lock.lock();
                             voice_lock.lock();
                             break;
                         } else {
@@ -147,17 +151,14 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
                                 params->buffer_params[state->current_buffer].buffer.address());
                         }
 
-                        scheduler_lock.lock();
                         voice_lock.lock();
                     }
                 } else {
                     voice_lock.unlock();
-                    scheduler_lock.unlock();
 
                     data.invoke_callback(kern, mem, thread_id, SCE_NGS_PLAYER_LOOPED_BUFFER, state->current_loop_count,
                         params->buffer_params[state->current_buffer].buffer.address());
 
-                    scheduler_lock.lock();
                     voice_lock.lock();
                 }
 
@@ -231,21 +232,12 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
                     if (params->playback_scalar != 1.0)
                         src_sample_rate *= params->playback_scalar;
 
-                    if (!state->swr) {
-                        state->swr = swr_alloc_set_opts(nullptr,
-                            AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, sample_rate,
-                            AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, src_sample_rate,
-                            0, nullptr);
+                    Resampler *resampler = data.parent->rack->system->resamplers.rebind(state->resampler, { src_sample_rate, sample_rate, 2, ResamplerFormat::F32 });
 
-                        swr_init(state->swr);
-                    }
-                    int scaled_samples_amount = swr_get_out_samples(state->swr, samples_count.samples);
+                    int scaled_samples_amount = resampler->get_out_frames(samples_count.samples);
                     std::vector<std::uint8_t> scaled_data(scaled_samples_amount * sizeof(float) * 2, 0);
 
-                    uint8_t *scaled_dest_data = scaled_data.data();
-                    const uint8_t *scaled_src_data = decoded_data.data();
-                    scaled_samples_amount = swr_convert(state->swr, &scaled_dest_data, scaled_samples_amount, &scaled_src_data, samples_count.samples);
-                    assert(scaled_samples_amount > 0);
+                    scaled_samples_amount = resampler->convert(decoded_data.data(), samples_count.samples, reinterpret_cast<float *>(scaled_data.data()), scaled_samples_amount);
 
                     // Get current size of audio queue for processed samples in memory
                     const std::size_t current_count = state->decoded_samples_pending * sizeof(float) * 2;
@@ -296,8 +288,8 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
         state->bytes_consumed_since_key_on = 0;
 
         std::fill_n(state->adpcm_history, 4, 0);
-        if (state->swr)
-            swr_free(&state->swr);
+        data.parent->rack->system->resamplers.release(state->resampler);
+        state->resampler = nullptr;
     }
 
     return finished;
@@ -0,0 +1,80 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/modules/reverb.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace ngs::reverb {
+Module::Module()
+    : ngs::Module(ngs::BussType::BUSS_REVERB) {}
+
+std::size_t Module::get_buffer_parameter_size() const {
+    return sizeof(Parameters);
+}
+
+void Module::on_state_change(ModuleData &data, const VoiceState previous) {
+    // Do not let the tail of the previous sound leak into the next one
+    if (data.parent->state == VOICE_STATE_AVAILABLE) {
+        data.get_state<State>()->reverb.reset();
+    }
+}
+
+static float millibels_to_gain(SceInt32 level) {
+    return std::pow(10.0f, static_cast<float>(level) / 2000.0f);
+}
+
+static void configure(State &state, const Parameters &params, float sample_rate) {
+    // Early reflections are not modeled, their delay only pushes the tail back
+    const dsp::ReverbSettings settings = {
+        params.decay_time,
+        params.decay_hf_ratio,
+        params.reflections_delay + params.reverb_delay,
+        params.diffusion / 100.0f,
+        millibels_to_gain(params.room) * millibels_to_gain(params.reverb) * millibels_to_gain(params.wet),
+        millibels_to_gain(params.dry),
+    };
+
+    state.reverb.configure(settings, sample_rate);
+    state.last_params = params;
+    state.configured = true;
+}
+
+bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::mutex> &voice_lock) {
+    VoiceProduct &product = data.parent->products[0];
+
+    if (!product.data && !data.parent->inputs.inputs.empty()) {
+        product.data = data.parent->inputs.inputs[0].data();
+    }
+
+    const Parameters *params = data.get_parameters<Parameters>(mem);
+
+    if (data.is_bypassed || !product.data || !params) {
+        return false;
+    }
+
+    State *state = data.get_state<State>();
+
+    if (!state->configured || std::memcmp(&state->last_params, params, sizeof(Parameters)) != 0) {
+        configure(*state, *params, static_cast<float>(data.parent->rack->system->sample_rate));
+    }
+
+    state->reverb.process(reinterpret_cast<float *>(product.data), data.parent->rack->system->granularity);
+    return false;
+}
+} // namespace ngs::reverb
@@ -18,6 +18,7 @@
 #include <kernel/state.h>
 
 #include <ngs/definitions/atrac9.h>
+#include <ngs/definitions/buss.h>
 #include <ngs/definitions/master.h>
 #include <ngs/definitions/passthrough.h>
 #include <ngs/definitions/player.h>
@@ -27,6 +28,7 @@
 #include <ngs/modules/master.h>
 #include <ngs/modules/passthrough.h>
 #include <ngs/modules/player.h>
+#include <ngs/mixing.h>
 #include <ngs/state.h>
 #include <ngs/system.h>
 #include <util/lock_and_find.h>
@@ -81,12 +83,7 @@ std::int32_t VoiceInputManager::receive(ngs::Patch *patch, const VoiceProduct &p
 
     // Try mixing, also with the use of this volume matrix
     // Dest is our voice to receive this data.
-    for (std::int32_t k = 0; k < patch->dest->rack->system->granularity; k++) {
-        dest_buffer[k * 2] = std::clamp(dest_buffer[k * 2] + data_to_mix_in[k * 2] * patch->volume_matrix[0][0]
-                + data_to_mix_in[k * 2 + 1] * patch->volume_matrix[1][0],
-            -1.0f, 1.0f);
-        dest_buffer[k * 2 + 1] = std::clamp(dest_buffer[k * 2 + 1] + data_to_mix_in[k * 2] * patch->volume_matrix[0][1] + data_to_mix_in[k * 2 + 1] * patch->volume_matrix[1][1], -1.0f, 1.0f);
-    }
+    mix_stereo(dest_buffer, data_to_mix_in, patch->volume_matrix, patch->dest->rack->system->granularity);
 
     return 0;
 }
@@ -328,6 +325,9 @@ void Voice::invoke_callback(KernelState &kernel, const MemState &mem, const SceU
         return;
     }
 
+    // Voices may be processed on several threads, but the callbacks all borrow the updating thread
+    const std::lock_guard<std::mutex> guard(rack->system->voice_scheduler.callback_mutex);
+
     const ThreadStatePtr thread = lock_and_find(thread_id, kernel.threads, kernel.mutex);
     const Address callback_info_addr = stack_alloc(*thread->cpu, sizeof(CallbackInfo));
 
@@ -468,8 +468,16 @@ void release_rack(State &ngs, const MemState &mem, System *system, Rack *rack) {
 
     // remove all queued voices
     for (const auto &voice : rack->voices) {
-        system->voice_scheduler.deque_voice(voice.get(mem));
-        voice.get(mem)->~Voice();
+        Voice *v = voice.get(mem);
+        system->voice_scheduler.deque_voice(v);
+
+        // Hand back what the modules took from the system, e.g. resamplers, so the next racks reuse it
+        for (std::size_t i = 0; i < rack->modules.size(); i++) {
+            if (rack->modules[i] && (i < v->datas.size()))
+                rack->modules[i]->on_release(v->datas[i]);
+        }
+
+        v->~Voice();
         // no need to free the voice from the rack
     }
 
@@ -498,6 +506,14 @@ Ptr<VoiceDefinition> create_voice_definition(State &ngs, MemState &mem, ngs::Bus
         return ngs.alloc_and_init<ngs::scream::Atrac9VoiceDefinition>(mem);
     case ngs::BussType::BUSS_SCREAM:
         return ngs.alloc_and_init<ngs::scream::PlayerVoiceDefinition>(mem);
+    case ngs::BussType::BUSS_EQUALIZATION:
+        return ngs.alloc_and_init<ngs::buss::EqualizerVoiceDefinition>(mem);
+    case ngs::BussType::BUSS_REVERB:
+        return ngs.alloc_and_init<ngs::buss::ReverbVoiceDefinition>(mem);
+    case ngs::BussType::BUSS_COMPRESSOR:
+        return ngs.alloc_and_init<ngs::buss::CompressorVoiceDefinition>(mem);
+    case ngs::BussType::BUSS_DISTORTION:
+        return ngs.alloc_and_init<ngs::buss::DistortionVoiceDefinition>(mem);
     default:
         LOG_WARN("Missing voice definition for Buss Type {}, using passthrough.", static_cast<uint32_t>(type));
         return ngs.alloc_and_init<ngs::passthrough::VoiceDefinition>(mem);
@@ -0,0 +1,213 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/resampler.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+extern "C" {
+#include <libswresample/swresample.h>
+}
+
+namespace ngs {
+std::size_t ResamplerKeyHash::operator()(const ResamplerKey &key) const {
+    std::size_t hash = std::hash<std::int32_t>()(key.in_rate);
+    hash = hash * 31 + std::hash<std::int32_t>()(key.out_rate);
+    hash = hash * 31 + static_cast<std::size_t>(key.channels) * 2 + static_cast<std::size_t>(key.format);
+    return hash;
+}
+
+LinearResampler::LinearResampler(const ResamplerKey &key)
+    : Resampler(key)
+    , step(static_cast<double>(key.in_rate) / static_cast<double>(key.out_rate)) {
+    reset();
+}
+
+std::int32_t LinearResampler::get_out_frames(std::int32_t in_frames) const {
+    return static_cast<std::int32_t>((in_frames + 1) / step) + 2;
+}
+
+void LinearResampler::reset() {
+    // The first output lands right on the first input frame
+    position = 1.0;
+    last[0] = last[1] = 0.0f;
+}
+
+static void load_frame(const ResamplerKey &key, const std::uint8_t *src, std::int32_t index, float (&frame)[2]) {
+    const std::int32_t offset = index * key.channels;
+
+    if (key.format == ResamplerFormat::S16) {
+        const std::int16_t *samples = reinterpret_cast<const std::int16_t *>(src) + offset;
+        frame[0] = static_cast<float>(samples[0]) * (1.0f / 32768.0f);
+        frame[1] = (key.channels == 2) ? static_cast<float>(samples[1]) * (1.0f / 32768.0f) : frame[0];
+    } else {
+        const float *samples = reinterpret_cast<const float *>(src) + offset;
+        frame[0] = samples[0];
+        frame[1] = (key.channels == 2) ? samples[1] : frame[0];
+    }
+}
+
+std::int32_t LinearResampler::convert(const std::uint8_t *src, std::int32_t in_frames, float *dest, std::int32_t max_out_frames) {
+    if (in_frames <= 0) {
+        return 0;
+    }
+
+    // Frame 0 is the last one of the previous call, the new ones start at 1
+    const auto get_frame = [&](std::int32_t index, float (&frame)[2]) {
+        if (index == 0) {
+            frame[0] = last[0];
+            frame[1] = last[1];
+        } else {
+            load_frame(key, src, index - 1, frame);
+        }
+    };
+
+    std::int32_t written = 0;
+    double pos = position;
+
+    while (written < max_out_frames) {
+        const auto index = static_cast<std::int32_t>(pos);
+        const float fraction = static_cast<float>(pos - index);
+
+        // Landing exactly on the last frame does not need the one after it
+        if (index + ((fraction != 0.0f) ? 1 : 0) > in_frames) {
+            break;
+        }
+
+        float current[2];
+        get_frame(index, current);
+
+        if (fraction == 0.0f) {
+            dest[written * 2] = current[0];
+            dest[written * 2 + 1] = current[1];
+        } else {
+            float next[2];
+            get_frame(index + 1, next);
+
+            dest[written * 2] = current[0] + (next[0] - current[0]) * fraction;
+            dest[written * 2 + 1] = current[1] + (next[1] - current[1]) * fraction;
+        }
+
+        written++;
+        pos += step;
+    }
+
+    load_frame(key, src, in_frames - 1, last);
+
+    // Output that did not fit is dropped rather than replayed
+    position = std::max(pos - in_frames, 0.0);
+
+    return written;
+}
+
+// Band-limited resampling for when linear interpolation would alias
+struct SwrResampler : public Resampler {
+    SwrContext *swr;
+
+    explicit SwrResampler(const ResamplerKey &key)
+        : Resampler(key) {
+        swr = swr_alloc_set_opts(nullptr,
+            AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_FLT, key.out_rate,
+            (key.channels == 1) ? AV_CH_LAYOUT_MONO : AV_CH_LAYOUT_STEREO, (key.format == ResamplerFormat::S16) ? AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_FLT, key.in_rate,
+            0, nullptr);
+
+        // Mono goes to both sides at full level, like the linear resampler does
+        if (key.channels == 1) {
+            const double matrix[2] = { 1.0, 1.0 };
+            swr_set_matrix(swr, matrix, 1);
+        }
+
+        swr_init(swr);
+    }
+
+    ~SwrResampler() override {
+        swr_free(&swr);
+    }
+
+    std::int32_t get_out_frames(std::int32_t in_frames) const override {
+        return swr_get_out_samples(swr, in_frames);
+    }
+
+    std::int32_t convert(const std::uint8_t *src, std::int32_t in_frames, float *dest, std::int32_t max_out_frames) override {
+        std::uint8_t *out = reinterpret_cast<std::uint8_t *>(dest);
+        return std::max(swr_convert(swr, &out, max_out_frames, &src, in_frames), 0);
+    }
+
+    void reset() override {
+        swr_close(swr);
+        swr_init(swr);
+    }
+};
+
+std::unique_ptr<Resampler> create_resampler(const ResamplerKey &key) {
+    if (ResamplerPool::is_linear_enough(key)) {
+        return std::make_unique<LinearResampler>(key);
+    }
+
+    return std::make_unique<SwrResampler>(key);
+}
+
+bool ResamplerPool::is_linear_enough(const ResamplerKey &key) {
+    // Linear interpolation has no filter: it leaves images of the input band above the original
+    // Nyquist frequency and folds back whatever is above the new one. Both stay small only while the
+    // two rates are within a few percent of each other, any wider ratio is left to swresample
+    return std::abs(key.in_rate - key.out_rate) <= key.out_rate / 16;
+}
+
+Resampler *ResamplerPool::acquire(const ResamplerKey &key) {
+    const std::lock_guard<std::mutex> guard(mutex);
+
+    std::vector<Resampler *> &candidates = available[key];
+    if (!candidates.empty()) {
+        Resampler *resampler = candidates.back();
+        candidates.pop_back();
+        return resampler;
+    }
+
+    resamplers.push_back(create_resampler(key));
+    return resamplers.back().get();
+}
+
+void ResamplerPool::release(Resampler *resampler) {
+    if (!resampler) {
+        return;
+    }
+
+    // Done outside the lock, the next voice gets it as good as new
+    resampler->reset();
+
+    const std::lock_guard<std::mutex> guard(mutex);
+    available[resampler->key].push_back(resampler);
+}
+
+Resampler *ResamplerPool::rebind(Resampler *&current, const ResamplerKey &key) {
+    if (current && (current->key == key)) {
+        return current;
+    }
+
+    release(current);
+    current = acquire(key);
+
+    return current;
+}
+
+std::size_t ResamplerPool::size() {
+    const std::lock_guard<std::mutex> guard(mutex);
+    return resamplers.size();
+}
+} // namespace ngs
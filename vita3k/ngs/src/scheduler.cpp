@@ -32,6 +32,7 @@ bool VoiceScheduler::deque_voice_impl(Voice *voice) {
     }
 
     queue.erase(voice_in);
+    graph_dirty = true;
     return true;
 }
 
@@ -66,6 +67,7 @@ void VoiceScheduler::deque_insert(const MemState &mem, Voice *voice) {
 
     const std::lock_guard<std::recursive_mutex> guard(mutex);
     queue.insert(queue.begin() + lowest_dest_pos, voice);
+    graph_dirty = true;
 }
 
 bool VoiceScheduler::play(const MemState &mem, Voice *voice) {
@@ -128,57 +130,213 @@ bool VoiceScheduler::off(Voice *voice) {
     return true;
 }
 
-void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
-    std::unique_lock<std::recursive_mutex> scheduler_lock(mutex);
-    is_updating = true;
+void VoiceScheduler::set_thread_count(std::size_t count) {
+    const std::lock_guard<std::recursive_mutex> guard(mutex);
+
+    if (count == 0) {
+        // Past a few threads the stages get too small for the workers to pay off
+        count = std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2, 1, 4);
+    }
 
-    // make a copy of the queue, this way we have no issue if it is modified in a callbck
-    std::vector<ngs::Voice *> queue_copy = queue;
+    // The updating thread takes part in the work, so it is not counted in the pool
+    if (count <= 1) {
+        workers.reset();
+    } else if (!workers || (workers->size() != count - 1)) {
+        workers = std::make_unique<util::ThreadPool>(count - 1);
+    }
+}
 
-    // Do a first routine to clear inputs from previous update session
-    for (ngs::Voice *voice : queue_copy) {
-        voice->inputs.reset_inputs();
+void VoiceScheduler::rebuild_graph(const MemState &mem) {
+    auto new_graph = std::make_shared<VoiceGraph>();
+    new_graph->voices = queue;
+
+    std::unordered_map<Voice *, std::size_t> positions;
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        positions.emplace(queue[i], i);
+    }
+
+    // The queue is already sorted so that a voice comes after every voice patched into it
+    std::vector<std::size_t> depths(queue.size(), 0);
+    std::size_t max_depth = 0;
+
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        Voice *source = queue[i];
+        max_depth = std::max(max_depth, depths[i]);
+
+        for (const auto &patches : source->patches) {
+            for (const auto &patch : patches) {
+                const Patch *patch_info = patch.get(mem);
+                if (!patch_info || patch_info->output_sub_index == -1) {
+                    continue;
+                }
+
+                const auto dest_pos = positions.find(patch_info->dest);
+
+                // Data sent to a voice which was already processed is lost, as it was done serially
+                if (dest_pos == positions.end() || dest_pos->second <= i) {
+                    continue;
+                }
+
+                depths[dest_pos->second] = std::max(depths[dest_pos->second], depths[i] + 1);
+
+                std::vector<Voice *> &dest_sources = new_graph->sources[patch_info->dest];
+                if (dest_sources.empty() || dest_sources.back() != source) {
+                    dest_sources.push_back(source);
+                }
+            }
+        }
+    }
+
+    new_graph->stages.resize(queue.empty() ? 0 : max_depth + 1);
+
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        std::vector<VoiceGroup> &groups = new_graph->stages[depths[i]].groups;
+        Rack *rack = queue[i]->rack;
+
+        auto group = std::find_if(groups.begin(), groups.end(), [rack](const VoiceGroup &group) {
+            return group.rack == rack;
+        });
+
+        if (group == groups.end()) {
+            groups.push_back({ rack, {} });
+            group = groups.end() - 1;
+        }
+
+        group->voices.push_back(queue[i]);
+        group->positions.push_back(i);
     }
 
-    for (ngs::Voice *voice : queue_copy) {
+    graph = std::move(new_graph);
+    graph_dirty = false;
+}
+
+// Mix the outputs of every voice patched into this one, the same way deliver_data does
+static void gather_inputs(const MemState &mem, const std::vector<Voice *> &sources, Voice *voice) {
+    for (Voice *source : sources) {
+        // Guest threads may patch the source meanwhile. Sources belong to earlier stages and guest threads
+        // never hold two voice locks, so locking it while holding the one of the destination can't deadlock
+        const std::lock_guard<std::mutex> source_guard(*source->voice_mutex);
+        const std::size_t output_count = std::min<std::size_t>(source->rack->vdef->output_count(), source->patches.size());
+
+        for (std::size_t i = 0; i < output_count; i++) {
+            const VoiceProduct &product = source->products[i];
+            if (!product.data) {
+                continue;
+            }
+
+            for (const auto &patch : source->patches[i]) {
+                Patch *patch_info = patch.get(mem);
+                if (!patch_info || patch_info->output_sub_index == -1 || patch_info->dest != voice) {
+                    continue;
+                }
+
+                voice->inputs.receive(patch_info, product);
+            }
+        }
+    }
+}
+
+void VoiceScheduler::process_group(KernelState &kern, const MemState &mem, const SceUID thread_id, const VoiceGraph &current, const VoiceGroup &group, std::vector<FinishedVoice> &finished) {
+    for (std::size_t v = 0; v < group.voices.size(); v++) {
+        ngs::Voice *voice = group.voices[v];
+
         // Modify the state, in peace....
         std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+
+        const auto sources = current.sources.find(voice);
+        if (sources != current.sources.end()) {
+            gather_inputs(mem, sources->second, voice);
+        }
+
         std::memset(voice->products, 0, sizeof(voice->products));
 
-        bool finished = false;
+        bool is_finished = false;
         uint32_t finished_module = 0;
 
         for (std::size_t i = 0; i < voice->rack->modules.size(); i++) {
             if (voice->rack->modules[i]) {
-                if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
-                    finished = true;
+                if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], voice_lock)) {
+                    is_finished = true;
                     finished_module = voice->rack->modules[i]->module_id();
                 }
             }
         }
-        if (finished) {
+        if (is_finished) {
             voice->is_keyed_off = true;
             voice->transition(VoiceState::VOICE_STATE_FINALIZING);
-            if (voice->finished_callback) {
-                voice_lock.unlock();
-                scheduler_lock.unlock();
-                voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, finished_module);
-                scheduler_lock.lock();
-                voice_lock.lock();
-            }
-            voice->is_keyed_off = false;
+            finished.push_back({ group.positions[v], voice, finished_module });
+        }
+
+        voice->frame_count++;
+    }
+}
+
+// Run on the updating thread once every group of a stage is done, so the finished callbacks
+// are called in queue order however many threads processed the stage
+void VoiceScheduler::finish_voices(KernelState &kern, const MemState &mem, const SceUID thread_id, std::vector<std::vector<FinishedVoice>> &finished) {
+    std::vector<FinishedVoice> in_order;
+    for (std::vector<FinishedVoice> &group_finished : finished) {
+        in_order.insert(in_order.end(), group_finished.begin(), group_finished.end());
+        group_finished.clear();
+    }
 
-            stop(voice);
+    std::sort(in_order.begin(), in_order.end(), [](const FinishedVoice &lhs, const FinishedVoice &rhs) {
+        return lhs.position < rhs.position;
+    });
+
+    for (const FinishedVoice &done : in_order) {
+        Voice *voice = done.voice;
+        if (voice->finished_callback) {
+            voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, done.module_id);
         }
 
-        for (std::size_t i = 0; i < voice->rack->vdef->output_count(); i++) {
-            if (voice->products[i].data)
-                deliver_data(mem, voice, static_cast<std::uint8_t>(i), voice->products[i]);
+        const std::lock_guard<std::mutex> voice_guard(*voice->voice_mutex);
+        voice->is_keyed_off = false;
+
+        stop(voice);
+    }
+}
+
+void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
+    std::unique_lock<std::recursive_mutex> scheduler_lock(mutex);
+    is_updating = true;
+
+    if (graph_dirty || !graph) {
+        rebuild_graph(mem);
+    }
+
+    // Keep our own reference, this way we have no issue if the graph is rebuilt from a callback
+    const std::shared_ptr<const VoiceGraph> current = graph;
+
+    // Do a first routine to clear inputs from previous update session
+    for (ngs::Voice *voice : current->voices) {
+        voice->inputs.reset_inputs();
+    }
+
+    // Racks can't be released while is_updating is set, anything else done to the queue in the meantime
+    // only applies to the next update
+    scheduler_lock.unlock();
+
+    std::vector<std::vector<FinishedVoice>> finished;
+
+    for (const VoiceStage &stage : current->stages) {
+        finished.resize(std::max(finished.size(), stage.groups.size()));
+
+        if (workers && (stage.groups.size() > 1)) {
+            workers->parallel_for(stage.groups.size(), [&](std::size_t i) {
+                process_group(kern, mem, thread_id, *current, stage.groups[i], finished[i]);
+            });
+        } else {
+            for (std::size_t i = 0; i < stage.groups.size(); i++) {
+                process_group(kern, mem, thread_id, *current, stage.groups[i], finished[i]);
+            }
         }
 
-        voice->frame_count++;
+        finish_voices(kern, mem, thread_id, finished);
     }
 
+    scheduler_lock.lock();
+
     while (!operations_pending.empty()) {
         OperationPending &op = operations_pending.front();
 
@@ -236,6 +394,7 @@ bool VoiceScheduler::resort_to_respect_dependencies(const MemState &mem, Voice *
                 {
                     const std::lock_guard<std::recursive_mutex> guard(mutex);
                     std::rotate(queue.begin() + dest_pos, queue.begin() + dest_pos + 1, queue.end());
+                    graph_dirty = true;
                 }
 
                 resort_to_respect_dependencies(mem, dest);
@@ -258,6 +417,11 @@ Ptr<Patch> VoiceScheduler::patch(const MemState &mem, PatchSetupInfo *info) {
         return patch;
     }
 
+    {
+        const std::lock_guard<std::recursive_mutex> guard(mutex);
+        graph_dirty = true;
+    }
+
     const std::int32_t source_pos = get_position(source);
     const std::int32_t dest_pos = get_position(dest);
 
@@ -0,0 +1,311 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+using namespace ngs::dsp;
+
+namespace {
+constexpr float SAMPLE_RATE = 48000.0f;
+
+// Blocks are processed one granule at a time, like the modules do
+constexpr std::size_t GRANULARITY = 256;
+
+double to_db(const double gain) {
+    return 20.0 * std::log10(gain);
+}
+
+std::vector<float> stereo_sine(const float frequency, const std::size_t frames) {
+    std::vector<float> result(frames * 2);
+    for (std::size_t i = 0; i < frames; i++) {
+        const float value = static_cast<float>(std::sin(2.0 * std::numbers::pi * frequency * i / SAMPLE_RATE));
+        result[i * 2] = value;
+        result[i * 2 + 1] = value;
+    }
+
+    return result;
+}
+
+template <typename Processor>
+void process_in_granules(Processor &&processor, std::vector<float> &samples) {
+    const std::size_t frames = samples.size() / 2;
+    for (std::size_t offset = 0; offset < frames; offset += GRANULARITY) {
+        processor(samples.data() + offset * 2, std::min(GRANULARITY, frames - offset));
+    }
+}
+
+// Amplitude of the given frequency in one channel over [start, end), by projection on sin and cos
+double measure_amplitude(const std::vector<float> &samples, const int channel, const float frequency, const std::size_t start, const std::size_t end) {
+    double in_phase = 0.0;
+    double quadrature = 0.0;
+
+    for (std::size_t i = start; i < end; i++) {
+        const double phase = 2.0 * std::numbers::pi * frequency * i / SAMPLE_RATE;
+        in_phase += samples[i * 2 + channel] * std::sin(phase);
+        quadrature += samples[i * 2 + channel] * std::cos(phase);
+    }
+
+    return 2.0 * std::hypot(in_phase, quadrature) / static_cast<double>(end - start);
+}
+
+double measure_cascade(BiquadCascade &cascade, const float frequency) {
+    const std::size_t frames = static_cast<std::size_t>(SAMPLE_RATE);
+    std::vector<float> samples = stereo_sine(frequency, frames);
+
+    cascade.reset();
+    process_in_granules([&](float *block, std::size_t count) { cascade.process(block, count); }, samples);
+
+    // Skip the first half, the filter needs some time to settle
+    const double left = measure_amplitude(samples, 0, frequency, frames / 2, frames);
+    const double right = measure_amplitude(samples, 1, frequency, frames / 2, frames);
+    EXPECT_NEAR(left, right, 1e-6);
+
+    return left;
+}
+
+double energy(const std::vector<float> &samples, const std::size_t start, const std::size_t end) {
+    double result = 0.0;
+    for (std::size_t i = start * 2; i < end * 2; i++) {
+        result += static_cast<double>(samples[i]) * samples[i];
+    }
+
+    return result;
+}
+} // namespace
+
+TEST(ngs_dsp, biquad_designs_hit_their_targets) {
+    const float gain = std::pow(10.0f, 6.0f / 20.0f);
+
+    // Peak and shelves reach the requested gain, the other types their textbook values
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::PEAK, SAMPLE_RATE, 1000.0f, 2.0f, gain), SAMPLE_RATE, 1000.0f)), 6.0, 0.01);
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::LOW_SHELF, SAMPLE_RATE, 500.0f, 0.7071f, gain), SAMPLE_RATE, 10.0f)), 6.0, 0.05);
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::LOW_SHELF, SAMPLE_RATE, 500.0f, 0.7071f, gain), SAMPLE_RATE, 20000.0f)), 0.0, 0.05);
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::HIGH_SHELF, SAMPLE_RATE, 2000.0f, 0.7071f, gain), SAMPLE_RATE, 23000.0f)), 6.0, 0.05);
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::HIGH_SHELF, SAMPLE_RATE, 2000.0f, 0.7071f, gain), SAMPLE_RATE, 10.0f)), 0.0, 0.05);
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::LOW_PASS, SAMPLE_RATE, 1000.0f, 0.7071f, 1.0f), SAMPLE_RATE, 1000.0f)), -3.01, 0.01);
+    EXPECT_NEAR(to_db(biquad_response(design_biquad(FilterType::HIGH_PASS, SAMPLE_RATE, 1000.0f, 0.7071f, 1.0f), SAMPLE_RATE, 1000.0f)), -3.01, 0.01);
+    EXPECT_NEAR(biquad_response(design_biquad(FilterType::BAND_PASS, SAMPLE_RATE, 3000.0f, 4.0f, 1.0f), SAMPLE_RATE, 3000.0f), 1.0, 1e-4);
+    EXPECT_LT(biquad_response(design_biquad(FilterType::NOTCH, SAMPLE_RATE, 3000.0f, 4.0f, 1.0f), SAMPLE_RATE, 3000.0f), 1e-3);
+    EXPECT_NEAR(biquad_response(design_biquad(FilterType::OFF, SAMPLE_RATE, 3000.0f, 4.0f, 1.0f), SAMPLE_RATE, 3000.0f), 1.0, 1e-9);
+}
+
+TEST(ngs_dsp, biquad_output_matches_reference_response) {
+    struct Design {
+        FilterType type;
+        float frequency;
+        float q;
+        float gain_db;
+    };
+
+    const Design designs[] = {
+        { FilterType::LOW_PASS, 800.0f, 0.7071f, 0.0f },
+        { FilterType::HIGH_PASS, 2500.0f, 1.5f, 0.0f },
+        { FilterType::BAND_PASS, 1200.0f, 3.0f, 0.0f },
+        { FilterType::NOTCH, 5000.0f, 2.0f, 0.0f },
+        { FilterType::PEAK, 1000.0f, 1.0f, -9.0f },
+        { FilterType::LOW_SHELF, 300.0f, 0.7071f, 4.0f },
+        { FilterType::HIGH_SHELF, 6000.0f, 0.7071f, -6.0f },
+    };
+
+    const float probes[] = { 100.0f, 440.0f, 1000.0f, 2500.0f, 7000.0f, 15000.0f };
+
+    for (const Design &design : designs) {
+        BiquadCascade cascade;
+        cascade.bands[0] = design_biquad(design.type, SAMPLE_RATE, design.frequency, design.q, std::pow(10.0f, design.gain_db / 20.0f));
+        cascade.band_count = 1;
+
+        for (const float probe : probes) {
+            const double expected = biquad_response(cascade.bands[0], SAMPLE_RATE, probe);
+            const double measured = measure_cascade(cascade, probe);
+
+            // Deep notches are compared in absolute terms, where dB would blow up
+            if (expected < 0.01) {
+                EXPECT_NEAR(measured, expected, 1e-3) << static_cast<int>(design.type) << " at " << probe;
+            } else {
+                EXPECT_NEAR(to_db(measured), to_db(expected), 0.1) << static_cast<int>(design.type) << " at " << probe;
+            }
+        }
+    }
+}
+
+TEST(ngs_dsp, biquad_cascade_multiplies_responses) {
+    BiquadCascade cascade;
+    cascade.bands[0] = design_biquad(FilterType::LOW_SHELF, SAMPLE_RATE, 200.0f, 0.7071f, 2.0f);
+    cascade.bands[1] = design_biquad(FilterType::PEAK, SAMPLE_RATE, 1000.0f, 1.0f, 0.5f);
+    cascade.bands[2] = design_biquad(FilterType::PEAK, SAMPLE_RATE, 4000.0f, 2.0f, 1.5f);
+    cascade.bands[3] = design_biquad(FilterType::LOW_PASS, SAMPLE_RATE, 12000.0f, 0.7071f, 1.0f);
+    cascade.band_count = 4;
+
+    for (const float probe : { 60.0f, 1000.0f, 3500.0f, 9000.0f }) {
+        double expected = 1.0;
+        for (const BiquadCoefficients &band : cascade.bands) {
+            expected *= biquad_response(band, SAMPLE_RATE, probe);
+        }
+
+        EXPECT_NEAR(to_db(measure_cascade(cascade, probe)), to_db(expected), 0.1) << probe;
+    }
+}
+
+TEST(ngs_dsp, compressor_settles_on_static_curve) {
+    for (const bool rms : { false, true }) {
+        Compressor compressor;
+        compressor.configure({ -20.0f, 4.0f, 1.0f, 50.0f, 0.0f, rms }, SAMPLE_RATE);
+
+        // A constant level of -6 dB goes 14 dB over the threshold, 4:1 only lets 3.5 dB of it through
+        std::vector<float> samples(static_cast<std::size_t>(SAMPLE_RATE) * 2, 0.5f);
+        process_in_granules([&](float *block, std::size_t count) { compressor.process(block, count); }, samples);
+
+        const double expected_db = -20.0 + (to_db(0.5) + 20.0) / 4.0;
+        EXPECT_NEAR(to_db(samples.back()), expected_db, 0.1);
+        EXPECT_NEAR(to_db(samples[samples.size() - 2]), expected_db, 0.1);
+        EXPECT_NEAR(compressor.static_gain_db(static_cast<float>(to_db(0.5))), expected_db - to_db(0.5), 1e-3);
+    }
+
+    // Under the threshold only the makeup gain is applied
+    Compressor compressor;
+    compressor.configure({ -20.0f, 4.0f, 1.0f, 50.0f, 3.0f, false }, SAMPLE_RATE);
+
+    std::vector<float> samples(static_cast<std::size_t>(SAMPLE_RATE) * 2, 0.05f);
+    process_in_granules([&](float *block, std::size_t count) { compressor.process(block, count); }, samples);
+    EXPECT_NEAR(to_db(samples.back()), to_db(0.05) + 3.0, 0.01);
+}
+
+TEST(ngs_dsp, compressor_attack_is_gradual) {
+    Compressor compressor;
+    compressor.configure({ -20.0f, 10.0f, 10.0f, 100.0f, 0.0f, false }, SAMPLE_RATE);
+
+    std::vector<float> samples(GRANULARITY * 2, 1.0f);
+    compressor.process(samples.data(), GRANULARITY);
+
+    // The first samples get through almost untouched, the gain then keeps on going down
+    EXPECT_GT(samples[0], 0.9f);
+    for (std::size_t i = 1; i < GRANULARITY; i++) {
+        EXPECT_LE(samples[i * 2], samples[(i - 1) * 2]);
+    }
+}
+
+TEST(ngs_dsp, distortion_is_bounded_and_odd) {
+    const DistortionSettings settings = { 4.0f, 0.8f, 1.0f, 0.0f };
+
+    std::vector<float> input(2001);
+    for (std::size_t i = 0; i < input.size(); i++) {
+        input[i] = -5.0f + 10.0f * static_cast<float>(i) / static_cast<float>(input.size() - 1);
+    }
+
+    std::vector<float> output = input;
+    distort(output.data(), output.size(), settings);
+
+    for (std::size_t i = 0; i < output.size(); i++) {
+        EXPECT_LE(std::abs(output[i]), settings.clip_level + 1e-6f);
+        EXPECT_NEAR(output[i], -output[output.size() - 1 - i], 1e-6f);
+
+        // Monotonic, so no step anywhere, including where it reaches the clip level
+        if (i != 0) {
+            EXPECT_GE(output[i], output[i - 1]);
+        }
+    }
+
+    // Linear with a slope of 1.5 * drive around zero
+    float small = 1e-4f;
+    distort(&small, 1, settings);
+    EXPECT_NEAR(small, 1.5f * settings.drive * 1e-4f, 1e-7f);
+}
+
+TEST(ngs_dsp, distortion_mixes_wet_and_dry) {
+    const float input[] = { -0.9f, -0.2f, 0.0f, 0.1f, 0.6f };
+
+    float wet[5];
+    float mixed[5];
+    std::copy(std::begin(input), std::end(input), wet);
+    std::copy(std::begin(input), std::end(input), mixed);
+
+    distort(wet, 5, { 2.0f, 1.0f, 1.0f, 0.0f });
+    distort(mixed, 5, { 2.0f, 1.0f, 0.25f, 0.5f });
+
+    for (int i = 0; i < 5; i++) {
+        EXPECT_NEAR(mixed[i], 0.25f * wet[i] + 0.5f * input[i], 1e-6f);
+    }
+}
+
+TEST(ngs_dsp, reverb_decays_at_requested_rate) {
+    constexpr float DECAY_TIME = 2.0f;
+
+    auto reverb = std::make_unique<Reverb>();
+    reverb->configure({ DECAY_TIME, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f }, SAMPLE_RATE);
+
+    const std::size_t burst = static_cast<std::size_t>(SAMPLE_RATE / 2);
+    const std::size_t frames = static_cast<std::size_t>(SAMPLE_RATE * 2);
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::vector<float> samples(frames * 2, 0.0f);
+    for (std::size_t i = 0; i < burst * 2; i++) {
+        samples[i] = distribution(generator);
+    }
+
+    process_in_granules([&](float *block, std::size_t count) { reverb->process(block, count); }, samples);
+
+    // Half a second apart, the tail must have lost 60 dB * 0.5 / DECAY_TIME
+    const std::size_t window = static_cast<std::size_t>(SAMPLE_RATE / 10);
+    const std::size_t first = burst + window;
+    const std::size_t second = first + static_cast<std::size_t>(SAMPLE_RATE / 2);
+
+    const double drop = 10.0 * std::log10(energy(samples, first, first + window) / energy(samples, second, second + window));
+    EXPECT_NEAR(drop, 60.0 * 0.5 / DECAY_TIME, 2.0);
+}
+
+TEST(ngs_dsp, reverb_stays_stable) {
+    auto reverb = std::make_unique<Reverb>();
+    reverb->configure({ 20.0f, 0.2f, 0.05f, 1.0f, 1.0f, 1.0f }, SAMPLE_RATE);
+
+    std::mt19937 generator(99);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    std::vector<float> samples(static_cast<std::size_t>(SAMPLE_RATE) * 10 * 2);
+    for (float &sample : samples) {
+        sample = distribution(generator);
+    }
+
+    process_in_granules([&](float *block, std::size_t count) { reverb->process(block, count); }, samples);
+
+    for (const float sample : samples) {
+        ASSERT_TRUE(std::isfinite(sample));
+        ASSERT_LT(std::abs(sample), 100.0f);
+    }
+}
+
+TEST(ngs_dsp, reverb_pre_delay_holds_back_the_tail) {
+    auto reverb = std::make_unique<Reverb>();
+    reverb->configure({ 1.0f, 1.0f, 0.05f, 1.0f, 1.0f, 0.0f }, SAMPLE_RATE);
+
+    std::vector<float> samples(static_cast<std::size_t>(SAMPLE_RATE) * 2, 0.0f);
+    samples[0] = samples[1] = 1.0f;
+    process_in_granules([&](float *block, std::size_t count) { reverb->process(block, count); }, samples);
+
+    // Nothing can come out before the pre-delay and the shortest comb have both elapsed
+    const std::size_t silent = static_cast<std::size_t>(SAMPLE_RATE * 0.05f) + 1116 * 48000 / 44100;
+    EXPECT_EQ(energy(samples, 0, silent), 0.0);
+    EXPECT_GT(energy(samples, silent, samples.size() / 2), 0.0);
+}
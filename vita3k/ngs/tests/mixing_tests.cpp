@@ -0,0 +1,152 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/mixing.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+// Lengths hitting every vector width and leftover case
+constexpr std::size_t LENGTHS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 255, 256, 1023 };
+
+std::vector<float> random_samples(const std::size_t count, const float range, const unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-range, range);
+
+    std::vector<float> result(count);
+    for (float &sample : result) {
+        sample = distribution(generator);
+    }
+
+    return result;
+}
+
+// Bitwise, so that -0.0 and 0.0 are told apart
+bool same_bits(const std::vector<float> &lhs, const std::vector<float> &rhs) {
+    return (lhs.size() == rhs.size()) && (std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(float)) == 0);
+}
+} // namespace
+
+TEST(ngs_mixing, mix_stereo_matches_scalar) {
+    const float matrices[][2][2] = {
+        { { 1.0f, 0.0f }, { 0.0f, 1.0f } },
+        { { 0.7f, 0.2f }, { -0.3f, 1.3f } },
+        { { 2.5f, 2.5f }, { 2.5f, 2.5f } },
+    };
+
+    for (const std::size_t frames : LENGTHS) {
+        for (const auto &matrix : matrices) {
+            const std::vector<float> src = random_samples(frames * 2, 1.0f, static_cast<unsigned>(frames));
+            std::vector<float> expected = random_samples(frames * 2, 1.0f, static_cast<unsigned>(frames + 1));
+            std::vector<float> result = expected;
+
+            // Mix a few times over the same buffer so that clamped values get mixed again
+            for (int pass = 0; pass < 3; pass++) {
+                ngs::mix_stereo_scalar(expected.data(), src.data(), matrix, frames);
+                ngs::mix_stereo(result.data(), src.data(), matrix, frames);
+            }
+
+            ASSERT_TRUE(same_bits(result, expected)) << frames << " frames";
+        }
+    }
+}
+
+TEST(ngs_mixing, mix_stereo_clamps) {
+    const float matrix[2][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f } };
+    std::vector<float> dest = { 0.9f, -0.9f, 0.5f, 0.5f };
+    const std::vector<float> src = { 0.5f, -0.5f, 0.25f, -0.25f };
+
+    ngs::mix_stereo(dest.data(), src.data(), matrix, 2);
+
+    ASSERT_EQ(dest[0], 1.0f);
+    ASSERT_EQ(dest[1], -1.0f);
+    ASSERT_EQ(dest[2], 0.75f);
+    ASSERT_EQ(dest[3], 0.25f);
+}
+
+TEST(ngs_mixing, apply_gain_matches_scalar) {
+    for (const std::size_t count : LENGTHS) {
+        std::vector<float> expected = random_samples(count, 4.0f, static_cast<unsigned>(count));
+        std::vector<float> result = expected;
+
+        ngs::apply_gain_scalar(expected.data(), 0.37f, count);
+        ngs::apply_gain(result.data(), 0.37f, count);
+
+        ASSERT_TRUE(same_bits(result, expected)) << count << " samples";
+    }
+}
+
+TEST(ngs_mixing, float_to_s16_matches_scalar) {
+    for (const std::size_t count : LENGTHS) {
+        // Out of range values to cover the saturation
+        std::vector<float> src = random_samples(count, 1.5f, static_cast<unsigned>(count));
+        if (count >= 4) {
+            src[0] = 1.0f;
+            src[1] = -1.0f;
+            src[2] = 32767.0f / 32768.0f;
+            src[3] = -0.0f;
+        }
+
+        std::vector<std::int16_t> expected(count);
+        std::vector<std::int16_t> result(count);
+        ngs::float_to_s16_scalar(src.data(), expected.data(), count);
+        ngs::float_to_s16(src.data(), result.data(), count);
+
+        ASSERT_EQ(result, expected) << count << " samples";
+    }
+}
+
+TEST(ngs_mixing, s16_to_float_matches_scalar) {
+    std::vector<std::int16_t> src(1023);
+    for (std::size_t i = 0; i < src.size(); i++) {
+        src[i] = static_cast<std::int16_t>(i * 97 - 32768);
+    }
+    src[0] = -32768;
+    src[1] = 32767;
+
+    for (const std::size_t count : LENGTHS) {
+        std::vector<float> expected(count);
+        std::vector<float> result(count);
+        ngs::s16_to_float_scalar(src.data(), expected.data(), count);
+        ngs::s16_to_float(src.data(), result.data(), count);
+
+        ASSERT_TRUE(same_bits(result, expected)) << count << " samples";
+    }
+}
+
+TEST(ngs_mixing, interleave_round_trip) {
+    for (const std::size_t frames : LENGTHS) {
+        const std::vector<float> left = random_samples(frames, 1.0f, static_cast<unsigned>(frames));
+        const std::vector<float> right = random_samples(frames, 1.0f, static_cast<unsigned>(frames + 1));
+
+        std::vector<float> expected(frames * 2);
+        std::vector<float> interleaved(frames * 2);
+        ngs::interleave_scalar(left.data(), right.data(), expected.data(), frames);
+        ngs::interleave(left.data(), right.data(), interleaved.data(), frames);
+        ASSERT_TRUE(same_bits(interleaved, expected)) << frames << " frames";
+
+        std::vector<float> new_left(frames);
+        std::vector<float> new_right(frames);
+        ngs::deinterleave(interleaved.data(), new_left.data(), new_right.data(), frames);
+        ASSERT_TRUE(same_bits(new_left, left)) << frames << " frames";
+        ASSERT_TRUE(same_bits(new_right, right)) << frames << " frames";
+    }
+}
@@ -0,0 +1,215 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/resampler.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <vector>
+
+using namespace ngs;
+
+namespace {
+std::vector<float> stereo_sine(const std::int32_t frames, const double frequency, const std::int32_t rate, const std::int32_t start = 0) {
+    std::vector<float> result(frames * 2);
+    for (std::int32_t i = 0; i < frames; i++) {
+        const float value = static_cast<float>(std::sin(2.0 * std::numbers::pi * frequency * (start + i) / rate));
+        result[i * 2] = value;
+        result[i * 2 + 1] = -value;
+    }
+
+    return result;
+}
+
+const std::uint8_t *as_bytes(const std::vector<float> &samples) {
+    return reinterpret_cast<const std::uint8_t *>(samples.data());
+}
+} // namespace
+
+TEST(resampler, same_rate_is_exact) {
+    LinearResampler resampler({ 48000, 48000, 2, ResamplerFormat::F32 });
+    const std::vector<float> input = stereo_sine(256, 440.0, 48000);
+
+    std::vector<float> output(resampler.get_out_frames(256) * 2);
+    ASSERT_EQ(resampler.convert(as_bytes(input), 256, output.data(), resampler.get_out_frames(256)), 256);
+
+    for (std::size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQ(output[i], input[i]);
+    }
+}
+
+TEST(resampler, linear_follows_sine) {
+    constexpr std::int32_t IN_RATE = 22050;
+    constexpr std::int32_t OUT_RATE = 48000;
+    constexpr double FREQUENCY = 440.0;
+
+    LinearResampler resampler({ IN_RATE, OUT_RATE, 2, ResamplerFormat::F32 });
+    const std::vector<float> input = stereo_sine(1024, FREQUENCY, IN_RATE);
+
+    const std::int32_t max_out = resampler.get_out_frames(1024);
+    std::vector<float> output(max_out * 2);
+    const std::int32_t written = resampler.convert(as_bytes(input), 1024, output.data(), max_out);
+    // Everything up to the last input frame
+    ASSERT_EQ(written, 1023 * OUT_RATE / IN_RATE + 1);
+
+    // A low tone sampled this finely stays within a hair of the real curve
+    for (std::int32_t i = 0; i < written; i++) {
+        const double expected = std::sin(2.0 * std::numbers::pi * FREQUENCY * i / OUT_RATE);
+        ASSERT_NEAR(output[i * 2], expected, 2e-3);
+        ASSERT_NEAR(output[i * 2 + 1], -expected, 2e-3);
+    }
+}
+
+TEST(resampler, blocks_are_continuous) {
+    const ResamplerKey key{ 32000, 48000, 2, ResamplerFormat::F32 };
+    const std::vector<float> input = stereo_sine(960, 1000.0, 32000);
+
+    LinearResampler whole(key);
+    std::vector<float> expected(whole.get_out_frames(960) * 2);
+    expected.resize(whole.convert(as_bytes(input), 960, expected.data(), whole.get_out_frames(960)) * 2);
+
+    // Feeding it in uneven pieces must not change a single sample
+    LinearResampler pieces(key);
+    std::vector<float> result;
+    std::int32_t offset = 0;
+    for (const std::int32_t size : { 1, 7, 100, 333, 519 }) {
+        std::vector<float> output(pieces.get_out_frames(size) * 2);
+        const std::int32_t written = pieces.convert(as_bytes(input) + offset * sizeof(float) * 2, size, output.data(), pieces.get_out_frames(size));
+        result.insert(result.end(), output.begin(), output.begin() + written * 2);
+        offset += size;
+    }
+
+    ASSERT_EQ(result.size(), expected.size());
+    for (std::size_t i = 0; i < result.size(); i++) {
+        ASSERT_NEAR(result[i], expected[i], 1e-6);
+    }
+}
+
+TEST(resampler, mono_s16_goes_to_both_sides) {
+    LinearResampler resampler({ 48000, 48000, 1, ResamplerFormat::S16 });
+    const std::int16_t input[4] = { 0, 16384, -16384, 32767 };
+
+    float output[8];
+    ASSERT_EQ(resampler.convert(reinterpret_cast<const std::uint8_t *>(input), 4, output, 4), 4);
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_FLOAT_EQ(output[i * 2], input[i] / 32768.0f);
+        ASSERT_FLOAT_EQ(output[i * 2 + 1], input[i] / 32768.0f);
+    }
+}
+
+TEST(resampler, linear_enough) {
+    ASSERT_TRUE(ResamplerPool::is_linear_enough({ 48000, 48000, 2, ResamplerFormat::F32 }));
+    ASSERT_TRUE(ResamplerPool::is_linear_enough({ 46000, 48000, 2, ResamplerFormat::F32 }));
+    ASSERT_TRUE(ResamplerPool::is_linear_enough({ 50000, 48000, 2, ResamplerFormat::F32 }));
+    ASSERT_FALSE(ResamplerPool::is_linear_enough({ 22050, 48000, 2, ResamplerFormat::F32 }));
+    ASSERT_FALSE(ResamplerPool::is_linear_enough({ 44100, 48000, 2, ResamplerFormat::F32 }));
+    ASSERT_FALSE(ResamplerPool::is_linear_enough({ 96000, 48000, 2, ResamplerFormat::F32 }));
+}
+
+TEST(resampler, pool_reuses_released) {
+    ResamplerPool pool;
+    const ResamplerKey key{ 44100, 48000, 2, ResamplerFormat::F32 };
+
+    Resampler *first = pool.acquire(key);
+    Resampler *second = pool.acquire(key);
+    ASSERT_NE(first, second);
+    ASSERT_EQ(pool.size(), 2);
+
+    pool.release(first);
+    ASSERT_EQ(pool.acquire(key), first);
+    ASSERT_EQ(pool.size(), 2);
+
+    // A different key never gets a resampler configured for another one
+    Resampler *other = pool.acquire({ 24000, 48000, 2, ResamplerFormat::F32 });
+    ASSERT_NE(other, first);
+    ASSERT_NE(other, second);
+    ASSERT_EQ(pool.size(), 3);
+}
+
+TEST(resampler, rebind_keeps_matching) {
+    ResamplerPool pool;
+    Resampler *voice = nullptr;
+
+    Resampler *bound = pool.rebind(voice, { 44100, 48000, 2, ResamplerFormat::F32 });
+    ASSERT_EQ(bound, voice);
+    ASSERT_EQ(pool.rebind(voice, { 44100, 48000, 2, ResamplerFormat::F32 }), bound);
+
+    pool.rebind(voice, { 32000, 48000, 2, ResamplerFormat::F32 });
+    ASSERT_EQ(voice->key.in_rate, 32000);
+
+    // The old one went back to the pool
+    ASSERT_EQ(pool.acquire({ 44100, 48000, 2, ResamplerFormat::F32 }), bound);
+    ASSERT_EQ(pool.size(), 2);
+}
+
+TEST(resampler, benchmark) {
+    constexpr std::int32_t VOICE_COUNT = 64;
+    constexpr std::int32_t GRANULARITY = 512;
+    constexpr std::int32_t OUT_RATE = 48000;
+    constexpr int ITERATIONS = 50;
+    // Pitch scaling pushes some of them past the output rate
+    constexpr std::int32_t RATES[] = { 8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000, 64000, 96000 };
+
+    std::vector<ResamplerKey> keys;
+    std::vector<std::vector<float>> inputs;
+    for (std::int32_t i = 0; i < VOICE_COUNT; i++) {
+        const std::int32_t rate = RATES[i % std::size(RATES)];
+        const std::int32_t frames = GRANULARITY * rate / OUT_RATE + 1;
+
+        keys.push_back({ rate, OUT_RATE, 2, ResamplerFormat::F32 });
+        inputs.push_back(stereo_sine(frames, 220.0 + i * 10.0, rate));
+    }
+
+    std::vector<float> output(GRANULARITY * 4 * 2);
+    using clock = std::chrono::steady_clock;
+
+    // Every voice keeps the resampler matching its rate
+    ResamplerPool pool;
+    std::vector<Resampler *> bound(VOICE_COUNT, nullptr);
+
+    const auto pool_start = clock::now();
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+        for (std::int32_t i = 0; i < VOICE_COUNT; i++) {
+            Resampler *resampler = pool.rebind(bound[i], keys[i]);
+            resampler->convert(as_bytes(inputs[i]), inputs[i].size() / 2, output.data(), GRANULARITY * 4);
+        }
+    }
+    const auto pool_time = std::chrono::duration<double, std::nano>(clock::now() - pool_start).count() / (ITERATIONS * VOICE_COUNT);
+
+    // One resampler for everyone, configured again whenever the next voice plays at another rate
+    std::unique_ptr<Resampler> shared;
+
+    const auto shared_start = clock::now();
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+        for (std::int32_t i = 0; i < VOICE_COUNT; i++) {
+            if (!shared || !(shared->key == keys[i])) {
+                shared = create_resampler(keys[i]);
+            }
+            shared->convert(as_bytes(inputs[i]), inputs[i].size() / 2, output.data(), GRANULARITY * 4);
+        }
+    }
+    const auto shared_time = std::chrono::duration<double, std::nano>(clock::now() - shared_start).count() / (ITERATIONS * VOICE_COUNT);
+
+    std::printf("resampler %d voices at mixed rates: pooled %.0fns, shared %.0fns per voice granule\n", VOICE_COUNT, pool_time, shared_time);
+
+    ASSERT_EQ(pool.size(), VOICE_COUNT);
+}
@@ -0,0 +1,307 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/state.h>
+#include <ngs/definitions/master.h>
+#include <ngs/definitions/passthrough.h>
+#include <ngs/definitions/player.h>
+#include <ngs/modules/player.h>
+#include <ngs/state.h>
+#include <ngs/system.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Headless rig: guest memory is a plain host buffer and no module ever calls back into the guest,
+// so a whole system can be driven without a CPU or a kernel behind it.
+
+namespace {
+constexpr std::uint32_t GRANULARITY = 256;
+
+struct ToneState {
+    std::uint32_t seed;
+};
+
+// Source writing a deterministic noise, loud enough that the mixes clip and the mixing order matters
+struct ToneModule : public ngs::Module {
+    ToneModule()
+        : ngs::Module(ngs::BussType::BUSS_NORMAL_PLAYER) {}
+
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ngs::ModuleData &data, std::unique_lock<std::mutex> &voice_lock) override {
+        ToneState *state = data.get_state<ToneState>();
+
+        data.extra_storage.resize(GRANULARITY * 2 * sizeof(float));
+        float *samples = reinterpret_cast<float *>(data.extra_storage.data());
+
+        for (std::uint32_t i = 0; i < GRANULARITY * 2; i++) {
+            state->seed = state->seed * 1664525 + 1013904223;
+            samples[i] = static_cast<float>(state->seed >> 8) / static_cast<float>(1 << 24) - 0.5f;
+        }
+
+        data.parent->products[0].data = data.extra_storage.data();
+        return false;
+    }
+
+    std::size_t get_buffer_parameter_size() const override {
+        return ngs::default_normal_parameter_size;
+    }
+};
+
+struct ToneDefinition : public ngs::VoiceDefinition {
+    void new_modules(std::vector<std::unique_ptr<ngs::Module>> &mods) override {
+        mods.push_back(std::make_unique<ToneModule>());
+    }
+
+    std::size_t get_total_buffer_parameter_size() const override {
+        return ngs::default_normal_parameter_size;
+    }
+
+    std::uint32_t output_count() const override { return 1; }
+};
+
+struct NgsRig {
+    MemState mem;
+    KernelState kern;
+    ngs::State ngs;
+    ngs::System *system = nullptr;
+
+    Address next_address = 0x1000;
+
+    Ptr<ToneDefinition> tone_definition;
+    Ptr<ngs::passthrough::VoiceDefinition> bus_definition;
+    Ptr<ngs::master::VoiceDefinition> master_definition;
+
+    NgsRig() {
+        constexpr std::size_t MEMORY_SIZE = 16 * 1024 * 1024;
+        mem.memory = Memory(new std::uint8_t[MEMORY_SIZE](), [](std::uint8_t *memory) { delete[] memory; });
+
+        tone_definition = place<ToneDefinition>();
+        bus_definition = place<ngs::passthrough::VoiceDefinition>();
+        master_definition = place<ngs::master::VoiceDefinition>();
+
+        ngs::SystemInitParameters params = {};
+        params.granularity = GRANULARITY;
+        params.sample_rate = 48000;
+        params.max_voices = 256;
+
+        const std::uint32_t system_size = 64 * 1024;
+        const Ptr<void> system_memspace = alloc(system_size);
+        ngs::init_system(ngs, mem, &params, system_memspace, system_size);
+        system = system_memspace.cast<ngs::System>().get(mem);
+    }
+
+    ~NgsRig() {
+        ngs::release_system(ngs, mem, system);
+    }
+
+    Ptr<void> alloc(const std::uint32_t size) {
+        const Address address = next_address;
+        next_address += (size + 0xFFF) & ~0xFFF;
+        return Ptr<void>(address);
+    }
+
+    template <typename T>
+    Ptr<T> place() {
+        const Ptr<T> result = alloc(sizeof(T)).template cast<T>();
+        new (result.get(mem)) T();
+        return result;
+    }
+
+    ngs::Rack *create_rack(const Ptr<ngs::VoiceDefinition> definition, const std::int32_t voice_count) {
+        ngs::RackDescription description = {};
+        description.definition = definition;
+        description.voice_count = voice_count;
+        description.channels_per_voice = 2;
+        description.max_patches_per_input = 32;
+        description.patches_per_output = 4;
+
+        ngs::BufferParamsInfo info = {};
+        info.size = 256 * 1024;
+        info.data = alloc(info.size);
+
+        EXPECT_TRUE(ngs::init_rack(ngs, mem, system, &info, &description));
+        return info.data.cast<ngs::Rack>().get(mem);
+    }
+
+    ngs::Voice *voice(ngs::Rack *rack, const std::size_t index) {
+        return rack->voices[index].get(mem);
+    }
+
+    ngs::Patch *patch(ngs::Voice *source, ngs::Voice *dest, const float volume, const float cross_volume = 0.0f) {
+        ngs::PatchSetupInfo info = {};
+        info.source = Ptr<ngs::Voice>(source, mem);
+        info.source_output_index = 0;
+        info.source_output_subindex = -1;
+        info.dest = Ptr<ngs::Voice>(dest, mem);
+        info.dest_input_index = 0;
+
+        ngs::Patch *result = system->voice_scheduler.patch(mem, &info).get(mem);
+        EXPECT_NE(result, nullptr);
+
+        result->volume_matrix[0][0] = volume;
+        result->volume_matrix[1][1] = volume;
+        result->volume_matrix[1][0] = cross_volume;
+        return result;
+    }
+
+    void play(ngs::Voice *voice) {
+        EXPECT_TRUE(system->voice_scheduler.play(mem, voice));
+    }
+
+    std::vector<std::int16_t> update(ngs::Voice *master) {
+        system->voice_scheduler.update(kern, mem, 0);
+
+        const std::vector<std::uint8_t> &output = master->datas[1].voice_state_data;
+        std::vector<std::int16_t> result(output.size() / sizeof(std::int16_t));
+        std::memcpy(result.data(), output.data(), output.size());
+        return result;
+    }
+};
+
+// Three source racks, two of them going through submix buses and one straight to the master,
+// with one source patched to both a bus and the master
+std::vector<std::int16_t> render_rack(const std::size_t thread_count, const int frames) {
+    NgsRig rig;
+    rig.system->voice_scheduler.set_thread_count(thread_count);
+
+    ngs::Rack *master_rack = rig.create_rack(rig.master_definition, 1);
+    ngs::Rack *bus_rack = rig.create_rack(rig.bus_definition, 2);
+    std::vector<ngs::Rack *> tone_racks;
+    for (int i = 0; i < 3; i++) {
+        tone_racks.push_back(rig.create_rack(rig.tone_definition, 24));
+    }
+
+    ngs::Voice *master = rig.voice(master_rack, 0);
+    ngs::Voice *buses[2] = { rig.voice(bus_rack, 0), rig.voice(bus_rack, 1) };
+
+    rig.patch(buses[0], master, 0.5f);
+    rig.patch(buses[1], master, 0.75f);
+
+    for (std::size_t r = 0; r < tone_racks.size(); r++) {
+        for (std::size_t v = 0; v < 24; v++) {
+            ngs::Voice *tone = rig.voice(tone_racks[r], v);
+            tone->datas[0].get_state<ToneState>()->seed = static_cast<std::uint32_t>(r * 100 + v);
+
+            const float volume = 0.1f + 0.05f * static_cast<float>(v % 7);
+            if (r == 2) {
+                rig.patch(tone, master, volume, volume * 0.25f);
+            } else {
+                rig.patch(tone, buses[r], volume, volume * 0.25f);
+            }
+
+            if (v == 3) {
+                rig.patch(tone, master, volume, volume * 0.25f);
+            }
+        }
+    }
+
+    rig.play(master);
+    rig.play(buses[0]);
+    rig.play(buses[1]);
+    for (ngs::Rack *rack : tone_racks) {
+        for (std::size_t v = 0; v < 24; v++) {
+            rig.play(rig.voice(rack, v));
+        }
+    }
+
+    std::vector<std::int16_t> result;
+    for (int i = 0; i < frames; i++) {
+        const std::vector<std::int16_t> frame = rig.update(master);
+        result.insert(result.end(), frame.begin(), frame.end());
+    }
+
+    return result;
+}
+} // namespace
+
+TEST(ngs_scheduler, identical_output_across_thread_counts) {
+    const std::vector<std::int16_t> reference = render_rack(1, 32);
+    ASSERT_EQ(reference.size(), 32 * GRANULARITY * 2);
+    ASSERT_NE(std::count(reference.begin(), reference.end(), 0), reference.size());
+
+    for (const std::size_t thread_count : { 2, 3, 4, 8 }) {
+        ASSERT_EQ(render_rack(thread_count, 32), reference) << "with " << thread_count << " threads";
+    }
+}
+
+TEST(ngs_scheduler, chain_follows_patch_order) {
+    NgsRig rig;
+    rig.system->voice_scheduler.set_thread_count(4);
+
+    ngs::Rack *master_rack = rig.create_rack(rig.master_definition, 1);
+    ngs::Rack *bus_rack = rig.create_rack(rig.bus_definition, 2);
+    ngs::Rack *tone_rack = rig.create_rack(rig.tone_definition, 1);
+
+    ngs::Voice *master = rig.voice(master_rack, 0);
+    ngs::Voice *first_bus = rig.voice(bus_rack, 0);
+    ngs::Voice *second_bus = rig.voice(bus_rack, 1);
+    ngs::Voice *tone = rig.voice(tone_rack, 0);
+
+    // Played before the patches exist, the queue is only sorted once they are made
+    rig.play(tone);
+    rig.play(master);
+    rig.play(second_bus);
+    rig.play(first_bus);
+
+    rig.patch(second_bus, master, 1.0f);
+    rig.patch(first_bus, second_bus, 1.0f);
+    rig.patch(tone, first_bus, 1.0f);
+
+    tone->datas[0].get_state<ToneState>()->seed = 1234;
+    const std::vector<std::int16_t> output = rig.update(master);
+
+    // Replay the tone by hand, it goes through both buses untouched
+    ToneState expected_state = { 1234 };
+    ASSERT_EQ(output.size(), GRANULARITY * 2);
+    for (std::uint32_t i = 0; i < GRANULARITY; i++) {
+        float samples[2];
+        for (float &sample : samples) {
+            expected_state.seed = expected_state.seed * 1664525 + 1013904223;
+            sample = static_cast<float>(expected_state.seed >> 8) / static_cast<float>(1 << 24) - 0.5f;
+        }
+
+        ASSERT_EQ(output[i * 2], static_cast<std::int16_t>(samples[0] * 32768.0f));
+        ASSERT_EQ(output[i * 2 + 1], static_cast<std::int16_t>(samples[1] * 32768.0f));
+    }
+
+    // Once the source stops, nothing reaches the master anymore
+    ASSERT_TRUE(rig.system->voice_scheduler.stop(tone));
+    const std::vector<std::int16_t> silence = rig.update(master);
+    ASSERT_EQ(std::count(silence.begin(), silence.end(), 0), silence.size());
+}
+
+TEST(ngs_scheduler, released_racks_return_their_resamplers) {
+    NgsRig rig;
+    const Ptr<ngs::player::VoiceDefinition> player_definition = rig.place<ngs::player::VoiceDefinition>();
+    const ngs::ResamplerKey key = { 44100, 48000, 2, ngs::ResamplerFormat::F32 };
+
+    // Every scene makes its own rack of players and drops it once done
+    for (int scene = 0; scene < 3; scene++) {
+        ngs::Rack *rack = rig.create_rack(player_definition, 4);
+
+        for (std::size_t v = 0; v < 4; v++) {
+            ngs::player::State *state = rig.voice(rack, v)->datas[0].get_state<ngs::player::State>();
+            rig.system->resamplers.rebind(state->resampler, key);
+        }
+
+        ngs::release_rack(rig.ngs, rig.mem, rig.system, rack);
+    }
+
+    ASSERT_EQ(rig.system->resamplers.size(), 4);
+}
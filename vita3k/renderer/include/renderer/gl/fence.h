@@ -33,6 +33,9 @@ public:
     void insert();
     bool wait_for_signal();
 
+    // Check without waiting whether the GPU went past the fence
+    bool is_signaled();
+
     bool empty() const {
         return !sync_;
     }
@@ -20,38 +20,64 @@
 #include <cstdint>
 #include <glutil/object_array.h>
 #include <renderer/gl/fence.h>
+#include <renderer/ring_allocator.h>
+
+#include <deque>
+#include <memory>
 #include <tuple>
 
 namespace renderer::gl {
 
 struct RingBuffer {
 private:
-    GLObjectArray<1> buffer_;
-    Fence safe_segment_consumed_fence_;
+    struct MappedBuffer {
+        GLObjectArray<1> buffer;
+        std::uint8_t *base = nullptr;
+        std::size_t capacity = 0;
+    };
+
+    // Buffer replaced after an overflow, kept alive until the GPU is done with it
+    struct RetiredBuffer {
+        std::unique_ptr<MappedBuffer> mapped;
+        std::uint64_t fence;
+    };
+
+    std::unique_ptr<MappedBuffer> current_;
+    std::deque<RetiredBuffer> retired_;
 
-    std::uint8_t *base_;
-    std::size_t cursor_;
-    std::size_t capacity_;
+    RingAllocator allocator_;
+    std::deque<std::pair<std::uint64_t, std::unique_ptr<Fence>>> fences_;
+    std::uint64_t next_fence_;
+    std::uint64_t completed_fence_;
 
+    std::size_t max_capacity_;
     GLenum purpose_;
 
-    void create_and_map();
+    std::unique_ptr<MappedBuffer> create_and_map(const std::size_t capacity);
+    void insert_fence();
+    void poll_fences();
 
 public:
-    explicit RingBuffer(GLenum purpose, const std::size_t capacity);
-    ~RingBuffer();
+    explicit RingBuffer(GLenum purpose, const std::size_t capacity, const std::size_t max_capacity);
 
     // Allocate new data from ring buffer, return offset of the data resided in the buffer
-    // In case the data is full, it will wait for fence to notify previous draw commands has finished on previous buffer part
-    // and then reset the cursor
+    // In case the data does not fit before data the GPU may still be reading, a larger buffer is chained instead of
+    // waiting, so call handle() after every allocation
     std::pair<std::uint8_t *, std::size_t> allocate(const std::size_t data_size);
 
     // Notify the buffer that a draw call is done. This inserts a fence depends on the amount of data that has been consumed
     // previously by push
     void draw_call_done();
 
+    // Notify the buffer that a scene begins, to fence the previous one and record its usage
+    void frame_done();
+
     GLint handle() const {
-        return buffer_[0];
+        return current_ ? current_->buffer[0] : 0;
+    }
+
+    const RingAllocatorStats &stats() const {
+        return allocator_.stats();
     }
 };
 
@@ -19,8 +19,8 @@
 
 #include <glutil/object_array.h>
 #include <renderer/surface_cache.h>
+#include <renderer/surface_range_index.h>
 
-#include <array>
 #include <memory>
 #include <unordered_map>
 
@@ -33,11 +33,10 @@ struct GLRenderTarget;
 
 struct GLSurfaceCacheInfo {
     enum {
-        FLAG_DIRTY = 1 << 0,
-        FLAG_FREE = 1 << 1
+        FLAG_DIRTY = 1 << 0
     };
 
-    std::uint32_t flags = FLAG_FREE;
+    std::uint32_t flags = 0;
 };
 
 struct GLCastedTexture {
@@ -78,14 +77,13 @@ struct GLDepthStencilSurfaceCacheInfo : public GLSurfaceCacheInfo {
 
 class GLSurfaceCache : public SurfaceCache {
 private:
-    static constexpr std::uint32_t MAX_CACHE_SIZE_PER_CONTAINER = 20;
+    static constexpr std::size_t DEFAULT_CACHE_SIZE_PER_CONTAINER = 20;
 
-    std::map<std::uint64_t, std::unique_ptr<GLColorSurfaceCacheInfo>, std::greater<std::uint64_t>> color_surface_textures;
-    std::array<GLDepthStencilSurfaceCacheInfo, MAX_CACHE_SIZE_PER_CONTAINER> depth_stencil_textures;
+    // Keep this declared before the surface indexes, their remove callbacks purge framebuffers from it
     std::unordered_map<std::uint64_t, GLObjectArray<1>> framebuffer_array;
 
-    std::vector<std::uint64_t> last_use_color_surface_index;
-    std::vector<std::size_t> last_use_depth_stencil_surface_index;
+    SurfaceRangeIndex<GLColorSurfaceCacheInfo> color_surface_textures;
+    SurfaceRangeIndex<GLDepthStencilSurfaceCacheInfo> depth_stencil_textures;
 
     GLObjectArray<1> typeless_copy_buffer;
     std::size_t typeless_copy_buffer_size = 0;
@@ -97,6 +95,8 @@ private:
         const GLenum dest_upload_format, const GLenum dest_type, const GLenum source_format, const GLenum source_type,
         const int offset_x, const int offset_y, const int width, const int height, const int dest_width, const int dest_height, const std::size_t total_source_size);
 
+    void purge_framebuffers(const GLuint texture_handle, const bool is_depth_stencil);
+
 public:
     explicit GLSurfaceCache();
 
@@ -116,6 +116,17 @@ public:
         target = new_target;
     }
 
+    // Zero for either limit means unlimited. The budget is shared by color and depth stencil surfaces.
+    void set_limits(const std::size_t capacity_per_container, const std::uint64_t vram_budget);
+
+    const SurfaceCacheStats &color_surface_stats() const {
+        return color_surface_textures.stats();
+    }
+
+    const SurfaceCacheStats &depth_stencil_surface_stats() const {
+        return depth_stencil_textures.stats();
+    }
+
     std::uint64_t sourcing_color_surface_for_presentation(Ptr<const void> address, uint32_t width, uint32_t height, const std::uint32_t pitch, float *uvs, const int res_multiplier, SceFVector2 &texture_size) override;
 };
 } // namespace renderer::gl
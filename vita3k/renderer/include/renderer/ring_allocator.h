@@ -0,0 +1,156 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+
+namespace renderer {
+
+struct RingAllocatorStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes_allocated = 0;
+    // Allocations which did not fit and made the owner chain a new buffer
+    std::uint64_t overflows = 0;
+    std::uint64_t last_frame_bytes = 0;
+    // Most bytes allocated during a single frame
+    std::uint64_t frame_high_water = 0;
+};
+
+// Bookkeeping of a ring buffer shared with the GPU, without any backend object so it can be tested alone.
+//
+// Positions only ever grow, the offset in the buffer being the position modulo the capacity. Allocations are
+// grouped into segments, each closed with a fence id from the owner. A segment is reused once the owner
+// reports its fence done, so the space in use is [tail, head).
+class RingAllocator {
+public:
+    static constexpr std::uint64_t NO_SPACE = ~0ULL;
+
+    // Ask for a fence once this fraction of the capacity was allocated since the last one
+    static constexpr std::uint64_t FENCE_DIVISOR = 8;
+
+private:
+    struct Segment {
+        std::uint64_t end;
+        std::uint64_t fence;
+    };
+
+    std::uint64_t capacity = 0;
+    std::uint64_t head = 0;
+    std::uint64_t tail = 0;
+    std::uint64_t closed = 0;
+    std::uint64_t frame_start = 0;
+
+    std::deque<Segment> segments;
+    RingAllocatorStats statistics;
+
+public:
+    explicit RingAllocator(const std::uint64_t capacity)
+        : capacity(capacity) {
+    }
+
+    // Return the offset of the new allocation in the buffer, or NO_SPACE if it overlaps data the GPU may still read
+    std::uint64_t allocate(const std::uint64_t size, const std::uint64_t alignment) {
+        if (size > capacity) {
+            statistics.overflows++;
+            return NO_SPACE;
+        }
+
+        std::uint64_t position = (head + alignment - 1) / alignment * alignment;
+        std::uint64_t offset = position % capacity;
+
+        // Never split an allocation over the end of the buffer
+        if (offset + size > capacity) {
+            position += capacity - offset;
+            offset = 0;
+        }
+
+        if (position + size - tail > capacity) {
+            statistics.overflows++;
+            return NO_SPACE;
+        }
+
+        head = position + size;
+
+        statistics.allocations++;
+        statistics.bytes_allocated += size;
+
+        return offset;
+    }
+
+    bool has_unfenced_data() const {
+        return head != closed;
+    }
+
+    bool should_fence() const {
+        return head - closed >= capacity / FENCE_DIVISOR;
+    }
+
+    // Everything allocated so far stays in use until the given fence is retired
+    void close_segment(const std::uint64_t fence) {
+        if (has_unfenced_data()) {
+            segments.push_back({ head, fence });
+            closed = head;
+        }
+    }
+
+    // Release the segments of every fence up to and including the given one
+    void retire(const std::uint64_t fence) {
+        while (!segments.empty() && (segments.front().fence <= fence)) {
+            tail = segments.front().end;
+            segments.pop_front();
+        }
+    }
+
+    void end_frame() {
+        statistics.last_frame_bytes = head - frame_start;
+        statistics.frame_high_water = std::max(statistics.frame_high_water, statistics.last_frame_bytes);
+        frame_start = head;
+    }
+
+    // Size of the buffer chained after an overflow: double the capacity, or more if one frame or one
+    // allocation would not fit in that, never going over the maximum.
+    static std::uint64_t grow_capacity(const std::uint64_t current, const std::uint64_t request, const std::uint64_t frame_high_water, const std::uint64_t maximum) {
+        std::uint64_t result = std::max<std::uint64_t>(current * 2, 1);
+        while ((result < request * 2) || (result < frame_high_water * 2)) {
+            result *= 2;
+        }
+
+        return std::max(std::min(result, maximum), std::min(request, maximum));
+    }
+
+    std::uint64_t size() const {
+        return capacity;
+    }
+
+    std::uint64_t used() const {
+        return head - tail;
+    }
+
+    const RingAllocatorStats &stats() const {
+        return statistics;
+    }
+
+    // Keep the statistics over a new allocator after the owner changed buffers
+    void inherit_stats(const RingAllocatorStats &previous) {
+        statistics = previous;
+    }
+};
+
+} // namespace renderer
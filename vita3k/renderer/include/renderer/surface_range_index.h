@@ -0,0 +1,260 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace renderer {
+
+struct SurfaceCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+};
+
+// Index of cached surfaces keyed by guest address range [address, address + size).
+// This holds no backend objects itself, the owner is told about every removal through the
+// remove callback so it can release whatever depends on the entry (framebuffers, views...).
+//
+// Entries are sorted by base address. Overlap queries only walk back as far as the size of the
+// largest live entry, so they cost O(log n + k) where k is the number of candidates in that window.
+template <typename T>
+class SurfaceRangeIndex {
+public:
+    typedef std::function<void(std::uint64_t, T &)> RemoveCallback;
+    typedef std::pair<std::uint64_t, T *> Match;
+
+private:
+    typedef std::list<std::uint64_t> LRUList;
+
+    static constexpr std::uint64_t NO_ENTRY = ~0ULL;
+
+    struct Entry {
+        std::uint64_t size = 0;
+        std::uint64_t cost = 0;
+        std::unique_ptr<T> value;
+        typename LRUList::iterator lru_position;
+    };
+
+    std::map<std::uint64_t, Entry> entries;
+    std::multiset<std::uint64_t> sizes;
+
+    // Front is the least recently used entry
+    LRUList lru;
+
+    std::size_t capacity = 0;
+    std::uint64_t budget = 0;
+    std::uint64_t used = 0;
+
+    SurfaceCacheStats statistics;
+    RemoveCallback remove_callback;
+
+    std::uint64_t max_size() const {
+        return sizes.empty() ? 0 : *sizes.rbegin();
+    }
+
+    void remove(typename std::map<std::uint64_t, Entry>::iterator ite) {
+        Entry &entry = ite->second;
+
+        if (remove_callback) {
+            remove_callback(ite->first, *entry.value);
+        }
+
+        sizes.erase(sizes.find(entry.size));
+        lru.erase(entry.lru_position);
+        used -= entry.cost;
+
+        entries.erase(ite);
+    }
+
+    bool over_limits() const {
+        return ((capacity != 0) && (entries.size() > capacity)) || ((budget != 0) && (used > budget));
+    }
+
+    // Evict the least recently used entries until we are within limits again, keeping the given one alive
+    void enforce_limits(const std::uint64_t keep) {
+        auto candidate = lru.begin();
+
+        while (over_limits() && (candidate != lru.end())) {
+            if (*candidate == keep) {
+                candidate++;
+                continue;
+            }
+
+            const std::uint64_t address = *(candidate++);
+            remove(entries.find(address));
+            statistics.evictions++;
+        }
+    }
+
+public:
+    // Zero means unlimited for both the entry count and the byte budget
+    explicit SurfaceRangeIndex(const std::size_t capacity = 0, const std::uint64_t budget = 0)
+        : capacity(capacity)
+        , budget(budget) {
+    }
+
+    void set_remove_callback(RemoveCallback callback) {
+        remove_callback = std::move(callback);
+    }
+
+    void set_limits(const std::size_t new_capacity, const std::uint64_t new_budget) {
+        capacity = new_capacity;
+        budget = new_budget;
+
+        enforce_limits(NO_ENTRY);
+    }
+
+    // Find the entry which starts exactly at the given address
+    T *find(const std::uint64_t address) {
+        auto ite = entries.find(address);
+        if (ite == entries.end()) {
+            statistics.misses++;
+            return nullptr;
+        }
+
+        statistics.hits++;
+        return ite->second.value.get();
+    }
+
+    // Find the entry with the highest base address whose range contains the given address
+    Match lookup(const std::uint64_t address) {
+        const std::uint64_t window = max_size();
+        auto ite = entries.upper_bound(address);
+
+        while (ite != entries.begin()) {
+            ite--;
+
+            if (address - ite->first >= window) {
+                break;
+            }
+
+            if (ite->first + ite->second.size > address) {
+                statistics.hits++;
+                return { ite->first, ite->second.value.get() };
+            }
+        }
+
+        statistics.misses++;
+        return { 0, nullptr };
+    }
+
+    // Collect every entry overlapping [address, address + size), sorted by base address
+    void query(const std::uint64_t address, const std::uint64_t size, std::vector<Match> &result) {
+        result.clear();
+
+        const std::uint64_t window = max_size();
+        const std::uint64_t start = (address > window) ? address - window : 0;
+        const std::uint64_t end = address + size;
+
+        for (auto ite = entries.lower_bound(start); (ite != entries.end()) && (ite->first < end); ite++) {
+            if (ite->first + ite->second.size > address) {
+                result.emplace_back(ite->first, ite->second.value.get());
+            }
+        }
+    }
+
+    // Add a new entry, replacing any entry starting at the same address. May evict other entries to
+    // stay within the capacity and budget.
+    T &insert(const std::uint64_t address, const std::uint64_t size, const std::uint64_t cost, std::unique_ptr<T> value) {
+        auto existing = entries.find(address);
+        if (existing != entries.end()) {
+            remove(existing);
+        }
+
+        Entry &entry = entries[address];
+        entry.size = size;
+        entry.cost = cost;
+        entry.value = std::move(value);
+        entry.lru_position = lru.insert(lru.end(), address);
+
+        sizes.insert(size);
+        used += cost;
+
+        T &result = *entry.value;
+        enforce_limits(address);
+
+        return result;
+    }
+
+    // Change the guest range and host cost of an existing entry, e.g. after the surface was remade larger
+    void resize(const std::uint64_t address, const std::uint64_t size, const std::uint64_t cost) {
+        auto ite = entries.find(address);
+        if (ite == entries.end()) {
+            return;
+        }
+
+        sizes.erase(sizes.find(ite->second.size));
+        sizes.insert(size);
+
+        used = used - ite->second.cost + cost;
+        ite->second.size = size;
+        ite->second.cost = cost;
+
+        enforce_limits(address);
+    }
+
+    // Mark the entry as the most recently used one
+    void touch(const std::uint64_t address) {
+        auto ite = entries.find(address);
+        if (ite != entries.end()) {
+            lru.splice(lru.end(), lru, ite->second.lru_position);
+        }
+    }
+
+    bool erase(const std::uint64_t address) {
+        auto ite = entries.find(address);
+        if (ite == entries.end()) {
+            return false;
+        }
+
+        remove(ite);
+        return true;
+    }
+
+    void clear() {
+        while (!entries.empty()) {
+            remove(entries.begin());
+        }
+    }
+
+    std::size_t size() const {
+        return entries.size();
+    }
+
+    std::uint64_t used_bytes() const {
+        return used;
+    }
+
+    const SurfaceCacheStats &stats() const {
+        return statistics;
+    }
+
+    void reset_stats() {
+        statistics = SurfaceCacheStats{};
+    }
+};
+
+} // namespace renderer
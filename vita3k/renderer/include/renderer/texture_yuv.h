@@ -0,0 +1,33 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace renderer::texture {
+
+// Fast path for the most common video texture, planar YUV 4:2:0 with BT.601 limited range coefficients.
+// The rows in [row_begin, row_end) are written to dst as RGBA8, row_begin must be even. Both functions
+// use the same 16-bit fixed point math and give identical results.
+void yuv420p_bt601_to_rgba_scalar(uint8_t *dst, const uint8_t *y_plane, const uint8_t *u_plane, const uint8_t *v_plane,
+    size_t width, size_t row_begin, size_t row_end);
+void yuv420p_bt601_to_rgba_simd(uint8_t *dst, const uint8_t *y_plane, const uint8_t *u_plane, const uint8_t *v_plane,
+    size_t width, size_t row_begin, size_t row_end);
+
+} // namespace renderer::texture
@@ -34,6 +34,8 @@
 #include <util/log.h>
 #include <util/string_utils.h>
 
+#include <algorithm>
+
 namespace renderer {
 COMMAND(handle_create_context) {
     std::unique_ptr<Context> *ctx = helper.pop<std::unique_ptr<Context> *>();
@@ -129,6 +131,10 @@ bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, co
         state = std::make_unique<gl::GLState>();
         if (!gl::create(window, state, base_path, config.hashless_texture_cache))
             return false;
+
+        // Budget is given in MiB, zero for either of them means unlimited
+        static_cast<gl::GLState &>(*state).surface_cache.set_limits(std::max(config.surface_cache_capacity, 0),
+            static_cast<std::uint64_t>(std::max(config.surface_cache_vram_budget, 0)) * 1024 * 1024);
         break;
 #ifdef USE_VULKAN
     case Backend::Vulkan:
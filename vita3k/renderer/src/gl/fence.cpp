@@ -102,4 +102,26 @@ bool Fence::wait_for_signal() {
     return signaled_;
 }
 
+bool Fence::is_signaled() {
+    if (signaled_ || !sync_) {
+        return signaled_;
+    }
+
+    const GLenum result = glClientWaitSync(sync_, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    if (result == GL_WAIT_FAILED) {
+        LOG_ERROR("Failed to query fence sync status");
+    }
+
+    signaled_ = true;
+
+    glDeleteSync(sync_);
+    sync_ = nullptr;
+
+    return true;
+}
+
 } // namespace renderer::gl
@@ -43,12 +43,12 @@
 namespace renderer::gl {
 
 GLContext::GLContext()
-    : vertex_stream_ring_buffer(GL_ARRAY_BUFFER, MB(128))
-    , index_stream_ring_buffer(GL_ELEMENT_ARRAY_BUFFER, MB(64))
-    , vertex_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(256))
-    , fragment_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(256))
-    , vertex_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(8))
-    , fragment_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(8)) {
+    : vertex_stream_ring_buffer(GL_ARRAY_BUFFER, MB(32), MB(512))
+    , index_stream_ring_buffer(GL_ELEMENT_ARRAY_BUFFER, MB(16), MB(256))
+    , vertex_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(64), MB(1024))
+    , fragment_uniform_stream_ring_buffer(GL_SHADER_STORAGE_BUFFER, MB(64), MB(1024))
+    , vertex_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(2), MB(32))
+    , fragment_info_uniform_buffer(GL_UNIFORM_BUFFER, MB(2), MB(32)) {
     std::memset(&previous_vert_info, 0, sizeof(GXMRenderVertUniformBlock));
     std::memset(&previous_frag_info, 0, sizeof(GXMRenderFragUniformBlock));
 }
@@ -435,6 +435,14 @@ void set_context(GLState &state, GLContext &context, const MemState &mem, const
 
     bind_fundamental(context);
 
+    // A new scene starts, fence the data of the previous one and record how much it used
+    context.vertex_stream_ring_buffer.frame_done();
+    context.index_stream_ring_buffer.frame_done();
+    context.vertex_uniform_stream_ring_buffer.frame_done();
+    context.fragment_uniform_stream_ring_buffer.frame_done();
+    context.vertex_info_uniform_buffer.frame_done();
+    context.fragment_info_uniform_buffer.frame_done();
+
     if (rt) {
         context.render_target = rt;
     } else {
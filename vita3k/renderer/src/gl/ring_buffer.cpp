@@ -15,72 +15,119 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
-// NOTE: I revised algorithm from RPCS3's GLHelpers.h. Please look at the class ring_buffer. Asked kd for advice.
-// I (pent0) mostly rewritten to understand it, other contributors in future can see the rpcs3 code.
-
 #include <renderer/gl/ring_buffer.h>
-#include <util/align.h>
 #include <util/log.h>
 
 namespace renderer::gl {
 
-RingBuffer::RingBuffer(GLenum purpose, const std::size_t capacity)
-    : base_(nullptr)
-    , cursor_(0)
-    , capacity_(capacity)
+static constexpr std::size_t RING_BUFFER_ALIGNMENT = 256;
+
+RingBuffer::RingBuffer(GLenum purpose, const std::size_t capacity, const std::size_t max_capacity)
+    : allocator_(capacity)
+    , next_fence_(1)
+    , completed_fence_(0)
+    , max_capacity_(max_capacity)
     , purpose_(purpose) {
-    buffer_.init(reinterpret_cast<renderer::Generator *>(glGenBuffers), reinterpret_cast<renderer::Deleter *>(glDeleteBuffers));
 }
 
-RingBuffer::~RingBuffer() {
-    if (base_) {
-        glBindBuffer(purpose_, buffer_[0]);
-        glUnmapBuffer(purpose_);
+std::unique_ptr<RingBuffer::MappedBuffer> RingBuffer::create_and_map(const std::size_t capacity) {
+    auto mapped = std::make_unique<MappedBuffer>();
+    mapped->buffer.init(reinterpret_cast<renderer::Generator *>(glGenBuffers), reinterpret_cast<renderer::Deleter *>(glDeleteBuffers));
+    mapped->capacity = capacity;
+
+    glBindBuffer(purpose_, mapped->buffer[0]);
+    glBufferStorage(purpose_, capacity, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+    // Deleting the buffer releases the mapping, so it is never unmapped explicitly
+    mapped->base = reinterpret_cast<std::uint8_t *>(glMapBufferRange(purpose_, 0, capacity, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+
+    if (!mapped->base) {
+        LOG_ERROR("Failed to map persistent buffer to host!");
+        return nullptr;
     }
+
+    return mapped;
 }
 
-void RingBuffer::create_and_map() {
-    glBindBuffer(purpose_, buffer_[0]);
-    glBufferStorage(purpose_, capacity_, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+void RingBuffer::insert_fence() {
+    if (!allocator_.has_unfenced_data()) {
+        return;
+    }
 
-    base_ = reinterpret_cast<std::uint8_t *>(glMapBufferRange(purpose_, 0, capacity_, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    auto fence = std::make_unique<Fence>();
+    fence->insert();
+    if (fence->empty()) {
+        return;
+    }
 
-    if (!base_) {
-        LOG_ERROR("Failed to map persistent buffer to host!");
+    allocator_.close_segment(next_fence_);
+    fences_.emplace_back(next_fence_++, std::move(fence));
+}
+
+void RingBuffer::poll_fences() {
+    // Commands complete in order, so only the oldest fence needs to be checked
+    while (!fences_.empty() && fences_.front().second->is_signaled()) {
+        completed_fence_ = fences_.front().first;
+        fences_.pop_front();
+    }
+
+    allocator_.retire(completed_fence_);
+
+    while (!retired_.empty() && (retired_.front().fence <= completed_fence_)) {
+        retired_.pop_front();
     }
 }
 
 std::pair<std::uint8_t *, std::size_t> RingBuffer::allocate(const std::size_t data_size) {
-    if (!base_) {
-        create_and_map();
-        if (!base_) {
+    if (!current_) {
+        current_ = create_and_map(allocator_.size());
+        if (!current_) {
             return std::make_pair(nullptr, static_cast<std::size_t>(-1));
         }
     }
 
-    std::size_t offset = align(cursor_, 256);
+    poll_fences();
+
+    std::uint64_t offset = allocator_.allocate(data_size, RING_BUFFER_ALIGNMENT);
 
-    if ((offset + data_size) >= capacity_) {
-        if (!safe_segment_consumed_fence_.empty()) {
-            safe_segment_consumed_fence_.wait_for_signal();
-        } else {
-            LOG_ERROR("Sync fence has not been inserted but the size of the ring buffer has already reached full!");
-            glFinish();
+    if (offset == RingAllocator::NO_SPACE) {
+        // Chain a new buffer rather than stalling on the GPU, the old one is dropped once its last fence signals
+        const RingAllocatorStats stats = allocator_.stats();
+        const std::size_t new_capacity = RingAllocator::grow_capacity(current_->capacity, data_size, stats.frame_high_water, max_capacity_);
+
+        std::unique_ptr<MappedBuffer> replacement = create_and_map(new_capacity);
+        if (!replacement) {
+            return std::make_pair(nullptr, static_cast<std::size_t>(-1));
         }
 
-        offset = 0;
-        cursor_ = 0;
+        insert_fence();
+        retired_.push_back({ std::move(current_), next_fence_ - 1 });
+
+        current_ = std::move(replacement);
+        allocator_ = RingAllocator(new_capacity);
+        allocator_.inherit_stats(stats);
+
+        LOG_INFO("Ring buffer grew to {} KiB after {} overflows, scene high-water {} KiB", new_capacity >> 10, stats.overflows, stats.frame_high_water >> 10);
+
+        offset = allocator_.allocate(data_size, RING_BUFFER_ALIGNMENT);
+        if (offset == RingAllocator::NO_SPACE) {
+            LOG_ERROR("Ring buffer allocation of {} bytes is larger than the maximum capacity {}", data_size, max_capacity_);
+            return std::make_pair(nullptr, static_cast<std::size_t>(-1));
+        }
     }
 
-    cursor_ = align(offset + data_size, 256);
-    return std::make_pair(base_ + offset, offset);
+    return std::make_pair(current_->base + offset, static_cast<std::size_t>(offset));
 }
 
 void RingBuffer::draw_call_done() {
-    // Insert a fence when the buffer has been consumed about 25% (same as RPCS3)
-    if (safe_segment_consumed_fence_.empty() && (cursor_ >= (capacity_ >> 2))) {
-        safe_segment_consumed_fence_.insert();
+    if (allocator_.should_fence()) {
+        insert_fence();
     }
 }
 
+void RingBuffer::frame_done() {
+    insert_fence();
+    allocator_.end_frame();
+}
+
 } // namespace renderer::gl
@@ -26,7 +26,34 @@
 namespace renderer::gl {
 static constexpr std::uint64_t CASTED_UNUSED_TEXTURE_PURGE_SECS = 40;
 
-GLSurfaceCache::GLSurfaceCache() {
+GLSurfaceCache::GLSurfaceCache()
+    : color_surface_textures(DEFAULT_CACHE_SIZE_PER_CONTAINER)
+    , depth_stencil_textures(DEFAULT_CACHE_SIZE_PER_CONTAINER) {
+    color_surface_textures.set_remove_callback([this](std::uint64_t, GLColorSurfaceCacheInfo &info) {
+        purge_framebuffers(info.gl_texture[0], false);
+    });
+
+    depth_stencil_textures.set_remove_callback([this](std::uint64_t, GLDepthStencilSurfaceCacheInfo &info) {
+        purge_framebuffers(info.gl_texture[0], true);
+    });
+}
+
+void GLSurfaceCache::set_limits(const std::size_t capacity_per_container, const std::uint64_t vram_budget) {
+    // Color surfaces are usually the majority of what is stored, give them the bigger share
+    color_surface_textures.set_limits(capacity_per_container, vram_budget - vram_budget / 4);
+    depth_stencil_textures.set_limits(capacity_per_container, vram_budget / 4);
+}
+
+void GLSurfaceCache::purge_framebuffers(const GLuint texture_handle, const bool is_depth_stencil) {
+    const int shift = is_depth_stencil ? 32 : 0;
+
+    for (auto it = framebuffer_array.begin(); it != framebuffer_array.end();) {
+        if (((it->first >> shift) & 0xFFFFFFFF) == texture_handle) {
+            it = framebuffer_array.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void GLSurfaceCache::do_typeless_copy(const GLint dest_texture, const GLint source_texture, const GLenum dest_internal,
@@ -77,19 +104,12 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
     std::size_t bytes_per_stride = pixel_stride * color::bytes_per_pixel(base_format);
     std::size_t total_surface_size = bytes_per_stride * original_height;
 
-    // Of course, this works under the assumption that range must be unique :D
-    auto ite = color_surface_textures.lower_bound(key);
+    // Take the closest surface below this address which range contains it
+    const auto [cached_key, cached_info] = color_surface_textures.lookup(key);
     bool invalidated = false;
 
-    bool overlap = false;
-    if (ite != color_surface_textures.end()) {
-        // if the surface found does not overlap the surface we want, it's useless to look at it
-        overlap = (ite->first + ite->second->total_bytes) > key;
-    }
-
-    if (overlap) {
-        GLColorSurfaceCacheInfo &info = *ite->second;
-        auto used_iterator = std::find(last_use_color_surface_index.begin(), last_use_color_surface_index.end(), ite->first);
+    if (cached_info) {
+        GLColorSurfaceCacheInfo &info = *cached_info;
 
         if (stored_height) {
             *stored_height = info.original_height;
@@ -105,12 +125,12 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
         // 2. Same base address, but width and height change to be larger, or format change if write. Remake a new one for both read and write sitatation.
         // 3. Out of cache range. In write case, create a new one, in read case, lul
         // 4. Read situation with smaller width and height, probably need to extract the needed region out.
-        const bool addr_in_range_of_cache = ((key + total_surface_size) <= (ite->first + info.total_bytes));
-        const bool cache_probably_freed = ((ite->first != key) && addr_in_range_of_cache && (purpose == SurfaceTextureRetrievePurpose::WRITING));
+        const bool addr_in_range_of_cache = ((key + total_surface_size) <= (cached_key + info.total_bytes));
+        const bool cache_probably_freed = ((cached_key != key) && addr_in_range_of_cache && (purpose == SurfaceTextureRetrievePurpose::WRITING));
         const bool surface_extent_changed = (info.width < width) || (info.height < height);
         bool surface_stat_changed = false;
 
-        if (ite->first == key) {
+        if (cached_key == key) {
             if (purpose == SurfaceTextureRetrievePurpose::WRITING) {
                 surface_stat_changed = surface_extent_changed || (base_format != info.format);
             } else {
@@ -120,15 +140,8 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
         }
 
         if (cache_probably_freed) {
-            for (auto ite = framebuffer_array.begin(); ite != framebuffer_array.end();) {
-                if ((ite->first & 0xFFFFFFFF) == key) {
-                    ite = framebuffer_array.erase(ite);
-                } else {
-                    ite++;
-                }
-            }
-            // Clear out. We will recreate later
-            color_surface_textures.erase(ite);
+            // Clear out along with its framebuffers. We will recreate later
+            color_surface_textures.erase(cached_key);
             invalidated = true;
         } else if (surface_stat_changed) {
             // Remake locally to avoid making changes to framebuffer array
@@ -178,8 +191,11 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
             }
 
             info.casted_textures.clear();
+            color_surface_textures.resize(cached_key, total_surface_size, static_cast<std::uint64_t>(width) * height * color::bytes_per_pixel_in_gl_storage(base_format));
         }
-        if ((purpose == SurfaceTextureRetrievePurpose::WRITING) && (swizzle != info.swizzle)) {
+        if (invalidated) {
+            // The info is gone with the erased surface, just make a new one
+        } else if ((purpose == SurfaceTextureRetrievePurpose::WRITING) && (swizzle != info.swizzle)) {
             info.swizzle = swizzle;
         } else if (purpose == SurfaceTextureRetrievePurpose::READING) {
             swizzle = info.swizzle;
@@ -190,11 +206,7 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
             }
         } else if (purpose == SurfaceTextureRetrievePurpose::READING) {
             // If we read and it's still in range
-            if (used_iterator != last_use_color_surface_index.end()) {
-                last_use_color_surface_index.erase(used_iterator);
-            }
-
-            last_use_color_surface_index.push_back(ite->first);
+            color_surface_textures.touch(cached_key);
 
             if (info.flags & GLSurfaceCacheInfo::FLAG_DIRTY) {
                 // We can't use this texture sadly :( If it uses for writing of course it will be gud gud
@@ -232,7 +244,7 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
             }
 
             if (castable) {
-                const std::size_t data_delta = address.address() - ite->first;
+                const std::size_t data_delta = address.address() - cached_key;
                 std::size_t start_sourced_line = (data_delta / bytes_per_stride) * state.res_multiplier;
                 std::size_t start_x = (data_delta % bytes_per_stride) / color::bytes_per_pixel(base_format) * state.res_multiplier;
 
@@ -258,7 +270,7 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
                         source_data_type = color::translate_type(info.format);
                     }
 
-                    if ((base_format != info.format) || (info.height != height) || (info.width != width) || (ite->first != address.address())) {
+                    if ((base_format != info.format) || (info.height != height) || (info.width != width) || (cached_key != address.address())) {
                         // Look in cast cache and grab one. The cache really does not store immediate grab on now, but rather to reduce the synchronization in the pipeline (use different texture)
                         for (std::size_t i = 0; i < casted_vec.size();) {
                             if ((casted_vec[i]->cropped_height == height) && (casted_vec[i]->cropped_width == width) && (casted_vec[i]->cropped_y == start_sourced_line) && (casted_vec[i]->cropped_x == start_x) && (casted_vec[i]->format == base_format)) {
@@ -354,17 +366,11 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
 
         if (!invalidated) {
             if (purpose == SurfaceTextureRetrievePurpose::WRITING) {
-                if (used_iterator != last_use_color_surface_index.end()) {
-                    last_use_color_surface_index.erase(used_iterator);
-                }
-
-                last_use_color_surface_index.push_back(ite->first);
+                color_surface_textures.touch(cached_key);
                 return info.gl_texture[0];
             } else {
                 return 0;
             }
-        } else if (used_iterator != last_use_color_surface_index.end()) {
-            last_use_color_surface_index.erase(used_iterator);
         }
     }
 
@@ -388,8 +394,6 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
 
     if (!info_added->gl_texture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
         LOG_ERROR("Failed to initialise color surface texture!");
-        color_surface_textures.erase(key);
-
         return 0;
     }
 
@@ -415,33 +419,10 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
 
-    if (color_surface_textures.count(key) > 0) {
-        static bool has_happened = false;
-        LOG_WARN_IF(!has_happened, "Two different surfaces have the same base adress, this is not handled, an openGL error will happen.");
-        has_happened = true;
-    }
-    color_surface_textures.emplace(key, std::move(info_added));
-
-    // Now that everything goes well, we can start rearranging
-    if (last_use_color_surface_index.size() >= MAX_CACHE_SIZE_PER_CONTAINER) {
-        // We have to purge a cache along with framebuffer
-        // So choose the one that is last used
-        const std::uint64_t first_key = last_use_color_surface_index.front();
-        GLuint texture_handle = color_surface_textures.find(first_key)->second->gl_texture[0];
-
-        for (auto it = framebuffer_array.cbegin(); it != framebuffer_array.cend();) {
-            if ((it->first & 0xFFFFFFFF) == texture_handle) {
-                it = framebuffer_array.erase(it);
-            } else {
-                ++it;
-            }
-        }
-
-        last_use_color_surface_index.erase(last_use_color_surface_index.begin());
-        color_surface_textures.erase(first_key);
-    }
-
-    last_use_color_surface_index.push_back(key);
+    // Now that everything goes well, we can insert it. A surface already stored at the same base address is replaced,
+    // and least recently used surfaces are purged along with their framebuffers if we go over the capacity or budget.
+    const std::uint64_t texture_bytes = static_cast<std::uint64_t>(width) * height * color::bytes_per_pixel_in_gl_storage(base_format);
+    color_surface_textures.insert(key, total_surface_size, texture_bytes, std::move(info_added));
 
     if (stored_height) {
         *stored_height = height;
@@ -455,12 +436,12 @@ std::uint64_t GLSurfaceCache::retrieve_color_surface_texture_handle(const State
 }
 
 std::uint64_t GLSurfaceCache::retrieve_ping_pong_color_surface_texture_handle(Ptr<void> address) {
-    auto ite = color_surface_textures.find(address.address());
-    if (ite == color_surface_textures.end()) {
+    GLColorSurfaceCacheInfo *cached_info = color_surface_textures.find(address.address());
+    if (!cached_info) {
         return 0;
     }
 
-    GLColorSurfaceCacheInfo &info = *ite->second;
+    GLColorSurfaceCacheInfo &info = *cached_info;
 
     GLenum surface_internal_format = color::translate_internal_format(info.format);
     GLenum surface_upload_format = color::translate_format(info.format);
@@ -509,24 +490,14 @@ std::uint64_t GLSurfaceCache::retrieve_depth_stencil_texture_handle(const State
         force_height = target->height;
     }
 
-    std::size_t found_index = static_cast<std::size_t>(-1);
-
     // The whole depth stencil struct is reserved for future use
-    for (std::size_t i = 0; i < depth_stencil_textures.size(); i++) {
-        if ((depth_stencil_textures[i].surface.depthData == surface.depthData) && (packed_ds || (!packed_ds && (depth_stencil_textures[i].surface.stencilData == surface.stencilData)))) {
-            found_index = i;
-            break;
-        }
-    }
+    const std::uint64_t key = surface.depthData ? surface.depthData.address() : surface.stencilData.address();
+    GLDepthStencilSurfaceCacheInfo *found_info = depth_stencil_textures.find(key);
 
-    if (found_index != static_cast<std::size_t>(-1)) {
-        auto ite = std::find(last_use_depth_stencil_surface_index.begin(), last_use_depth_stencil_surface_index.end(), found_index);
-        if (ite != last_use_depth_stencil_surface_index.end()) {
-            last_use_depth_stencil_surface_index.erase(ite);
-            last_use_depth_stencil_surface_index.push_back(found_index);
-        }
+    if (found_info && (packed_ds || (found_info->surface.stencilData == surface.stencilData))) {
+        depth_stencil_textures.touch(key);
 
-        GLDepthStencilSurfaceCacheInfo &cached_info = depth_stencil_textures[found_index];
+        GLDepthStencilSurfaceCacheInfo &cached_info = *found_info;
         bool need_remake = false;
         if (cached_info.width < force_width) {
             cached_info.width = force_width;
@@ -539,70 +510,40 @@ std::uint64_t GLSurfaceCache::retrieve_depth_stencil_texture_handle(const State
         }
 
         if (need_remake) {
-            glBindTexture(GL_TEXTURE_2D, depth_stencil_textures[found_index].gl_texture[0]);
+            glBindTexture(GL_TEXTURE_2D, cached_info.gl_texture[0]);
             glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, cached_info.width, cached_info.height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+
+            const std::uint64_t texture_bytes = static_cast<std::uint64_t>(cached_info.width) * cached_info.height * 4;
+            depth_stencil_textures.resize(key, texture_bytes / (state.res_multiplier * state.res_multiplier), texture_bytes);
         }
 
-        return depth_stencil_textures[found_index].gl_texture[0];
+        return cached_info.gl_texture[0];
     }
 
     if (is_reading) {
         return 0;
     }
 
-    // Now that everything goes well, we can start rearranging
-    // Almost carbon copy but still too specific
-    if (last_use_depth_stencil_surface_index.size() >= MAX_CACHE_SIZE_PER_CONTAINER) {
-        // We have to purge a cache along with framebuffer
-        // So choose the one that is last used
-        const std::size_t index = last_use_depth_stencil_surface_index.front();
-        GLuint ds_texture_handle = depth_stencil_textures[index].gl_texture[0];
-
-        for (auto it = framebuffer_array.cbegin(); it != framebuffer_array.cend();) {
-            if (((it->first >> 32) & 0xFFFFFFFF) == ds_texture_handle) {
-                it = framebuffer_array.erase(it);
-            } else {
-                ++it;
-            }
-        }
-
-        last_use_depth_stencil_surface_index.erase(last_use_depth_stencil_surface_index.begin());
-        depth_stencil_textures[index].flags = GLSurfaceCacheInfo::FLAG_FREE;
-
-        found_index = index;
-    }
-
-    if (found_index == static_cast<std::size_t>(-1)) {
-        // Still nowhere to found a free slot? We can search maybe
-        for (std::size_t i = 0; i < depth_stencil_textures.size(); i++) {
-            if (depth_stencil_textures[i].flags & GLSurfaceCacheInfo::FLAG_FREE) {
-                if (depth_stencil_textures[i].gl_texture[0] == 0) {
-                    if (!depth_stencil_textures[i].gl_texture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
-                        LOG_ERROR("Fail to initialize depth stencil texture!");
-                        return 0;
-                    }
-                }
-                found_index = i;
-                break;
-            }
-        }
-    }
-
-    if (found_index == static_cast<std::size_t>(-1)) {
-        LOG_ERROR("No free depth stencil texture cache slot!");
+    std::unique_ptr<GLDepthStencilSurfaceCacheInfo> info_added = std::make_unique<GLDepthStencilSurfaceCacheInfo>();
+    if (!info_added->gl_texture.init(reinterpret_cast<renderer::Generator *>(glGenTextures), reinterpret_cast<renderer::Deleter *>(glDeleteTextures))) {
+        LOG_ERROR("Fail to initialize depth stencil texture!");
         return 0;
     }
 
-    last_use_depth_stencil_surface_index.push_back(found_index);
-    depth_stencil_textures[found_index].flags = 0;
-    depth_stencil_textures[found_index].surface = surface;
-    depth_stencil_textures[found_index].width = force_width;
-    depth_stencil_textures[found_index].height = force_height;
+    info_added->surface = surface;
+    info_added->width = force_width;
+    info_added->height = force_height;
+
+    const GLuint texture_handle_return = info_added->gl_texture[0];
 
-    glBindTexture(GL_TEXTURE_2D, depth_stencil_textures[found_index].gl_texture[0]);
+    glBindTexture(GL_TEXTURE_2D, texture_handle_return);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, force_width, force_height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
 
-    return depth_stencil_textures[found_index].gl_texture[0];
+    // Same as color surfaces, least recently used ones are purged along with their framebuffers when going over the limits
+    const std::uint64_t texture_bytes = static_cast<std::uint64_t>(force_width) * force_height * 4;
+    depth_stencil_textures.insert(key, texture_bytes / (state.res_multiplier * state.res_multiplier), texture_bytes, std::move(info_added));
+
+    return texture_handle_return;
 }
 
 std::uint64_t GLSurfaceCache::retrieve_framebuffer_handle(const State &state, const MemState &mem, SceGxmColorSurface *color, SceGxmDepthStencilSurface *depth_stencil,
@@ -690,19 +631,19 @@ std::uint64_t GLSurfaceCache::retrieve_framebuffer_handle(const State &state, co
 }
 
 std::uint64_t GLSurfaceCache::sourcing_color_surface_for_presentation(Ptr<const void> address, uint32_t width, uint32_t height, const std::uint32_t pitch, float *uvs, const int res_multiplier, SceFVector2 &texture_size) {
-    auto ite = color_surface_textures.lower_bound(address.address());
-    if (ite == color_surface_textures.end()) {
+    const auto [cached_key, cached_info] = color_surface_textures.lookup(address.address());
+    if (!cached_info) {
         return 0;
     }
 
     width *= res_multiplier;
     height *= res_multiplier;
 
-    const GLColorSurfaceCacheInfo &info = *ite->second;
+    const GLColorSurfaceCacheInfo &info = *cached_info;
 
     if (info.pixel_stride == pitch) {
         // In assumption the format is RGBA8
-        const std::size_t data_delta = address.address() - ite->first;
+        const std::size_t data_delta = address.address() - cached_key;
         std::uint32_t limited_height = height;
         if ((data_delta % (pitch * 4)) == 0) {
             std::uint32_t start_sourced_line = (data_delta / (pitch * 4)) * res_multiplier;
@@ -514,6 +514,8 @@ void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &stat
     // Each draw will upload the stream data. Assuming that, we can just bind buffer, upload data
     // The GXM submit side should already submit used buffer, but we just delete all just in case
     std::array<std::size_t, SCE_GXM_MAX_VERTEX_STREAMS> offset_in_buffer;
+    // The ring buffer may chain a new buffer between two streams
+    std::array<GLuint, SCE_GXM_MAX_VERTEX_STREAMS> stream_buffer = {};
     for (std::size_t i = 0; i < SCE_GXM_MAX_VERTEX_STREAMS; i++) {
         if (state.vertex_streams[i].data) {
             std::pair<std::uint8_t *, std::size_t> result = context.vertex_stream_ring_buffer.allocate(state.vertex_streams[i].size);
@@ -522,6 +524,7 @@ void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &stat
             } else {
                 std::memcpy(result.first, state.vertex_streams[i].data, state.vertex_streams[i].size);
                 offset_in_buffer[i] = result.second;
+                stream_buffer[i] = context.vertex_stream_ring_buffer.handle();
             }
 
             delete[] state.vertex_streams[i].data;
@@ -530,11 +533,10 @@ void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &stat
             state.vertex_streams[i].size = 0;
         } else {
             offset_in_buffer[i] = 0;
+            stream_buffer[i] = context.vertex_stream_ring_buffer.handle();
         }
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, context.vertex_stream_ring_buffer.handle());
-
     for (const SceGxmVertexAttribute &attribute : vertex_program.attributes) {
         const SceGxmVertexStream &stream = vertex_program.streams[attribute.streamIndex];
 
@@ -563,6 +565,7 @@ void sync_vertex_streams_and_attributes(GLContext &context, GxmRecordState &stat
             }
 
             const std::uint16_t stream_index = attribute.streamIndex;
+            glBindBuffer(GL_ARRAY_BUFFER, stream_buffer[stream_index]);
 
             if (upload_integral || (attribute_format == SCE_GXM_ATTRIBUTE_FORMAT_UNTYPED)) {
                 glVertexAttribIPointer(attrib_location, attribute.componentCount, type, stream.stride, reinterpret_cast<const GLvoid *>(attribute.offset + offset_in_buffer[stream_index]));
@@ -441,36 +441,13 @@ void upload_bound_texture(const SceGxmTexture &gxm_texture, const MemState &mem)
         }
 
         if (gxm::is_yuv_format(base_format)) {
-            switch (fmt) {
-            case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC1:
-            case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC1:
-            case SCE_GXM_TEXTURE_FORMAT_YUV420P3_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_YUV420P3_CSC1:
-            case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC1: {
-                yuv_texture_pixels.resize(width * height * 3);
-                renderer::texture::yuv420_texture_to_rgb(yuv_texture_pixels.data(),
-                    reinterpret_cast<const uint8_t *>(pixels), width, height);
-                pixels = yuv_texture_pixels.data();
-                pixels_per_stride = width;
-                break;
+            yuv_texture_pixels.resize(width * height * 4);
+            if (!renderer::texture::yuv_texture_to_rgba(yuv_texture_pixels.data(), reinterpret_cast<const uint8_t *>(pixels), width, height, fmt)) {
+                return;
             }
 
-            case SCE_GXM_TEXTURE_FORMAT_YUYV422_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_YVYU422_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_UYVY422_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_VYUY422_CSC0:
-            case SCE_GXM_TEXTURE_FORMAT_YUYV422_CSC1:
-            case SCE_GXM_TEXTURE_FORMAT_YVYU422_CSC1:
-            case SCE_GXM_TEXTURE_FORMAT_UYVY422_CSC1:
-            case SCE_GXM_TEXTURE_FORMAT_VYUY422_CSC1:
-                LOG_ERROR("Yuv Texture format not implemented: {}", fmt);
-                assert(false);
-            default:
-                assert(false);
-            }
+            pixels = yuv_texture_pixels.data();
+            pixels_per_stride = width;
         }
 
         const GLenum format = translate_format(base_format);
@@ -553,10 +530,7 @@ void dump(const SceGxmTexture &gxm_texture, const MemState &mem, const std::stri
     }
     size_t size = (bpp * stride * height) / 8;
 
-    if (gxm::is_yuv_format(base_format)) {
-        bpp = 24;
-        size = width * height * 3;
-    } else if (need_decompress_and_unswizzle_on_cpu || gxm::is_paletted_format(base_format)) {
+    if (need_decompress_and_unswizzle_on_cpu || gxm::is_paletted_format(base_format) || gxm::is_yuv_format(base_format)) {
         bpp = 32;
         size = width * height * 4;
     }
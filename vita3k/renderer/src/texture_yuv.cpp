@@ -16,10 +16,14 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
 #include <renderer/functions.h>
+#include <renderer/texture_yuv.h>
 
 #include <util/log.h>
+#include <util/thread_pool.h>
 
 #include <algorithm>
+#include <list>
+#include <vector>
 
 extern "C" {
 #include <libswscale/swscale.h>
@@ -27,54 +31,269 @@ extern "C" {
 
 namespace renderer::texture {
 
-static SwsContext *s_render_sws_context{};
-static size_t res[2] = { 0, 0 };
-SwsContext *get_sws_context(size_t width, size_t height) {
-    bool recreate = false;
-    if (res[0] != width || res[1] != height) {
-        recreate = true;
-        res[0] = width;
-        res[1] = height;
-    } else if (s_render_sws_context == nullptr) {
-        recreate = true;
+// Number of rows below which splitting the conversion is not worth waking up the workers
+static constexpr size_t MIN_ROWS_PER_SLICE = 64;
+static constexpr size_t SWS_CONTEXT_CACHE_SIZE = 8;
+
+struct SwsContextKey {
+    size_t width;
+    size_t height;
+    AVPixelFormat format;
+    int colorspace;
+
+    bool operator==(const SwsContextKey &rhs) const {
+        return (width == rhs.width) && (height == rhs.height) && (format == rhs.format) && (colorspace == rhs.colorspace);
+    }
+};
+
+// Small LRU of conversion contexts. A context can't be used by two threads at once, so each key holds one
+// context per slice converted in parallel. Titles playing videos often flip between a few sizes each
+// frame, which used to recreate the single context every time. Only used from the render thread.
+class SwsContextCache {
+    struct Entry {
+        SwsContextKey key;
+        std::vector<SwsContext *> contexts;
+    };
+
+    // Front is the most recently used
+    std::list<Entry> entries;
+
+    static void free_entry(Entry &entry) {
+        for (SwsContext *context : entry.contexts) {
+            sws_freeContext(context);
+        }
+    }
+
+public:
+    ~SwsContextCache() {
+        for (Entry &entry : entries) {
+            free_entry(entry);
+        }
     }
 
-    if (recreate) {
-        if (s_render_sws_context != nullptr) {
-            sws_freeContext(s_render_sws_context);
-            s_render_sws_context = nullptr;
+    // Get at least count contexts for the given key, nullptr if the creation failed
+    SwsContext *const *get(const SwsContextKey &key, size_t count) {
+        auto ite = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) { return entry.key == key; });
+        if (ite != entries.end()) {
+            entries.splice(entries.begin(), entries, ite);
+        } else {
+            if (entries.size() >= SWS_CONTEXT_CACHE_SIZE) {
+                free_entry(entries.back());
+                entries.pop_back();
+            }
+
+            entries.push_front({ key, {} });
+        }
+
+        std::vector<SwsContext *> &contexts = entries.front().contexts;
+        while (contexts.size() < count) {
+            SwsContext *context = sws_getContext(static_cast<int>(key.width), static_cast<int>(key.height), key.format,
+                static_cast<int>(key.width), static_cast<int>(key.height), AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+
+            if (!context) {
+                return nullptr;
+            }
+
+            // Vita video textures are limited range
+            sws_setColorspaceDetails(context, sws_getCoefficients(key.colorspace), 0, sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+            contexts.push_back(context);
         }
-        s_render_sws_context = sws_getContext(width, height, AV_PIX_FMT_YUV420P, width, height, AV_PIX_FMT_RGB24,
-            0, nullptr, nullptr, nullptr);
+
+        return contexts.data();
     }
-    return s_render_sws_context;
+};
+
+static SwsContextCache &get_sws_context_cache() {
+    static SwsContextCache cache;
+    return cache;
 }
 
-void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, size_t width, size_t height) {
-    SwsContext *context = get_sws_context(width, height);
-    assert(context);
+static util::ThreadPool &get_conversion_pool() {
+    // The render thread takes part in the conversion too, keep some cores for the guest
+    static util::ThreadPool pool(std::max(std::thread::hardware_concurrency() / 2, 2U) - 1);
+    return pool;
+}
 
-    const uint8_t *slices[] = {
-        &src[0], // Y Slice
-        &src[width * height], // U Slice
-        &src[width * height + width * height / 4], // V Slice
-    };
+static size_t get_slice_count(size_t height) {
+    const size_t max_slices = get_conversion_pool().size() + 1;
+    return std::clamp<size_t>(height / MIN_ROWS_PER_SLICE, 1, max_slices);
+}
 
-    int strides[] = {
-        static_cast<int>(width),
-        static_cast<int>(width / 2),
-        static_cast<int>(width / 2),
-    };
+struct YuvLayout {
+    AVPixelFormat format;
+    int colorspace;
+    bool swap_chroma;
+};
 
-    uint8_t *dst_slices[] = {
-        dst,
-    };
+static bool get_yuv_layout(SceGxmTextureFormat fmt, YuvLayout &layout) {
+    switch (fmt) {
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC0:
+        layout = { AV_PIX_FMT_NV12, SWS_CS_ITU601, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC0:
+        layout = { AV_PIX_FMT_NV21, SWS_CS_ITU601, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC1:
+        layout = { AV_PIX_FMT_NV12, SWS_CS_ITU709, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC1:
+        layout = { AV_PIX_FMT_NV21, SWS_CS_ITU709, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P3_CSC0:
+        layout = { AV_PIX_FMT_YUV420P, SWS_CS_ITU601, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC0:
+        layout = { AV_PIX_FMT_YUV420P, SWS_CS_ITU601, true };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P3_CSC1:
+        layout = { AV_PIX_FMT_YUV420P, SWS_CS_ITU709, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC1:
+        layout = { AV_PIX_FMT_YUV420P, SWS_CS_ITU709, true };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YUYV422_CSC0:
+        layout = { AV_PIX_FMT_YUYV422, SWS_CS_ITU601, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YVYU422_CSC0:
+        layout = { AV_PIX_FMT_YVYU422, SWS_CS_ITU601, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_UYVY422_CSC0:
+        layout = { AV_PIX_FMT_UYVY422, SWS_CS_ITU601, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_VYUY422_CSC0:
+        // No such layout in ffmpeg, it gets repacked as UYVY first
+        layout = { AV_PIX_FMT_UYVY422, SWS_CS_ITU601, true };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YUYV422_CSC1:
+        layout = { AV_PIX_FMT_YUYV422, SWS_CS_ITU709, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_YVYU422_CSC1:
+        layout = { AV_PIX_FMT_YVYU422, SWS_CS_ITU709, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_UYVY422_CSC1:
+        layout = { AV_PIX_FMT_UYVY422, SWS_CS_ITU709, false };
+        return true;
+    case SCE_GXM_TEXTURE_FORMAT_VYUY422_CSC1:
+        layout = { AV_PIX_FMT_UYVY422, SWS_CS_ITU709, true };
+        return true;
+    default:
+        return false;
+    }
+}
 
-    const int dst_strides[] = {
-        static_cast<int>(width * 3),
-    };
+// Fill the plane pointers and strides of the rows starting at row (must be even for 4:2:0)
+static void get_planes(const YuvLayout &layout, const uint8_t *src, size_t width, size_t height, size_t row, const uint8_t *planes[3], int strides[3]) {
+    const size_t chroma_width = (width + 1) / 2;
+    const size_t luma_size = width * height;
+
+    switch (layout.format) {
+    case AV_PIX_FMT_YUV420P: {
+        const uint8_t *first_chroma = src + luma_size;
+        const uint8_t *second_chroma = first_chroma + chroma_width * ((height + 1) / 2);
+
+        planes[0] = src + row * width;
+        planes[1] = (layout.swap_chroma ? second_chroma : first_chroma) + (row / 2) * chroma_width;
+        planes[2] = (layout.swap_chroma ? first_chroma : second_chroma) + (row / 2) * chroma_width;
+        strides[0] = static_cast<int>(width);
+        strides[1] = static_cast<int>(chroma_width);
+        strides[2] = static_cast<int>(chroma_width);
+        break;
+    }
+
+    case AV_PIX_FMT_NV12:
+    case AV_PIX_FMT_NV21:
+        planes[0] = src + row * width;
+        planes[1] = src + luma_size + (row / 2) * chroma_width * 2;
+        planes[2] = nullptr;
+        strides[0] = static_cast<int>(width);
+        strides[1] = static_cast<int>(chroma_width * 2);
+        strides[2] = 0;
+        break;
+
+    default:
+        planes[0] = src + row * width * 2;
+        planes[1] = nullptr;
+        planes[2] = nullptr;
+        strides[0] = static_cast<int>(width * 2);
+        strides[1] = 0;
+        strides[2] = 0;
+        break;
+    }
+}
+
+bool yuv_texture_to_rgba(uint8_t *dst, const uint8_t *src, size_t width, size_t height, SceGxmTextureFormat fmt) {
+    YuvLayout layout;
+    if (!get_yuv_layout(fmt, layout)) {
+        LOG_ERROR("Yuv Texture format not implemented: {}", fmt);
+        return false;
+    }
+
+    // Align the slices on two rows to keep 4:2:0 chroma rows whole
+    const size_t slice_count = get_slice_count(height);
+    const size_t slice_height = ((height + slice_count - 1) / slice_count + 1) & ~static_cast<size_t>(1);
+
+    if ((layout.format == AV_PIX_FMT_YUV420P) && (layout.colorspace == SWS_CS_ITU601)) {
+        const uint8_t *planes[3];
+        int strides[3];
+        get_planes(layout, src, width, height, 0, planes, strides);
+
+        get_conversion_pool().parallel_for(slice_count, [&](size_t slice) {
+            const size_t row_begin = std::min(slice * slice_height, height);
+            const size_t row_end = std::min(row_begin + slice_height, height);
+            yuv420p_bt601_to_rgba_simd(dst, planes[0], planes[1], planes[2], width, row_begin, row_end);
+        });
+
+        return true;
+    }
+
+    std::vector<uint8_t> repacked;
+    if ((layout.format == AV_PIX_FMT_UYVY422) && layout.swap_chroma) {
+        // VYUY to UYVY
+        repacked.assign(src, src + width * height * 2);
+        for (size_t i = 0; i + 3 < repacked.size(); i += 4) {
+            std::swap(repacked[i], repacked[i + 2]);
+        }
+
+        src = repacked.data();
+    }
+
+    const size_t last_slice_height = height - slice_height * (slice_count - 1);
+    SwsContextCache &cache = get_sws_context_cache();
+
+    SwsContext *const *contexts = nullptr;
+    SwsContext *const *last_context = nullptr;
+
+    if (last_slice_height == slice_height) {
+        contexts = cache.get({ width, slice_height, layout.format, layout.colorspace }, slice_count);
+        last_context = contexts ? contexts + slice_count - 1 : nullptr;
+    } else {
+        if (slice_count > 1) {
+            contexts = cache.get({ width, slice_height, layout.format, layout.colorspace }, slice_count - 1);
+        }
+
+        last_context = cache.get({ width, last_slice_height, layout.format, layout.colorspace }, 1);
+    }
+
+    if (!last_context || ((slice_count > 1) && !contexts)) {
+        LOG_ERROR("Failed to create YUV conversion context for {}x{} texture", width, height);
+        return false;
+    }
+
+    get_conversion_pool().parallel_for(slice_count, [&](size_t slice) {
+        const size_t row = slice * slice_height;
+        const bool is_last = (slice == slice_count - 1);
+
+        const uint8_t *planes[3];
+        int strides[3];
+        get_planes(layout, src, width, height, row, planes, strides);
+
+        uint8_t *dst_slices[] = { dst + row * width * 4 };
+        const int dst_strides[] = { static_cast<int>(width * 4) };
+
+        SwsContext *context = is_last ? last_context[0] : contexts[slice];
+        sws_scale(context, planes, strides, 0, static_cast<int>(is_last ? last_slice_height : slice_height), dst_slices, dst_strides);
+    });
 
-    int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
-    assert(error == height);
+    return true;
 }
 } // namespace renderer::texture
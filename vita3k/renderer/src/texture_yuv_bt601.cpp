@@ -0,0 +1,136 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/texture_yuv.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define YUV_USE_SSE2
+#endif
+
+namespace renderer::texture {
+
+// BT.601 limited range coefficients, luma scaled by 2^14 and chroma by 2^13. Luma is shifted left by 7 and
+// chroma by 8 before the multiply, so the high half of the product has 5 fractional bits for all terms.
+static constexpr int16_t COEF_Y = 19077; // 1.16438
+static constexpr int16_t COEF_RV = 13075; // 1.59603
+static constexpr int16_t COEF_GU = 3209; // 0.39176
+static constexpr int16_t COEF_GV = 6660; // 0.81297
+static constexpr int16_t COEF_BU = 16525; // 2.01723
+
+static inline int16_t mul_high(const int16_t a, const int16_t b) {
+    return static_cast<int16_t>((static_cast<int32_t>(a) * b) >> 16);
+}
+
+static inline uint8_t to_channel(const int16_t value) {
+    return static_cast<uint8_t>(std::clamp((value + 16) >> 5, 0, 255));
+}
+
+static void convert_pixels_scalar(uint8_t *dst, const uint8_t *y_row, const uint8_t *u_row, const uint8_t *v_row, size_t x_begin, size_t width) {
+    for (size_t x = x_begin; x < width; x++) {
+        const int16_t y = mul_high(static_cast<int16_t>((y_row[x] - 16) << 7), COEF_Y);
+        const int16_t u = static_cast<int16_t>((u_row[x >> 1] - 128) << 8);
+        const int16_t v = static_cast<int16_t>((v_row[x >> 1] - 128) << 8);
+
+        dst[x * 4 + 0] = to_channel(y + mul_high(v, COEF_RV));
+        dst[x * 4 + 1] = to_channel(y - mul_high(u, COEF_GU) - mul_high(v, COEF_GV));
+        dst[x * 4 + 2] = to_channel(y + mul_high(u, COEF_BU));
+        dst[x * 4 + 3] = 0xFF;
+    }
+}
+
+void yuv420p_bt601_to_rgba_scalar(uint8_t *dst, const uint8_t *y_plane, const uint8_t *u_plane, const uint8_t *v_plane,
+    size_t width, size_t row_begin, size_t row_end) {
+    const size_t chroma_width = (width + 1) / 2;
+
+    for (size_t row = row_begin; row < row_end; row++) {
+        convert_pixels_scalar(dst + row * width * 4, y_plane + row * width, u_plane + (row / 2) * chroma_width,
+            v_plane + (row / 2) * chroma_width, 0, width);
+    }
+}
+
+#ifdef YUV_USE_SSE2
+// Convert 8 pixels, given 8 luma values and their chroma already duplicated horizontally
+static inline void convert_8_sse2(__m128i y, __m128i u, __m128i v, __m128i &r, __m128i &g, __m128i &b) {
+    y = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), 7), _mm_set1_epi16(COEF_Y));
+
+    const __m128i rounding = _mm_set1_epi16(16);
+    const __m128i rv = _mm_mulhi_epi16(v, _mm_set1_epi16(COEF_RV));
+    const __m128i gu = _mm_mulhi_epi16(u, _mm_set1_epi16(COEF_GU));
+    const __m128i gv = _mm_mulhi_epi16(v, _mm_set1_epi16(COEF_GV));
+    const __m128i bu = _mm_mulhi_epi16(u, _mm_set1_epi16(COEF_BU));
+
+    r = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(y, rv), rounding), 5);
+    g = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(y, gu), gv), rounding), 5);
+    b = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(y, bu), rounding), 5);
+}
+
+static void convert_row_sse2(uint8_t *dst, const uint8_t *y_row, const uint8_t *u_row, const uint8_t *v_row, size_t width) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i chroma_bias = _mm_set1_epi16(128);
+    const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y_row + x));
+        const __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u_row + x / 2));
+        const __m128i v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v_row + x / 2));
+
+        const __m128i u16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), chroma_bias), 8);
+        const __m128i v16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), chroma_bias), 8);
+
+        __m128i r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+        convert_8_sse2(_mm_unpacklo_epi8(y8, zero), _mm_unpacklo_epi16(u16, u16), _mm_unpacklo_epi16(v16, v16), r_lo, g_lo, b_lo);
+        convert_8_sse2(_mm_unpackhi_epi8(y8, zero), _mm_unpackhi_epi16(u16, u16), _mm_unpackhi_epi16(v16, v16), r_hi, g_hi, b_hi);
+
+        const __m128i r = _mm_packus_epi16(r_lo, r_hi);
+        const __m128i g = _mm_packus_epi16(g_lo, g_hi);
+        const __m128i b = _mm_packus_epi16(b_lo, b_hi);
+
+        const __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+        const __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+        const __m128i ba_lo = _mm_unpacklo_epi8(b, alpha);
+        const __m128i ba_hi = _mm_unpackhi_epi8(b, alpha);
+
+        __m128i *out = reinterpret_cast<__m128i *>(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(rg_lo, ba_lo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg_lo, ba_lo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rg_hi, ba_hi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rg_hi, ba_hi));
+    }
+
+    convert_pixels_scalar(dst, y_row, u_row, v_row, x, width);
+}
+#endif
+
+void yuv420p_bt601_to_rgba_simd(uint8_t *dst, const uint8_t *y_plane, const uint8_t *u_plane, const uint8_t *v_plane,
+    size_t width, size_t row_begin, size_t row_end) {
+#ifdef YUV_USE_SSE2
+    const size_t chroma_width = (width + 1) / 2;
+
+    for (size_t row = row_begin; row < row_end; row++) {
+        convert_row_sse2(dst + row * width * 4, y_plane + row * width, u_plane + (row / 2) * chroma_width,
+            v_plane + (row / 2) * chroma_width, width);
+    }
+#else
+    yuv420p_bt601_to_rgba_scalar(dst, y_plane, u_plane, v_plane, width, row_begin, row_end);
+#endif
+}
+
+} // namespace renderer::texture
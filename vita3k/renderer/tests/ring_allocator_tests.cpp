@@ -0,0 +1,104 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/ring_allocator.h>
+
+#include <gtest/gtest.h>
+
+using renderer::RingAllocator;
+
+TEST(ring_allocator, aligns_allocations) {
+    RingAllocator ring(1024);
+    ASSERT_EQ(ring.allocate(10, 256), 0);
+    ASSERT_EQ(ring.allocate(10, 256), 256);
+    ASSERT_EQ(ring.allocate(300, 256), 512);
+    ASSERT_EQ(ring.used(), 812);
+}
+
+TEST(ring_allocator, full_until_fence_retired) {
+    RingAllocator ring(1024);
+    ASSERT_EQ(ring.allocate(512, 256), 0);
+    ring.close_segment(1);
+    ASSERT_EQ(ring.allocate(512, 256), 512);
+    ring.close_segment(2);
+
+    // Both halves are in flight
+    ASSERT_EQ(ring.allocate(256, 256), RingAllocator::NO_SPACE);
+    ASSERT_EQ(ring.stats().overflows, 1);
+
+    ring.retire(1);
+    ASSERT_EQ(ring.allocate(256, 256), 0);
+    ASSERT_EQ(ring.allocate(256, 256), 256);
+    ASSERT_EQ(ring.allocate(256, 256), RingAllocator::NO_SPACE);
+}
+
+TEST(ring_allocator, never_splits_over_the_end) {
+    RingAllocator ring(1024);
+    ASSERT_EQ(ring.allocate(768, 256), 0);
+    ring.close_segment(1);
+    ring.retire(1);
+
+    // 512 bytes are free at the end but only 256 before wrapping
+    ASSERT_EQ(ring.allocate(512, 256), 0);
+    ASSERT_EQ(ring.used(), 768);
+}
+
+TEST(ring_allocator, unfenced_data_is_never_reused) {
+    RingAllocator ring(1024);
+    ASSERT_EQ(ring.allocate(1024, 256), 0);
+    ring.retire(100);
+    ASSERT_EQ(ring.allocate(1, 1), RingAllocator::NO_SPACE);
+
+    ASSERT_TRUE(ring.has_unfenced_data());
+    ring.close_segment(101);
+    ASSERT_FALSE(ring.has_unfenced_data());
+    ring.retire(101);
+    ASSERT_EQ(ring.allocate(1, 1), 0);
+}
+
+TEST(ring_allocator, fence_request_threshold) {
+    RingAllocator ring(8 * 1024);
+    ring.allocate(512, 1);
+    ASSERT_FALSE(ring.should_fence());
+    ring.allocate(512, 1);
+    ASSERT_TRUE(ring.should_fence());
+    ring.close_segment(1);
+    ASSERT_FALSE(ring.should_fence());
+}
+
+TEST(ring_allocator, frame_high_water) {
+    RingAllocator ring(4096);
+    ring.allocate(1000, 1);
+    ring.end_frame();
+    ring.allocate(3000, 1);
+    ring.end_frame();
+    ring.allocate(10, 1);
+    ring.end_frame();
+
+    ASSERT_EQ(ring.stats().last_frame_bytes, 10);
+    ASSERT_EQ(ring.stats().frame_high_water, 3000);
+    ASSERT_EQ(ring.stats().bytes_allocated, 4010);
+}
+
+TEST(ring_allocator, grow_capacity) {
+    ASSERT_EQ(RingAllocator::grow_capacity(1024, 100, 0, 1 << 20), 2048);
+    ASSERT_EQ(RingAllocator::grow_capacity(1024, 3000, 0, 1 << 20), 8192);
+    ASSERT_EQ(RingAllocator::grow_capacity(1024, 100, 5000, 1 << 20), 16384);
+    ASSERT_EQ(RingAllocator::grow_capacity(1024, 100, 0, 1536), 1536);
+    // A single request larger than the maximum is still clamped
+    ASSERT_EQ(RingAllocator::grow_capacity(1024, 1 << 21, 0, 1 << 20), 1 << 20);
+}
@@ -0,0 +1,143 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/surface_range_index.h>
+
+#include <gtest/gtest.h>
+
+using renderer::SurfaceRangeIndex;
+
+TEST(surface_range_index, lookup_containing_address) {
+    SurfaceRangeIndex<int> index;
+    index.insert(0x1000, 0x100, 1, std::make_unique<int>(1));
+    index.insert(0x2000, 0x800, 1, std::make_unique<int>(2));
+
+    auto [key, value] = index.lookup(0x2400);
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(key, 0x2000);
+    ASSERT_EQ(*value, 2);
+
+    ASSERT_EQ(index.lookup(0x1100).second, nullptr);
+    ASSERT_EQ(index.lookup(0xFFF).second, nullptr);
+    ASSERT_EQ(index.lookup(0x10FF).first, 0x1000);
+}
+
+TEST(surface_range_index, lookup_prefers_closest_base) {
+    SurfaceRangeIndex<int> index;
+    index.insert(0x1000, 0x10000, 1, std::make_unique<int>(1));
+    index.insert(0x4000, 0x100, 1, std::make_unique<int>(2));
+
+    // Inside both, the highest base wins
+    ASSERT_EQ(index.lookup(0x4010).first, 0x4000);
+
+    // Past the small one, the large one still contains it
+    ASSERT_EQ(index.lookup(0x5000).first, 0x1000);
+}
+
+TEST(surface_range_index, query_overlaps) {
+    SurfaceRangeIndex<int> index;
+    index.insert(0x0, 0x100, 1, std::make_unique<int>(0));
+    index.insert(0x1000, 0x4000, 1, std::make_unique<int>(1));
+    index.insert(0x2000, 0x100, 1, std::make_unique<int>(2));
+    index.insert(0x6000, 0x100, 1, std::make_unique<int>(3));
+
+    std::vector<SurfaceRangeIndex<int>::Match> result;
+    index.query(0x2050, 0x10, result);
+    ASSERT_EQ(result.size(), 2);
+    ASSERT_EQ(result[0].first, 0x1000);
+    ASSERT_EQ(result[1].first, 0x2000);
+
+    index.query(0x0, 0x1001, result);
+    ASSERT_EQ(result.size(), 2);
+    ASSERT_EQ(result[0].first, 0x0);
+    ASSERT_EQ(result[1].first, 0x1000);
+
+    // End is exclusive
+    index.query(0x5000, 0x1000, result);
+    ASSERT_TRUE(result.empty());
+}
+
+TEST(surface_range_index, capacity_evicts_least_recently_used) {
+    std::vector<std::uint64_t> removed;
+
+    SurfaceRangeIndex<int> index(2);
+    index.set_remove_callback([&](std::uint64_t address, int &) {
+        removed.push_back(address);
+    });
+
+    index.insert(0x1000, 0x100, 1, std::make_unique<int>(1));
+    index.insert(0x2000, 0x100, 1, std::make_unique<int>(2));
+    index.touch(0x1000);
+    index.insert(0x3000, 0x100, 1, std::make_unique<int>(3));
+
+    ASSERT_EQ(index.size(), 2);
+    ASSERT_EQ(removed, std::vector<std::uint64_t>{ 0x2000 });
+    ASSERT_EQ(index.stats().evictions, 1);
+    ASSERT_NE(index.find(0x1000), nullptr);
+    ASSERT_EQ(index.find(0x2000), nullptr);
+}
+
+TEST(surface_range_index, budget_evicts_until_it_fits) {
+    SurfaceRangeIndex<int> index(0, 1000);
+    index.insert(0x1000, 0x100, 400, std::make_unique<int>(1));
+    index.insert(0x2000, 0x100, 400, std::make_unique<int>(2));
+    ASSERT_EQ(index.used_bytes(), 800);
+
+    index.insert(0x3000, 0x100, 900, std::make_unique<int>(3));
+    ASSERT_EQ(index.size(), 1);
+    ASSERT_EQ(index.used_bytes(), 900);
+    ASSERT_EQ(index.stats().evictions, 2);
+
+    // Growing an entry over the budget does not evict the entry itself
+    index.resize(0x3000, 0x200, 1200);
+    ASSERT_EQ(index.size(), 1);
+    ASSERT_EQ(index.used_bytes(), 1200);
+}
+
+TEST(surface_range_index, replace_same_base) {
+    int removed = 0;
+
+    SurfaceRangeIndex<int> index;
+    index.set_remove_callback([&](std::uint64_t, int &) {
+        removed++;
+    });
+
+    index.insert(0x1000, 0x100, 10, std::make_unique<int>(1));
+    index.insert(0x1000, 0x10000, 20, std::make_unique<int>(2));
+
+    ASSERT_EQ(removed, 1);
+    ASSERT_EQ(index.size(), 1);
+    ASSERT_EQ(index.used_bytes(), 20);
+    ASSERT_EQ(index.lookup(0x8000).first, 0x1000);
+    ASSERT_EQ(index.stats().evictions, 0);
+}
+
+TEST(surface_range_index, hit_miss_counters) {
+    SurfaceRangeIndex<int> index;
+    index.insert(0x1000, 0x100, 1, std::make_unique<int>(1));
+
+    index.lookup(0x1010);
+    index.lookup(0x2000);
+    index.find(0x1000);
+    index.find(0x1010);
+
+    ASSERT_EQ(index.stats().hits, 2);
+    ASSERT_EQ(index.stats().misses, 2);
+
+    index.reset_stats();
+    ASSERT_EQ(index.stats().hits, 0);
+}
@@ -0,0 +1,100 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/texture_yuv.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace renderer::texture;
+
+struct YuvImage {
+    size_t width;
+    size_t height;
+    std::vector<uint8_t> y, u, v;
+
+    YuvImage(size_t width, size_t height, unsigned int seed)
+        : width(width)
+        , height(height)
+        , y(width * height)
+        , u(((width + 1) / 2) * ((height + 1) / 2))
+        , v(u.size()) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (auto *plane : { &y, &u, &v }) {
+            for (auto &value : *plane) {
+                value = static_cast<uint8_t>(dist(rng));
+            }
+        }
+    }
+};
+
+// Straight float implementation of the BT.601 limited range conversion
+static uint8_t reference_channel(double value) {
+    return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L));
+}
+
+TEST(texture_yuv, simd_matches_scalar) {
+    // Odd width to also go through the leftover pixels
+    for (size_t width : { 16, 64, 70, 333 }) {
+        const YuvImage image(width, 48, static_cast<unsigned int>(width));
+        std::vector<uint8_t> scalar(width * image.height * 4);
+        std::vector<uint8_t> simd(width * image.height * 4);
+
+        yuv420p_bt601_to_rgba_scalar(scalar.data(), image.y.data(), image.u.data(), image.v.data(), width, 0, image.height);
+        yuv420p_bt601_to_rgba_simd(simd.data(), image.y.data(), image.u.data(), image.v.data(), width, 0, image.height);
+
+        ASSERT_EQ(scalar, simd) << "width " << width;
+    }
+}
+
+TEST(texture_yuv, scalar_close_to_reference) {
+    const YuvImage image(64, 32, 1);
+    std::vector<uint8_t> rgba(image.width * image.height * 4);
+    yuv420p_bt601_to_rgba_scalar(rgba.data(), image.y.data(), image.u.data(), image.v.data(), image.width, 0, image.height);
+
+    for (size_t row = 0; row < image.height; row++) {
+        for (size_t x = 0; x < image.width; x++) {
+            const double y = 1.164383 * (image.y[row * image.width + x] - 16);
+            const double u = image.u[(row / 2) * (image.width / 2) + x / 2] - 128.0;
+            const double v = image.v[(row / 2) * (image.width / 2) + x / 2] - 128.0;
+
+            const uint8_t *pixel = &rgba[(row * image.width + x) * 4];
+            ASSERT_NEAR(pixel[0], reference_channel(y + 1.596027 * v), 1);
+            ASSERT_NEAR(pixel[1], reference_channel(y - 0.391762 * u - 0.812968 * v), 1);
+            ASSERT_NEAR(pixel[2], reference_channel(y + 2.017232 * u), 1);
+            ASSERT_EQ(pixel[3], 0xFF);
+        }
+    }
+}
+
+TEST(texture_yuv, slices_match_whole_image) {
+    const YuvImage image(128, 96, 2);
+    std::vector<uint8_t> whole(image.width * image.height * 4);
+    std::vector<uint8_t> sliced(image.width * image.height * 4);
+
+    yuv420p_bt601_to_rgba_simd(whole.data(), image.y.data(), image.u.data(), image.v.data(), image.width, 0, image.height);
+    for (size_t row = 0; row < image.height; row += 32) {
+        yuv420p_bt601_to_rgba_simd(sliced.data(), image.y.data(), image.u.data(), image.v.data(), image.width, row, row + 32);
+    }
+
+    ASSERT_EQ(whole, sliced);
+}
@@ -0,0 +1,32 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstddef>
+
+// Kernels for the grain buffers of the SAS mixer. The vectorized versions give exactly the same
+// results as the scalar ones, which are also used for the leftover samples.
+namespace sas {
+// Add a mono voice to an interleaved stereo bus: dest += samples * levels * gain, per channel
+void mix_voice(float *dest, const float *samples, const float *levels, float left, float right, std::size_t frames);
+void mix_voice_scalar(float *dest, const float *samples, const float *levels, float left, float right, std::size_t frames);
+
+// Add an interleaved stereo bus to another one, with a gain for each channel
+void accumulate(float *dest, const float *src, float left, float right, std::size_t frames);
+void accumulate_scalar(float *dest, const float *src, float left, float right, std::size_t frames);
+} // namespace sas
@@ -0,0 +1,226 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <ngs/dsp.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Software version of the SAS voice mixer. Every voice is rendered for a whole grain at once, then
+// added to the dry and wet buses with the kernels of sas/mixing.h.
+namespace sas {
+constexpr std::uint32_t SAMPLE_RATE = 48000;
+constexpr std::uint32_t MAX_VOICES = 32;
+constexpr std::uint32_t MIN_GRAIN = 64;
+constexpr std::uint32_t MAX_GRAIN = 2048;
+constexpr std::uint32_t DEFAULT_GRAIN = 256;
+
+constexpr std::int32_t PITCH_BASE = 0x1000;
+constexpr std::int32_t MAX_PITCH = 0x4000;
+constexpr std::int32_t VOLUME_MAX = 0x1000;
+constexpr std::int32_t ENVELOPE_MAX = 0x40000000;
+
+constexpr std::uint32_t VAG_FRAME_SIZE = 16;
+constexpr std::uint32_t VAG_FRAME_SAMPLES = 28;
+
+enum class CurveMode : std::uint32_t {
+    LINEAR_INCREASE = 0,
+    LINEAR_DECREASE = 1,
+    LINEAR_BENT = 2,
+    EXPONENT_DECREASE = 3,
+    EXPONENT_INCREASE = 4,
+    DIRECT = 5,
+};
+
+// Which phases a SetADSR call changes
+enum EnvelopeFlags : std::uint32_t {
+    ENVELOPE_ATTACK = 1,
+    ENVELOPE_DECAY = 2,
+    ENVELOPE_SUSTAIN = 4,
+    ENVELOPE_RELEASE = 8,
+};
+
+// Also the index of the mode and rate of the phase
+enum class EnvelopePhase : std::uint32_t {
+    ATTACK = 0,
+    DECAY = 1,
+    SUSTAIN = 2,
+    RELEASE = 3,
+    OFF = 4,
+};
+
+// The height goes from 0 to ENVELOPE_MAX and moves once per sample along the curve of the current phase.
+// Attack ends at the top, decay at the sustain level, sustain lasts until key off and release ends at 0.
+struct Envelope {
+    CurveMode modes[4] = { CurveMode::LINEAR_INCREASE, CurveMode::EXPONENT_DECREASE, CurveMode::LINEAR_DECREASE, CurveMode::LINEAR_DECREASE };
+    std::int32_t rates[4] = { ENVELOPE_MAX, 0, 0, ENVELOPE_MAX };
+    std::int32_t sustain_level = ENVELOPE_MAX;
+
+    std::int32_t height = 0;
+    EnvelopePhase phase = EnvelopePhase::OFF;
+
+    void key_on();
+    void key_off();
+
+    // Unpack the two registers of the SPU style simple envelope
+    void set_simple(std::uint32_t adsr1, std::uint32_t adsr2);
+
+    // Write the level of each sample in [0, 1], then move to the next one
+    void render(float *levels, std::size_t count);
+
+private:
+    void step();
+};
+
+enum class SourceType {
+    NONE,
+    VAG,
+    PCM,
+    NOISE,
+};
+
+struct Voice {
+    SourceType type = SourceType::NONE;
+
+    // Guest memory, not owned. VAG sizes are in bytes and PCM sizes in 16-bit samples.
+    const std::uint8_t *data = nullptr;
+    std::uint32_t size = 0;
+    bool vag_loop = false;
+    std::int32_t pcm_loop_position = -1;
+    std::uint32_t noise_clock = 0;
+
+    std::int32_t pitch = PITCH_BASE;
+    std::int32_t volume[2] = { VOLUME_MAX, VOLUME_MAX };
+    std::int32_t wet_volume[2] = { 0, 0 };
+    std::int32_t distortion = 0;
+
+    Envelope envelope;
+    bool is_on = false;
+    bool is_paused = false;
+    bool has_ended = true;
+
+    void set_vag(const std::uint8_t *vag, std::uint32_t bytes, bool loop);
+    void set_pcm(const std::int16_t *pcm, std::uint32_t samples, std::int32_t loop_position);
+    void set_noise(std::uint32_t clock);
+
+    void key_on();
+    void key_off();
+
+    // Render one grain of the voice before volumes: the source resampled to the voice pitch and the
+    // envelope level of each sample. Returns false if the voice is silent for the whole grain.
+    bool render(float *samples, float *levels, std::size_t count);
+
+private:
+    // Source samples from the current position, source[0] being the one the fraction starts from
+    std::vector<float> source;
+    std::uint32_t fraction = 0;
+    std::size_t source_valid = 0;
+    bool source_ended = false;
+
+    std::uint32_t read_position = 0;
+    std::uint32_t vag_loop_start = 0;
+    bool vag_last_frame = false;
+    std::int32_t vag_history[2] = {};
+    std::int16_t vag_samples[VAG_FRAME_SAMPLES] = {};
+    std::uint32_t vag_sample_index = VAG_FRAME_SAMPLES;
+
+    std::uint32_t noise_seed = 1;
+    std::uint32_t noise_hold = 0;
+    float noise_value = 0.0f;
+
+    bool decode_vag_frame();
+    bool read_sample(float &sample);
+    void fill_source(std::size_t count);
+};
+
+enum class EffectType : std::int32_t {
+    OFF = -1,
+    ROOM = 0,
+    STUDIO_SMALL = 1,
+    STUDIO_MEDIUM = 2,
+    STUDIO_LARGE = 3,
+    HALL = 4,
+    SPACE = 5,
+    ECHO = 6,
+    DELAY = 7,
+    PIPE = 8,
+};
+
+constexpr std::uint32_t MAX_EFFECT_PARAM = 127;
+
+// Processes the wet bus. Echo, delay and pipe are feedback delay lines, the others reverbs.
+struct Effect {
+    EffectType type = EffectType::OFF;
+    bool dry = true;
+    bool wet = false;
+    std::uint32_t delay = 0;
+    std::uint32_t feedback = 0;
+    std::int32_t volume[2] = { 0, 0 };
+
+    // Apply the type and parameters
+    void configure();
+    void process(float *samples, std::size_t frames);
+
+private:
+    std::unique_ptr<ngs::dsp::Reverb> reverb;
+    std::vector<float> delay_line;
+    std::size_t delay_position = 0;
+    float delay_feedback = 0.0f;
+};
+
+enum class OutputMode : std::uint32_t {
+    STEREO = 0,
+    MULTICHANNEL = 1,
+};
+
+// Maximum of the absolute samples of each channel over the last grain, in 16-bit units
+struct Peak {
+    std::int32_t left = 0;
+    std::int32_t right = 0;
+};
+
+struct State {
+    std::mutex mutex;
+
+    std::uint32_t grain = DEFAULT_GRAIN;
+    OutputMode output_mode = OutputMode::STEREO;
+    std::vector<Voice> voices;
+    Effect effect;
+
+    Peak dry_peak;
+    Peak wet_peak;
+    Peak pre_master_peak;
+
+    void init(std::uint32_t voice_count, std::uint32_t grain);
+    void set_grain(std::uint32_t new_grain);
+
+    // Mix one grain of every voice as interleaved stereo. If given, the input is mixed in with its own volumes.
+    void render(std::int16_t *output, const std::int16_t *input = nullptr, std::int32_t input_left = 0, std::int32_t input_right = 0);
+
+private:
+    std::vector<float> dry;
+    std::vector<float> wet;
+    std::vector<float> master;
+    std::vector<float> voice_samples;
+    std::vector<float> voice_levels;
+};
+} // namespace sas
@@ -0,0 +1,169 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/state.h>
+
+#include <algorithm>
+
+namespace sas {
+static std::int64_t walk_curve(CurveMode mode, std::int64_t height, std::int64_t rate) {
+    switch (mode) {
+    case CurveMode::LINEAR_INCREASE:
+        return height + rate;
+    case CurveMode::LINEAR_DECREASE:
+        return height - rate;
+    case CurveMode::LINEAR_BENT:
+        // Slows down to a quarter of the rate for the last quarter
+        return height + ((height < ENVELOPE_MAX / 4 * 3) ? rate : rate / 4);
+    case CurveMode::EXPONENT_DECREASE:
+        // The rate is the part of the height lost on each sample, in 1/2^31. Always move so the end is reached.
+        return height - std::max<std::int64_t>((height * rate) >> 31, rate ? 1 : 0);
+    case CurveMode::EXPONENT_INCREASE:
+        return height + std::max<std::int64_t>(((ENVELOPE_MAX - height) * rate) >> 31, rate ? 1 : 0);
+    case CurveMode::DIRECT:
+        return rate;
+    }
+
+    return height;
+}
+
+void Envelope::key_on() {
+    height = 0;
+    phase = EnvelopePhase::ATTACK;
+}
+
+void Envelope::key_off() {
+    if (phase != EnvelopePhase::OFF) {
+        phase = EnvelopePhase::RELEASE;
+    }
+}
+
+void Envelope::step() {
+    if (phase == EnvelopePhase::OFF) {
+        return;
+    }
+
+    const auto index = static_cast<std::uint32_t>(phase);
+    std::int64_t next = walk_curve(modes[index], height, rates[index]);
+
+    switch (phase) {
+    case EnvelopePhase::ATTACK:
+        if (next >= ENVELOPE_MAX) {
+            next = ENVELOPE_MAX;
+            phase = EnvelopePhase::DECAY;
+        }
+        break;
+    case EnvelopePhase::DECAY:
+        if (next <= sustain_level) {
+            next = sustain_level;
+            phase = EnvelopePhase::SUSTAIN;
+        }
+        break;
+    case EnvelopePhase::SUSTAIN:
+        if (next <= 0) {
+            phase = EnvelopePhase::RELEASE;
+        }
+        break;
+    case EnvelopePhase::RELEASE:
+        if (next <= 0) {
+            phase = EnvelopePhase::OFF;
+        }
+        break;
+    case EnvelopePhase::OFF:
+        break;
+    }
+
+    height = static_cast<std::int32_t>(std::clamp<std::int64_t>(next, 0, ENVELOPE_MAX));
+}
+
+void Envelope::render(float *levels, std::size_t count) {
+    constexpr float scale = 1.0f / ENVELOPE_MAX;
+
+    for (std::size_t i = 0; i < count; i++) {
+        // Nothing moves anymore, the rest of the grain is flat
+        const bool is_flat = (phase == EnvelopePhase::OFF)
+            || ((phase == EnvelopePhase::SUSTAIN) && (rates[2] == 0) && (modes[2] != CurveMode::DIRECT));
+        if (is_flat) {
+            std::fill(levels + i, levels + count, height * scale);
+            return;
+        }
+
+        levels[i] = height * scale;
+        step();
+    }
+}
+
+// Rates of the simple envelope, as in the SPU registers it comes from
+static std::int32_t simple_rate(std::uint32_t value) {
+    value &= 0x7F;
+    if (value == 0x7F) {
+        return 0;
+    }
+
+    const std::int32_t rate = ((7 - (value & 3)) << 26) >> (value >> 2);
+    return std::max(rate, 1);
+}
+
+static std::int32_t exponent_rate(std::uint32_t value) {
+    value &= 0x7F;
+    if (value == 0x7F) {
+        return 0;
+    }
+
+    const std::int32_t rate = ((7 - (value & 3)) << 24) >> (value >> 2);
+    return std::max(rate, 1);
+}
+
+static std::int32_t halving_rate(std::uint32_t value) {
+    return (value == 0) ? 0x7FFFFFFF : static_cast<std::int32_t>(0x80000000u >> value);
+}
+
+void Envelope::set_simple(std::uint32_t adsr1, std::uint32_t adsr2) {
+    modes[0] = (adsr1 & 0x8000) ? CurveMode::LINEAR_BENT : CurveMode::LINEAR_INCREASE;
+    rates[0] = simple_rate(adsr1 >> 8);
+
+    modes[1] = CurveMode::EXPONENT_DECREASE;
+    rates[1] = halving_rate((adsr1 >> 4) & 0xF);
+
+    sustain_level = static_cast<std::int32_t>(((adsr1 & 0xF) + 1) << 26);
+
+    switch ((adsr2 >> 13) & 0x7) {
+    case 0: modes[2] = CurveMode::LINEAR_INCREASE; break;
+    case 2: modes[2] = CurveMode::LINEAR_DECREASE; break;
+    case 4: modes[2] = CurveMode::LINEAR_BENT; break;
+    default: modes[2] = CurveMode::EXPONENT_DECREASE; break;
+    }
+    rates[2] = (modes[2] == CurveMode::EXPONENT_DECREASE) ? exponent_rate(adsr2 >> 6) : simple_rate(adsr2 >> 6);
+
+    const std::uint32_t release = adsr2 & 0x1F;
+    if (adsr2 & 0x20) {
+        modes[3] = CurveMode::EXPONENT_DECREASE;
+        rates[3] = (release == 31) ? 0 : halving_rate(release);
+    } else {
+        modes[3] = CurveMode::LINEAR_DECREASE;
+        if (release == 31) {
+            rates[3] = 0;
+        } else if (release == 30) {
+            rates[3] = ENVELOPE_MAX;
+        } else if (release == 29) {
+            rates[3] = 1;
+        } else {
+            rates[3] = static_cast<std::int32_t>(0x10000000u >> release);
+        }
+    }
+}
+} // namespace sas
@@ -0,0 +1,117 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/mixing.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIXING_USE_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIXING_USE_NEON
+#endif
+
+namespace sas {
+static void mix_voice_tail(float *dest, const float *samples, const float *levels, float left, float right, std::size_t start, std::size_t frames) {
+    for (std::size_t k = start; k < frames; k++) {
+        const float sample = samples[k] * levels[k];
+
+        dest[k * 2] += sample * left;
+        dest[k * 2 + 1] += sample * right;
+    }
+}
+
+static void accumulate_tail(float *dest, const float *src, float left, float right, std::size_t start, std::size_t frames) {
+    for (std::size_t k = start; k < frames; k++) {
+        dest[k * 2] += src[k * 2] * left;
+        dest[k * 2 + 1] += src[k * 2 + 1] * right;
+    }
+}
+
+void mix_voice_scalar(float *dest, const float *samples, const float *levels, float left, float right, std::size_t frames) {
+    mix_voice_tail(dest, samples, levels, left, right, 0, frames);
+}
+
+void accumulate_scalar(float *dest, const float *src, float left, float right, std::size_t frames) {
+    accumulate_tail(dest, src, left, right, 0, frames);
+}
+
+#ifdef MIXING_USE_SSE2
+void mix_voice(float *dest, const float *samples, const float *levels, float left, float right, std::size_t frames) {
+    const __m128 left_gain = _mm_set1_ps(left);
+    const __m128 right_gain = _mm_set1_ps(right);
+
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const __m128 sample = _mm_mul_ps(_mm_loadu_ps(samples + k), _mm_loadu_ps(levels + k));
+        const __m128 lefts = _mm_mul_ps(sample, left_gain);
+        const __m128 rights = _mm_mul_ps(sample, right_gain);
+
+        _mm_storeu_ps(dest + k * 2, _mm_add_ps(_mm_loadu_ps(dest + k * 2), _mm_unpacklo_ps(lefts, rights)));
+        _mm_storeu_ps(dest + k * 2 + 4, _mm_add_ps(_mm_loadu_ps(dest + k * 2 + 4), _mm_unpackhi_ps(lefts, rights)));
+    }
+
+    mix_voice_tail(dest, samples, levels, left, right, k, frames);
+}
+
+void accumulate(float *dest, const float *src, float left, float right, std::size_t frames) {
+    const __m128 gains = _mm_setr_ps(left, right, left, right);
+
+    std::size_t k = 0;
+    for (; k + 2 <= frames; k += 2) {
+        _mm_storeu_ps(dest + k * 2, _mm_add_ps(_mm_loadu_ps(dest + k * 2), _mm_mul_ps(_mm_loadu_ps(src + k * 2), gains)));
+    }
+
+    accumulate_tail(dest, src, left, right, k, frames);
+}
+#elif defined(MIXING_USE_NEON)
+void mix_voice(float *dest, const float *samples, const float *levels, float left, float right, std::size_t frames) {
+    std::size_t k = 0;
+    for (; k + 4 <= frames; k += 4) {
+        const float32x4_t sample = vmulq_f32(vld1q_f32(samples + k), vld1q_f32(levels + k));
+
+        // Separate multiply and add, a fused one would round differently from the scalar code
+        float32x4x2_t stereo = vld2q_f32(dest + k * 2);
+        stereo.val[0] = vaddq_f32(stereo.val[0], vmulq_n_f32(sample, left));
+        stereo.val[1] = vaddq_f32(stereo.val[1], vmulq_n_f32(sample, right));
+        vst2q_f32(dest + k * 2, stereo);
+    }
+
+    mix_voice_tail(dest, samples, levels, left, right, k, frames);
+}
+
+void accumulate(float *dest, const float *src, float left, float right, std::size_t frames) {
+    const float gain_values[4] = { left, right, left, right };
+    const float32x4_t gains = vld1q_f32(gain_values);
+
+    std::size_t k = 0;
+    for (; k + 2 <= frames; k += 2) {
+        vst1q_f32(dest + k * 2, vaddq_f32(vld1q_f32(dest + k * 2), vmulq_f32(vld1q_f32(src + k * 2), gains)));
+    }
+
+    accumulate_tail(dest, src, left, right, k, frames);
+}
+#else
+void mix_voice(float *dest, const float *samples, const float *levels, float left, float right, std::size_t frames) {
+    mix_voice_tail(dest, samples, levels, left, right, 0, frames);
+}
+
+void accumulate(float *dest, const float *src, float left, float right, std::size_t frames) {
+    accumulate_tail(dest, src, left, right, 0, frames);
+}
+#endif
+} // namespace sas
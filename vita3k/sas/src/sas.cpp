@@ -0,0 +1,195 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/mixing.h>
+#include <sas/state.h>
+
+#include <ngs/mixing.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sas {
+// Tuning of the reverb types, from the smallest room to the largest space
+static constexpr ngs::dsp::ReverbSettings REVERB_PRESETS[] = {
+    // decay_time, decay_hf_ratio, pre_delay, diffusion, wet, dry
+    { 0.4f, 0.83f, 0.005f, 1.0f, 1.0f, 0.0f }, // ROOM
+    { 0.6f, 0.83f, 0.008f, 1.0f, 1.0f, 0.0f }, // STUDIO_SMALL
+    { 1.0f, 0.83f, 0.012f, 1.0f, 1.0f, 0.0f }, // STUDIO_MEDIUM
+    { 1.5f, 0.83f, 0.018f, 1.0f, 1.0f, 0.0f }, // STUDIO_LARGE
+    { 2.5f, 0.65f, 0.030f, 1.0f, 1.0f, 0.0f }, // HALL
+    { 5.0f, 0.50f, 0.060f, 1.0f, 1.0f, 0.0f }, // SPACE
+};
+
+// The pipe effect is a short fixed echo
+static constexpr std::size_t PIPE_DELAY = SAMPLE_RATE / 50;
+static constexpr float PIPE_FEEDBACK = 0.5f;
+
+static constexpr float S16_SCALE = 32768.0f;
+
+void Effect::configure() {
+    reverb.reset();
+    delay_line.clear();
+    delay_position = 0;
+    delay_feedback = 0.0f;
+
+    switch (type) {
+    case EffectType::ROOM:
+    case EffectType::STUDIO_SMALL:
+    case EffectType::STUDIO_MEDIUM:
+    case EffectType::STUDIO_LARGE:
+    case EffectType::HALL:
+    case EffectType::SPACE:
+        // Value initialized so the first configure sees a new sample rate and clears the lines
+        reverb.reset(new ngs::dsp::Reverb());
+        reverb->configure(REVERB_PRESETS[static_cast<std::int32_t>(type)], static_cast<float>(SAMPLE_RATE));
+        break;
+
+    case EffectType::ECHO:
+    case EffectType::DELAY: {
+        // Both parameters go up to MAX_EFFECT_PARAM, the delay covering up to a second
+        const std::size_t length = std::max<std::size_t>(1, static_cast<std::size_t>(delay) * SAMPLE_RATE / (MAX_EFFECT_PARAM + 1));
+        delay_line.assign(length * 2, 0.0f);
+
+        if (type == EffectType::ECHO) {
+            delay_feedback = static_cast<float>(feedback) / (MAX_EFFECT_PARAM + 1);
+        }
+        break;
+    }
+
+    case EffectType::PIPE:
+        delay_line.assign(PIPE_DELAY * 2, 0.0f);
+        delay_feedback = PIPE_FEEDBACK;
+        break;
+
+    case EffectType::OFF:
+        break;
+    }
+}
+
+void Effect::process(float *samples, std::size_t frames) {
+    if (reverb) {
+        reverb->process(samples, frames);
+        return;
+    }
+
+    if (delay_line.empty()) {
+        if (type == EffectType::OFF) {
+            std::fill_n(samples, frames * 2, 0.0f);
+        }
+        return;
+    }
+
+    // Only the delayed signal is output, what goes back in is the input plus the feedback
+    const std::size_t length = delay_line.size();
+    for (std::size_t i = 0; i < frames * 2; i++) {
+        const float delayed = delay_line[delay_position];
+        delay_line[delay_position] = samples[i] + delayed * delay_feedback;
+        samples[i] = delayed;
+
+        if (++delay_position == length) {
+            delay_position = 0;
+        }
+    }
+}
+
+void State::init(std::uint32_t voice_count, std::uint32_t new_grain) {
+    voices.clear();
+    voices.resize(voice_count);
+
+    effect = Effect();
+    dry_peak = {};
+    wet_peak = {};
+    pre_master_peak = {};
+    output_mode = OutputMode::STEREO;
+
+    set_grain(new_grain);
+}
+
+void State::set_grain(std::uint32_t new_grain) {
+    grain = new_grain;
+
+    dry.resize(grain * 2);
+    wet.resize(grain * 2);
+    master.resize(grain * 2);
+    voice_samples.resize(grain);
+    voice_levels.resize(grain);
+}
+
+static Peak measure_peak(const float *samples, std::size_t frames) {
+    float left = 0.0f;
+    float right = 0.0f;
+
+    for (std::size_t i = 0; i < frames; i++) {
+        left = std::max(left, std::abs(samples[i * 2]));
+        right = std::max(right, std::abs(samples[i * 2 + 1]));
+    }
+
+    return {
+        static_cast<std::int32_t>(std::min(left * S16_SCALE, 32767.0f)),
+        static_cast<std::int32_t>(std::min(right * S16_SCALE, 32767.0f)),
+    };
+}
+
+void State::render(std::int16_t *output, const std::int16_t *input, std::int32_t input_left, std::int32_t input_right) {
+    constexpr float volume_scale = 1.0f / VOLUME_MAX;
+
+    std::fill(dry.begin(), dry.end(), 0.0f);
+    std::fill(wet.begin(), wet.end(), 0.0f);
+
+    const bool use_wet = effect.wet && (effect.type != EffectType::OFF);
+
+    for (Voice &voice : voices) {
+        if (!voice.render(voice_samples.data(), voice_levels.data(), grain)) {
+            continue;
+        }
+
+        mix_voice(dry.data(), voice_samples.data(), voice_levels.data(), voice.volume[0] * volume_scale, voice.volume[1] * volume_scale, grain);
+
+        if (use_wet && (voice.wet_volume[0] || voice.wet_volume[1])) {
+            mix_voice(wet.data(), voice_samples.data(), voice_levels.data(), voice.wet_volume[0] * volume_scale, voice.wet_volume[1] * volume_scale, grain);
+        }
+    }
+
+    if (use_wet) {
+        effect.process(wet.data(), grain);
+    }
+
+    dry_peak = measure_peak(dry.data(), grain);
+    wet_peak = measure_peak(wet.data(), grain);
+
+    if (effect.dry) {
+        master = dry;
+    } else {
+        std::fill(master.begin(), master.end(), 0.0f);
+    }
+
+    if (use_wet) {
+        accumulate(master.data(), wet.data(), effect.volume[0] * volume_scale, effect.volume[1] * volume_scale, grain);
+    }
+
+    pre_master_peak = measure_peak(master.data(), grain);
+
+    if (input) {
+        // The dry bus is not needed anymore, reuse it for the converted input
+        ngs::s16_to_float(input, dry.data(), grain * 2);
+        accumulate(master.data(), dry.data(), input_left * volume_scale, input_right * volume_scale, grain);
+    }
+
+    ngs::float_to_s16(master.data(), output, grain * 2);
+}
+} // namespace sas
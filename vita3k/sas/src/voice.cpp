@@ -0,0 +1,237 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/state.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace sas {
+enum VagFlags : std::uint8_t {
+    VAG_LOOP_END = 1,
+    VAG_LOOP_REPEAT = 2,
+    VAG_LOOP_START = 4,
+};
+
+// Frames with every flag set only mark the end of the data
+static constexpr std::uint8_t VAG_END_MARKER = 7;
+
+// PS-ADPCM prediction filters, in 1/64
+static constexpr std::int32_t VAG_COEFS[5][2] = {
+    { 0, 0 },
+    { 60, 0 },
+    { 115, -52 },
+    { 98, -55 },
+    { 122, -60 },
+};
+
+static constexpr float S16_SCALE = 1.0f / 32768.0f;
+
+void Voice::set_vag(const std::uint8_t *vag, std::uint32_t bytes, bool loop) {
+    type = SourceType::VAG;
+    data = vag;
+    size = bytes;
+    vag_loop = loop;
+}
+
+void Voice::set_pcm(const std::int16_t *pcm, std::uint32_t samples, std::int32_t loop_position) {
+    type = SourceType::PCM;
+    data = reinterpret_cast<const std::uint8_t *>(pcm);
+    size = samples;
+    pcm_loop_position = loop_position;
+}
+
+void Voice::set_noise(std::uint32_t clock) {
+    type = SourceType::NOISE;
+    noise_clock = std::min<std::uint32_t>(clock, 63);
+}
+
+void Voice::key_on() {
+    source.clear();
+    fraction = 0;
+    source_valid = 0;
+    source_ended = false;
+
+    read_position = 0;
+    vag_loop_start = 0;
+    vag_last_frame = false;
+    vag_history[0] = vag_history[1] = 0;
+    vag_sample_index = VAG_FRAME_SAMPLES;
+
+    noise_hold = 0;
+
+    envelope.key_on();
+    is_on = (type != SourceType::NONE);
+    has_ended = !is_on;
+}
+
+void Voice::key_off() {
+    envelope.key_off();
+}
+
+bool Voice::decode_vag_frame() {
+    if (vag_last_frame || (read_position + VAG_FRAME_SIZE > size)) {
+        return false;
+    }
+
+    const std::uint8_t *frame = data + read_position;
+    const std::uint8_t flags = frame[1];
+    if (flags == VAG_END_MARKER) {
+        return false;
+    }
+
+    if (flags & VAG_LOOP_START) {
+        vag_loop_start = read_position;
+    }
+
+    const std::int32_t *coefs = VAG_COEFS[std::min(frame[0] >> 4, 4)];
+    std::uint32_t shift = frame[0] & 0xF;
+    if (shift > 12) {
+        shift = 9;
+    }
+
+    for (std::uint32_t i = 0; i < VAG_FRAME_SAMPLES; i++) {
+        // Low nibble first, sign extended from the top of a 16-bit word
+        const std::uint32_t nibble = (frame[2 + i / 2] >> ((i & 1) * 4)) & 0xF;
+        std::int32_t sample = static_cast<std::int16_t>(nibble << 12) >> shift;
+        sample += (vag_history[0] * coefs[0] + vag_history[1] * coefs[1] + 32) >> 6;
+        sample = std::clamp(sample, -32768, 32767);
+
+        vag_history[1] = vag_history[0];
+        vag_history[0] = sample;
+        vag_samples[i] = static_cast<std::int16_t>(sample);
+    }
+
+    vag_sample_index = 0;
+    read_position += VAG_FRAME_SIZE;
+
+    if (flags & VAG_LOOP_END) {
+        if (vag_loop && (flags & VAG_LOOP_REPEAT)) {
+            read_position = vag_loop_start;
+        } else {
+            vag_last_frame = true;
+        }
+    }
+
+    return true;
+}
+
+bool Voice::read_sample(float &sample) {
+    switch (type) {
+    case SourceType::VAG:
+        if ((vag_sample_index == VAG_FRAME_SAMPLES) && !decode_vag_frame()) {
+            return false;
+        }
+
+        sample = vag_samples[vag_sample_index++] * S16_SCALE;
+        return true;
+
+    case SourceType::PCM: {
+        if (read_position >= size) {
+            if ((pcm_loop_position < 0) || (static_cast<std::uint32_t>(pcm_loop_position) >= size)) {
+                return false;
+            }
+            read_position = pcm_loop_position;
+        }
+
+        std::int16_t value;
+        std::memcpy(&value, data + read_position * sizeof(std::int16_t), sizeof(value));
+        read_position++;
+
+        sample = value * S16_SCALE;
+        return true;
+    }
+
+    case SourceType::NOISE:
+        // Clock 63 gives a new value on every sample, each step down in 4 halves the rate
+        if (noise_hold == 0) {
+            noise_seed = noise_seed * 1664525 + 1013904223;
+            noise_value = static_cast<std::int32_t>(noise_seed) * (1.0f / 2147483648.0f);
+            noise_hold = 1u << ((63 - noise_clock) / 4);
+        }
+
+        noise_hold--;
+        sample = noise_value;
+        return true;
+
+    case SourceType::NONE:
+        break;
+    }
+
+    return false;
+}
+
+void Voice::fill_source(std::size_t count) {
+    while (source.size() < count) {
+        float sample = 0.0f;
+        if (!source_ended && !read_sample(sample)) {
+            source_ended = true;
+        }
+
+        if (!source_ended) {
+            source_valid++;
+        }
+
+        source.push_back(sample);
+    }
+}
+
+bool Voice::render(float *samples, float *levels, std::size_t count) {
+    if (!is_on || is_paused) {
+        return false;
+    }
+
+    // Linear interpolation at the voice pitch, with 12 bits of fraction
+    const std::uint64_t step = pitch;
+    const std::size_t last_index = static_cast<std::size_t>((fraction + (count - 1) * step) >> 12);
+    const std::size_t consumed = static_cast<std::size_t>((fraction + count * step) >> 12);
+
+    fill_source(std::max(last_index + 2, consumed + 1));
+
+    for (std::size_t i = 0; i < count; i++) {
+        const std::uint64_t position = fraction + i * step;
+        const std::size_t index = static_cast<std::size_t>(position >> 12);
+        const float weight = (position & 0xFFF) * (1.0f / 4096.0f);
+
+        samples[i] = source[index] + (source[index + 1] - source[index]) * weight;
+    }
+
+    source.erase(source.begin(), source.begin() + consumed);
+    source_valid -= std::min(source_valid, consumed);
+    fraction = static_cast<std::uint32_t>((fraction + count * step) & 0xFFF);
+
+    if (distortion > 0) {
+        const ngs::dsp::DistortionSettings settings = {
+            1.0f + distortion * (7.0f / VOLUME_MAX),
+            1.0f,
+            1.0f,
+            0.0f,
+        };
+        ngs::dsp::distort(samples, count, settings);
+    }
+
+    envelope.render(levels, count);
+
+    // Ended once the envelope is done or every sample of the source was played
+    if ((envelope.phase == EnvelopePhase::OFF) || (source_ended && (source_valid == 0))) {
+        is_on = false;
+        has_ended = true;
+    }
+
+    return true;
+}
+} // namespace sas
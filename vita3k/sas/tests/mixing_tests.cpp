@@ -0,0 +1,82 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/mixing.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+// Lengths hitting every vector width and leftover case
+constexpr std::size_t LENGTHS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 255, 256, 1023 };
+
+std::vector<float> random_samples(const std::size_t count, const float range, const unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-range, range);
+
+    std::vector<float> result(count);
+    for (float &sample : result) {
+        sample = distribution(generator);
+    }
+
+    return result;
+}
+
+bool same_bits(const std::vector<float> &lhs, const std::vector<float> &rhs) {
+    return (lhs.size() == rhs.size()) && (std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(float)) == 0);
+}
+} // namespace
+
+TEST(sas_mixing, mix_voice_matches_scalar) {
+    for (const std::size_t frames : LENGTHS) {
+        const std::vector<float> samples = random_samples(frames, 1.0f, static_cast<unsigned>(frames));
+        const std::vector<float> levels = random_samples(frames, 1.0f, static_cast<unsigned>(frames + 1));
+        std::vector<float> expected = random_samples(frames * 2, 1.0f, static_cast<unsigned>(frames + 2));
+        std::vector<float> result = expected;
+
+        sas::mix_voice_scalar(expected.data(), samples.data(), levels.data(), 0.75f, -0.25f, frames);
+        sas::mix_voice(result.data(), samples.data(), levels.data(), 0.75f, -0.25f, frames);
+
+        ASSERT_TRUE(same_bits(result, expected)) << frames << " frames";
+    }
+}
+
+TEST(sas_mixing, accumulate_matches_scalar) {
+    for (const std::size_t frames : LENGTHS) {
+        const std::vector<float> src = random_samples(frames * 2, 1.0f, static_cast<unsigned>(frames));
+        std::vector<float> expected = random_samples(frames * 2, 1.0f, static_cast<unsigned>(frames + 1));
+        std::vector<float> result = expected;
+
+        sas::accumulate_scalar(expected.data(), src.data(), 0.5f, 1.5f, frames);
+        sas::accumulate(result.data(), src.data(), 0.5f, 1.5f, frames);
+
+        ASSERT_TRUE(same_bits(result, expected)) << frames << " frames";
+    }
+}
+
+TEST(sas_mixing, mix_voice_pans_channels) {
+    std::vector<float> dest(4, 0.0f);
+    const float samples[] = { 0.5f, -1.0f };
+    const float levels[] = { 1.0f, 0.5f };
+
+    sas::mix_voice(dest.data(), samples, levels, 1.0f, 0.0f, 2);
+
+    ASSERT_EQ(dest, (std::vector<float>{ 0.5f, 0.0f, -0.5f, 0.0f }));
+}
@@ -0,0 +1,359 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <sas/state.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+// A 16 byte VAG frame where every sample decodes to nibble << 12
+std::vector<std::uint8_t> vag_frame(std::uint8_t flags, std::uint8_t nibble) {
+    std::vector<std::uint8_t> frame(sas::VAG_FRAME_SIZE, static_cast<std::uint8_t>(nibble | (nibble << 4)));
+    frame[0] = 0;
+    frame[1] = flags;
+    return frame;
+}
+
+std::vector<std::int16_t> ramp(std::size_t count) {
+    std::vector<std::int16_t> result(count);
+    for (std::size_t i = 0; i < count; i++) {
+        result[i] = static_cast<std::int16_t>(i * 16 - 8000);
+    }
+    return result;
+}
+} // namespace
+
+TEST(sas_envelope, linear_attack) {
+    constexpr std::int32_t rate = sas::ENVELOPE_MAX / 64;
+
+    sas::Envelope envelope;
+    envelope.rates[0] = rate;
+    envelope.key_on();
+
+    float levels[80];
+    envelope.render(levels, 80);
+
+    for (std::size_t i = 0; i <= 64; i++) {
+        ASSERT_EQ(levels[i], static_cast<float>(i) / 64.0f) << i;
+    }
+
+    // Default decay and sustain hold the top
+    ASSERT_EQ(levels[79], 1.0f);
+    ASSERT_EQ(envelope.phase, sas::EnvelopePhase::SUSTAIN);
+}
+
+TEST(sas_envelope, full_cycle) {
+    sas::Envelope envelope;
+    envelope.rates[0] = sas::ENVELOPE_MAX / 4;
+    envelope.modes[1] = sas::CurveMode::LINEAR_DECREASE;
+    envelope.rates[1] = sas::ENVELOPE_MAX / 8;
+    envelope.sustain_level = sas::ENVELOPE_MAX / 2;
+    envelope.rates[2] = 0;
+    envelope.rates[3] = sas::ENVELOPE_MAX / 16;
+    envelope.key_on();
+
+    float levels[16];
+    envelope.render(levels, 16);
+
+    // 4 samples up, 4 down to the sustain level, then flat
+    ASSERT_EQ(levels[4], 1.0f);
+    ASSERT_EQ(levels[6], 0.75f);
+    ASSERT_EQ(levels[8], 0.5f);
+    ASSERT_EQ(levels[15], 0.5f);
+    ASSERT_EQ(envelope.phase, sas::EnvelopePhase::SUSTAIN);
+
+    envelope.key_off();
+    envelope.render(levels, 16);
+
+    ASSERT_EQ(levels[0], 0.5f);
+    ASSERT_EQ(levels[4], 0.25f);
+    ASSERT_EQ(levels[8], 0.0f);
+    ASSERT_EQ(envelope.phase, sas::EnvelopePhase::OFF);
+}
+
+TEST(sas_envelope, exponent_decrease_reaches_zero) {
+    sas::Envelope envelope;
+    envelope.height = sas::ENVELOPE_MAX;
+    envelope.phase = sas::EnvelopePhase::RELEASE;
+    envelope.modes[3] = sas::CurveMode::EXPONENT_DECREASE;
+    envelope.rates[3] = 0x10000000;
+
+    std::vector<float> levels(4096);
+    envelope.render(levels.data(), levels.size());
+
+    // Each sample loses an eighth of the height
+    ASSERT_EQ(levels[1], 0.875f);
+    ASSERT_EQ(envelope.phase, sas::EnvelopePhase::OFF);
+}
+
+TEST(sas_envelope, simple_registers) {
+    sas::Envelope envelope;
+    envelope.set_simple(0x000F, 0x1FC0);
+
+    ASSERT_EQ(envelope.modes[0], sas::CurveMode::LINEAR_INCREASE);
+    ASSERT_EQ(envelope.rates[0], 0x1C000000);
+    ASSERT_EQ(envelope.modes[1], sas::CurveMode::EXPONENT_DECREASE);
+    ASSERT_EQ(envelope.rates[1], 0x7FFFFFFF);
+    ASSERT_EQ(envelope.sustain_level, sas::ENVELOPE_MAX);
+    ASSERT_EQ(envelope.modes[2], sas::CurveMode::LINEAR_INCREASE);
+    ASSERT_EQ(envelope.rates[2], 0);
+    ASSERT_EQ(envelope.modes[3], sas::CurveMode::LINEAR_DECREASE);
+    ASSERT_EQ(envelope.rates[3], 0x10000000);
+
+    // Bent attack, exponential release
+    envelope.set_simple(0x8000, 0x0025);
+    ASSERT_EQ(envelope.modes[0], sas::CurveMode::LINEAR_BENT);
+    ASSERT_EQ(envelope.modes[3], sas::CurveMode::EXPONENT_DECREASE);
+    ASSERT_EQ(envelope.rates[3], 0x4000000);
+}
+
+TEST(sas, pcm_plays_back_unchanged) {
+    const std::vector<std::int16_t> pcm = ramp(600);
+
+    sas::State state;
+    state.init(1, 256);
+    state.voices[0].set_pcm(pcm.data(), static_cast<std::uint32_t>(pcm.size()), -1);
+    state.voices[0].key_on();
+
+    std::vector<std::int16_t> output(512 * 2);
+    state.render(output.data());
+    state.render(output.data() + 512);
+
+    // The envelope starts from 0, so the first sample is silent
+    ASSERT_EQ(output[0], 0);
+    for (std::size_t i = 1; i < 512; i++) {
+        ASSERT_EQ(output[i * 2], pcm[i]) << i;
+        ASSERT_EQ(output[i * 2 + 1], pcm[i]) << i;
+    }
+
+    ASSERT_TRUE(state.voices[0].is_on);
+
+    // The last 88 samples are played, then the voice ends
+    state.render(output.data());
+    ASSERT_EQ(output[87 * 2], pcm[599]);
+    ASSERT_EQ(output[88 * 2], 0);
+    ASSERT_FALSE(state.voices[0].is_on);
+    ASSERT_TRUE(state.voices[0].has_ended);
+}
+
+TEST(sas, pcm_pitch_and_loop) {
+    const std::vector<std::int16_t> pcm = ramp(100);
+
+    sas::State state;
+    state.init(1, 64);
+    sas::Voice &voice = state.voices[0];
+    voice.set_pcm(pcm.data(), static_cast<std::uint32_t>(pcm.size()), 50);
+    voice.pitch = sas::PITCH_BASE * 2;
+    voice.key_on();
+
+    std::vector<std::int16_t> output(64 * 2);
+    state.render(output.data());
+
+    // Twice the speed takes every other sample, then comes back to the loop position
+    for (std::size_t i = 1; i < 50; i++) {
+        ASSERT_EQ(output[i * 2], pcm[i * 2]) << i;
+    }
+    for (std::size_t i = 50; i < 64; i++) {
+        ASSERT_EQ(output[i * 2], pcm[50 + (i - 50) * 2]) << i;
+    }
+
+    // Half way between two samples
+    voice.pitch = sas::PITCH_BASE / 2;
+    state.render(output.data());
+    ASSERT_EQ(output[2], (pcm[78] + pcm[79]) / 2);
+}
+
+TEST(sas, vag_decode_and_loop) {
+    std::vector<std::uint8_t> vag = vag_frame(4, 1);
+    const std::vector<std::uint8_t> end = vag_frame(3, 2);
+    vag.insert(vag.end(), end.begin(), end.end());
+
+    for (const bool loop : { false, true }) {
+        sas::State state;
+        state.init(1, 128);
+        state.voices[0].set_vag(vag.data(), static_cast<std::uint32_t>(vag.size()), loop);
+        state.voices[0].key_on();
+
+        std::vector<std::int16_t> output(128 * 2);
+        state.render(output.data());
+
+        for (std::size_t i = 1; i < 28; i++) {
+            ASSERT_EQ(output[i * 2], 0x1000) << i;
+        }
+        for (std::size_t i = 28; i < 56; i++) {
+            ASSERT_EQ(output[i * 2], 0x2000) << i;
+        }
+        for (std::size_t i = 56; i < 84; i++) {
+            ASSERT_EQ(output[i * 2], loop ? 0x1000 : 0) << i;
+        }
+
+        ASSERT_EQ(state.voices[0].has_ended, !loop);
+    }
+}
+
+TEST(sas, vag_prediction_filter) {
+    // Filter 1 with shift 12: the first sample is 1, then each adds 60/64 of the previous one
+    std::vector<std::uint8_t> vag = vag_frame(1, 0);
+    vag[0] = 0x1C;
+    vag[2] = 0x01;
+
+    sas::State state;
+    state.init(1, 64);
+    state.voices[0].set_vag(vag.data(), static_cast<std::uint32_t>(vag.size()), false);
+    state.voices[0].key_on();
+
+    std::vector<std::int16_t> output(64 * 2);
+    state.render(output.data());
+
+    // (1 * 60 + 32) >> 6 == 1, so the value stays at 1 until it is scaled by the full envelope
+    ASSERT_EQ(output[2], 1);
+    ASSERT_EQ(output[27 * 2], 1);
+}
+
+TEST(sas, mix_with_input) {
+    sas::State state;
+    state.init(1, 64);
+
+    std::vector<std::int16_t> buffer(64 * 2);
+    for (std::size_t i = 0; i < buffer.size(); i++) {
+        buffer[i] = static_cast<std::int16_t>(i * 100);
+    }
+    const std::vector<std::int16_t> input = buffer;
+
+    state.render(buffer.data(), buffer.data(), sas::VOLUME_MAX, sas::VOLUME_MAX / 2);
+
+    for (std::size_t i = 0; i < 64; i++) {
+        ASSERT_EQ(buffer[i * 2], input[i * 2]);
+        ASSERT_EQ(buffer[i * 2 + 1], input[i * 2 + 1] / 2);
+    }
+}
+
+TEST(sas, pause_keeps_position) {
+    const std::vector<std::int16_t> pcm = ramp(300);
+
+    sas::State state;
+    state.init(1, 64);
+    state.voices[0].set_pcm(pcm.data(), static_cast<std::uint32_t>(pcm.size()), -1);
+    state.voices[0].key_on();
+    state.voices[0].is_paused = true;
+
+    std::vector<std::int16_t> output(64 * 2);
+    state.render(output.data());
+    ASSERT_EQ(output, std::vector<std::int16_t>(64 * 2, 0));
+
+    state.voices[0].is_paused = false;
+    state.render(output.data());
+    ASSERT_EQ(output[2], pcm[1]);
+    ASSERT_EQ(output[63 * 2], pcm[63]);
+}
+
+TEST(sas, volumes_and_peaks) {
+    const std::vector<std::int16_t> pcm(256, 0x4000);
+
+    sas::State state;
+    state.init(1, 64);
+    state.voices[0].set_pcm(pcm.data(), static_cast<std::uint32_t>(pcm.size()), 0);
+    state.voices[0].volume[0] = sas::VOLUME_MAX / 2;
+    state.voices[0].volume[1] = -sas::VOLUME_MAX;
+    state.voices[0].key_on();
+
+    std::vector<std::int16_t> output(64 * 2);
+    state.render(output.data());
+
+    ASSERT_EQ(output[2], 0x2000);
+    ASSERT_EQ(output[3], -0x4000);
+    ASSERT_EQ(state.dry_peak.left, 0x2000);
+    ASSERT_EQ(state.dry_peak.right, 0x4000);
+    ASSERT_EQ(state.wet_peak.left, 0);
+}
+
+TEST(sas, echo_impulse) {
+    sas::Effect effect;
+    effect.type = sas::EffectType::ECHO;
+    effect.delay = 1;
+    effect.feedback = 64;
+    effect.configure();
+
+    // A delay of 1 is 1/128 of a second
+    constexpr std::size_t delay = sas::SAMPLE_RATE / 128;
+    std::vector<float> samples(1024 * 2, 0.0f);
+    samples[0] = 1.0f;
+
+    effect.process(samples.data(), 1024);
+
+    ASSERT_EQ(samples[0], 0.0f);
+    ASSERT_EQ(samples[delay * 2], 1.0f);
+    ASSERT_EQ(samples[delay * 2 + 1], 0.0f);
+    ASSERT_EQ(samples[delay * 4], 0.5f);
+}
+
+TEST(sas, reverb_goes_to_wet_bus) {
+    const std::vector<std::int16_t> pcm(4096, 0x4000);
+
+    sas::State state;
+    state.init(1, 256);
+    state.effect.type = sas::EffectType::HALL;
+    state.effect.dry = false;
+    state.effect.wet = true;
+    state.effect.volume[0] = state.effect.volume[1] = sas::VOLUME_MAX;
+    state.effect.configure();
+    state.voices[0].set_pcm(pcm.data(), static_cast<std::uint32_t>(pcm.size()), -1);
+    state.voices[0].wet_volume[0] = state.voices[0].wet_volume[1] = sas::VOLUME_MAX;
+    state.voices[0].key_on();
+
+    // Long enough to get through the pre-delay and the combs of the hall
+    std::vector<std::int16_t> output(256 * 2);
+    for (int i = 0; i < 16; i++) {
+        state.render(output.data());
+    }
+
+    ASSERT_GT(state.wet_peak.left, 0);
+    ASSERT_GT(state.pre_master_peak.left, 0);
+}
+
+TEST(sas, benchmark) {
+    constexpr std::uint32_t grain = 256;
+    constexpr std::uint32_t grain_count = 2000;
+
+    const std::vector<std::int16_t> pcm = ramp(4000);
+
+    sas::State state;
+    state.init(sas::MAX_VOICES, grain);
+    for (std::uint32_t i = 0; i < sas::MAX_VOICES; i++) {
+        sas::Voice &voice = state.voices[i];
+        voice.set_pcm(pcm.data(), static_cast<std::uint32_t>(pcm.size()), 0);
+        voice.pitch = sas::PITCH_BASE / 2 + static_cast<std::int32_t>(i) * 97;
+        voice.volume[0] = voice.volume[1] = sas::VOLUME_MAX / sas::MAX_VOICES;
+        voice.key_on();
+    }
+
+    std::vector<std::int16_t> output(grain * 2);
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    for (std::uint32_t i = 0; i < grain_count; i++) {
+        state.render(output.data());
+    }
+    const auto time = std::chrono::duration<double>(clock::now() - start).count();
+
+    std::printf("sas %u voices: %.0f grains/s, %.1fx real time\n", sas::MAX_VOICES, grain_count / time,
+        grain_count * grain / (time * sas::SAMPLE_RATE));
+}
@@ -0,0 +1,100 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded queue for exactly one producer thread and one consumer thread. Neither side ever blocks or
+// takes a lock, each one only publishes its own position and reads the position of the other side.
+template <typename T>
+class SPSCRingBuffer {
+public:
+    // The capacity is rounded up to a power of two, so positions wrap with a mask
+    explicit SPSCRingBuffer(std::size_t min_capacity) {
+        std::size_t capacity = 1;
+        while (capacity < min_capacity) {
+            capacity <<= 1;
+        }
+
+        buffer = std::make_unique<T[]>(capacity);
+        mask = capacity - 1;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+    // Exact when called from either side, a snapshot otherwise
+    std::size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Producer only. Returns how many elements fit.
+    std::size_t write(const T *data, std::size_t count) {
+        const std::size_t write_pos = tail.load(std::memory_order_relaxed);
+        const std::size_t read_pos = head.load(std::memory_order_acquire);
+
+        count = std::min(count, capacity() - (write_pos - read_pos));
+
+        const std::size_t start = write_pos & mask;
+        const std::size_t first = std::min(count, capacity() - start);
+        std::copy_n(data, first, &buffer[start]);
+        std::copy_n(data + first, count - first, &buffer[0]);
+
+        tail.store(write_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer only. Hands up to count elements to consume(const T *data, std::size_t count) in at most
+    // two contiguous runs, without copying them, then releases them to the producer.
+    template <typename F>
+    std::size_t consume(std::size_t count, F &&consume) {
+        const std::size_t read_pos = head.load(std::memory_order_relaxed);
+        const std::size_t write_pos = tail.load(std::memory_order_acquire);
+
+        count = std::min(count, write_pos - read_pos);
+
+        const std::size_t start = read_pos & mask;
+        const std::size_t first = std::min(count, capacity() - start);
+        if (first != 0) {
+            consume(&buffer[start], first);
+        }
+        if (count != first) {
+            consume(&buffer[0], count - first);
+        }
+
+        head.store(read_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer only
+    std::size_t read(T *out, std::size_t count) {
+        return consume(count, [&out](const T *data, std::size_t run) {
+            out = std::copy_n(data, run, out);
+        });
+    }
+
+private:
+    std::unique_ptr<T[]> buffer;
+    std::size_t mask = 0;
+
+    // Free running positions, on separate cache lines so both sides do not fight over them
+    alignas(64) std::atomic<std::size_t> head = 0;
+    alignas(64) std::atomic<std::size_t> tail = 0;
+};
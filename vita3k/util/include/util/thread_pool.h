@@ -0,0 +1,72 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// Fixed set of worker threads consuming a FIFO of tasks
+class ThreadPool {
+public:
+    // Zero threads means one less than the number of hardware threads, the caller being the last one
+    explicit ThreadPool(std::size_t thread_count = 0);
+    ~ThreadPool();
+
+    std::size_t size() const {
+        return workers.size();
+    }
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&func) {
+        typedef std::invoke_result_t<F> Result;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+        std::future<Result> result = task->get_future();
+
+        push([task]() {
+            (*task)();
+        });
+
+        return result;
+    }
+
+    // Call func(i) for every i in [0, count) on the workers and on the calling thread, and return once
+    // every call is done. Safe to use from a worker thread, the caller always makes progress by itself.
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)> &func);
+
+private:
+    void push(std::function<void()> task);
+    void worker_loop();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopping = false;
+};
+
+} // namespace util
@@ -0,0 +1,134 @@
+// Vita3K emulator project
+// Copyright (C) 2022 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace util {
+
+ThreadPool::ThreadPool(std::size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+    }
+
+    workers.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    cond.notify_all();
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+
+    cond.notify_one();
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [&] { return stopping || !tasks.empty(); });
+
+            if (stopping && tasks.empty()) {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)> &func) {
+    if (count == 0) {
+        return;
+    }
+
+    if ((count == 1) || workers.empty()) {
+        for (std::size_t i = 0; i < count; i++) {
+            func(i);
+        }
+
+        return;
+    }
+
+    // Shared with the helpers, which may only get to run after this call has returned if the pool is busy
+    struct Job {
+        const std::function<void(std::size_t)> *func;
+        std::size_t count;
+        std::atomic<std::size_t> next = 0;
+        std::size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable cond;
+
+        void run() {
+            std::size_t finished = 0;
+            for (std::size_t i = next++; i < count; i = next++) {
+                (*func)(i);
+                finished++;
+            }
+
+            if (finished != 0) {
+                const std::lock_guard<std::mutex> lock(mutex);
+                done += finished;
+                if (done == count) {
+                    cond.notify_all();
+                }
+            }
+        }
+    };
+
+    auto job = std::make_shared<Job>();
+    job->func = &func;
+    job->count = count;
+
+    const std::size_t helper_count = std::min(count - 1, workers.size());
+    for (std::size_t i = 0; i < helper_count; i++) {
+        push([job]() {
+            job->run();
+        });
+    }
+
+    job->run();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cond.wait(lock, [&] { return job->done == job->count; });
+}
+
+} // namespace util